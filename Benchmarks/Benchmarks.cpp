@@ -0,0 +1,18 @@
+#include "Core/Benchmark.h"
+#include "Containers/ContainersBenchmark.h"
+#include "Memory/AllocatorBenchmark.h"
+
+using namespace Sailor;
+
+// Standalone runner of the containers and the allocators benchmarks, the engine is not initialized:
+// no window, no renderer and no scheduler, so the cases that need the tasks are skipped.
+//   SailorBenchmarks --repetitions 10 --cpu 2 --out current.json --baseline baseline.json
+//   SailorBenchmarks --compare baseline.json current.json --threshold 5
+int main(int argc, const char** argv)
+{
+	Benchmark::Runner runner;
+	RegisterContainersBenchmarks(runner);
+	RegisterAllocatorBenchmarks(runner);
+
+	return Benchmark::RunFromCommandLine(runner, argv, argc);
+}
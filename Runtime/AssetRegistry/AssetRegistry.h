@@ -159,7 +159,7 @@ namespace Sailor
 		SAILOR_API AssetInfoPtr GetAssetInfoPtr_Internal(FileId uid) const;
 		SAILOR_API AssetInfoPtr GetAssetInfoPtr_Internal(const std::string& assetFilepath) const;
 
-		TMap<FileId, AssetInfoPtr> m_loadedAssetInfo;
+		TFlatMap<FileId, AssetInfoPtr> m_loadedAssetInfo;
 		TMap<std::string, FileId> m_fileIds;
 		TMap<std::string, class IAssetInfoHandler*> m_assetInfoHandlers;
 
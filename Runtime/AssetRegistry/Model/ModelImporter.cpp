@@ -288,42 +288,7 @@ Tasks::TaskPtr<ModelPtr> ModelImporter::LoadModel(FileId uid, ModelPtr& outModel
 
 		ModelPtr model = ModelPtr::Make(m_allocator, uid);
 
-		// The way to drop qualifiers inside lambda
-		auto& boundsSphere = model->m_boundsSphere;
-		auto& boundsAabb = model->m_boundsAabb;
-
-		struct Data
-		{
-			TVector<MeshContext> m_parsedMeshes;
-			bool m_bIsImported = false;
-		};
-
-		promise = Tasks::CreateTaskWithResult<TSharedPtr<Data>>("Load model",
-			[model, assetInfo, &boundsAabb, &boundsSphere]()
-			{
-				TSharedPtr<Data> res = TSharedPtr<Data>::Make();
-				res->m_bIsImported = ImportModel(assetInfo, res->m_parsedMeshes, boundsAabb, boundsSphere);
-				return res;
-			})->Then<ModelPtr>([model](TSharedPtr<Data> data) mutable
-				{
-					if (data->m_bIsImported)
-					{
-						for (const auto& mesh : data->m_parsedMeshes)
-						{
-							RHI::RHIMeshPtr ptr = RHI::Renderer::GetDriver()->CreateMesh();
-							ptr->m_vertexDescription = RHI::Renderer::GetDriver()->GetOrAddVertexDescription<RHI::VertexP3N3T3B3UV2C4>();
-							ptr->m_bounds = mesh.bounds;
-							RHI::Renderer::GetDriver()->UpdateMesh(ptr,
-								&mesh.outVertices[0], sizeof(RHI::VertexP3N3T3B3UV2C4) * mesh.outVertices.Num(),
-								&mesh.outIndices[0], sizeof(uint32_t) * mesh.outIndices.Num());
-
-							model->m_meshes.Emplace(ptr);
-						}
-
-						model->Flush();
-					}
-					return model;
-				}, "Update RHI Meshes", EThreadType::RHI)->ToTaskWithResult();
+		promise = LoadModelAsync(model, assetInfo);
 
 			outModel = loadedModel = model;
 			promise->Run();
@@ -341,6 +306,33 @@ Tasks::TaskPtr<ModelPtr> ModelImporter::LoadModel(FileId uid, ModelPtr& outModel
 	return Tasks::TaskPtr<ModelPtr>();
 }
 
+Tasks::Coroutine<ModelPtr> ModelImporter::LoadModelAsync(ModelPtr model, ModelAssetInfoPtr assetInfo)
+{
+	TVector<MeshContext> parsedMeshes;
+	const bool bIsImported = ImportModel(assetInfo, parsedMeshes, model->m_boundsAabb, model->m_boundsSphere);
+
+	co_await Tasks::ResumeOn(EThreadType::RHI);
+
+	if (bIsImported)
+	{
+		for (const auto& mesh : parsedMeshes)
+		{
+			RHI::RHIMeshPtr ptr = RHI::Renderer::GetDriver()->CreateMesh();
+			ptr->m_vertexDescription = RHI::Renderer::GetDriver()->GetOrAddVertexDescription<RHI::VertexP3N3T3B3UV2C4>();
+			ptr->m_bounds = mesh.bounds;
+			RHI::Renderer::GetDriver()->UpdateMesh(ptr,
+				&mesh.outVertices[0], sizeof(RHI::VertexP3N3T3B3UV2C4) * mesh.outVertices.Num(),
+				&mesh.outIndices[0], sizeof(uint32_t) * mesh.outIndices.Num());
+
+			model->m_meshes.Emplace(ptr);
+		}
+
+		model->Flush();
+	}
+
+	co_return model;
+}
+
 bool ModelImporter::LoadModel_Immediate(FileId uid, ModelPtr& outModel)
 {
 	SAILOR_PROFILE_FUNCTION();
@@ -12,6 +12,7 @@
 #include "AssetRegistry/AssetFactory.h"
 #include "ModelAssetInfo.h"
 #include "Tasks/Scheduler.h"
+#include "Tasks/Coroutine.h"
 #include "ModelAssetInfo.h"
 #include "Engine/Object.h"
 #include "Memory/ObjectPtr.hpp"
@@ -95,6 +96,9 @@ namespace Sailor
 
 		SAILOR_API static bool ImportModel(ModelAssetInfoPtr assetInfo, TVector<MeshContext>& outParsedMeshes, Math::AABB& outBoundsAabb, Math::Sphere& outBoundsSphere);
 
+		// Parses the model on the worker thread then creates the RHI meshes on the RHI thread
+		SAILOR_API static Tasks::Coroutine<ModelPtr> LoadModelAsync(ModelPtr model, ModelAssetInfoPtr assetInfo);
+
 		SAILOR_API void GenerateMaterialAssets(ModelAssetInfoPtr assetInfo);
 
 		TConcurrentMap<FileId, Tasks::TaskPtr<ModelPtr>> m_promises;
@@ -378,7 +378,7 @@ Tasks::TaskPtr<bool> ShaderCompiler::CompileAllPermutations(ShaderAssetInfoPtr a
 				m_shaderAssetsCache.Remove(assetInfo->GetFileId());
 
 				return true;
-			});
+			}, EThreadType::Worker, ETaskPriority::Background);
 
 		for (uint32_t i = 0; i < permutationsToCompile.Num(); i++)
 		{
@@ -386,7 +386,7 @@ Tasks::TaskPtr<bool> ShaderCompiler::CompileAllPermutations(ShaderAssetInfoPtr a
 				{
 					SAILOR_LOG("Start compiling shader %d", permutationsToCompile[i]);
 					App::GetSubmodule<ShaderCompiler>()->ForceCompilePermutation(assetInfo, permutationsToCompile[i]);
-				});
+				}, EThreadType::Worker, ETaskPriority::Background);
 
 			saveCacheJob->Join(job);
 			scheduler->Run(job);
@@ -804,12 +804,7 @@ Tasks::TaskPtr<ShaderSetPtr> ShaderCompiler::LoadShader(FileId uid, ShaderSetPtr
 
 			auto pShader = ShaderSetPtr::Make(m_allocator, uid, defines);
 
-			newPromise = Tasks::CreateTaskWithResult<ShaderSetPtr>("Load shader",
-				[pShader, this, permutation]()
-				{
-					UpdateRHIResource(pShader, permutation);
-					return pShader;
-				});
+			newPromise = LoadShaderAsync(pShader, permutation);
 
 			auto& shaders = m_loadedShaders.At_Lock(uid);
 
@@ -846,6 +841,14 @@ bool ShaderCompiler::LoadShader_Immediate(FileId uid, ShaderSetPtr& outShader, c
 	return task->GetResult().IsValid();
 }
 
+Tasks::Coroutine<ShaderSetPtr> ShaderCompiler::LoadShaderAsync(ShaderSetPtr pShader, uint32_t permutation)
+{
+	// The shaders are compiled and created on the worker thread,
+	// LoadShader_Immediate waits for the result from the frame graph nodes
+	UpdateRHIResource(pShader, permutation);
+	co_return pShader;
+}
+
 bool ShaderCompiler::UpdateRHIResource(ShaderSetPtr pShader, uint32_t permutation)
 {
 	SAILOR_PROFILE_FUNCTION();
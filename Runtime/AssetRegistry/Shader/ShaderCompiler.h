@@ -14,6 +14,7 @@
 #include "RHI/Types.h"
 #include "ShaderCache.h"
 #include "Tasks/Tasks.h"
+#include "Tasks/Coroutine.h"
 #include "Engine/Object.h"
 #include "Memory/ObjectPtr.hpp"
 #include "Memory/ObjectAllocator.hpp"
@@ -156,6 +157,7 @@ namespace Sailor
 		SAILOR_API static TVector<std::string> GetDefines(const TVector<std::string>& defines, uint32_t permutation);
 
 		SAILOR_API bool UpdateRHIResource(ShaderSetPtr shader, uint32_t permutation);
+		SAILOR_API Tasks::Coroutine<ShaderSetPtr> LoadShaderAsync(ShaderSetPtr shader, uint32_t permutation);
 
 		SAILOR_API void ReplaceTabsWithSpaces(AssetInfoPtr assetInfo) const;
 
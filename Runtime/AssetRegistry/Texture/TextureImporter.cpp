@@ -335,49 +335,8 @@ Tasks::TaskPtr<TexturePtr> TextureImporter::LoadTexture(FileId uid, TexturePtr&
 
 		TexturePtr pTexture = TexturePtr::Make(m_allocator, uid);
 
-		struct Data
-		{
-			ByteCode decodedData;
-			int32_t width;
-			int32_t height;
-			uint32_t mipLevels;
-			bool bIsImported;
-		};
-
-		promise = Tasks::CreateTaskWithResult<TSharedPtr<Data>>("Load Texture",
-			[pTexture, assetInfo]() mutable
-			{
-				TSharedPtr<Data> pData = TSharedPtr<Data>::Make();
-				pData->bIsImported = ImportTexture(assetInfo->GetFileId(), pData->decodedData, pData->width, pData->height, pData->mipLevels);
-
-				if (!pData->bIsImported)
-				{
-					SAILOR_LOG("Cannot Load texture: %s, with uid: %s", assetInfo->GetAssetFilepath().c_str(), assetInfo->GetFileId().ToString().c_str());
-				}
-
-				return pData;
-			})->Then<TexturePtr>([pTexture, assetInfo, this](TSharedPtr<Data> data) mutable
-				{
-					if (data->bIsImported && data->decodedData.Num() > 0)
-					{
-						pTexture->m_rhiTexture = RHI::Renderer::GetDriver()->CreateTexture(&data->decodedData[0], data->decodedData.Num(), glm::vec3(data->width, data->height, 1.0f),
-							data->mipLevels, RHI::ETextureType::Texture2D, assetInfo->GetFormat(), assetInfo->GetFiltration(),
-							assetInfo->GetClamping(),
-							assetInfo->ShouldSupportStorageBinding() ? (TextureImporter::DefaultTextureUsage | RHI::ETextureUsageBit::Storage_Bit) : TextureImporter::DefaultTextureUsage,
-							assetInfo->GetSamplerReduction());
-
-						RHI::Renderer::GetDriver()->SetDebugName(pTexture->m_rhiTexture, assetInfo->GetAssetFilepath());
-
-						size_t index = m_textureSamplersCurrentIndex++;
-
-						m_textureSamplersIndices.At_Lock(assetInfo->GetFileId()) = index;
-						m_textureSamplersIndices.Unlock(assetInfo->GetFileId());
-
-						RHI::Renderer::GetDriver()->UpdateShaderBinding(m_textureSamplersBindings, "textureSamplers", pTexture->m_rhiTexture, (uint32_t)index);
-					}
-
-					return pTexture;
-				}, "Create RHI texture", EThreadType::RHI)->ToTaskWithResult();
+		promise = LoadTextureAsync(pTexture, assetInfo);
+		promise->SetPriority(ETaskPriority::Background);
 
 			outTexture = loadedTexture = pTexture;
 			promise->Run();
@@ -396,6 +355,43 @@ Tasks::TaskPtr<TexturePtr> TextureImporter::LoadTexture(FileId uid, TexturePtr&
 	return Tasks::TaskPtr<TexturePtr>();
 }
 
+Tasks::Coroutine<TexturePtr> TextureImporter::LoadTextureAsync(TexturePtr pTexture, TextureAssetInfoPtr assetInfo)
+{
+	ByteCode decodedData;
+	int32_t width = 0;
+	int32_t height = 0;
+	uint32_t mipLevels = 0;
+
+	const bool bIsImported = ImportTexture(assetInfo->GetFileId(), decodedData, width, height, mipLevels);
+
+	if (!bIsImported)
+	{
+		SAILOR_LOG("Cannot Load texture: %s, with uid: %s", assetInfo->GetAssetFilepath().c_str(), assetInfo->GetFileId().ToString().c_str());
+	}
+
+	co_await Tasks::ResumeOn(EThreadType::RHI);
+
+	if (bIsImported && decodedData.Num() > 0)
+	{
+		pTexture->m_rhiTexture = RHI::Renderer::GetDriver()->CreateTexture(&decodedData[0], decodedData.Num(), glm::vec3(width, height, 1.0f),
+			mipLevels, RHI::ETextureType::Texture2D, assetInfo->GetFormat(), assetInfo->GetFiltration(),
+			assetInfo->GetClamping(),
+			assetInfo->ShouldSupportStorageBinding() ? (TextureImporter::DefaultTextureUsage | RHI::ETextureUsageBit::Storage_Bit) : TextureImporter::DefaultTextureUsage,
+			assetInfo->GetSamplerReduction());
+
+		RHI::Renderer::GetDriver()->SetDebugName(pTexture->m_rhiTexture, assetInfo->GetAssetFilepath());
+
+		size_t index = m_textureSamplersCurrentIndex++;
+
+		m_textureSamplersIndices.At_Lock(assetInfo->GetFileId()) = index;
+		m_textureSamplersIndices.Unlock(assetInfo->GetFileId());
+
+		RHI::Renderer::GetDriver()->UpdateShaderBinding(m_textureSamplersBindings, "textureSamplers", pTexture->m_rhiTexture, (uint32_t)index);
+	}
+
+	co_return pTexture;
+}
+
 size_t TextureImporter::GetTextureIndex(FileId uid)
 {
 	size_t res = m_textureSamplersIndices.At_Lock(uid);
@@ -16,6 +16,7 @@
 #include "Memory/ObjectPtr.hpp"
 #include "Memory/ObjectAllocator.hpp"
 #include "Tasks/Tasks.h"
+#include "Tasks/Coroutine.h"
 
 namespace Sailor
 {
@@ -82,6 +83,9 @@ namespace Sailor
 		Memory::ObjectAllocatorPtr m_allocator;
 
 		SAILOR_API bool IsTextureLoaded(FileId uid) const;
+
+		// Decodes the texture on the worker thread then creates the RHI texture on the RHI thread
+		SAILOR_API Tasks::Coroutine<TexturePtr> LoadTextureAsync(TexturePtr pTexture, TextureAssetInfoPtr assetInfo);
 		SAILOR_API static bool ImportTexture(FileId uid, ByteCode& decodedData, int32_t& width, int32_t& height, uint32_t& mipLevels);
 	};
 }
@@ -0,0 +1,591 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include "Core/Defines.h"
+#include "Math/Math.h"
+#include "Memory/Memory.h"
+#include "Containers/Concepts.h"
+#include "Containers/FlatMap.h"
+#include "Containers/Vector.h"
+#include "Containers/Pair.h"
+#include "Math/Bounds.h"
+
+namespace Sailor
+{
+	// Dynamic AABB tree (incremental BVH), inspired by Box2D's b2DynamicTree.
+	// Leaves store fattened bounds, so small movements don't touch the tree.
+	// The sibling for the new leaf is chosen by the surface area heuristic,
+	// the tree is kept balanced by rotations on the way up, so insert/remove/move are O(log n).
+	// Unlike the octree, huge and tiny objects are handled equally well.
+	// The queries test the tight bounds of the leaves, so the results are exact.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TAABBTree
+	{
+		static constexpr uint32_t InvalidNode = (uint32_t)-1;
+		static constexpr uint32_t MaxStackSize = 256;
+
+		struct Node
+		{
+			__forceinline bool IsLeaf() const { return m_child1 == InvalidNode; }
+
+			Math::AABB m_fat{};
+			Math::AABB m_tight{};
+
+			uint32_t m_parent = InvalidNode;
+			uint32_t m_child1 = InvalidNode;
+			uint32_t m_child2 = InvalidNode;
+
+			// Leaf = 0, released node = -1
+			int32_t m_height = -1;
+
+			TElementType m_element{};
+		};
+
+	public:
+
+		// The leaves are fattened by margin, the bigger margin the less updates but the more overlaps
+		TAABBTree(float margin = 0.1f) : m_margin(margin) {}
+
+		// Same signature as TOctree, the bounds are not limited
+		TAABBTree(glm::ivec3 center, uint32_t size, uint32_t minSize = 4) : TAABBTree((float)(std::max)(minSize, 1u) * 0.5f) {}
+
+		TAABBTree(const TAABBTree&) = default;
+		TAABBTree& operator=(const TAABBTree&) = default;
+		TAABBTree(TAABBTree&&) = default;
+		TAABBTree& operator=(TAABBTree&&) = default;
+		virtual ~TAABBTree() = default;
+
+		void Clear()
+		{
+			m_nodes.Clear();
+			m_freeNodes.Clear();
+			m_map.Clear();
+			m_root = InvalidNode;
+		}
+
+		bool Contains(const TElementType& element) const { return m_map.ContainsKey(element); }
+		size_t Num() const { return m_map.Num(); }
+		size_t NumNodes() const { return m_nodes.Num() - m_freeNodes.Num(); }
+		int32_t GetHeight() const { return m_root == InvalidNode ? 0 : m_nodes[m_root].m_height; }
+
+		bool Insert(const Math::AABB& aabb, const TElementType& element)
+		{
+			if (m_map.ContainsKey(element))
+			{
+				return false;
+			}
+
+			const uint32_t leaf = AllocateNode();
+
+			Node& node = m_nodes[leaf];
+			node.m_tight = aabb;
+			node.m_fat = Fatten(aabb);
+			node.m_height = 0;
+			node.m_element = element;
+
+			InsertLeaf(leaf);
+			m_map[element] = leaf;
+
+			return true;
+		}
+
+		// Inserts the element if it is missed.
+		// Returns true if the tree structure is changed
+		bool Update(const Math::AABB& aabb, const TElementType& element)
+		{
+			uint32_t* pLeaf = nullptr;
+			if (!m_map.Find(element, pLeaf))
+			{
+				return Insert(aabb, element);
+			}
+
+			const uint32_t leaf = *pLeaf;
+			Node& node = m_nodes[leaf];
+			node.m_tight = aabb;
+
+			if (Contains(node.m_fat, aabb))
+			{
+				return false;
+			}
+
+			RemoveLeaf(leaf);
+			m_nodes[leaf].m_fat = Fatten(aabb);
+			InsertLeaf(leaf);
+
+			return true;
+		}
+
+		bool Remove(const TElementType& element)
+		{
+			uint32_t* pLeaf = nullptr;
+			if (!m_map.Find(element, pLeaf))
+			{
+				return false;
+			}
+
+			const uint32_t leaf = *pLeaf;
+			m_map.Remove(element);
+
+			RemoveLeaf(leaf);
+			ReleaseNode(leaf);
+
+			return true;
+		}
+
+		// Same API as TOctree
+		__forceinline bool Insert(const glm::ivec3& pos, const glm::ivec3& extents, const TElementType& element) { return Insert(Math::AABB(glm::vec3(pos), glm::vec3(extents)), element); }
+		__forceinline bool Update(const glm::ivec3& pos, const glm::ivec3& extents, const TElementType& element) { Update(Math::AABB(glm::vec3(pos), glm::vec3(extents)), element); return true; }
+		__forceinline void Resolve() {}
+
+		void Trace(const Math::Frustum& frustum, TVector<TElementType>& outElements) const
+		{
+			outElements.Clear(false);
+			Query_Internal([&](const Math::AABB& aabb) { return frustum.OverlapsAABB(aabb); }, outElements);
+		}
+
+		void Query(const Math::AABB& bounds, TVector<TElementType>& outElements) const
+		{
+			outElements.Clear(false);
+			Query_Internal([&](const Math::AABB& aabb) { return Overlaps(aabb, bounds); }, outElements);
+		}
+
+		void Query(const Math::Sphere& sphere, TVector<TElementType>& outElements) const
+		{
+			outElements.Clear(false);
+			Query_Internal([&](const Math::AABB& aabb) { return Overlaps(aabb, sphere); }, outElements);
+		}
+
+		// The callback is called for each hit leaf as callback(element, distance) and returns the new max ray length,
+		// so return distance to find the closest hit, maxRayLength to gather all hits or 0 to stop.
+		template<typename TCallback>
+		void Raycast(const Math::Ray& ray, float maxRayLength, TCallback&& callback) const
+		{
+			if (m_root == InvalidNode)
+			{
+				return;
+			}
+
+			uint32_t stack[MaxStackSize];
+			uint32_t stackSize = 0;
+			stack[stackSize++] = m_root;
+
+			while (stackSize > 0)
+			{
+				const Node& node = m_nodes[stack[--stackSize]];
+
+				if (node.IsLeaf())
+				{
+					const float distance = IntersectRay(ray, node.m_tight, maxRayLength);
+					if (distance < maxRayLength)
+					{
+						maxRayLength = callback(node.m_element, distance);
+						if (maxRayLength <= 0.0f)
+						{
+							return;
+						}
+					}
+
+					continue;
+				}
+
+				if (IntersectRay(ray, node.m_fat, maxRayLength) < maxRayLength)
+				{
+					check(stackSize + 2 <= MaxStackSize);
+					stack[stackSize++] = node.m_child1;
+					stack[stackSize++] = node.m_child2;
+				}
+			}
+		}
+
+		bool RaycastClosest(const Math::Ray& ray, TElementType& outElement, float& outDistance, float maxRayLength = std::numeric_limits<float>::max()) const
+		{
+			bool bHit = false;
+			Raycast(ray, maxRayLength, [&](const TElementType& element, float distance)
+				{
+					bHit = true;
+					outElement = element;
+					outDistance = distance;
+					return distance;
+				});
+
+			return bHit;
+		}
+
+		template<typename TDebugContext>
+		void DrawTree(TDebugContext& context, float duration = 0.0f) const
+		{
+			for (const auto& node : m_nodes)
+			{
+				if (node.m_height >= 0)
+				{
+					const glm::vec4 color = node.IsLeaf() ? glm::vec4(0.2f, 1.0f, 0.2f, 1.0f) : glm::vec4(1.0f, 1.0f, 0.2f, 1.0f);
+					context.DrawAABB(node.m_fat, color, duration);
+				}
+			}
+		}
+
+	protected:
+
+		template<typename TPredicate>
+		void Query_Internal(TPredicate&& predicate, TVector<TElementType>& outElements) const
+		{
+			if (m_root == InvalidNode)
+			{
+				return;
+			}
+
+			uint32_t stack[MaxStackSize];
+			uint32_t stackSize = 0;
+			stack[stackSize++] = m_root;
+
+			while (stackSize > 0)
+			{
+				const Node& node = m_nodes[stack[--stackSize]];
+
+				if (node.IsLeaf())
+				{
+					if (predicate(node.m_tight))
+					{
+						outElements.Add(node.m_element);
+					}
+				}
+				else if (predicate(node.m_fat))
+				{
+					check(stackSize + 2 <= MaxStackSize);
+					stack[stackSize++] = node.m_child1;
+					stack[stackSize++] = node.m_child2;
+				}
+			}
+		}
+
+		static __forceinline Math::AABB Combine(const Math::AABB& lhs, const Math::AABB& rhs)
+		{
+			Math::AABB res;
+			res.m_min = glm::min(lhs.m_min, rhs.m_min);
+			res.m_max = glm::max(lhs.m_max, rhs.m_max);
+			return res;
+		}
+
+		static __forceinline float SurfaceArea(const Math::AABB& aabb)
+		{
+			const glm::vec3 e = aabb.m_max - aabb.m_min;
+			return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+		}
+
+		static __forceinline bool Contains(const Math::AABB& outer, const Math::AABB& inner)
+		{
+			return outer.m_min.x <= inner.m_min.x && outer.m_min.y <= inner.m_min.y && outer.m_min.z <= inner.m_min.z &&
+				outer.m_max.x >= inner.m_max.x && outer.m_max.y >= inner.m_max.y && outer.m_max.z >= inner.m_max.z;
+		}
+
+		static __forceinline bool Overlaps(const Math::AABB& lhs, const Math::AABB& rhs)
+		{
+			return lhs.m_min.x <= rhs.m_max.x && lhs.m_max.x >= rhs.m_min.x &&
+				lhs.m_min.y <= rhs.m_max.y && lhs.m_max.y >= rhs.m_min.y &&
+				lhs.m_min.z <= rhs.m_max.z && lhs.m_max.z >= rhs.m_min.z;
+		}
+
+		static __forceinline bool Overlaps(const Math::AABB& aabb, const Math::Sphere& sphere)
+		{
+			const glm::vec3 closest = glm::clamp(sphere.m_center, aabb.m_min, aabb.m_max);
+			const glm::vec3 delta = closest - sphere.m_center;
+			return glm::dot(delta, delta) <= sphere.m_radius * sphere.m_radius;
+		}
+
+		// Slab test, returns the distance to the entry point or max float
+		static __forceinline float IntersectRay(const Math::Ray& ray, const Math::AABB& aabb, float maxRayLength)
+		{
+			const glm::vec3 t1 = (aabb.m_min - ray.GetOrigin()) * ray.GetReciprocalDirection();
+			const glm::vec3 t2 = (aabb.m_max - ray.GetOrigin()) * ray.GetReciprocalDirection();
+
+			const glm::vec3 tMin = glm::min(t1, t2);
+			const glm::vec3 tMax = glm::max(t1, t2);
+
+			const float tEnter = (std::max)((std::max)(tMin.x, tMin.y), (std::max)(tMin.z, 0.0f));
+			const float tExit = (std::min)((std::min)(tMax.x, tMax.y), tMax.z);
+
+			return (tExit >= tEnter && tEnter < maxRayLength) ? tEnter : std::numeric_limits<float>::max();
+		}
+
+		__forceinline Math::AABB Fatten(const Math::AABB& aabb) const
+		{
+			Math::AABB res;
+			res.m_min = aabb.m_min - glm::vec3(m_margin);
+			res.m_max = aabb.m_max + glm::vec3(m_margin);
+			return res;
+		}
+
+		uint32_t AllocateNode()
+		{
+			if (m_freeNodes.Num())
+			{
+				const uint32_t index = *m_freeNodes.Last();
+				m_freeNodes.RemoveLast();
+				return index;
+			}
+
+			m_nodes.Add(Node());
+			return (uint32_t)m_nodes.Num() - 1;
+		}
+
+		void ReleaseNode(uint32_t index)
+		{
+			m_nodes[index] = Node();
+			m_freeNodes.Add(index);
+		}
+
+		void InsertLeaf(uint32_t leaf)
+		{
+			if (m_root == InvalidNode)
+			{
+				m_root = leaf;
+				m_nodes[leaf].m_parent = InvalidNode;
+				return;
+			}
+
+			// Find the best sibling
+			const Math::AABB leafAabb = m_nodes[leaf].m_fat;
+			uint32_t index = m_root;
+
+			while (!m_nodes[index].IsLeaf())
+			{
+				const Node& node = m_nodes[index];
+
+				const float area = SurfaceArea(node.m_fat);
+				const float combinedArea = SurfaceArea(Combine(node.m_fat, leafAabb));
+
+				// Cost of creating a new parent for this node and the new leaf
+				const float cost = 2.0f * combinedArea;
+
+				// Minimum cost of pushing the leaf further down the tree
+				const float inheritanceCost = 2.0f * (combinedArea - area);
+
+				const float cost1 = GetDescendCost(node.m_child1, leafAabb) + inheritanceCost;
+				const float cost2 = GetDescendCost(node.m_child2, leafAabb) + inheritanceCost;
+
+				if (cost < cost1 && cost < cost2)
+				{
+					break;
+				}
+
+				index = cost1 < cost2 ? node.m_child1 : node.m_child2;
+			}
+
+			const uint32_t sibling = index;
+
+			// Create a new parent
+			const uint32_t newParent = AllocateNode();
+			const uint32_t oldParent = m_nodes[sibling].m_parent;
+
+			Node& parent = m_nodes[newParent];
+			parent.m_parent = oldParent;
+			parent.m_fat = Combine(leafAabb, m_nodes[sibling].m_fat);
+			parent.m_height = m_nodes[sibling].m_height + 1;
+			parent.m_child1 = sibling;
+			parent.m_child2 = leaf;
+
+			if (oldParent != InvalidNode)
+			{
+				ReplaceChild(oldParent, sibling, newParent);
+			}
+			else
+			{
+				m_root = newParent;
+			}
+
+			m_nodes[sibling].m_parent = newParent;
+			m_nodes[leaf].m_parent = newParent;
+
+			Refit(m_nodes[leaf].m_parent);
+		}
+
+		void RemoveLeaf(uint32_t leaf)
+		{
+			if (leaf == m_root)
+			{
+				m_root = InvalidNode;
+				return;
+			}
+
+			const uint32_t parent = m_nodes[leaf].m_parent;
+			const uint32_t grandParent = m_nodes[parent].m_parent;
+			const uint32_t sibling = m_nodes[parent].m_child1 == leaf ? m_nodes[parent].m_child2 : m_nodes[parent].m_child1;
+
+			if (grandParent != InvalidNode)
+			{
+				ReplaceChild(grandParent, parent, sibling);
+				m_nodes[sibling].m_parent = grandParent;
+				ReleaseNode(parent);
+
+				Refit(grandParent);
+			}
+			else
+			{
+				m_root = sibling;
+				m_nodes[sibling].m_parent = InvalidNode;
+				ReleaseNode(parent);
+			}
+
+			m_nodes[leaf].m_parent = InvalidNode;
+		}
+
+		__forceinline float GetDescendCost(uint32_t index, const Math::AABB& leafAabb) const
+		{
+			const Node& node = m_nodes[index];
+			const float combinedArea = SurfaceArea(Combine(leafAabb, node.m_fat));
+			return node.IsLeaf() ? combinedArea : combinedArea - SurfaceArea(node.m_fat);
+		}
+
+		__forceinline void ReplaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild)
+		{
+			if (m_nodes[parent].m_child1 == oldChild)
+			{
+				m_nodes[parent].m_child1 = newChild;
+			}
+			else
+			{
+				m_nodes[parent].m_child2 = newChild;
+			}
+		}
+
+		// Balances and refits the ancestors
+		void Refit(uint32_t index)
+		{
+			while (index != InvalidNode)
+			{
+				index = Balance(index);
+
+				Node& node = m_nodes[index];
+				const Node& child1 = m_nodes[node.m_child1];
+				const Node& child2 = m_nodes[node.m_child2];
+
+				node.m_height = 1 + (std::max)(child1.m_height, child2.m_height);
+				node.m_fat = Combine(child1.m_fat, child2.m_fat);
+
+				index = node.m_parent;
+			}
+		}
+
+		// Performs the left or right rotation if the node A is imbalanced, returns the new root of the subtree
+		uint32_t Balance(uint32_t iA)
+		{
+			Node& A = m_nodes[iA];
+			if (A.IsLeaf() || A.m_height < 2)
+			{
+				return iA;
+			}
+
+			const uint32_t iB = A.m_child1;
+			const uint32_t iC = A.m_child2;
+			Node& B = m_nodes[iB];
+			Node& C = m_nodes[iC];
+
+			const int32_t balance = C.m_height - B.m_height;
+
+			// Rotate C up
+			if (balance > 1)
+			{
+				const uint32_t iF = C.m_child1;
+				const uint32_t iG = C.m_child2;
+				Node& F = m_nodes[iF];
+				Node& G = m_nodes[iG];
+
+				C.m_child1 = iA;
+				C.m_parent = A.m_parent;
+				A.m_parent = iC;
+
+				if (C.m_parent != InvalidNode)
+				{
+					ReplaceChild(C.m_parent, iA, iC);
+				}
+				else
+				{
+					m_root = iC;
+				}
+
+				if (F.m_height > G.m_height)
+				{
+					C.m_child2 = iF;
+					A.m_child2 = iG;
+					G.m_parent = iA;
+					A.m_fat = Combine(B.m_fat, G.m_fat);
+					C.m_fat = Combine(A.m_fat, F.m_fat);
+
+					A.m_height = 1 + (std::max)(B.m_height, G.m_height);
+					C.m_height = 1 + (std::max)(A.m_height, F.m_height);
+				}
+				else
+				{
+					C.m_child2 = iG;
+					A.m_child2 = iF;
+					F.m_parent = iA;
+					A.m_fat = Combine(B.m_fat, F.m_fat);
+					C.m_fat = Combine(A.m_fat, G.m_fat);
+
+					A.m_height = 1 + (std::max)(B.m_height, F.m_height);
+					C.m_height = 1 + (std::max)(A.m_height, G.m_height);
+				}
+
+				return iC;
+			}
+
+			// Rotate B up
+			if (balance < -1)
+			{
+				const uint32_t iD = B.m_child1;
+				const uint32_t iE = B.m_child2;
+				Node& D = m_nodes[iD];
+				Node& E = m_nodes[iE];
+
+				B.m_child1 = iA;
+				B.m_parent = A.m_parent;
+				A.m_parent = iB;
+
+				if (B.m_parent != InvalidNode)
+				{
+					ReplaceChild(B.m_parent, iA, iB);
+				}
+				else
+				{
+					m_root = iB;
+				}
+
+				if (D.m_height > E.m_height)
+				{
+					B.m_child2 = iD;
+					A.m_child1 = iE;
+					E.m_parent = iA;
+					A.m_fat = Combine(C.m_fat, E.m_fat);
+					B.m_fat = Combine(A.m_fat, D.m_fat);
+
+					A.m_height = 1 + (std::max)(C.m_height, E.m_height);
+					B.m_height = 1 + (std::max)(A.m_height, D.m_height);
+				}
+				else
+				{
+					B.m_child2 = iE;
+					A.m_child1 = iD;
+					D.m_parent = iA;
+					A.m_fat = Combine(C.m_fat, D.m_fat);
+					B.m_fat = Combine(A.m_fat, E.m_fat);
+
+					A.m_height = 1 + (std::max)(C.m_height, D.m_height);
+					B.m_height = 1 + (std::max)(A.m_height, E.m_height);
+				}
+
+				return iB;
+			}
+
+			return iA;
+		}
+
+		float m_margin = 0.1f;
+		uint32_t m_root = InvalidNode;
+
+		TVector<Node, TAllocator> m_nodes;
+		TVector<uint32_t, TAllocator> m_freeNodes;
+		TFlatMap<TElementType, uint32_t> m_map;
+	};
+}
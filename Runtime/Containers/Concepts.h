@@ -30,6 +30,14 @@ namespace Sailor
 	template<typename T>
 	concept IsTriviallyCopyable = std::is_trivially_copyable<T>::value;
 
+	// Opt-in via specialization for the types that could be moved as raw bytes without calling the destructor,
+	// i.e. the types that don't store the pointers to themselves (smart pointers, containers, handles)
+	template<typename T>
+	struct TIsTriviallyRelocatable : std::bool_constant<std::is_trivially_copyable<T>::value> {};
+
+	template<typename T>
+	concept IsTriviallyRelocatable = TIsTriviallyRelocatable<T>::value;
+
 	template<typename TBase, typename TDerived>
 	concept IsBaseOf = std::is_base_of<TBase, TDerived>::value;
 
@@ -0,0 +1,572 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <functional>
+#include <concepts>
+#include <type_traits>
+#include <atomic>
+#include <mutex>
+#include "Core/Defines.h"
+#include "Memory/Memory.h"
+#include "Memory/SlabAllocator.hpp"
+#include "Memory/EpochReclaimer.hpp"
+#include "Containers/Concepts.h"
+#include "Containers/Vector.h"
+#include "Containers/Hash.h"
+
+namespace Sailor
+{
+	// Read optimized concurrent hash map for the caches.
+	// Readers don't take any lock: they register in the epoch and walk the immutable nodes,
+	// writers lock the stripe of buckets, replace the nodes and retire the old ones.
+	// The retired nodes are released when no reader could observe them.
+	// The table grows incrementally: the buckets are migrated one by one by the following writes,
+	// readers follow the forwarding marker to the new table.
+	// Values are never modified inplace, so Find returns the copy of the value.
+	template<typename TKeyType, typename TValueType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TConcurrentHashMap final
+	{
+		static constexpr size_t NumStripes = 64;
+		static constexpr size_t MinNumBuckets = NumStripes;
+		static constexpr size_t MaxLoadFactor = 2;
+		static constexpr size_t MigrationBatch = 16;
+
+		struct Node
+		{
+			Node(size_t hash, const TKeyType& key, TValueType value) : m_hash(hash), m_key(key), m_value(std::move(value)) {}
+
+			const size_t m_hash;
+			const TKeyType m_key;
+			const TValueType m_value;
+			std::atomic<Node*> m_pNext = nullptr;
+		};
+
+		struct Table
+		{
+			size_t m_numBuckets = 0;
+			std::atomic<Node*>* m_buckets = nullptr;
+
+			// Resize state, m_pPrev is drained into this table
+			std::atomic<Table*> m_pPrev = nullptr;
+			Table* m_pNext = nullptr;
+			std::atomic<size_t> m_migrationCursor = 0;
+			std::atomic<size_t> m_numMigrated = 0;
+
+			__forceinline std::atomic<Node*>& GetBucket(size_t hash) const { return m_buckets[hash & (m_numBuckets - 1)]; }
+		};
+
+	public:
+
+		TConcurrentHashMap(size_t desiredNum = 0)
+		{
+			size_t numBuckets = MinNumBuckets;
+			while (numBuckets * MaxLoadFactor < desiredNum)
+			{
+				numBuckets *= 2;
+			}
+
+			m_pTable = CreateTable(numBuckets);
+		}
+
+		TConcurrentHashMap(const TConcurrentHashMap&) = delete;
+		TConcurrentHashMap& operator=(const TConcurrentHashMap&) = delete;
+
+		~TConcurrentHashMap()
+		{
+			Table* pTable = m_pTable.load();
+			if (Table* pPrev = pTable->m_pPrev.load())
+			{
+				DestroyTable(pPrev);
+			}
+			DestroyTable(pTable);
+		}
+
+		__forceinline size_t Num() const { return m_num.load(std::memory_order_relaxed); }
+		__forceinline bool IsEmpty() const { return Num() == 0; }
+
+		bool ContainsKey(const TKeyType& key) const
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+			return FindNode(key, HashKey(key)) != nullptr;
+		}
+
+		bool Find(const TKeyType& key, TValueType& outValue) const requires IsCopyConstructible<TValueType>
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+			if (const Node* pNode = FindNode(key, HashKey(key)))
+			{
+				outValue = pNode->m_value;
+				return true;
+			}
+			return false;
+		}
+
+		// The lambda is called while the node is protected, so the value could be read without the copy
+		template<typename TLambda>
+		bool Read(const TKeyType& key, TLambda&& lambda) const
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+			if (const Node* pNode = FindNode(key, HashKey(key)))
+			{
+				lambda(pNode->m_value);
+				return true;
+			}
+			return false;
+		}
+
+		// Inserts or replaces the value
+		void Insert(const TKeyType& key, TValueType value)
+		{
+			const size_t hash = HashKey(key);
+			Write(hash, [&](Table* pTable)
+				{
+					Replace(pTable, hash, key, &value);
+				});
+		}
+
+		// The factory is called under the stripe lock only if the key is missed,
+		// so the value is created once even if many threads request it at the same time
+		template<typename TFactory>
+		TValueType GetOrAdd(const TKeyType& key, TFactory&& factory) requires IsCopyConstructible<TValueType>
+		{
+			const size_t hash = HashKey(key);
+
+			{
+				Memory::EpochReclaimer::Guard guard(m_reclaimer);
+				if (const Node* pNode = FindNode(key, hash))
+				{
+					return pNode->m_value;
+				}
+			}
+
+			TValueType res{};
+			Write(hash, [&](Table* pTable)
+				{
+					for (Node* pNode = pTable->GetBucket(hash).load(std::memory_order_relaxed); pNode; pNode = pNode->m_pNext.load(std::memory_order_relaxed))
+					{
+						if (pNode->m_hash == hash && pNode->m_key == key)
+						{
+							res = pNode->m_value;
+							return;
+						}
+					}
+
+					TValueType value = factory();
+					res = value;
+					Replace(pTable, hash, key, &value);
+				});
+
+			return res;
+		}
+
+		bool Remove(const TKeyType& key)
+		{
+			const size_t hash = HashKey(key);
+			bool bRes = false;
+
+			Write(hash, [&](Table* pTable)
+				{
+					bRes = Replace(pTable, hash, key, nullptr);
+				});
+
+			return bRes;
+		}
+
+		// Not atomic with the concurrent writes, the stripes are cleared one by one.
+		// The values are released before the return if there are no concurrent readers,
+		// so the cached resources could be cleared before their owner is destroyed.
+		void Clear()
+		{
+			for (size_t stripe = 0; stripe < NumStripes; stripe++)
+			{
+				WriteStripe(stripe, [&](Table* pTable)
+					{
+						for (size_t i = stripe; i < pTable->m_numBuckets; i += NumStripes)
+						{
+							Node* pNode = pTable->m_buckets[i].exchange(nullptr, std::memory_order_release);
+							while (pNode)
+							{
+								Node* pNext = pNode->m_pNext.load(std::memory_order_relaxed);
+								RetireNode(pNode);
+								m_num.fetch_sub(1, std::memory_order_relaxed);
+								pNode = pNext;
+							}
+						}
+					});
+			}
+
+			m_reclaimer.Flush();
+		}
+
+		// The lambda gets (const TKeyType&, const TValueType&), concurrent writes could be missed or observed
+		template<typename TLambda>
+		void ForEach(TLambda&& lambda) const
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			Table* pTable = m_pTable.load(std::memory_order_acquire);
+			Table* pPrev = pTable->m_pPrev.load(std::memory_order_acquire);
+
+			// Only the buckets that were migrated before the old table is walked are visited in the new one,
+			// so the bucket that is migrated during the iteration is not visited twice
+			TVector<bool> migrated;
+			if (pPrev)
+			{
+				migrated.Resize(pPrev->m_numBuckets);
+
+				for (size_t i = 0; i < pPrev->m_numBuckets; i++)
+				{
+					Node* pNode = pPrev->m_buckets[i].load(std::memory_order_acquire);
+					if (pNode == Forwarded())
+					{
+						migrated[i] = true;
+						continue;
+					}
+
+					for (; pNode; pNode = pNode->m_pNext.load(std::memory_order_acquire))
+					{
+						lambda(pNode->m_key, pNode->m_value);
+					}
+				}
+			}
+
+			for (size_t i = 0; i < pTable->m_numBuckets; i++)
+			{
+				if (!pPrev || migrated[i & (pPrev->m_numBuckets - 1)])
+				{
+					ForEachInBucket(pTable, i, lambda);
+				}
+			}
+		}
+
+		TVector<TKeyType> GetKeys() const
+		{
+			TVector<TKeyType> res;
+			res.Reserve(Num());
+			ForEach([&](const TKeyType& key, const TValueType&) { res.Add(key); });
+			return res;
+		}
+
+		TVector<TValueType> GetValues() const
+		{
+			TVector<TValueType> res;
+			res.Reserve(Num());
+			ForEach([&](const TKeyType&, const TValueType& value) { res.Add(value); });
+			return res;
+		}
+
+	protected:
+
+		static __forceinline Node* Forwarded() { return reinterpret_cast<Node*>(uintptr_t(1)); }
+
+		static __forceinline size_t HashKey(const TKeyType& key)
+		{
+			const uint64_t h = (uint64_t)Sailor::GetHash(key) * 0x9E3779B97F4A7C15ull;
+			return (size_t)(h ^ (h >> 32));
+		}
+
+		// The table could start to grow during the iteration, the migrated bucket is split into two buckets of the next table
+		template<typename TLambda>
+		static void ForEachInBucket(const Table* pTable, size_t index, TLambda& lambda)
+		{
+			Node* pNode = pTable->m_buckets[index].load(std::memory_order_acquire);
+			if (pNode == Forwarded())
+			{
+				ForEachInBucket(pTable->m_pNext, index, lambda);
+				ForEachInBucket(pTable->m_pNext, index + pTable->m_numBuckets, lambda);
+				return;
+			}
+
+			for (; pNode; pNode = pNode->m_pNext.load(std::memory_order_acquire))
+			{
+				lambda(pNode->m_key, pNode->m_value);
+			}
+		}
+
+		// Starts from the table that is being drained and follows the forwarding markers
+		const Node* FindNode(const TKeyType& key, size_t hash) const
+		{
+			Table* pTable = m_pTable.load(std::memory_order_acquire);
+			if (Table* pPrev = pTable->m_pPrev.load(std::memory_order_acquire))
+			{
+				pTable = pPrev;
+			}
+
+			while (true)
+			{
+				Node* pNode = pTable->GetBucket(hash).load(std::memory_order_acquire);
+				if (pNode == Forwarded())
+				{
+					pTable = pTable->m_pNext;
+					continue;
+				}
+
+				for (; pNode; pNode = pNode->m_pNext.load(std::memory_order_acquire))
+				{
+					if (pNode->m_hash == hash && pNode->m_key == key)
+					{
+						return pNode;
+					}
+				}
+
+				return nullptr;
+			}
+		}
+
+		template<typename TLambda>
+		void Write(size_t hash, TLambda&& lambda)
+		{
+			WriteStripe(hash & (NumStripes - 1), std::forward<TLambda>(lambda));
+
+			HelpMigrate();
+			TryGrow();
+		}
+
+		// The stripe covers the same buckets in the old and the new tables since the tables are never smaller than NumStripes
+		template<typename TLambda>
+		void WriteStripe(size_t stripe, TLambda&& lambda)
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			Table* pFinished = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(m_locks[stripe]);
+
+				Table* pTable = m_pTable.load(std::memory_order_acquire);
+				if (Table* pPrev = pTable->m_pPrev.load(std::memory_order_acquire))
+				{
+					// Move the old buckets first, so the writes always go to the new table
+					for (size_t i = stripe; i < pPrev->m_numBuckets; i += NumStripes)
+					{
+						if (MigrateBucket(pPrev, i))
+						{
+							pFinished = pPrev;
+						}
+					}
+				}
+
+				lambda(pTable);
+			}
+
+			if (pFinished)
+			{
+				FinishMigration(pFinished);
+			}
+		}
+
+		// Copy on write: the node is never modified after it's published
+		bool Replace(Table* pTable, size_t hash, const TKeyType& key, TValueType* pValue)
+		{
+			std::atomic<Node*>* pLink = &pTable->GetBucket(hash);
+			Node* pNode = pLink->load(std::memory_order_relaxed);
+
+			check(pNode != Forwarded());
+
+			while (pNode && !(pNode->m_hash == hash && pNode->m_key == key))
+			{
+				pLink = &pNode->m_pNext;
+				pNode = pLink->load(std::memory_order_relaxed);
+			}
+
+			if (!pNode && !pValue)
+			{
+				return false;
+			}
+
+			Node* pNext = pNode ? pNode->m_pNext.load(std::memory_order_relaxed) : pTable->GetBucket(hash).load(std::memory_order_relaxed);
+
+			if (pValue)
+			{
+				Node* pNewNode = CreateNode(hash, key, std::move(*pValue));
+				pNewNode->m_pNext.store(pNext, std::memory_order_relaxed);
+
+				if (pNode)
+				{
+					pLink->store(pNewNode, std::memory_order_release);
+				}
+				else
+				{
+					pTable->GetBucket(hash).store(pNewNode, std::memory_order_release);
+					m_num.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				pLink->store(pNext, std::memory_order_release);
+				m_num.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			if (pNode)
+			{
+				RetireNode(pNode);
+			}
+
+			return true;
+		}
+
+		// Called under the stripe lock, returns true if the last bucket is migrated
+		bool MigrateBucket(Table* pPrev, size_t index)
+		{
+			std::atomic<Node*>& bucket = pPrev->m_buckets[index];
+			Node* pNode = bucket.load(std::memory_order_relaxed);
+
+			if (pNode == Forwarded())
+			{
+				return false;
+			}
+
+			// The old nodes could be walked by readers, so we copy them instead of relinking
+			Table* pNext = pPrev->m_pNext;
+			for (Node* pOld = pNode; pOld; pOld = pOld->m_pNext.load(std::memory_order_relaxed))
+			{
+				std::atomic<Node*>& newBucket = pNext->GetBucket(pOld->m_hash);
+
+				Node* pNewNode = CreateNode(pOld->m_hash, pOld->m_key, pOld->m_value);
+				pNewNode->m_pNext.store(newBucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				newBucket.store(pNewNode, std::memory_order_release);
+			}
+
+			// The nodes should be unreachable before they are retired
+			bucket.store(Forwarded(), std::memory_order_release);
+
+			while (pNode)
+			{
+				Node* pOld = pNode;
+				pNode = pNode->m_pNext.load(std::memory_order_relaxed);
+				RetireNode(pOld);
+			}
+
+			return ++pPrev->m_numMigrated == pPrev->m_numBuckets;
+		}
+
+		// Each write moves a few buckets of the old table, so there is no stop-the-world rehash
+		void HelpMigrate()
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			Table* pTable = m_pTable.load(std::memory_order_acquire);
+			Table* pPrev = pTable->m_pPrev.load(std::memory_order_acquire);
+
+			if (!pPrev)
+			{
+				return;
+			}
+
+			bool bFinished = false;
+			for (size_t i = 0; i < MigrationBatch; i++)
+			{
+				const size_t index = pPrev->m_migrationCursor.fetch_add(1, std::memory_order_relaxed);
+				if (index >= pPrev->m_numBuckets)
+				{
+					break;
+				}
+
+				std::lock_guard<std::mutex> lock(m_locks[index & (NumStripes - 1)]);
+				bFinished |= MigrateBucket(pPrev, index);
+			}
+
+			if (bFinished)
+			{
+				FinishMigration(pPrev);
+			}
+		}
+
+		void FinishMigration(Table* pPrev)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_resizeLock);
+				pPrev->m_pNext->m_pPrev.store(nullptr, std::memory_order_release);
+			}
+
+			m_reclaimer.Retire(pPrev, [](void* ptr) { DestroyTable(static_cast<Table*>(ptr)); });
+		}
+
+		void TryGrow()
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			Table* pTable = m_pTable.load(std::memory_order_acquire);
+			if (Num() <= pTable->m_numBuckets * MaxLoadFactor || pTable->m_pPrev.load(std::memory_order_acquire))
+			{
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(m_resizeLock, std::try_to_lock);
+			if (!lock.owns_lock())
+			{
+				return;
+			}
+
+			pTable = m_pTable.load(std::memory_order_acquire);
+			if (Num() <= pTable->m_numBuckets * MaxLoadFactor || pTable->m_pPrev.load(std::memory_order_acquire))
+			{
+				return;
+			}
+
+			Table* pNewTable = CreateTable(pTable->m_numBuckets * 2);
+			pNewTable->m_pPrev.store(pTable, std::memory_order_relaxed);
+			pTable->m_pNext = pNewTable;
+
+			m_pTable.store(pNewTable, std::memory_order_release);
+		}
+
+		Table* CreateTable(size_t numBuckets)
+		{
+			Table* pTable = new (TAllocator::allocate(sizeof(Table), alignof(Table))) Table();
+			pTable->m_numBuckets = numBuckets;
+			pTable->m_buckets = static_cast<std::atomic<Node*>*>(TAllocator::allocate(sizeof(std::atomic<Node*>) * numBuckets, alignof(std::atomic<Node*>)));
+
+			for (size_t i = 0; i < numBuckets; i++)
+			{
+				new (&pTable->m_buckets[i]) std::atomic<Node*>(nullptr);
+			}
+
+			return pTable;
+		}
+
+		static void DestroyTable(Table* pTable)
+		{
+			for (size_t i = 0; i < pTable->m_numBuckets; i++)
+			{
+				Node* pNode = pTable->m_buckets[i].load(std::memory_order_relaxed);
+				if (pNode == Forwarded())
+				{
+					continue;
+				}
+
+				while (pNode)
+				{
+					Node* pNext = pNode->m_pNext.load(std::memory_order_relaxed);
+					DestroyNode(pNode);
+					pNode = pNext;
+				}
+			}
+
+			TAllocator::free(pTable->m_buckets, sizeof(std::atomic<Node*>) * pTable->m_numBuckets);
+			pTable->~Table();
+			TAllocator::free(pTable, sizeof(Table));
+		}
+
+		static Node* CreateNode(size_t hash, const TKeyType& key, TValueType value)
+		{
+			void* ptr = Memory::TSmallObjectAllocator<TAllocator>::allocate(sizeof(Node), alignof(Node));
+			return new (ptr) Node(hash, key, std::move(value));
+		}
+
+		static void DestroyNode(Node* pNode)
+		{
+			pNode->~Node();
+			Memory::TSmallObjectAllocator<TAllocator>::free(pNode, sizeof(Node), alignof(Node));
+		}
+
+		__forceinline void RetireNode(Node* pNode) { m_reclaimer.Retire(pNode, [](void* ptr) { DestroyNode(static_cast<Node*>(ptr)); }); }
+
+		std::atomic<Table*> m_pTable = nullptr;
+		std::atomic<size_t> m_num = 0;
+
+		std::mutex m_locks[NumStripes];
+		std::mutex m_resizeLock;
+
+		Memory::EpochReclaimer m_reclaimer;
+	};
+}
@@ -0,0 +1,443 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Memory/Memory.h"
+#include "Memory/EpochReclaimer.hpp"
+
+namespace Sailor
+{
+	// Bounded lock-free MPMC queue (D. Vyukov), the capacity is rounded up to the power of 2.
+	// Each cell stores the sequence number, so producers and consumers contend only on their own position.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TBoundedConcurrentQueue final
+	{
+		struct Cell
+		{
+			std::atomic<size_t> m_sequence;
+			alignas(TElementType) uint8_t m_storage[sizeof(TElementType)];
+
+			__forceinline TElementType* Get() { return reinterpret_cast<TElementType*>(&m_storage[0]); }
+		};
+
+	public:
+
+		TBoundedConcurrentQueue(size_t capacity)
+		{
+			m_capacity = 2;
+			while (m_capacity < capacity)
+			{
+				m_capacity *= 2;
+			}
+
+			m_cells = static_cast<Cell*>(TAllocator::allocate(sizeof(Cell) * m_capacity, alignof(Cell)));
+			for (size_t i = 0; i < m_capacity; i++)
+			{
+				new (&m_cells[i].m_sequence) std::atomic<size_t>(i);
+			}
+		}
+
+		TBoundedConcurrentQueue(const TBoundedConcurrentQueue&) = delete;
+		TBoundedConcurrentQueue& operator=(const TBoundedConcurrentQueue&) = delete;
+
+		~TBoundedConcurrentQueue()
+		{
+			const size_t enqueuePos = m_enqueuePos.load();
+			for (size_t i = m_dequeuePos.load(); i != enqueuePos; i++)
+			{
+				m_cells[i & (m_capacity - 1)].Get()->~TElementType();
+			}
+
+			TAllocator::free(m_cells, sizeof(Cell) * m_capacity);
+		}
+
+		__forceinline size_t Capacity() const { return m_capacity; }
+
+		// Approximate under the contention
+		size_t Num() const
+		{
+			const size_t dequeuePos = m_dequeuePos.load(std::memory_order_relaxed);
+			const size_t enqueuePos = m_enqueuePos.load(std::memory_order_relaxed);
+			return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+		}
+
+		__forceinline bool IsEmpty() const { return Num() == 0; }
+
+		// Returns false if the queue is full
+		template<typename... TArgs>
+		bool TryEmplace(TArgs&& ... args)
+		{
+			size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Cell& cell = m_cells[pos & (m_capacity - 1)];
+				const size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+				const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+				if (diff == 0)
+				{
+					if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						new (cell.Get()) TElementType(std::forward<TArgs>(args)...);
+						cell.m_sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = m_enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		__forceinline bool TryPush(const TElementType& element) { return TryEmplace(element); }
+		__forceinline bool TryPush(TElementType&& element) { return TryEmplace(std::move(element)); }
+
+		// Returns false if the queue is empty
+		bool TryPop(TElementType& out)
+		{
+			size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Cell& cell = m_cells[pos & (m_capacity - 1)];
+				const size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+				const intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+				if (diff == 0)
+				{
+					if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						out = std::move(*cell.Get());
+						cell.Get()->~TElementType();
+						cell.m_sequence.store(pos + m_capacity, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = m_dequeuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+	protected:
+
+		Cell* m_cells = nullptr;
+		size_t m_capacity = 0;
+
+		alignas(64) std::atomic<size_t> m_enqueuePos = 0;
+		alignas(64) std::atomic<size_t> m_dequeuePos = 0;
+	};
+
+	// Unbounded lock-free MPMC queue, the chain of fixed size segments.
+	// Positions inside the segment are taken with fetch_add, so the producers don't retry under the contention.
+	// The consumer that outruns the producer marks the cell as taken and the producer moves to the next one.
+	// The drained segments are retired through the epoch reclamation.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator, size_t SegmentSize = 1024>
+	class TConcurrentQueue final
+	{
+		static_assert((SegmentSize & (SegmentSize - 1)) == 0, "Segment size must be a power of 2");
+
+		enum ECellState : uint32_t
+		{
+			Empty = 0,
+			Ready = 1,
+			Taken = 2
+		};
+
+		struct Cell
+		{
+			std::atomic<uint32_t> m_state = ECellState::Empty;
+			alignas(TElementType) uint8_t m_storage[sizeof(TElementType)];
+
+			__forceinline TElementType* Get() { return reinterpret_cast<TElementType*>(&m_storage[0]); }
+		};
+
+		struct Segment
+		{
+			alignas(64) std::atomic<size_t> m_enqueuePos = 0;
+			alignas(64) std::atomic<size_t> m_dequeuePos = 0;
+			alignas(64) std::atomic<Segment*> m_pNext = nullptr;
+			Cell m_cells[SegmentSize];
+		};
+
+	public:
+
+		TConcurrentQueue()
+		{
+			Segment* pSegment = CreateSegment();
+			m_pHead.store(pSegment);
+			m_pTail.store(pSegment);
+		}
+
+		TConcurrentQueue(const TConcurrentQueue&) = delete;
+		TConcurrentQueue& operator=(const TConcurrentQueue&) = delete;
+
+		~TConcurrentQueue()
+		{
+			Segment* pSegment = m_pHead.load();
+			while (pSegment)
+			{
+				Segment* pNext = pSegment->m_pNext.load();
+				DestroySegment(pSegment);
+				pSegment = pNext;
+			}
+		}
+
+		template<typename... TArgs>
+		void Emplace(TArgs&& ... args)
+		{
+			TElementType element(std::forward<TArgs>(args)...);
+			Push(std::move(element));
+		}
+
+		__forceinline void Push(const TElementType& element) { Push(TElementType(element)); }
+
+		void Push(TElementType&& element)
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			while (true)
+			{
+				Segment* pSegment = m_pTail.load(std::memory_order_acquire);
+				const size_t pos = pSegment->m_enqueuePos.fetch_add(1, std::memory_order_acq_rel);
+
+				if (pos < SegmentSize)
+				{
+					Cell& cell = pSegment->m_cells[pos];
+					new (cell.Get()) TElementType(std::move(element));
+
+					uint32_t state = ECellState::Empty;
+					if (cell.m_state.compare_exchange_strong(state, ECellState::Ready, std::memory_order_acq_rel))
+					{
+						return;
+					}
+
+					// The consumer has given up on this cell
+					element = std::move(*cell.Get());
+					cell.Get()->~TElementType();
+					continue;
+				}
+
+				// The segment is full, link the next one or help to advance the tail
+				Segment* pNext = pSegment->m_pNext.load(std::memory_order_acquire);
+				if (!pNext)
+				{
+					Segment* pNewSegment = CreateSegment();
+					if (pSegment->m_pNext.compare_exchange_strong(pNext, pNewSegment, std::memory_order_acq_rel))
+					{
+						pNext = pNewSegment;
+					}
+					else
+					{
+						DestroySegment(pNewSegment);
+					}
+				}
+
+				m_pTail.compare_exchange_strong(pSegment, pNext, std::memory_order_acq_rel);
+			}
+		}
+
+		// Returns false if the queue is empty
+		bool TryPop(TElementType& out)
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			while (true)
+			{
+				Segment* pSegment = m_pHead.load(std::memory_order_acquire);
+
+				// Don't burn the positions of an empty segment
+				const size_t dequeuePos = pSegment->m_dequeuePos.load(std::memory_order_acquire);
+				if (dequeuePos < SegmentSize && dequeuePos >= pSegment->m_enqueuePos.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+
+				const size_t pos = dequeuePos < SegmentSize ? pSegment->m_dequeuePos.fetch_add(1, std::memory_order_acq_rel) : dequeuePos;
+
+				if (pos < SegmentSize)
+				{
+					Cell& cell = pSegment->m_cells[pos];
+					if (cell.m_state.exchange(ECellState::Taken, std::memory_order_acq_rel) == ECellState::Ready)
+					{
+						out = std::move(*cell.Get());
+						cell.Get()->~TElementType();
+						return true;
+					}
+
+					// The producer hasn't finished yet, it will retry with the next cell
+					continue;
+				}
+
+				// The segment is drained
+				Segment* pNext = pSegment->m_pNext.load(std::memory_order_acquire);
+				if (!pNext)
+				{
+					return false;
+				}
+
+				// The tail shouldn't point to the retired segment
+				Segment* pTail = pSegment;
+				m_pTail.compare_exchange_strong(pTail, pNext, std::memory_order_acq_rel);
+
+				if (m_pHead.compare_exchange_strong(pSegment, pNext, std::memory_order_acq_rel))
+				{
+					m_reclaimer.Retire(pSegment, [](void* ptr) { DestroySegment(static_cast<Segment*>(ptr)); });
+				}
+			}
+		}
+
+		// Approximate under the contention
+		size_t Num() const
+		{
+			Memory::EpochReclaimer::Guard guard(m_reclaimer);
+
+			size_t res = 0;
+			for (Segment* pSegment = m_pHead.load(std::memory_order_acquire); pSegment; pSegment = pSegment->m_pNext.load(std::memory_order_acquire))
+			{
+				const size_t enqueuePos = std::min(pSegment->m_enqueuePos.load(std::memory_order_relaxed), SegmentSize);
+				const size_t dequeuePos = std::min(pSegment->m_dequeuePos.load(std::memory_order_relaxed), SegmentSize);
+				res += enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+			}
+
+			return res;
+		}
+
+		__forceinline bool IsEmpty() const { return Num() == 0; }
+
+	protected:
+
+		static Segment* CreateSegment()
+		{
+			return new (TAllocator::allocate(sizeof(Segment), alignof(Segment))) Segment();
+		}
+
+		static void DestroySegment(Segment* pSegment)
+		{
+			for (auto& cell : pSegment->m_cells)
+			{
+				if (cell.m_state.load(std::memory_order_relaxed) == ECellState::Ready)
+				{
+					cell.Get()->~TElementType();
+				}
+			}
+
+			pSegment->~Segment();
+			TAllocator::free(pSegment, sizeof(Segment));
+		}
+
+		alignas(64) std::atomic<Segment*> m_pHead = nullptr;
+		alignas(64) std::atomic<Segment*> m_pTail = nullptr;
+
+		// The segments are retired rarely and they are heavy
+		Memory::EpochReclaimer m_reclaimer{ 2 };
+	};
+
+	// Bounded wait-free single producer single consumer ring.
+	// Each side caches the position of the other one to avoid touching the shared cache line on every call.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TSpscQueue final
+	{
+	public:
+
+		TSpscQueue(size_t capacity)
+		{
+			m_capacity = 2;
+			while (m_capacity < capacity)
+			{
+				m_capacity *= 2;
+			}
+
+			m_elements = static_cast<TElementType*>(TAllocator::allocate(sizeof(TElementType) * m_capacity, alignof(TElementType)));
+		}
+
+		TSpscQueue(const TSpscQueue&) = delete;
+		TSpscQueue& operator=(const TSpscQueue&) = delete;
+
+		~TSpscQueue()
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			for (size_t i = m_head.load(std::memory_order_relaxed); i != tail; i++)
+			{
+				m_elements[i & (m_capacity - 1)].~TElementType();
+			}
+
+			TAllocator::free(m_elements, sizeof(TElementType) * m_capacity);
+		}
+
+		__forceinline size_t Capacity() const { return m_capacity; }
+		__forceinline size_t Num() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		__forceinline bool IsEmpty() const { return Num() == 0; }
+
+		// Producer side, returns false if the queue is full
+		template<typename... TArgs>
+		bool TryEmplace(TArgs&& ... args)
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cachedHead == m_capacity)
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == m_capacity)
+				{
+					return false;
+				}
+			}
+
+			new (&m_elements[tail & (m_capacity - 1)]) TElementType(std::forward<TArgs>(args)...);
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		__forceinline bool TryPush(const TElementType& element) { return TryEmplace(element); }
+		__forceinline bool TryPush(TElementType&& element) { return TryEmplace(std::move(element)); }
+
+		// Consumer side, returns false if the queue is empty
+		bool TryPop(TElementType& out)
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_cachedTail)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cachedTail)
+				{
+					return false;
+				}
+			}
+
+			TElementType& element = m_elements[head & (m_capacity - 1)];
+			out = std::move(element);
+			element.~TElementType();
+
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+	protected:
+
+		TElementType* m_elements = nullptr;
+		size_t m_capacity = 0;
+
+		// Consumer
+		alignas(64) std::atomic<size_t> m_head = 0;
+		size_t m_cachedTail = 0;
+
+		// Producer
+		alignas(64) std::atomic<size_t> m_tail = 0;
+		size_t m_cachedHead = 0;
+	};
+
+	SAILOR_API void RunQueueBenchmark();
+}
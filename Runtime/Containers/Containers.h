@@ -3,10 +3,17 @@
 #include "Containers/Concepts.h"
 #include "Containers/Pair.h"
 #include "Containers/List.h"
+#include "Containers/IntrusiveList.h"
 #include "Containers/Set.h"
 #include "Containers/Map.h"
+#include "Containers/FlatSet.h"
+#include "Containers/FlatMap.h"
 #include "Containers/ConcurrentSet.h"
 #include "Containers/ConcurrentMap.h"
+#include "Containers/ConcurrentHashMap.h"
+#include "Containers/ConcurrentQueue.h"
+#include "Containers/SlotMap.h"
 #include "Containers/Vector.h"
+#include "Containers/InlineVector.h"
 #include "Memory/LockFreeHeapAllocator.h"
 #include "Memory/MallocAllocator.hpp"
@@ -0,0 +1,26 @@
+#include "ContainersBenchmark.h"
+
+using namespace Sailor;
+
+void Sailor::RegisterContainersBenchmarks(Benchmark::Runner& runner)
+{
+	RegisterVectorBenchmarks(runner);
+	RegisterSetBenchmarks(runner);
+	RegisterMapBenchmarks(runner);
+	RegisterListBenchmarks(runner);
+	RegisterOctreeBenchmarks(runner);
+	RegisterSlotMapBenchmarks(runner);
+}
+
+void Sailor::RunContainersBenchmark()
+{
+	printf("\nStarting containers benchmark...\n");
+
+	Benchmark::Runner runner;
+	RegisterContainersBenchmarks(runner);
+
+	const Benchmark::Report report = runner.Run(Benchmark::Settings());
+
+	Benchmark::Print(report);
+	Benchmark::WriteJson("containersBenchmark.json", report);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "Core/Defines.h"
+#include "Core/Benchmark.h"
+
+namespace Sailor
+{
+	// The suites register the sanity checks and the cases, the names start with the suite name: 'vector/...', 'map/...'
+	SAILOR_API void RegisterVectorBenchmarks(Benchmark::Runner& runner);
+	SAILOR_API void RegisterSetBenchmarks(Benchmark::Runner& runner);
+	SAILOR_API void RegisterMapBenchmarks(Benchmark::Runner& runner);
+	SAILOR_API void RegisterListBenchmarks(Benchmark::Runner& runner);
+	SAILOR_API void RegisterOctreeBenchmarks(Benchmark::Runner& runner);
+	SAILOR_API void RegisterSlotMapBenchmarks(Benchmark::Runner& runner);
+
+	SAILOR_API void RegisterContainersBenchmarks(Benchmark::Runner& runner);
+
+	// Runs all suites and writes containersBenchmark.json
+	SAILOR_API void RunContainersBenchmark();
+}
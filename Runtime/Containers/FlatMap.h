@@ -0,0 +1,282 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <functional>
+#include <concepts>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Containers/Vector.h"
+#include "Containers/FlatSet.h"
+#include "Containers/Pair.h"
+
+namespace Sailor
+{
+	namespace Internal
+	{
+		template<typename TKeyType, typename TValueType>
+		struct TFlatMapSlot
+		{
+			TKeyType m_first;
+			TValueType m_second;
+
+			static __forceinline const TKeyType& Get(const TFlatMapSlot& slot) { return slot.m_first; }
+		};
+	}
+
+	// Open addressing hash map with the same API as TMap.
+	// Keys and values are stored inplace, so the pointers to values are invalidated on rehash.
+	template<typename TKeyType, typename TValueType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TFlatMap final : public Internal::TFlatHashTable<TKeyType, Internal::TFlatMapSlot<TKeyType, TValueType>, Internal::TFlatMapSlot<TKeyType, TValueType>, TAllocator>
+	{
+	public:
+
+		using TSlot = Internal::TFlatMapSlot<TKeyType, TValueType>;
+		using Super = Internal::TFlatHashTable<TKeyType, TSlot, TSlot, TAllocator>;
+
+		template<typename TDataType>
+		class SAILOR_API TBaseIterator
+		{
+		public:
+
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = TDataType;
+			using difference_type = int64_t;
+			using pointer = TDataType*;
+			using reference = TDataType&;
+
+			TBaseIterator() = default;
+			TBaseIterator(const TBaseIterator&) = default;
+			TBaseIterator(TBaseIterator&&) = default;
+			~TBaseIterator() = default;
+
+			TBaseIterator(const TFlatMap* map, size_t index) : m_map(const_cast<TFlatMap*>(map)), m_index(index) {}
+
+			operator TBaseIterator<const TDataType>() { return TBaseIterator<const TDataType>(m_map, m_index); }
+
+			TBaseIterator& operator=(const TBaseIterator& rhs) = default;
+			TBaseIterator& operator=(TBaseIterator&& rhs) = default;
+
+			bool operator==(const TBaseIterator& rhs) const { return m_index == rhs.m_index; }
+			bool operator!=(const TBaseIterator& rhs) const { return m_index != rhs.m_index; }
+
+			TPair<TKeyType, TValueType*> operator*() { return TPair<TKeyType, TValueType*>(Key(), &Value()); }
+			TPair<TKeyType, const TValueType*> operator*() const { return TPair<TKeyType, const TValueType*>(Key(), &Value()); }
+
+			const TKeyType& Key() const { return m_map->m_slots[m_index].m_first; }
+
+			TValueType& Value() { return m_map->m_slots[m_index].m_second; }
+			const TValueType& Value() const { return m_map->m_slots[m_index].m_second; }
+
+			TBaseIterator& operator++()
+			{
+				m_index = m_map->NextFull(m_index + 1);
+				return *this;
+			}
+
+			TBaseIterator& operator--()
+			{
+				m_index = m_map->PrevFull(m_index);
+				return *this;
+			}
+
+		protected:
+
+			TFlatMap* m_map = nullptr;
+			size_t m_index = 0;
+		};
+
+		using TIterator = TBaseIterator<TSlot>;
+		using TConstIterator = TBaseIterator<const TSlot>;
+
+		TFlatMap(const uint32_t desiredNumBuckets = 16) { Super::Reserve(desiredNumBuckets); }
+
+		TFlatMap(std::initializer_list<TPair<TKeyType, TValueType>> initList) : TFlatMap((uint32_t)initList.size())
+		{
+			for (const auto& el : initList)
+			{
+				Insert(el.m_first, el.m_second);
+			}
+		}
+
+		TFlatMap(const TFlatMap&) = default;
+		TFlatMap& operator=(const TFlatMap&) = default;
+
+		TFlatMap(TFlatMap&&) = default;
+		TFlatMap& operator=(TFlatMap&&) noexcept = default;
+
+		~TFlatMap() = default;
+
+		void Add(const TKeyType& key, const TValueType& value) requires IsCopyConstructible<TValueType>
+		{
+			Insert(key, value);
+		}
+
+		void Add(const TKeyType& key, TValueType&& value) requires IsMoveConstructible<TValueType>
+		{
+			Insert(key, std::move(value));
+		}
+
+		// The value is overwritten if the key is already presented
+		void Insert(const TKeyType& key, const TValueType& value) requires IsCopyConstructible<TValueType>
+		{
+			const size_t hash = Super::HashKey(key);
+			const size_t index = Super::FindIndex(key, hash);
+
+			if (index != Super::m_capacity)
+			{
+				Super::m_slots[index].m_second = value;
+				return;
+			}
+
+			const size_t newIndex = Super::PrepareInsert(hash);
+			new (&Super::m_slots[newIndex]) TSlot{ key, value };
+		}
+
+		void Insert(const TKeyType& key, TValueType&& value) requires IsMoveConstructible<TValueType>
+		{
+			const size_t hash = Super::HashKey(key);
+			const size_t index = Super::FindIndex(key, hash);
+
+			if (index != Super::m_capacity)
+			{
+				Super::m_slots[index].m_second = std::move(value);
+				return;
+			}
+
+			const size_t newIndex = Super::PrepareInsert(hash);
+			new (&Super::m_slots[newIndex]) TSlot{ key, std::move(value) };
+		}
+
+		bool Remove(const TKeyType& key)
+		{
+			const size_t index = Super::FindIndex(key, Super::HashKey(key));
+			if (index != Super::m_capacity)
+			{
+				Super::EraseAt(index);
+				return true;
+			}
+			return false;
+		}
+
+		TValueType& UpdateKey(const TKeyType& key)
+		{
+			TSlot& slot = GetOrAdd(key);
+			slot.m_first = key;
+			return slot.m_second;
+		}
+
+		__forceinline TValueType& operator[] (const TKeyType& key)
+		{
+			return GetOrAdd(key).m_second;
+		}
+
+		const TValueType& operator[] (const TKeyType& key) const
+		{
+			const size_t index = Super::FindIndex(key, Super::HashKey(key));
+			check(index != Super::m_capacity);
+			return Super::m_slots[index].m_second;
+		}
+
+		void Clear(uint32_t desiredBucketsNum = 8) { Super::Clear(desiredBucketsNum); }
+
+		bool Find(const TKeyType& key, TValueType*& out)
+		{
+			const size_t index = Super::FindIndex(key, Super::HashKey(key));
+			if (index != Super::m_capacity)
+			{
+				out = &Super::m_slots[index].m_second;
+				return true;
+			}
+			return false;
+		}
+
+		bool Find(const TKeyType& key, TValueType const*& out) const
+		{
+			const size_t index = Super::FindIndex(key, Super::HashKey(key));
+			if (index != Super::m_capacity)
+			{
+				out = &Super::m_slots[index].m_second;
+				return true;
+			}
+			return false;
+		}
+
+		__forceinline TIterator Find(const TKeyType& key) { return TIterator(this, Super::FindIndex(key, Super::HashKey(key))); }
+		__forceinline TConstIterator Find(const TKeyType& key) const { return TConstIterator(this, Super::FindIndex(key, Super::HashKey(key))); }
+
+		__forceinline bool ContainsKey(const TKeyType& key) const
+		{
+			return Super::FindIndex(key, Super::HashKey(key)) != Super::m_capacity;
+		}
+
+		bool ContainsValue(const TValueType& value) const
+		{
+			for (size_t i = 0; i < Super::m_capacity; i++)
+			{
+				if (Super::IsFull(Super::m_ctrl[i]) && Super::m_slots[i].m_second == value)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		TVector<TKeyType> GetKeys() const
+		{
+			TVector<TKeyType> res;
+			res.Reserve(Super::Num());
+
+			for (size_t i = 0; i < Super::m_capacity; i++)
+			{
+				if (Super::IsFull(Super::m_ctrl[i]))
+				{
+					res.Add(Super::m_slots[i].m_first);
+				}
+			}
+
+			return res;
+		}
+
+		TVector<TValueType> GetValues() const
+		{
+			TVector<TValueType> res;
+			res.Reserve(Super::Num());
+
+			for (size_t i = 0; i < Super::m_capacity; i++)
+			{
+				if (Super::IsFull(Super::m_ctrl[i]))
+				{
+					res.Add(Super::m_slots[i].m_second);
+				}
+			}
+
+			return res;
+		}
+
+		// Support ranged for
+		TIterator begin() { return TIterator(this, Super::NextFull(0)); }
+		TIterator end() { return TIterator(this, Super::m_capacity); }
+
+		TConstIterator begin() const { return TConstIterator(this, Super::NextFull(0)); }
+		TConstIterator end() const { return TConstIterator(this, Super::m_capacity); }
+
+	protected:
+
+		TSlot& GetOrAdd(const TKeyType& key)
+		{
+			const size_t hash = Super::HashKey(key);
+			const size_t index = Super::FindIndex(key, hash);
+
+			if (index != Super::m_capacity)
+			{
+				return Super::m_slots[index];
+			}
+
+			// PrepareInsert could rehash, so m_slots should be read after
+			const size_t newIndex = Super::PrepareInsert(hash);
+
+			// TODO: rethink the approach when default constructor is missed
+			return *new (&Super::m_slots[newIndex]) TSlot{ key, TValueType() };
+		}
+	};
+}
@@ -0,0 +1,590 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <functional>
+#include <concepts>
+#include <type_traits>
+#include <bit>
+#include <cstring>
+#include "Core/Defines.h"
+#include "Memory/Memory.h"
+#include "Containers/Concepts.h"
+#include "Containers/Vector.h"
+#include "Containers/Hash.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAILOR_FLAT_HASH_TABLE_SSE2
+#endif
+
+namespace Sailor
+{
+	namespace Internal
+	{
+		// Swiss table: open addressing with the separate array of control bytes.
+		// Each control byte is either empty/deleted or keeps 7 bits of the element's hash,
+		// so the group of 16 slots is probed with a single SIMD compare before touching the elements.
+		// The elements are stored contiguously and never allocated one by one.
+		template<typename TKeyType, typename TSlotType, typename TKeyOf, typename TAllocator>
+		class TFlatHashTable
+		{
+		protected:
+
+			using TControl = int8_t;
+
+			static constexpr TControl Empty = -128;
+			static constexpr TControl Deleted = -2;
+			static constexpr size_t GroupWidth = 16;
+			static constexpr size_t MinCapacity = 16;
+
+			struct Group
+			{
+				Group(const TControl* pCtrl)
+				{
+#ifdef SAILOR_FLAT_HASH_TABLE_SSE2
+					m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCtrl));
+#else
+					memcpy(m_ctrl, pCtrl, GroupWidth);
+#endif
+				}
+
+				// Bit per slot that contains h2
+				__forceinline uint32_t Match(TControl h2) const
+				{
+#ifdef SAILOR_FLAT_HASH_TABLE_SSE2
+					return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl));
+#else
+					uint32_t mask = 0;
+					for (uint32_t i = 0; i < GroupWidth; i++)
+					{
+						mask |= (uint32_t)(m_ctrl[i] == h2) << i;
+					}
+					return mask;
+#endif
+				}
+
+				__forceinline uint32_t MatchEmpty() const { return Match(Empty); }
+
+				// Empty and deleted slots have the sign bit set
+				__forceinline uint32_t MatchEmptyOrDeleted() const
+				{
+#ifdef SAILOR_FLAT_HASH_TABLE_SSE2
+					return (uint32_t)_mm_movemask_epi8(m_ctrl);
+#else
+					uint32_t mask = 0;
+					for (uint32_t i = 0; i < GroupWidth; i++)
+					{
+						mask |= (uint32_t)(m_ctrl[i] < 0) << i;
+					}
+					return mask;
+#endif
+				}
+
+#ifdef SAILOR_FLAT_HASH_TABLE_SSE2
+				__m128i m_ctrl;
+#else
+				TControl m_ctrl[GroupWidth];
+#endif
+			};
+
+		public:
+
+			TFlatHashTable() = default;
+
+			TFlatHashTable(const TFlatHashTable& rhs) requires IsCopyConstructible<TSlotType>
+			{
+				Reserve(rhs.m_num);
+				for (size_t i = 0; i < rhs.m_capacity; i++)
+				{
+					if (IsFull(rhs.m_ctrl[i]))
+					{
+						const TSlotType& slot = rhs.m_slots[i];
+						const size_t index = PrepareInsert(HashKey(TKeyOf::Get(slot)));
+						new (&m_slots[index]) TSlotType(slot);
+					}
+				}
+			}
+
+			TFlatHashTable(TFlatHashTable&& rhs) noexcept { Swap(*this, rhs); }
+
+			TFlatHashTable& operator=(const TFlatHashTable& rhs) requires IsCopyConstructible<TSlotType>
+			{
+				if (this != &rhs)
+				{
+					TFlatHashTable copy(rhs);
+					Swap(*this, copy);
+				}
+				return *this;
+			}
+
+			TFlatHashTable& operator=(TFlatHashTable&& rhs) noexcept
+			{
+				TFlatHashTable tmp(std::move(rhs));
+				Swap(*this, tmp);
+				return *this;
+			}
+
+			~TFlatHashTable() { Release(); }
+
+			__forceinline bool IsEmpty() const { return m_num == 0; }
+			__forceinline size_t Num() const { return m_num; }
+			__forceinline size_t Capacity() const { return m_capacity; }
+
+			void Reserve(size_t num)
+			{
+				if (num > GetMaxLoad(m_capacity) - m_numDeleted)
+				{
+					Rehash(GetCapacityForNum(num));
+				}
+			}
+
+			void Clear(size_t desiredNum = 0)
+			{
+				Release();
+				Reserve(desiredNum);
+			}
+
+			static void Swap(TFlatHashTable& lhs, TFlatHashTable& rhs)
+			{
+				std::swap(lhs.m_ctrl, rhs.m_ctrl);
+				std::swap(lhs.m_slots, rhs.m_slots);
+				std::swap(lhs.m_capacity, rhs.m_capacity);
+				std::swap(lhs.m_num, rhs.m_num);
+				std::swap(lhs.m_numDeleted, rhs.m_numDeleted);
+				std::swap(lhs.m_allocator, rhs.m_allocator);
+			}
+
+		protected:
+
+			static __forceinline bool IsFull(TControl ctrl) { return ctrl >= 0; }
+
+			static __forceinline size_t HashKey(const TKeyType& key)
+			{
+				// std::hash is identity for integers on some platforms, mix the bits to get useful h2
+				const uint64_t h = (uint64_t)Sailor::GetHash(key) * 0x9E3779B97F4A7C15ull;
+				return (size_t)(h ^ (h >> 32));
+			}
+
+			static __forceinline size_t H1(size_t hash) { return hash >> 7; }
+			static __forceinline TControl H2(size_t hash) { return (TControl)(hash & 0x7F); }
+
+			static __forceinline size_t GetMaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+			static size_t GetCapacityForNum(size_t num)
+			{
+				size_t capacity = MinCapacity;
+				while (GetMaxLoad(capacity) < num)
+				{
+					capacity *= 2;
+				}
+				return capacity;
+			}
+
+			// The first group is mirrored after the last slot, so the group could be loaded from any position
+			__forceinline void SetCtrl(size_t index, TControl ctrl)
+			{
+				m_ctrl[index] = ctrl;
+				if (index < GroupWidth)
+				{
+					m_ctrl[m_capacity + index] = ctrl;
+				}
+			}
+
+			size_t FindIndex(const TKeyType& key, size_t hash) const
+			{
+				if (m_capacity == 0)
+				{
+					return m_capacity;
+				}
+
+				const size_t mask = m_capacity - 1;
+				const TControl h2 = H2(hash);
+
+				size_t pos = H1(hash) & mask;
+				size_t step = 0;
+
+				while (true)
+				{
+					const Group group(m_ctrl + pos);
+
+					for (uint32_t match = group.Match(h2); match; match &= match - 1)
+					{
+						const size_t index = (pos + std::countr_zero(match)) & mask;
+						if (TKeyOf::Get(m_slots[index]) == key)
+						{
+							return index;
+						}
+					}
+
+					if (group.MatchEmpty())
+					{
+						return m_capacity;
+					}
+
+					// Triangular probing visits each group once, since the capacity is the power of 2
+					step += GroupWidth;
+					pos = (pos + step) & mask;
+
+					check(step <= m_capacity);
+				}
+			}
+
+			size_t FindFreeSlot(size_t hash) const
+			{
+				const size_t mask = m_capacity - 1;
+				size_t pos = H1(hash) & mask;
+				size_t step = 0;
+
+				while (true)
+				{
+					const Group group(m_ctrl + pos);
+					if (const uint32_t match = group.MatchEmptyOrDeleted())
+					{
+						return (pos + std::countr_zero(match)) & mask;
+					}
+
+					step += GroupWidth;
+					pos = (pos + step) & mask;
+				}
+			}
+
+			// Marks the slot as full and returns its index, the caller constructs the element
+			size_t PrepareInsert(size_t hash)
+			{
+				if (m_num + m_numDeleted >= GetMaxLoad(m_capacity))
+				{
+					// Too much tombstones, clean up them instead of growing
+					const size_t capacity = m_capacity && m_num < GetMaxLoad(m_capacity) / 2 ? m_capacity : GetCapacityForNum(m_num + 1);
+					Rehash(capacity < MinCapacity ? MinCapacity : capacity);
+				}
+
+				const size_t index = FindFreeSlot(hash);
+				if (m_ctrl[index] == Deleted)
+				{
+					m_numDeleted--;
+				}
+
+				SetCtrl(index, H2(hash));
+				m_num++;
+
+				return index;
+			}
+
+			void EraseAt(size_t index)
+			{
+				check(IsFull(m_ctrl[index]));
+
+				m_slots[index].~TSlotType();
+				m_num--;
+
+				// The slot could be marked as empty if the probe sequence has never passed through the full group here
+				const size_t mask = m_capacity - 1;
+				const Group before(m_ctrl + ((index - GroupWidth) & mask));
+				const Group after(m_ctrl + index);
+
+				const uint32_t emptyBefore = before.MatchEmpty();
+				const uint32_t emptyAfter = after.MatchEmpty();
+
+				const bool bWasNeverFull = emptyBefore && emptyAfter &&
+					(std::countr_zero(emptyAfter) + std::countl_zero(emptyBefore << 16)) < GroupWidth;
+
+				if (bWasNeverFull)
+				{
+					SetCtrl(index, Empty);
+				}
+				else
+				{
+					SetCtrl(index, Deleted);
+					m_numDeleted++;
+				}
+			}
+
+			void Rehash(size_t newCapacity)
+			{
+				check((newCapacity & (newCapacity - 1)) == 0 && newCapacity >= m_num);
+
+				TControl* pOldCtrl = m_ctrl;
+				TSlotType* pOldSlots = m_slots;
+				const size_t oldCapacity = m_capacity;
+
+				const size_t ctrlBytes = AlignUp(newCapacity + GroupWidth, alignof(TSlotType));
+				uint8_t* pData = static_cast<uint8_t*>(m_allocator.Allocate(ctrlBytes + newCapacity * sizeof(TSlotType), std::max(alignof(TSlotType), (size_t)8)));
+
+				m_ctrl = reinterpret_cast<TControl*>(pData);
+				m_slots = reinterpret_cast<TSlotType*>(pData + ctrlBytes);
+				m_capacity = newCapacity;
+				m_numDeleted = 0;
+
+				memset(m_ctrl, Empty, newCapacity + GroupWidth);
+
+				for (size_t i = 0; i < oldCapacity; i++)
+				{
+					if (IsFull(pOldCtrl[i]))
+					{
+						const size_t hash = HashKey(TKeyOf::Get(pOldSlots[i]));
+						const size_t index = FindFreeSlot(hash);
+						SetCtrl(index, H2(hash));
+
+						new (&m_slots[index]) TSlotType(std::move(pOldSlots[i]));
+						pOldSlots[i].~TSlotType();
+					}
+				}
+
+				if (pOldCtrl)
+				{
+					m_allocator.Free(pOldCtrl);
+				}
+			}
+
+			void Release()
+			{
+				if (!m_ctrl)
+				{
+					return;
+				}
+
+				if constexpr (!std::is_trivially_destructible_v<TSlotType>)
+				{
+					for (size_t i = 0; i < m_capacity; i++)
+					{
+						if (IsFull(m_ctrl[i]))
+						{
+							m_slots[i].~TSlotType();
+						}
+					}
+				}
+
+				m_allocator.Free(m_ctrl);
+
+				m_ctrl = nullptr;
+				m_slots = nullptr;
+				m_capacity = 0;
+				m_num = 0;
+				m_numDeleted = 0;
+			}
+
+			// Returns m_capacity if there are no full slots after index
+			__forceinline size_t NextFull(size_t index) const
+			{
+				while (index < m_capacity && !IsFull(m_ctrl[index]))
+				{
+					index++;
+				}
+				return index;
+			}
+
+			__forceinline size_t PrevFull(size_t index) const
+			{
+				while (index > 0)
+				{
+					index--;
+					if (IsFull(m_ctrl[index]))
+					{
+						return index;
+					}
+				}
+				return m_capacity;
+			}
+
+			static __forceinline size_t AlignUp(size_t value, size_t alignment) { return ((value + alignment - 1) / alignment) * alignment; }
+
+			TControl* m_ctrl = nullptr;
+			TSlotType* m_slots = nullptr;
+			size_t m_capacity = 0;
+			size_t m_num = 0;
+			size_t m_numDeleted = 0;
+
+			TAllocator m_allocator{};
+		};
+
+		template<typename T>
+		struct TIdentityKey
+		{
+			static __forceinline const T& Get(const T& value) { return value; }
+		};
+	}
+
+	// Open addressing hash set with the same API as TSet
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TFlatSet final : public Internal::TFlatHashTable<TElementType, TElementType, Internal::TIdentityKey<TElementType>, TAllocator>
+	{
+	public:
+
+		using Super = Internal::TFlatHashTable<TElementType, TElementType, Internal::TIdentityKey<TElementType>, TAllocator>;
+
+		template<typename TDataType>
+		class SAILOR_API TBaseIterator
+		{
+		public:
+
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = TDataType;
+			using difference_type = int64_t;
+			using pointer = TDataType*;
+			using reference = TDataType&;
+
+			TBaseIterator() = default;
+			TBaseIterator(const TBaseIterator&) = default;
+			TBaseIterator(TBaseIterator&&) = default;
+			~TBaseIterator() = default;
+
+			TBaseIterator(const TFlatSet* set, size_t index) : m_set(const_cast<TFlatSet*>(set)), m_index(index) {}
+
+			TBaseIterator& operator=(const TBaseIterator& rhs) = default;
+			TBaseIterator& operator=(TBaseIterator&& rhs) = default;
+
+			bool operator==(const TBaseIterator& rhs) const { return m_index == rhs.m_index; }
+			bool operator!=(const TBaseIterator& rhs) const { return m_index != rhs.m_index; }
+
+			pointer operator->() const { return &m_set->m_slots[m_index]; }
+			reference operator*() const { return m_set->m_slots[m_index]; }
+
+			TBaseIterator& operator++()
+			{
+				m_index = m_set->NextFull(m_index + 1);
+				return *this;
+			}
+
+			TBaseIterator& operator--()
+			{
+				m_index = m_set->PrevFull(m_index);
+				return *this;
+			}
+
+		protected:
+
+			TFlatSet* m_set = nullptr;
+			size_t m_index = 0;
+		};
+
+		// Modifying of the element could break the hash, so the set is iterated by const references only
+		using TIterator = TBaseIterator<const TElementType>;
+		using TConstIterator = TBaseIterator<const TElementType>;
+
+		TFlatSet(const uint32_t desiredNumBuckets = 8) { Super::Reserve(desiredNumBuckets); }
+		TFlatSet(TFlatSet&&) = default;
+		TFlatSet(const TFlatSet&) requires IsCopyConstructible<TElementType> = default;
+
+		TFlatSet& operator=(TFlatSet&&) noexcept = default;
+		TFlatSet& operator=(const TFlatSet&) requires IsCopyConstructible<TElementType> = default;
+
+		TFlatSet(std::initializer_list<TElementType> initList) : TFlatSet((uint32_t)initList.size())
+		{
+			InsertRange(initList);
+		}
+
+		TFlatSet(const TVectorIterator<TElementType>& begin, const TVectorIterator<TElementType>& end)
+		{
+			TVectorIterator<TElementType> it = begin;
+			while (it != end)
+			{
+				Insert(*it);
+				it++;
+			}
+		}
+
+		__forceinline bool Contains(const TElementType& inElement) const
+		{
+			return Super::FindIndex(inElement, Super::HashKey(inElement)) != Super::m_capacity;
+		}
+
+		TVector<TElementType> ToVector() const
+		{
+			TVector<TElementType> res;
+			res.Reserve(Super::Num());
+
+			for (const auto& el : *this)
+			{
+				res.Add(el);
+			}
+
+			return res;
+		}
+
+		void InsertRange(std::initializer_list<TElementType> initList)
+		{
+			for (const auto& el : initList)
+			{
+				Insert(el);
+			}
+		}
+
+		void Insert(TElementType inElement)
+		{
+			const size_t hash = Super::HashKey(inElement);
+			if (Super::FindIndex(inElement, hash) != Super::m_capacity)
+			{
+				return;
+			}
+
+			const size_t index = Super::PrepareInsert(hash);
+			new (&Super::m_slots[index]) TElementType(std::move(inElement));
+		}
+
+		bool RemoveFirst(const TPredicate<TElementType>& predicate)
+		{
+			for (size_t i = 0; i < Super::m_capacity; i++)
+			{
+				if (Super::IsFull(Super::m_ctrl[i]) && predicate(Super::m_slots[i]))
+				{
+					Super::EraseAt(i);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		size_t RemoveAll(const TPredicate<TElementType>& predicate)
+		{
+			// Erasing doesn't move the elements, so we can remove them in place
+			size_t num = 0;
+			for (size_t i = 0; i < Super::m_capacity; i++)
+			{
+				if (Super::IsFull(Super::m_ctrl[i]) && predicate(Super::m_slots[i]))
+				{
+					Super::EraseAt(i);
+					num++;
+				}
+			}
+			return num;
+		}
+
+		bool Remove(const TElementType& inElement)
+		{
+			const size_t index = Super::FindIndex(inElement, Super::HashKey(inElement));
+			if (index != Super::m_capacity)
+			{
+				Super::EraseAt(index);
+				return true;
+			}
+			return false;
+		}
+
+		void Clear(uint32_t desiredBucketsNum = 8) { Super::Clear(desiredBucketsNum); }
+
+		// Support ranged for
+		TIterator begin() { return TIterator(this, Super::NextFull(0)); }
+		TIterator end() { return TIterator(this, Super::m_capacity); }
+
+		TConstIterator begin() const { return TConstIterator(this, Super::NextFull(0)); }
+		TConstIterator end() const { return TConstIterator(this, Super::m_capacity); }
+
+		bool operator==(const TFlatSet& rhs) const
+		{
+			if (rhs.Num() != this->Num())
+			{
+				return false;
+			}
+
+			for (auto& el : rhs)
+			{
+				if (!this->Contains(el))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	};
+}
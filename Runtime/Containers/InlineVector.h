@@ -0,0 +1,310 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include "Core/Defines.h"
+#include "Memory/Memory.h"
+#include "Containers/Concepts.h"
+#include "Containers/Vector.h"
+
+namespace Sailor
+{
+	// Small vector: the first NumInline elements are stored in the object itself,
+	// the bigger amount spills to the heap, the inline storage is not used after that until Clear.
+	// Unlike TVector with TInlineAllocator there are no per-allocation headers
+	// and the container is copyable and movable.
+	// The object stores the pointer to itself, so it is not trivially relocatable.
+	template<typename TElementType, size_t NumInline, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TInlineVector final
+	{
+		static_assert(NumInline > 0, "Use TVector if there is no inline storage");
+
+	public:
+
+		using TIterator = TVectorIterator<TElementType>;
+		using TConstIterator = TConstVectorIterator<TElementType>;
+
+		static constexpr size_t InvalidIndex = (size_t)-1;
+
+		TInlineVector() : m_pData(GetInlineData()) {}
+		TInlineVector(std::initializer_list<TElementType> initList) : TInlineVector() { AddRange(initList.begin(), initList.size()); }
+
+		TInlineVector(const TInlineVector& other) requires IsCopyConstructible<TElementType> : TInlineVector() { AddRange(other.GetData(), other.Num()); }
+		TInlineVector(TInlineVector&& other) noexcept : TInlineVector() { MoveFrom(other); }
+
+		~TInlineVector() { Clear(true); }
+
+		TInlineVector& operator=(const TInlineVector& other) requires IsCopyConstructible<TElementType>
+		{
+			if (this != &other)
+			{
+				Clear(false);
+				AddRange(other.GetData(), other.Num());
+			}
+			return *this;
+		}
+
+		TInlineVector& operator=(TInlineVector&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Clear(true);
+				MoveFrom(other);
+			}
+			return *this;
+		}
+
+		__forceinline const TElementType& operator[](size_t index) const
+		{
+			check(index < m_num);
+			return m_pData[index];
+		}
+
+		__forceinline TElementType& operator[](size_t index)
+		{
+			check(index < m_num);
+			return m_pData[index];
+		}
+
+		__forceinline size_t Num() const { return m_num; }
+		__forceinline size_t Capacity() const { return m_capacity; }
+		__forceinline bool IsEmpty() const { return m_num == 0; }
+		__forceinline bool IsInline() const { return m_pData == GetInlineData(); }
+
+		__forceinline TElementType* GetData() { return m_pData; }
+		__forceinline const TElementType* GetData() const { return m_pData; }
+
+		template<typename... TArgs>
+		size_t Emplace(TArgs&& ... args)
+		{
+			if (m_num == m_capacity)
+			{
+				Grow(m_num + 1);
+			}
+
+			new (&m_pData[m_num]) TElementType(std::forward<TArgs>(args)...);
+			return m_num++;
+		}
+
+		size_t Add(TElementType item)
+		{
+			return Emplace(std::move(item));
+		}
+
+		void AddRange(const TElementType* first, size_t count) requires IsCopyConstructible<TElementType>
+		{
+			Reserve(m_num + count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				new (&m_pData[m_num + i]) TElementType(first[i]);
+			}
+
+			m_num += count;
+		}
+
+		void AddRange(std::initializer_list<TElementType> initList)
+		{
+			AddRange(initList.begin(), initList.size());
+		}
+
+		void Insert(TElementType item, size_t index)
+		{
+			check(index <= m_num);
+
+			if (index == m_num)
+			{
+				Emplace(std::move(item));
+				return;
+			}
+
+			if (m_num == m_capacity)
+			{
+				Grow(m_num + 1);
+			}
+
+			new (&m_pData[m_num]) TElementType(std::move(m_pData[m_num - 1]));
+			for (size_t i = m_num - 1; i > index; i--)
+			{
+				m_pData[i] = std::move(m_pData[i - 1]);
+			}
+
+			m_pData[index] = std::move(item);
+			m_num++;
+		}
+
+		void RemoveAt(size_t index, size_t count = 1)
+		{
+			check(index + count <= m_num);
+
+			for (size_t i = index; i + count < m_num; i++)
+			{
+				m_pData[i] = std::move(m_pData[i + count]);
+			}
+
+			DestructElements(m_num - count, count);
+			m_num -= count;
+		}
+
+		void RemoveLast()
+		{
+			check(m_num > 0);
+			DestructElements(--m_num, 1);
+		}
+
+		// Returns the index of the removed element or InvalidIndex
+		size_t RemoveFirst(const TElementType& item)
+		{
+			const size_t index = Find(item);
+			if (index != InvalidIndex)
+			{
+				RemoveAt(index);
+			}
+
+			return index;
+		}
+
+		size_t Find(const TElementType& item) const
+		{
+			for (size_t i = 0; i < m_num; i++)
+			{
+				if (m_pData[i] == item)
+				{
+					return i;
+				}
+			}
+
+			return InvalidIndex;
+		}
+
+		__forceinline bool Contains(const TElementType& item) const { return Find(item) != InvalidIndex; }
+
+		void Reserve(size_t newCapacity)
+		{
+			if (newCapacity > m_capacity)
+			{
+				Relocate(newCapacity);
+			}
+		}
+
+		void Resize(size_t count) requires IsDefaultConstructible<TElementType>
+		{
+			if (count < m_num)
+			{
+				DestructElements(count, m_num - count);
+				m_num = count;
+				return;
+			}
+
+			Reserve(count);
+
+			for (size_t i = m_num; i < count; i++)
+			{
+				new (&m_pData[i]) TElementType();
+			}
+
+			m_num = count;
+		}
+
+		// Returns back to the inline storage if the capacity is reset
+		void Clear(bool bResetCapacity = true)
+		{
+			DestructElements(0, m_num);
+			m_num = 0;
+
+			if (bResetCapacity && !IsInline())
+			{
+				m_allocator.Free(m_pData);
+				m_pData = GetInlineData();
+				m_capacity = NumInline;
+			}
+		}
+
+		// Support ranged for
+		TIterator begin() { return TIterator(m_pData); }
+		TIterator end() { return TIterator(m_pData + m_num); }
+
+		TConstIterator begin() const { return TConstIterator(m_pData); }
+		TConstIterator end() const { return TConstIterator(m_pData + m_num); }
+
+	protected:
+
+		__forceinline TElementType* GetInlineData() { return reinterpret_cast<TElementType*>(m_inline); }
+		__forceinline const TElementType* GetInlineData() const { return reinterpret_cast<const TElementType*>(m_inline); }
+
+		__forceinline void DestructElements(size_t index, size_t count)
+		{
+			if constexpr (!IsTriviallyDestructible<TElementType>)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					m_pData[index + i].~TElementType();
+				}
+			}
+		}
+
+		__forceinline void Grow(size_t requiredNum)
+		{
+			Relocate((std::max)(requiredNum, m_capacity * 2));
+		}
+
+		// Moves the elements to the heap block with the new capacity
+		void Relocate(size_t newCapacity)
+		{
+			TElementType* pNewData = static_cast<TElementType*>(m_allocator.Allocate(newCapacity * sizeof(TElementType), alignof(TElementType)));
+
+			if constexpr (IsTriviallyRelocatable<TElementType>)
+			{
+				memcpy((void*)pNewData, (const void*)m_pData, m_num * sizeof(TElementType));
+			}
+			else
+			{
+				for (size_t i = 0; i < m_num; i++)
+				{
+					new (&pNewData[i]) TElementType(std::move(m_pData[i]));
+					m_pData[i].~TElementType();
+				}
+			}
+
+			if (!IsInline())
+			{
+				m_allocator.Free(m_pData);
+			}
+
+			m_pData = pNewData;
+			m_capacity = newCapacity;
+		}
+
+		// Steals the heap block or moves the inline elements, other is left empty
+		void MoveFrom(TInlineVector& other)
+		{
+			if (!other.IsInline())
+			{
+				m_pData = other.m_pData;
+				m_num = other.m_num;
+				m_capacity = other.m_capacity;
+
+				other.m_pData = other.GetInlineData();
+				other.m_num = 0;
+				other.m_capacity = NumInline;
+				return;
+			}
+
+			for (size_t i = 0; i < other.m_num; i++)
+			{
+				new (&m_pData[i]) TElementType(std::move(other.m_pData[i]));
+			}
+
+			m_num = other.m_num;
+			other.Clear(false);
+		}
+
+		alignas(TElementType) uint8_t m_inline[NumInline * sizeof(TElementType)];
+
+		TElementType* m_pData = nullptr;
+		size_t m_num = 0;
+		size_t m_capacity = NumInline;
+		TAllocator m_allocator{};
+	};
+}
@@ -0,0 +1,241 @@
+#pragma once
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Containers/Concepts.h"
+
+namespace Sailor
+{
+	template<typename TElementType>
+	class TIntrusiveList;
+
+	// The base of the elements, the links live inside the element so the list never allocates.
+	// The element could be in one list at a time and should outlive its membership
+	template<typename TElementType>
+	class TIntrusiveListNode
+	{
+	public:
+
+		TIntrusiveListNode() = default;
+
+		// The links belong to the list, not to the value
+		TIntrusiveListNode(const TIntrusiveListNode&) {}
+		TIntrusiveListNode& operator=(const TIntrusiveListNode&) { return *this; }
+
+		~TIntrusiveListNode() { check(!IsLinked()); }
+
+		__forceinline bool IsLinked() const { return m_pList != nullptr; }
+
+	protected:
+
+		TElementType* m_pNextNode = nullptr;
+		TElementType* m_pPrevNode = nullptr;
+		const void* m_pList = nullptr;
+
+		friend class TIntrusiveList<TElementType>;
+	};
+
+	// Doubly linked list that doesn't own the elements, the elements derive from TIntrusiveListNode
+	template<typename TElementType>
+	class TIntrusiveList final
+	{
+		using TNode = TIntrusiveListNode<TElementType>;
+
+	public:
+
+		template<typename TDataType>
+		class TBaseIterator
+		{
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = TDataType;
+			using difference_type = int64_t;
+			using pointer = TDataType*;
+			using reference = TDataType&;
+
+			TBaseIterator() = default;
+			TBaseIterator(TDataType* pElement) : m_pElement(pElement), m_pNext(pElement ? GetNode(pElement)->m_pNextNode : nullptr) {}
+
+			bool operator==(const TBaseIterator& rhs) const { return m_pElement == rhs.m_pElement; }
+			bool operator!=(const TBaseIterator& rhs) const { return m_pElement != rhs.m_pElement; }
+
+			reference operator*() const { return *m_pElement; }
+			pointer operator->() const { return m_pElement; }
+
+			// The next element is cached, so the current one could be removed while iterating, but not the next one
+			TBaseIterator& operator++()
+			{
+				m_pElement = m_pNext;
+				m_pNext = m_pElement ? GetNode(m_pElement)->m_pNextNode : nullptr;
+				return *this;
+			}
+
+		protected:
+
+			TDataType* m_pElement = nullptr;
+			TDataType* m_pNext = nullptr;
+		};
+
+		using TIterator = TBaseIterator<TElementType>;
+		using TConstIterator = TBaseIterator<const TElementType>;
+
+		TIntrusiveList() = default;
+		TIntrusiveList(const TIntrusiveList&) = delete;
+		TIntrusiveList& operator=(const TIntrusiveList&) = delete;
+
+		TIntrusiveList(TIntrusiveList&& other) noexcept { Swap(*this, other); }
+
+		TIntrusiveList& operator=(TIntrusiveList&& other) noexcept
+		{
+			Clear();
+			Swap(*this, other);
+			return *this;
+		}
+
+		~TIntrusiveList() { Clear(); }
+
+		__forceinline size_t Num() const { return m_num; }
+		__forceinline bool IsEmpty() const { return m_num == 0; }
+
+		__forceinline TElementType* First() const { return m_pFirst; }
+		__forceinline TElementType* Last() const { return m_pLast; }
+
+		__forceinline bool Contains(const TElementType& element) const { return GetNode(&element)->m_pList == this; }
+
+		void PushBack(TElementType& element)
+		{
+			TNode* pNode = GetNode(&element);
+			check(!pNode->IsLinked());
+
+			pNode->m_pList = this;
+			pNode->m_pPrevNode = m_pLast;
+			pNode->m_pNextNode = nullptr;
+
+			if (m_pLast)
+			{
+				GetNode(m_pLast)->m_pNextNode = &element;
+			}
+			else
+			{
+				m_pFirst = &element;
+			}
+
+			m_pLast = &element;
+			m_num++;
+		}
+
+		void PushFront(TElementType& element)
+		{
+			TNode* pNode = GetNode(&element);
+			check(!pNode->IsLinked());
+
+			pNode->m_pList = this;
+			pNode->m_pPrevNode = nullptr;
+			pNode->m_pNextNode = m_pFirst;
+
+			if (m_pFirst)
+			{
+				GetNode(m_pFirst)->m_pPrevNode = &element;
+			}
+			else
+			{
+				m_pLast = &element;
+			}
+
+			m_pFirst = &element;
+			m_num++;
+		}
+
+		void Remove(TElementType& element)
+		{
+			TNode* pNode = GetNode(&element);
+			check(pNode->m_pList == this);
+
+			if (pNode->m_pPrevNode)
+			{
+				GetNode(pNode->m_pPrevNode)->m_pNextNode = pNode->m_pNextNode;
+			}
+			else
+			{
+				m_pFirst = pNode->m_pNextNode;
+			}
+
+			if (pNode->m_pNextNode)
+			{
+				GetNode(pNode->m_pNextNode)->m_pPrevNode = pNode->m_pPrevNode;
+			}
+			else
+			{
+				m_pLast = pNode->m_pPrevNode;
+			}
+
+			pNode->m_pPrevNode = pNode->m_pNextNode = nullptr;
+			pNode->m_pList = nullptr;
+			m_num--;
+		}
+
+		TElementType* PopFront()
+		{
+			TElementType* pElement = m_pFirst;
+			if (pElement)
+			{
+				Remove(*pElement);
+			}
+			return pElement;
+		}
+
+		TElementType* PopBack()
+		{
+			TElementType* pElement = m_pLast;
+			if (pElement)
+			{
+				Remove(*pElement);
+			}
+			return pElement;
+		}
+
+		// Unlinks the elements, they are not destroyed
+		void Clear()
+		{
+			while (m_pFirst)
+			{
+				Remove(*m_pFirst);
+			}
+		}
+
+		static void Swap(TIntrusiveList& lhs, TIntrusiveList& rhs)
+		{
+			std::swap(lhs.m_pFirst, rhs.m_pFirst);
+			std::swap(lhs.m_pLast, rhs.m_pLast);
+			std::swap(lhs.m_num, rhs.m_num);
+
+			for (TElementType* pElement = lhs.m_pFirst; pElement; pElement = GetNode(pElement)->m_pNextNode)
+			{
+				GetNode(pElement)->m_pList = &lhs;
+			}
+
+			for (TElementType* pElement = rhs.m_pFirst; pElement; pElement = GetNode(pElement)->m_pNextNode)
+			{
+				GetNode(pElement)->m_pList = &rhs;
+			}
+		}
+
+		// Support ranged for
+		TIterator begin() { return TIterator(m_pFirst); }
+		TIterator end() { return TIterator(nullptr); }
+
+		TConstIterator begin() const { return TConstIterator(m_pFirst); }
+		TConstIterator end() const { return TConstIterator(nullptr); }
+
+	protected:
+
+		static __forceinline TNode* GetNode(TElementType* pElement) { return static_cast<TNode*>(pElement); }
+		static __forceinline const TNode* GetNode(const TElementType* pElement) { return static_cast<const TNode*>(pElement); }
+
+		TElementType* m_pFirst = nullptr;
+		TElementType* m_pLast = nullptr;
+		size_t m_num = 0;
+	};
+}
@@ -9,6 +9,7 @@
 #include "Core/Defines.h"
 #include "Math/Math.h"
 #include "Containers/Concepts.h"
+#include "Memory/NodePoolAllocator.hpp"
 
 namespace Sailor
 {
@@ -96,8 +97,14 @@ namespace Sailor
 			}
 		}
 
-		TList(TList&& other) = default;
-		TList& operator=(TList&& other) = default;
+		TList(TList&& other) noexcept requires IsMoveConstructible<TAllocator> { Swap(*this, other); }
+
+		TList& operator=(TList&& other) noexcept requires IsMoveConstructible<TAllocator>
+		{
+			Clear();
+			Swap(*this, other);
+			return *this;
+		}
 
 		TList& operator=(std::initializer_list<TElementType> initList) { AddRange(initList.begin(), initList.size()); return *this; }
 
@@ -116,7 +123,7 @@ namespace Sailor
 		template<typename... TArgs>
 		__forceinline void EmplaceBack(TArgs&& ... args)
 		{
-			TNode* node = static_cast<TNode*>(m_allocator.Allocate(sizeof(TNode)));
+			TNode* node = static_cast<TNode*>(m_allocator.Allocate(sizeof(TNode), alignof(TNode)));
 			new (node) TNode(std::forward<TArgs>(args)...);
 
 			if (!m_pFirst)
@@ -136,7 +143,7 @@ namespace Sailor
 		template<typename... TArgs>
 		__forceinline void EmplaceFront(TArgs&& ... args)
 		{
-			TNode* node = static_cast<TNode*>(m_allocator.Allocate(sizeof(TNode)));
+			TNode* node = static_cast<TNode*>(m_allocator.Allocate(sizeof(TNode), alignof(TNode)));
 			new (node) TNode(std::forward<TArgs>(args)...);
 
 			if (!m_pFirst)
@@ -352,7 +359,7 @@ namespace Sailor
 					current->~TNode();
 				}
 
-				m_allocator.Free(current);
+				m_allocator.Free(current, sizeof(TNode));
 
 				current = next;
 			}
@@ -449,7 +456,7 @@ namespace Sailor
 				item->~TNode();
 			}
 
-			m_allocator.Free(item);
+			m_allocator.Free(item, sizeof(TNode));
 
 			if (next)
 			{
@@ -481,5 +488,9 @@ namespace Sailor
 		TAllocator m_allocator{};
 	};
 
+	// The nodes are pooled, the insert/remove don't touch the heap after the warm up
+	template<typename TElementType, size_t MaxNodesPerChunk = 64, typename TAllocator = Memory::DefaultGlobalAllocator>
+	using TPooledList = TList<TElementType, Memory::TNodePoolAllocator<MaxNodesPerChunk, TAllocator>>;
+
 	SAILOR_API void RunListBenchmark();
 }
\ No newline at end of file
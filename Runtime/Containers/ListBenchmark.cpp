@@ -1,20 +1,21 @@
-#include "Memory.h"
 #include <cstdlib>
 #include <list>
+#include <vector>
 #include <cassert>
 #include <cctype>
-#include "Core/Utils.h"
+#include "Core/Benchmark.h"
+#include "ContainersBenchmark.h"
 #include "List.h"
+#include "IntrusiveList.h"
 #include "Memory/Memory.h"
-#include "Tasks/Tasks.h"
-#include "Tasks/Scheduler.h"
 
 using namespace Sailor;
 using namespace Sailor::Memory;
-using Timer = Utils::Timer;
 
 class TestCase_ListPerfromance
 {
+public:
+
 	struct TData
 	{
 		TData(uint32_t value)
@@ -56,190 +57,320 @@ class TestCase_ListPerfromance
 		uint32_t m_value;
 	};
 
-public:
+	static constexpr size_t Count = 163600;
 
-	static void RunTests()
+	// Steady amount of the elements with the constant insert/remove, like the free lists
+	template<typename TContainer>
+	static void ChurnTests(Benchmark::State& state)
 	{
-		RunSanityTests();
-	}
+		const size_t count = 4000000;
+		const size_t numAlive = 64;
 
-	static void RunSanityTests()
-	{
-		printf("%s\n", "class Sailor::TList");
-		printf("Sanity check passed: %d\n", SanityCheck());
-		PerformanceTests();
-		printf("\n");
+		TContainer container;
+
+		state.Measure("push_pop_churn", count, [&]()
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					if constexpr (requires { container.push_back(i); })
+					{
+						container.push_back(i);
+						if (container.size() > numAlive)
+						{
+							container.pop_front();
+						}
+					}
+					else
+					{
+						container.PushBack(i);
+						if (container.Num() > numAlive)
+						{
+							container.PopFront();
+						}
+					}
+				}
+			});
 	}
 
-	static void PerformanceTests()
+	static void StdPerformanceTests(Benchmark::State& state)
 	{
-		TList<TData> container;
 		std::list<TData> ideal;
 
-		Timer stdList;
-		Timer tList;
+		srand(0);
+		state.Measure("push", Count, [&]()
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					const int32_t value = rand();
+
+					if (i % 2)
+					{
+						ideal.push_back(TData(value));
+					}
+					else
+					{
+						ideal.push_front(TData(value));
+					}
+				}
+			});
+
+		uint32_t countToDelete = Count / 4;
+		state.Measure("pop", countToDelete, [&]()
+			{
+				for (size_t i = 0; i < countToDelete; i++)
+				{
+					if (i % 2)
+					{
+						ideal.pop_front();
+					}
+					else
+					{
+						ideal.pop_back();
+					}
+				}
+			});
+
+		countToDelete = Count / 256;
+		srand(0);
+		state.Measure("remove_all", countToDelete, [&]()
+			{
+				for (size_t i = 0; i < countToDelete; i++)
+				{
+					const int32_t value = rand();
+					ideal.remove(TData(value));
+				}
+			});
+	}
 
-		const size_t count = 163600;
+	template<typename TContainer>
+	static void PerformanceTests(Benchmark::State& state)
+	{
+		TContainer container;
 
 		srand(0);
-		stdList.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			const int32_t value = rand();
-
-			if (i % 2)
+		state.Measure("push", Count, [&]()
 			{
-				ideal.push_back(TData(value));
-			}
-			else
+				for (size_t i = 0; i < Count; i++)
+				{
+					const int32_t value = rand();
+
+					if (i % 2)
+					{
+						container.PushBack(TData(value));
+					}
+					else
+					{
+						container.PushFront(TData(value));
+					}
+				}
+			});
+
+		uint32_t countToDelete = Count / 4;
+		state.Measure("pop", countToDelete, [&]()
 			{
-				ideal.push_front(TData(value));
-			}
-		}
-		stdList.Stop();
+				for (size_t i = 0; i < countToDelete; i++)
+				{
+					if (i % 2)
+					{
+						container.PopFront();
+					}
+					else
+					{
+						container.PopBack();
+					}
+				}
+			});
+
+		countToDelete = Count / 256;
+		srand(0);
+		state.Measure("remove_all", countToDelete, [&]()
+			{
+				for (size_t i = 0; i < countToDelete; i++)
+				{
+					const int32_t value = rand();
+					container.RemoveAll(value);
+				}
+			});
+	}
+
+	template<typename TContainer>
+	static bool SanityCheck()
+	{
+		const size_t count = 16571;
+
+		TContainer container;
+		std::list<TData> ideal;
 
 		srand(0);
-		tList.Start();
 		for (size_t i = 0; i < count; i++)
 		{
 			const int32_t value = rand();
 
 			if (i % 2)
 			{
+				ideal.push_back(TData(value));
 				container.PushBack(TData(value));
 			}
 			else
 			{
+				ideal.push_front(TData(value));
 				container.PushFront(TData(value));
 			}
 		}
-		tList.Stop();
-
-		SAILOR_LOG("Performance test push:\n\tstd::list %llums\n\tTList %llums", stdList.ResultMs(), tList.ResultMs());
 
-		stdList.Clear();
-		tList.Clear();
-
-		uint32_t countToDelete = count / 4;
+		bool bRes = Compare(ideal, container);
 
-		srand(0);
-		stdList.Start();
+		uint32_t countToDelete = count / 2;
 		for (size_t i = 0; i < countToDelete; i++)
 		{
-			if (i % 2)
-			{
-				ideal.pop_front();
-			}
-			else
-			{
-				ideal.pop_back();
-			}
+			const int32_t value = (int32_t)i;
+			ideal.remove(value);
+			container.RemoveAll(value);
 		}
-		stdList.Stop();
 
-		srand(0);
-		tList.Start();
+		bRes &= Compare(ideal, container);
+		countToDelete = count / 5;
 		for (size_t i = 0; i < countToDelete; i++)
 		{
 			if (i % 2)
 			{
+				ideal.pop_back();
 				container.PopBack();
 			}
 			else
 			{
-				container.PopBack();
+				ideal.pop_front();
+				container.PopFront();
 			}
 		}
-		tList.Stop();
 
-		SAILOR_LOG("Performance test pop:\n\tstd::list %llums\n\tTList %llums", stdList.ResultMs(), tList.ResultMs());
+		bRes &= Compare(ideal, container);
 
-		stdList.Clear();
-		tList.Clear();
+		container.Clear();
+		ideal.clear();
 
-		countToDelete = count / 256;
+		return bRes && numInstances == 0;
+	}
 
-		srand(0);
-		stdList.Start();
-		for (size_t i = 0; i < countToDelete; i++)
+	struct TIntrusiveData : public TIntrusiveListNode<TIntrusiveData>
+	{
+		TIntrusiveData(uint32_t value = 0) : m_value(value) {}
+
+		uint32_t m_value;
+	};
+
+	// The same order as the ideal one in both directions
+	static bool CompareOrder(const std::list<uint32_t>& ideal, const TIntrusiveList<TIntrusiveData>& container)
+	{
+		if (ideal.size() != container.Num())
 		{
-			const int32_t value = rand();
-			ideal.erase(std::find(ideal.begin(), ideal.end(), value));
+			return false;
 		}
-		stdList.Stop();
 
-		srand(0);
-		tList.Start();
-		for (size_t i = 0; i < countToDelete; i++)
+		auto it = ideal.begin();
+		for (const auto& el : container)
 		{
-			const int32_t value = rand();
-			container.RemoveAll(value);
+			if (!container.Contains(el) || el.m_value != *it++)
+			{
+				return false;
+			}
 		}
-		tList.Stop();
 
-		SAILOR_LOG("Performance test remove all:\n\tstd::list %llums\n\tTList %llums", stdList.ResultMs(), tList.ResultMs());
+		return ideal.empty() ? !container.First() && !container.Last() :
+			container.First()->m_value == ideal.front() && container.Last()->m_value == ideal.back();
 	}
 
-	static bool SanityCheck()
+	static bool IntrusiveSanityCheck()
 	{
 		const size_t count = 16571;
 
-		TList<TData> container;
-		std::list<TData> ideal;
+		std::vector<TIntrusiveData> elements(count);
+		TIntrusiveList<TIntrusiveData> container;
+		std::list<uint32_t> ideal;
 
 		srand(0);
 		for (size_t i = 0; i < count; i++)
 		{
-			const int32_t value = rand();
+			elements[i].m_value = (uint32_t)i;
 
-			if (i % 2)
+			if (rand() % 2)
 			{
-				ideal.push_back(TData(value));
-				container.PushBack(TData(value));
+				ideal.push_back((uint32_t)i);
+				container.PushBack(elements[i]);
 			}
 			else
 			{
-				ideal.push_front(TData(value));
-				container.PushFront(TData(value));
+				ideal.push_front((uint32_t)i);
+				container.PushFront(elements[i]);
 			}
 		}
 
-		bool bRes = Compare(ideal, container);
+		bool bRes = CompareOrder(ideal, container);
 
-		uint32_t countToDelete = count / 2;
-		for (size_t i = 0; i < countToDelete; i++)
+		// Remove the current element while iterating
+		for (auto& el : container)
 		{
-			const int32_t value = (int32_t)i;
-			ideal.remove(value);
-			container.RemoveAll(value);
+			if (el.m_value % 3 == 0)
+			{
+				container.Remove(el);
+				bRes &= !el.IsLinked() && !container.Contains(el);
+			}
 		}
+		ideal.remove_if([](uint32_t value) { return value % 3 == 0; });
 
-		bRes &= Compare(ideal, container);
-		countToDelete = count / 5;
-		for (size_t i = 0; i < countToDelete; i++)
+		bRes &= CompareOrder(ideal, container);
+
+		for (size_t i = 0; i < count / 5; i++)
 		{
+			TIntrusiveData* pElement = nullptr;
+			uint32_t value = 0;
+
 			if (i % 2)
 			{
+				pElement = container.PopBack();
+				value = ideal.back();
 				ideal.pop_back();
-				container.PopBack();
 			}
 			else
 			{
+				pElement = container.PopFront();
+				value = ideal.front();
 				ideal.pop_front();
-				container.PopFront();
 			}
+
+			bRes &= pElement && pElement->m_value == value && !pElement->IsLinked();
 		}
 
-		bRes &= Compare(ideal, container);
+		bRes &= CompareOrder(ideal, container);
 
-		container.Clear();
-		ideal.clear();
+		// The links are retargeted to the new owner
+		TIntrusiveList<TIntrusiveData> moved(std::move(container));
+		bRes &= container.IsEmpty() && CompareOrder(ideal, moved);
+		bRes &= moved.First() && moved.Contains(*moved.First()) && !container.Contains(*moved.First());
 
-		return bRes && numInstances == 0;
+		TIntrusiveList<TIntrusiveData> other;
+		other.PushBack(elements[0]);
+
+		TIntrusiveList<TIntrusiveData>::Swap(moved, other);
+		bRes &= moved.Num() == 1 && moved.Contains(elements[0]) && CompareOrder(ideal, other);
+
+		// The assignment unlinks the previous elements
+		moved = std::move(other);
+		bRes &= !elements[0].IsLinked() && other.IsEmpty() && CompareOrder(ideal, moved);
+
+		moved.Clear();
+		bRes &= moved.IsEmpty() && !moved.PopFront() && !moved.PopBack();
+
+		for (const auto& el : elements)
+		{
+			bRes &= !el.IsLinked();
+		}
+
+		return bRes;
 	}
 
-	template<typename T>
-	static bool Compare(const std::list<T>& lhs, const TList<T>& rhs)
+	template<typename T, typename TContainer>
+	static bool Compare(const std::list<T>& lhs, const TContainer& rhs)
 	{
 		if (lhs.size() != rhs.Num())
 		{
@@ -270,9 +401,26 @@ public:
 
 size_t TestCase_ListPerfromance::numInstances = 0;
 
+void Sailor::RegisterListBenchmarks(Benchmark::Runner& runner)
+{
+	runner.AddCheck("list/sanity/TList", &TestCase_ListPerfromance::SanityCheck<TList<TestCase_ListPerfromance::TData>>);
+	runner.AddCheck("list/sanity/TPooledList", &TestCase_ListPerfromance::SanityCheck<TPooledList<TestCase_ListPerfromance::TData>>);
+	runner.AddCheck("list/sanity/TIntrusiveList", &TestCase_ListPerfromance::IntrusiveSanityCheck);
+
+	runner.Add("list/std::list", &TestCase_ListPerfromance::StdPerformanceTests);
+	runner.Add("list/TList", &TestCase_ListPerfromance::PerformanceTests<TList<TestCase_ListPerfromance::TData>>);
+	runner.Add("list/TPooledList", &TestCase_ListPerfromance::PerformanceTests<TPooledList<TestCase_ListPerfromance::TData>>);
+
+	runner.Add("list/churn/std::list", &TestCase_ListPerfromance::ChurnTests<std::list<size_t>>);
+	runner.Add("list/churn/TList", &TestCase_ListPerfromance::ChurnTests<TList<size_t>>);
+	runner.Add("list/churn/TPooledList", &TestCase_ListPerfromance::ChurnTests<TPooledList<size_t>>);
+}
+
 void Sailor::RunListBenchmark()
 {
 	printf("\nStarting List benchmark...\n");
 
-	TestCase_ListPerfromance::RunTests();
+	Benchmark::Runner runner;
+	RegisterListBenchmarks(runner);
+	Benchmark::Print(runner.Run(Benchmark::Settings()));
 }
@@ -0,0 +1,588 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include <immintrin.h>
+#include "Core/Defines.h"
+#include "Math/Math.h"
+#include "Memory/Memory.h"
+#include "Containers/Concepts.h"
+#include "Containers/FlatMap.h"
+#include "Containers/Vector.h"
+#include "Containers/Pair.h"
+#include "Math/Bounds.h"
+
+namespace Sailor
+{
+	// Loose octree with the same API as TOctree.
+	// The node is addressed by the locational code (the sentinel bit followed by the Morton code of the cell on its level),
+	// nodes are stored in the flat array and found by the code, so the insertion never subdivides or redistributes elements.
+	// The element goes to the deepest level where it fits into the loose bounds (twice the cell size),
+	// the cell is chosen by the element's center.
+	// Element bounds are stored per node in SoA groups of 4, so the frustum test handles 4 elements at once.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TLooseOctree
+	{
+		static constexpr uint32_t MaxDepth = 20;
+		static constexpr uint32_t InvalidNode = (uint32_t)-1;
+
+		// minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4]
+		static constexpr uint32_t NumFloatsInGroup = 24;
+
+		struct Node
+		{
+			uint64_t m_code = 1;
+			uint32_t m_parent = InvalidNode;
+			uint32_t m_numChildren = 0;
+			uint32_t m_children[8]{ InvalidNode, InvalidNode, InvalidNode, InvalidNode, InvalidNode, InvalidNode, InvalidNode, InvalidNode };
+
+			glm::vec3 m_looseMin{};
+			glm::vec3 m_looseMax{};
+
+			TVector<TElementType, TAllocator> m_elements;
+			TVector<float, TAllocator> m_bounds;
+
+			__forceinline bool IsEmpty() const { return m_elements.Num() == 0 && m_numChildren == 0; }
+
+			__forceinline void SetBounds(size_t slot, const glm::vec3& min, const glm::vec3& max)
+			{
+				float* pGroup = &m_bounds[(slot / 4) * NumFloatsInGroup];
+				const size_t lane = slot % 4;
+
+				pGroup[lane] = min.x;
+				pGroup[lane + 4] = min.y;
+				pGroup[lane + 8] = min.z;
+				pGroup[lane + 12] = max.x;
+				pGroup[lane + 16] = max.y;
+				pGroup[lane + 20] = max.z;
+			}
+
+			__forceinline void CopyBounds(size_t dst, size_t src)
+			{
+				const float* pSrc = &m_bounds[(src / 4) * NumFloatsInGroup + src % 4];
+				float* pDst = &m_bounds[(dst / 4) * NumFloatsInGroup + dst % 4];
+
+				for (uint32_t i = 0; i < 6; i++)
+				{
+					pDst[i * 4] = pSrc[i * 4];
+				}
+			}
+
+			__forceinline uint32_t Add(const TElementType& element, const glm::vec3& min, const glm::vec3& max)
+			{
+				const size_t slot = m_elements.Num();
+				if (slot % 4 == 0)
+				{
+					m_bounds.AddDefault(NumFloatsInGroup);
+				}
+
+				m_elements.Add(element);
+				SetBounds(slot, min, max);
+
+				return (uint32_t)slot;
+			}
+
+			// The last element is moved into the slot
+			__forceinline void RemoveAtSwap(size_t slot)
+			{
+				const size_t last = m_elements.Num() - 1;
+				if (slot != last)
+				{
+					m_elements[slot] = std::move(m_elements[last]);
+					CopyBounds(slot, last);
+				}
+
+				m_elements.RemoveLast();
+
+				if (last % 4 == 0)
+				{
+					m_bounds.RemoveAt(m_bounds.Num() - NumFloatsInGroup, NumFloatsInGroup);
+				}
+			}
+		};
+
+		struct Location
+		{
+			uint32_t m_node = InvalidNode;
+			uint32_t m_slot = 0;
+		};
+
+		struct Cell
+		{
+			uint64_t m_code = 1;
+			uint32_t m_level = 0;
+			glm::uvec3 m_coords{};
+		};
+
+	public:
+
+		// Constructors & Destructor
+		TLooseOctree(glm::ivec3 center = glm::ivec3(0, 0, 0), uint32_t size = 16536u, uint32_t minSize = 4) : m_center(center), m_size(size)
+		{
+			m_depth = 0;
+			while (m_depth < MaxDepth && (m_size >> (m_depth + 1)) >= (std::max)(minSize, 1u))
+			{
+				m_depth++;
+			}
+
+			m_nodes.Add(Node());
+			InitNode(m_nodes[0], Cell());
+		}
+
+		TLooseOctree(const TLooseOctree&) = default;
+		TLooseOctree& operator=(const TLooseOctree&) = default;
+		TLooseOctree(TLooseOctree&&) = default;
+		TLooseOctree& operator=(TLooseOctree&&) = default;
+		virtual ~TLooseOctree() = default;
+
+		void Clear()
+		{
+			m_nodes.Clear();
+			m_nodes.Add(Node());
+			InitNode(m_nodes[0], Cell());
+
+			m_freeNodes.Clear();
+			m_codeToNode.Clear();
+			m_map.Clear();
+		}
+
+		bool Contains(const TElementType& element) const { return m_map.ContainsKey(element); }
+		size_t Num() const { return m_map.Num(); }
+		size_t NumNodes() const { return m_nodes.Num() - m_freeNodes.Num(); }
+
+		bool Insert(const glm::ivec3& pos, const glm::ivec3& extents, const TElementType& element)
+		{
+			if (m_map.ContainsKey(element))
+			{
+				return false;
+			}
+
+			return Update(pos, extents, element);
+		}
+
+		bool Update(const glm::ivec3& pos, const glm::ivec3& extents, const TElementType& element)
+		{
+			Cell cell;
+			if (!GetCell(pos, extents, cell))
+			{
+				Remove(element);
+				return false;
+			}
+
+			const glm::vec3 min = glm::vec3(pos - extents);
+			const glm::vec3 max = glm::vec3(pos + extents);
+
+			Location* location = nullptr;
+			if (m_map.Find(element, location))
+			{
+				// If we're still in the same cell then we just update the bounds
+				if (m_nodes[location->m_node].m_code == cell.m_code)
+				{
+					m_nodes[location->m_node].SetBounds(location->m_slot, min, max);
+					return true;
+				}
+
+				RemoveAt(*location);
+			}
+
+			const uint32_t nodeIndex = GetOrAddNode(cell);
+			m_map[element] = Location{ nodeIndex, m_nodes[nodeIndex].Add(element, min, max) };
+
+			return true;
+		}
+
+		// Elements are grouped by the cell, so each node is looked up once
+		void UpdateBatch(const TVector<TPair<TElementType, Math::AABB>>& elements)
+		{
+			struct Pending
+			{
+				Cell m_cell;
+				uint32_t m_index;
+			};
+
+			TVector<Pending> pending;
+			pending.Reserve(elements.Num());
+
+			for (uint32_t i = 0; i < elements.Num(); i++)
+			{
+				const auto& el = elements[i];
+				const glm::ivec3 pos = glm::ivec3(el.m_second.GetCenter());
+				const glm::ivec3 extents = glm::ivec3(glm::ceil(el.m_second.GetExtents()));
+
+				Cell cell;
+				if (!GetCell(pos, extents, cell))
+				{
+					Remove(el.m_first);
+					continue;
+				}
+
+				Location* location = nullptr;
+				if (m_map.Find(el.m_first, location) && m_nodes[location->m_node].m_code == cell.m_code)
+				{
+					m_nodes[location->m_node].SetBounds(location->m_slot, glm::vec3(pos - extents), glm::vec3(pos + extents));
+					continue;
+				}
+
+				pending.Add(Pending{ cell, i });
+			}
+
+			pending.Sort([](const Pending& lhs, const Pending& rhs) { return lhs.m_cell.m_code < rhs.m_cell.m_code; });
+
+			size_t runStart = 0;
+			while (runStart < pending.Num())
+			{
+				size_t runEnd = runStart + 1;
+				while (runEnd < pending.Num() && pending[runEnd].m_cell.m_code == pending[runStart].m_cell.m_code)
+				{
+					runEnd++;
+				}
+
+				// Removing could release the nodes, so the target node is resolved after
+				for (size_t i = runStart; i < runEnd; i++)
+				{
+					Location* location = nullptr;
+					if (m_map.Find(elements[pending[i].m_index].m_first, location))
+					{
+						RemoveAt(*location);
+						m_map.Remove(elements[pending[i].m_index].m_first);
+					}
+				}
+
+				const uint32_t nodeIndex = GetOrAddNode(pending[runStart].m_cell);
+				Node& node = m_nodes[nodeIndex];
+
+				for (size_t i = runStart; i < runEnd; i++)
+				{
+					const auto& el = elements[pending[i].m_index];
+					const glm::ivec3 pos = glm::ivec3(el.m_second.GetCenter());
+					const glm::ivec3 extents = glm::ivec3(glm::ceil(el.m_second.GetExtents()));
+
+					// The element could be duplicated in the batch, the last bounds win
+					Location* location = nullptr;
+					if (m_map.Find(el.m_first, location))
+					{
+						node.SetBounds(location->m_slot, glm::vec3(pos - extents), glm::vec3(pos + extents));
+						continue;
+					}
+
+					m_map[el.m_first] = Location{ nodeIndex, node.Add(el.m_first, glm::vec3(pos - extents), glm::vec3(pos + extents)) };
+				}
+
+				runStart = runEnd;
+			}
+		}
+
+		bool Remove(const TElementType& element)
+		{
+			Location* location = nullptr;
+			if (m_map.Find(element, location))
+			{
+				RemoveAt(*location);
+				m_map.Remove(element);
+				return true;
+			}
+
+			return false;
+		}
+
+		// Empty nodes are released on remove, so there is nothing to resolve
+		__forceinline void Resolve() {}
+
+		template<typename TDebugContext>
+		void DrawOctree(TDebugContext& context, float duration = 0.0f) const
+		{
+			for (uint32_t i = 0; i < m_nodes.Num(); i++)
+			{
+				const Node& node = m_nodes[i];
+				if (node.m_code == 0)
+				{
+					continue;
+				}
+
+				Math::AABB aabb;
+				aabb.m_min = node.m_looseMin;
+				aabb.m_max = node.m_looseMax;
+
+				const glm::vec4 color = node.m_elements.Num() ? glm::vec4(0.2f, 1.0f, 0.2f, 1.0f) : glm::vec4(1.0f, 0.2f, 0.2f, 1.0f);
+				context.DrawAABB(aabb, color, duration);
+			}
+		}
+
+		void Trace(const Math::Frustum& frustum, TVector<TElementType>& outElements) const
+		{
+			outElements.Clear(false);
+
+			FrustumPlanes planes;
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				const glm::vec4& abcd = frustum.GetPlane(i).m_abcd;
+
+				planes.m_x[i] = _mm_set1_ps(abcd.x);
+				planes.m_y[i] = _mm_set1_ps(abcd.y);
+				planes.m_z[i] = _mm_set1_ps(abcd.z);
+				planes.m_w[i] = _mm_set1_ps(abcd.w);
+			}
+
+			Trace_Internal(m_nodes[0], frustum, planes, outElements);
+		}
+
+	protected:
+
+		struct FrustumPlanes
+		{
+			__m128 m_x[6];
+			__m128 m_y[6];
+			__m128 m_z[6];
+			__m128 m_w[6];
+		};
+
+		enum class EOverlap : uint8_t
+		{
+			Outside = 0,
+			Intersects,
+			Inside
+		};
+
+		static EOverlap Classify(const Math::Frustum& frustum, const glm::vec3& min, const glm::vec3& max)
+		{
+			EOverlap res = EOverlap::Inside;
+
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				const glm::vec4& abcd = frustum.GetPlane(i).m_abcd;
+
+				const float farthest = (std::max)(min.x * abcd.x, max.x * abcd.x) + (std::max)(min.y * abcd.y, max.y * abcd.y) + (std::max)(min.z * abcd.z, max.z * abcd.z) + abcd.w;
+				if (farthest <= 0.0f)
+				{
+					return EOverlap::Outside;
+				}
+
+				const float nearest = (std::min)(min.x * abcd.x, max.x * abcd.x) + (std::min)(min.y * abcd.y, max.y * abcd.y) + (std::min)(min.z * abcd.z, max.z * abcd.z) + abcd.w;
+				if (nearest <= 0.0f)
+				{
+					res = EOverlap::Intersects;
+				}
+			}
+
+			return res;
+		}
+
+		void Trace_Internal(const Node& node, const Math::Frustum& frustum, const FrustumPlanes& planes, TVector<TElementType>& outElements) const
+		{
+			const EOverlap overlap = Classify(frustum, node.m_looseMin, node.m_looseMax);
+
+			if (overlap == EOverlap::Outside)
+			{
+				return;
+			}
+
+			if (overlap == EOverlap::Inside)
+			{
+				GetElements_Internal(node, outElements);
+				return;
+			}
+
+			const size_t numElements = node.m_elements.Num();
+			const float* pBounds = node.m_bounds.GetData();
+
+			for (size_t i = 0; i < numElements; i += 4)
+			{
+				const __m128 minX = _mm_loadu_ps(pBounds);
+				const __m128 minY = _mm_loadu_ps(pBounds + 4);
+				const __m128 minZ = _mm_loadu_ps(pBounds + 8);
+				const __m128 maxX = _mm_loadu_ps(pBounds + 12);
+				const __m128 maxY = _mm_loadu_ps(pBounds + 16);
+				const __m128 maxZ = _mm_loadu_ps(pBounds + 20);
+				pBounds += NumFloatsInGroup;
+
+				__m128 outside = _mm_setzero_ps();
+				for (uint32_t j = 0; j < 6; j++)
+				{
+					const __m128 x = _mm_max_ps(_mm_mul_ps(minX, planes.m_x[j]), _mm_mul_ps(maxX, planes.m_x[j]));
+					const __m128 y = _mm_max_ps(_mm_mul_ps(minY, planes.m_y[j]), _mm_mul_ps(maxY, planes.m_y[j]));
+					const __m128 z = _mm_max_ps(_mm_mul_ps(minZ, planes.m_z[j]), _mm_mul_ps(maxZ, planes.m_z[j]));
+					const __m128 distance = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, planes.m_w[j]));
+
+					outside = _mm_or_ps(outside, _mm_cmple_ps(distance, _mm_setzero_ps()));
+				}
+
+				const uint32_t numLanes = (uint32_t)(std::min)(numElements - i, (size_t)4);
+				const uint32_t visible = ~(uint32_t)_mm_movemask_ps(outside) & ((1u << numLanes) - 1);
+
+				for (uint32_t lane = 0; lane < numLanes; lane++)
+				{
+					if (visible & (1u << lane))
+					{
+						outElements.Add(node.m_elements[i + lane]);
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				if (node.m_children[i] != InvalidNode)
+				{
+					Trace_Internal(m_nodes[node.m_children[i]], frustum, planes, outElements);
+				}
+			}
+		}
+
+		void GetElements_Internal(const Node& node, TVector<TElementType>& outElements) const
+		{
+			outElements.AddRange(node.m_elements);
+
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				if (node.m_children[i] != InvalidNode)
+				{
+					GetElements_Internal(m_nodes[node.m_children[i]], outElements);
+				}
+			}
+		}
+
+		static __forceinline uint64_t SpreadBits(uint64_t x)
+		{
+			x &= 0x1fffff;
+			x = (x | x << 32) & 0x1f00000000ffffull;
+			x = (x | x << 16) & 0x1f0000ff0000ffull;
+			x = (x | x << 8) & 0x100f00f00f00f00full;
+			x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+			x = (x | x << 2) & 0x1249249249249249ull;
+			return x;
+		}
+
+		static __forceinline uint64_t GetCode(const glm::uvec3& coords, uint32_t level)
+		{
+			return (1ull << (3 * level)) | SpreadBits(coords.x) | (SpreadBits(coords.y) << 1) | (SpreadBits(coords.z) << 2);
+		}
+
+		// Returns false if the center is out of the root
+		bool GetCell(const glm::ivec3& pos, const glm::ivec3& extents, Cell& outCell) const
+		{
+			const int64_t halfSize = (int64_t)(m_size / 2);
+			const int64_t local[3] = { (int64_t)pos.x - m_center.x + halfSize, (int64_t)pos.y - m_center.y + halfSize, (int64_t)pos.z - m_center.z + halfSize };
+
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				if (local[i] < 0 || local[i] >= (int64_t)m_size)
+				{
+					return false;
+				}
+			}
+
+			// The element fits into the loose bounds if its extents are not greater than the half of the cell
+			const int64_t radius = (std::max)((std::max)(std::abs((int64_t)extents.x), std::abs((int64_t)extents.y)), std::abs((int64_t)extents.z));
+
+			uint32_t level = 0;
+			while (level < m_depth && radius * 2 <= (int64_t)(m_size >> (level + 1)))
+			{
+				level++;
+			}
+
+			outCell.m_level = level;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				outCell.m_coords[i] = (uint32_t)((local[i] << level) / (int64_t)m_size);
+			}
+
+			outCell.m_code = GetCode(outCell.m_coords, level);
+
+			return true;
+		}
+
+		void InitNode(Node& node, const Cell& cell) const
+		{
+			const float cellSize = (float)m_size / (float)(1u << cell.m_level);
+			const glm::vec3 min = glm::vec3(m_center) - glm::vec3((float)(m_size / 2)) + glm::vec3(cell.m_coords) * cellSize;
+			const glm::vec3 center = min + glm::vec3(cellSize * 0.5f);
+
+			node.m_code = cell.m_code;
+			node.m_looseMin = center - glm::vec3(cellSize);
+			node.m_looseMax = center + glm::vec3(cellSize);
+		}
+
+		uint32_t GetOrAddNode(const Cell& cell)
+		{
+			if (cell.m_level == 0)
+			{
+				return 0;
+			}
+
+			uint32_t* pIndex = nullptr;
+			if (m_codeToNode.Find(cell.m_code, pIndex))
+			{
+				return *pIndex;
+			}
+
+			const Cell parentCell{ cell.m_code >> 3, cell.m_level - 1, cell.m_coords / 2u };
+			const uint32_t parentIndex = GetOrAddNode(parentCell);
+
+			uint32_t nodeIndex = 0;
+			if (m_freeNodes.Num())
+			{
+				nodeIndex = *m_freeNodes.Last();
+				m_freeNodes.RemoveLast();
+			}
+			else
+			{
+				nodeIndex = (uint32_t)m_nodes.Num();
+				m_nodes.Add(Node());
+			}
+
+			Node& node = m_nodes[nodeIndex];
+			InitNode(node, cell);
+			node.m_parent = parentIndex;
+
+			Node& parent = m_nodes[parentIndex];
+			parent.m_children[cell.m_code & 7] = nodeIndex;
+			parent.m_numChildren++;
+
+			m_codeToNode[cell.m_code] = nodeIndex;
+
+			return nodeIndex;
+		}
+
+		// Doesn't touch m_map for the removed element
+		void RemoveAt(const Location& location)
+		{
+			Node& node = m_nodes[location.m_node];
+			node.RemoveAtSwap(location.m_slot);
+
+			if (location.m_slot < node.m_elements.Num())
+			{
+				m_map[node.m_elements[location.m_slot]].m_slot = location.m_slot;
+			}
+
+			// Release the empty branch
+			uint32_t nodeIndex = location.m_node;
+			while (nodeIndex != 0 && m_nodes[nodeIndex].IsEmpty())
+			{
+				Node& emptyNode = m_nodes[nodeIndex];
+				const uint32_t parentIndex = emptyNode.m_parent;
+
+				Node& parent = m_nodes[parentIndex];
+				parent.m_children[emptyNode.m_code & 7] = InvalidNode;
+				parent.m_numChildren--;
+
+				m_codeToNode.Remove(emptyNode.m_code);
+
+				// Code 0 marks the released node
+				emptyNode = Node();
+				emptyNode.m_code = 0;
+				m_freeNodes.Add(nodeIndex);
+
+				nodeIndex = parentIndex;
+			}
+		}
+
+		glm::ivec3 m_center{};
+		uint32_t m_size = 1;
+		uint32_t m_depth = 0;
+
+		TVector<Node> m_nodes;
+		TVector<uint32_t> m_freeNodes;
+		TFlatMap<uint64_t, uint32_t> m_codeToNode;
+		TFlatMap<TElementType, Location> m_map;
+	};
+}
@@ -4,6 +4,7 @@
 #include <functional>
 #include <concepts>
 #include <type_traits>
+#include <optional>
 #include "Core/Defines.h"
 #include "Memory/LockFreeHeapAllocator.h"
 #include "Containers/Vector.h"
@@ -1,13 +1,19 @@
 #include <unordered_map>
 #include "Containers/Map.h"
+#include "Containers/FlatMap.h"
 #include "Containers/ConcurrentMap.h"
-#include "Core/Utils.h"
+#include "Containers/ConcurrentHashMap.h"
+#include "Containers/ContainersBenchmark.h"
+#include "Core/Benchmark.h"
 #include <random>
+#include <thread>
+
+#ifndef SAILOR_BENCHMARKS_STANDALONE
 #include "Tasks/Tasks.h"
 #include "Tasks/Scheduler.h"
+#endif
 
 using namespace Sailor::Memory;
-using Timer = Sailor::Utils::Timer;
 
 namespace Sailor
 {
@@ -112,98 +118,75 @@ namespace Sailor
 		uint32_t m_value;
 	};
 
-	struct Result
-	{
-		std::string m_className;
-
-		Result() = default;
-		Result(std::string className) : m_className(className) {}
-
-		size_t m_operator = 0;
-		size_t m_containsKey = 0;
-		size_t m_containsValue = 0;
-		size_t m_removeFirst = 0;
-		size_t m_remove = 0;
-		float m_misses = 0.0f;
-
-		bool m_bSanityPassed = false;
-
-		void PrintLog()
-		{
-			SAILOR_LOG("\nClassName: %s", m_className.c_str());
-			SAILOR_LOG("Sanity check passed: %d", m_bSanityPassed);
-			SAILOR_LOG("Performance test operator[]: %llums", m_operator);
-			SAILOR_LOG("Performance test Remove: %llums", m_remove);
-			SAILOR_LOG("Performance test ContainsKey (misses %.2f): %llums", m_misses, m_containsKey);
-			SAILOR_LOG("Performance test ContainsValue: %llums", m_containsValue);
-		}
-	};
-
 	template<typename TValue, typename TContainer>
 	class TestCase_MapPerfromance
 	{
 	public:
 
-		static Result RunTests()
-		{
-			Result r = PerformanceTests();
-			r.m_bSanityPassed = true;
-			return r;
-		}
+		static constexpr size_t Count = 300000;
 
-		static Result PerformanceTests()
+		static void PerformanceTests(Benchmark::State& state)
 		{
-			Result res(typeid(TContainer).name());
-
-			const size_t count = 300000;
-
 			TContainer container;
-			Timer tMap;
 
-			tMap.Start();
-			for (size_t i = 0; i < count; i++)
-			{
-				container[i] = i * 3;
-			}
-			tMap.Stop();
+			state.Measure("operator[]", Count, [&]()
+				{
+					for (size_t i = 0; i < Count; i++)
+					{
+						container[i] = i * 3;
+					}
+				});
 
-			res.m_operator = tMap.ResultMs();
+			std::mt19937 g;
+			size_t misses = 0;
 
-			tMap.Clear();
-			std::random_device rd;
-			std::mt19937 g(rd());
+			g.seed(0);
+			state.Measure("contains_key", Count, [&]()
+				{
+					for (size_t i = 0; i < Count; i++)
+					{
+						const size_t value = i % 2 ? g() : g() % Count;
+						if (!ContainsKey(container, value))
+						{
+							misses++;
+						}
+					}
+				});
 
-			std::atomic<uint32_t> misses = 0;
+			state.SetCounter("contains_key", "misses", misses / (double)Count);
 
-			g.seed(0);
-			tMap.Start();
-			for (size_t i = 0; i < count; i++)
-			{
-				const size_t value = i % 2 ? g() : g() % count;
-				if (!container.ContainsKey(value))
+			state.Measure("remove", Count / 2, [&]()
 				{
-					misses++;
-				}
-			}
-			tMap.Stop();
+					for (size_t i = 0; i < Count; i++)
+					{
+						if (i % 2)
+						{
+							Remove(container, i);
+						}
+					}
+				});
+		}
 
-			res.m_containsKey = tMap.ResultMs();
-			res.m_misses = misses.load() / (float)count;
+		// Steady amount of the elements with the constant insert/remove, the buckets are emptied and refilled
+		static void ChurnTests(Benchmark::State& state)
+		{
+			const size_t numAlive = 65536;
+			const size_t count = 1000000;
 
-			tMap.Clear();
-			tMap.Start();
-			for (size_t i = 0; i < count; i++)
+			TContainer container;
+			for (size_t i = 0; i < numAlive; i++)
 			{
-				if (i % 2)
-				{
-					container.Remove(i);
-				}
+				container[i] = TValue(i);
 			}
-			tMap.Stop();
 
-			res.m_remove = tMap.ResultMs();
-
-			return res;
+			state.Measure("insert_remove_churn", count, [&]()
+				{
+					for (size_t i = numAlive; i < numAlive + count; i++)
+					{
+						Remove(container, i - numAlive);
+						container[i] = TValue(i);
+					}
+				});
 		}
 
 		static bool SanityCheck()
@@ -234,7 +217,7 @@ namespace Sailor
 
 				for (const auto& el : container)
 				{
-					if (ideal[el.m_first] != el.m_second)
+					if (ideal[el.m_first] != *el.m_second)
 					{
 						return false;
 					}
@@ -242,96 +225,51 @@ namespace Sailor
 			}
 			return true;
 		}
-	};
 
-	template<typename TValue>
-	class TestCase_MapPerfromance<TValue, std::unordered_map<size_t, TValue>>
-	{
-	public:
+	protected:
 
-		static Result RunTests()
+		static bool ContainsKey(TContainer& container, size_t key)
 		{
-			Result r = PerformanceTests();
-			r.m_bSanityPassed = true;
-			return r;
-		}
-
-		static Result PerformanceTests()
-		{
-			Result res(typeid(std::unordered_map<size_t, TValue>).name());
-
-			const size_t count = 300000;
-
-			Timer stdMap;
-			std::unordered_map<size_t, TValue> ideal;
-
-			stdMap.Start();
-			for (size_t i = 0; i < count; i++)
+			if constexpr (requires { container.contains(key); })
 			{
-				ideal[i] = i * 3;
+				return container.contains(key);
 			}
-			stdMap.Stop();
-
-			res.m_operator = stdMap.ResultMs();
-
-			stdMap.Clear();
-
-			std::random_device rd;
-			std::mt19937 g(rd());
-
-			std::atomic<uint32_t> misses = 0;
-
-			misses = 0;
-			g.seed(0);
-			stdMap.Start();
-			for (size_t i = 0; i < count; i++)
+			else
 			{
-				const size_t value = i % 2 ? g() : g() % count;
-				if (ideal.find(value) == ideal.end())
-				{
-					misses++;
-				}
+				return container.ContainsKey(key);
 			}
-			stdMap.Stop();
-			res.m_containsKey = stdMap.ResultMs();
-			res.m_misses = misses.load() / (float)count;
+		}
 
-			stdMap.Clear();
-			stdMap.Start();
-			for (size_t i = 0; i < count; i++)
+		static void Remove(TContainer& container, size_t key)
+		{
+			if constexpr (requires { container.erase(key); })
 			{
-				if (i % 2)
-				{
-					ideal.erase(i);
-				}
+				container.erase(key);
+			}
+			else
+			{
+				container.Remove(key);
 			}
-			stdMap.Stop();
-
-			res.m_remove = stdMap.ResultMs();
-			return res;
 		}
 	};
 
+#ifndef SAILOR_BENCHMARKS_STANDALONE
 	template<typename TValue, typename TContainer>
 	class TestCase_ConcurrentMapPerfromance
 	{
 	public:
 
-		static Result RunTests()
-		{
-			const size_t numThreads = 16;
-			const size_t count = 300000;
-			Result res(typeid(TContainer).name());
+		static constexpr size_t NumThreads = 16;
+		static constexpr size_t Count = 300000;
 
+		static void PerformanceTests(Benchmark::State& state)
+		{
 			TContainer container;
-			Timer tMap;
-
-			std::random_device rd;
-			std::mt19937 g(rd());
 
+			std::mt19937 g;
 			std::vector<uint32_t> order;
 
-			for (uint32_t i = 0; i < count; i++)
+			for (uint32_t i = 0; i < Count; i++)
 			{
 				order.push_back(i);
 			}
@@ -342,77 +280,77 @@ namespace Sailor
 
 			TVector<Tasks::ITaskPtr> tasksToWait;
 
-			for (uint32_t i = 0; i < numThreads; i++)
+			for (uint32_t i = 0; i < NumThreads; i++)
 			{
 				auto task = Tasks::CreateTask("Test Concurrent Map", [&container, i, cShift]() mutable
 					{
 						for (uint32_t k = 0; k < 1; k++)
 						{
-							uint32_t start = uint32_t(i * (count / numThreads) + k * cShift);
+							uint32_t start = uint32_t(i * (Count / NumThreads) + k * cShift);
 
-							for (uint32_t j = start; j < count + start; j++)
+							for (uint32_t j = start; j < Count + start; j++)
 							{
-								container.At_Lock(j % count);
-								container.Unlock(j % count);
+								container.At_Lock(j % Count);
+								container.Unlock(j % Count);
 							}
 						}
 					});
 				tasksToWait.Add(task);
 			}
 
-			tMap.Start();
-			for (uint32_t i = 0; i < numThreads; i++)
-			{
-				tasksToWait[i]->Run();
-			}
-
-			for (uint32_t i = 0; i < numThreads; i++)
-			{
-				tasksToWait[i]->Wait();
-			}
-			tMap.Stop();
+			state.Measure("at_lock", Count * NumThreads, [&]()
+				{
+					for (uint32_t i = 0; i < NumThreads; i++)
+					{
+						tasksToWait[i]->Run();
+					}
 
-			res.m_operator = tMap.ResultMs();
+					for (uint32_t i = 0; i < NumThreads; i++)
+					{
+						tasksToWait[i]->Wait();
+					}
+				});
 
-			res.m_bSanityPassed = container.Num() == count;
-			for (size_t i = 0; i < count; i++)
+			bool bSanityPassed = container.Num() == Count;
+			for (size_t i = 0; i < Count; i++)
 			{
 				if (*((int*)container[0].m_data) != *((int*)container[i].m_data))
 				{
-					res.m_bSanityPassed = false;
+					bSanityPassed = false;
 					break;
 				}
 			}
 
-			tMap.Clear();
+			if (!bSanityPassed)
+			{
+				state.Fail("Wrong values after the concurrent access");
+			}
 
-			std::atomic<uint32_t> misses = 0;
+			size_t misses = 0;
 
 			g.seed(0);
-			tMap.Start();
-			for (size_t i = 0; i < count; i++)
-			{
-				const size_t value = i % 2 ? g() : g() % count;
-				if (!container.ContainsKey(value))
+			state.Measure("contains_key", Count, [&]()
 				{
-					misses++;
-				}
-			}
-			tMap.Stop();
-
-			res.m_containsKey = tMap.ResultMs();
-			res.m_misses = misses.load() / (float)count;
+					for (size_t i = 0; i < Count; i++)
+					{
+						const size_t value = i % 2 ? g() : g() % Count;
+						if (!container.ContainsKey(value))
+						{
+							misses++;
+						}
+					}
+				});
 
-			tMap.Clear();
+			state.SetCounter("contains_key", "misses", misses / (double)Count);
 
 			tasksToWait.Clear();
-			for (uint32_t i = 0; i < numThreads; i++)
+			for (uint32_t i = 0; i < NumThreads; i++)
 			{
 				auto task = Tasks::CreateTask("Test Concurrent Map", [&container, i]() mutable
 					{
-						uint32_t start = uint32_t(i * (count / numThreads));
+						uint32_t start = uint32_t(i * (Count / NumThreads));
 
-						for (uint32_t j = start; j < count + start; j++)
+						for (uint32_t j = start; j < Count + start; j++)
 						{
 							if (j % 2)
 							{
@@ -424,46 +362,221 @@ namespace Sailor
 				tasksToWait.Add(task);
 			}
 
-			tMap.Start();
-			for (uint32_t i = 0; i < numThreads; i++)
+			state.Measure("remove", Count * NumThreads / 2, [&]()
+				{
+					for (uint32_t i = 0; i < NumThreads; i++)
+					{
+						tasksToWait[i]->Run();
+					}
+
+					for (uint32_t i = 0; i < NumThreads; i++)
+					{
+						tasksToWait[i]->Wait();
+					}
+				});
+		}
+	};
+#endif
+
+	// Read mostly workload like the shader/material caches: 95% of lookups by existing keys, 5% of overwrites
+	template<typename TContainer>
+	class TestCase_MapContention
+	{
+	public:
+
+		static constexpr size_t NumKeys = 65536;
+		static constexpr size_t NumOpsPerThread = 1 << 18;
+		static constexpr uint32_t WritesPercent = 5;
+
+		static void PerformanceTests(Benchmark::State& state)
+		{
+			for (const size_t numThreads : { 1, 2, 4, 8, 16, 32, 64 })
 			{
-				tasksToWait[i]->Run();
+				TContainer container;
+				for (size_t i = 0; i < NumKeys; i++)
+				{
+					Write(container, i, i * 3);
+				}
+
+				std::atomic<size_t> misses = 0;
+				std::vector<std::thread> threads;
+
+				const std::string phase = "threads_" + std::to_string(numThreads);
+				state.Measure(phase.c_str(), numThreads * NumOpsPerThread, [&]()
+					{
+						for (size_t t = 0; t < numThreads; t++)
+						{
+							threads.emplace_back([&container, &misses, t]()
+								{
+									std::mt19937 g((uint32_t)t);
+									size_t localMisses = 0;
+
+									for (size_t i = 0; i < NumOpsPerThread; i++)
+									{
+										const size_t key = g() % NumKeys;
+										if (g() % 100 < WritesPercent)
+										{
+											Write(container, key, key * 3);
+										}
+										else if (Read(container, key) != key * 3)
+										{
+											localMisses++;
+										}
+									}
+
+									misses += localMisses;
+								});
+						}
+
+						for (auto& thread : threads)
+						{
+							thread.join();
+						}
+					});
+
+				if (misses.load() != 0)
+				{
+					state.Fail("Wrong values are read");
+				}
 			}
+		}
+
+	protected:
 
-			for (uint32_t i = 0; i < numThreads; i++)
+		static void Write(TContainer& container, size_t key, size_t value)
+		{
+			if constexpr (requires { container.At_Lock(key); })
 			{
-				tasksToWait[i]->Wait();
+				container.At_Lock(key) = value;
+				container.Unlock(key);
 			}
-			tMap.Stop();
-			res.m_remove = tMap.ResultMs();
+			else
+			{
+				container.Insert(key, value);
+			}
+		}
 
-			return res;
+		static size_t Read(TContainer& container, size_t key)
+		{
+			if constexpr (requires { container.At_Lock(key); })
+			{
+				// Reads have to take the lock, the bucket could be rehashed
+				const size_t res = container.At_Lock(key);
+				container.Unlock(key);
+				return res;
+			}
+			else
+			{
+				size_t res = 0;
+				container.Find(key, res);
+				return res;
+			}
 		}
 	};
 
-	void RunMapBenchmark()
+	class TestCase_ConcurrentHashMap
+	{
+	public:
+
+		static constexpr size_t NumKeys = 1 << 17;
+
+		// The writer grows the table while the reader iterates it: no key is visited twice
+		// and the keys inserted before the iteration are not missed
+		static bool GrowWhileIterating()
+		{
+			TConcurrentHashMap<size_t, size_t> container;
+			std::atomic<size_t> numInserted = 0;
+			bool bPassed = true;
+
+			std::thread writer([&container, &numInserted]()
+				{
+					for (size_t i = 0; i < NumKeys; i++)
+					{
+						container.Insert(i, i);
+						numInserted.store(i + 1, std::memory_order_release);
+					}
+				});
+
+			std::vector<uint8_t> visited;
+			size_t numIterations = 0;
+			while (numInserted.load(std::memory_order_acquire) < NumKeys || numIterations == 0)
+			{
+				const size_t numBefore = numInserted.load(std::memory_order_acquire);
+
+				visited.assign(NumKeys, 0);
+				container.ForEach([&](const size_t& key, const size_t& value)
+					{
+						bPassed &= key == value && visited[key]++ == 0;
+					});
+
+				bPassed &= std::find(visited.begin(), visited.begin() + numBefore, 0) == visited.begin() + numBefore;
+				numIterations++;
+			}
+
+			writer.join();
+			return bPassed;
+		}
+
+		// The cache could be cleared right before the owner of the cached resources is destroyed
+		static bool ClearReleasesValues()
+		{
+			std::shared_ptr<int> value = std::make_shared<int>(0);
+
+			TConcurrentHashMap<size_t, std::shared_ptr<int>> container;
+			for (size_t i = 0; i < 1024; i++)
+			{
+				container.Insert(i, value);
+			}
+
+			container.Clear();
+
+			return container.IsEmpty() && value.use_count() == 1;
+		}
+	};
+
+	void RegisterMapBenchmarks(Benchmark::Runner& runner)
 	{
 		using TDeepData = TDeepData<1024>;
 		using TPlainData = TPlainData<1024>;
 
-		printf("\nStarting Map benchmark...\n");
+		runner.AddCheck("map/sanity/TMap<TPlainData>", &TestCase_MapPerfromance<TPlainData, TMap<size_t, TPlainData>>::SanityCheck);
+		runner.AddCheck("map/sanity/TMap<TDeepData>", &TestCase_MapPerfromance<TDeepData, TMap<size_t, TDeepData>>::SanityCheck);
+		runner.AddCheck("map/sanity/TFlatMap<TPlainData>", &TestCase_MapPerfromance<TPlainData, TFlatMap<size_t, TPlainData>>::SanityCheck);
+		runner.AddCheck("map/sanity/TFlatMap<TDeepData>", &TestCase_MapPerfromance<TDeepData, TFlatMap<size_t, TDeepData>>::SanityCheck);
+		runner.AddCheck("map/sanity/TConcurrentHashMap/grow_while_iterating", &TestCase_ConcurrentHashMap::GrowWhileIterating);
+		runner.AddCheck("map/sanity/TConcurrentHashMap/clear_releases_values", &TestCase_ConcurrentHashMap::ClearReleasesValues);
 
-		TVector<Result> res;
+		runner.Add("map/std::unordered_map<TPlainData>", &TestCase_MapPerfromance<TPlainData, std::unordered_map<size_t, TPlainData>>::PerformanceTests);
+		runner.Add("map/std::unordered_map<TDeepData>", &TestCase_MapPerfromance<TDeepData, std::unordered_map<size_t, TDeepData>>::PerformanceTests);
 
-		res.Add(TestCase_MapPerfromance<TPlainData, std::unordered_map<size_t, TPlainData>>::RunTests());
-		res.Add(TestCase_MapPerfromance<TDeepData, std::unordered_map<size_t, TDeepData>>::RunTests());
+		runner.Add("map/TMap<TPlainData>", &TestCase_MapPerfromance<TPlainData, TMap<size_t, TPlainData>>::PerformanceTests);
+		runner.Add("map/TMap<TDeepData>", &TestCase_MapPerfromance<TDeepData, TMap<size_t, TDeepData>>::PerformanceTests);
 
-		res.Add(TestCase_MapPerfromance<TPlainData, Sailor::TMap<size_t, TPlainData>>::RunTests());
-		res.Add(TestCase_MapPerfromance<TDeepData, Sailor::TMap<size_t, TDeepData>>::RunTests());
+		runner.Add("map/TFlatMap<TPlainData>", &TestCase_MapPerfromance<TPlainData, TFlatMap<size_t, TPlainData>>::PerformanceTests);
+		runner.Add("map/TFlatMap<TDeepData>", &TestCase_MapPerfromance<TDeepData, TFlatMap<size_t, TDeepData>>::PerformanceTests);
 
-		res.Add(TestCase_ConcurrentMapPerfromance<TPlainData, Sailor::TConcurrentMap<size_t, TPlainData, 32u, ERehashPolicy::Always>>::RunTests());
-		res.Add(TestCase_ConcurrentMapPerfromance<TDeepData, Sailor::TConcurrentMap<size_t, TDeepData, 32u, ERehashPolicy::Always>>::RunTests());
+		runner.Add("map/churn/std::unordered_map", &TestCase_MapPerfromance<size_t, std::unordered_map<size_t, size_t>>::ChurnTests);
+		runner.Add("map/churn/TMap", &TestCase_MapPerfromance<size_t, TMap<size_t, size_t>>::ChurnTests);
 
-		for (auto& r : res)
+#ifndef SAILOR_BENCHMARKS_STANDALONE
+		// The tasks are executed by the scheduler, that is not available in the standalone runs
+		if (App::GetSubmodule<Tasks::Scheduler>())
 		{
-			r.PrintLog();
+			runner.AddMultithreaded("map/TConcurrentMap<TPlainData>", &TestCase_ConcurrentMapPerfromance<TPlainData, TConcurrentMap<size_t, TPlainData, 32u, ERehashPolicy::Always>>::PerformanceTests);
+			runner.AddMultithreaded("map/TConcurrentMap<TDeepData>", &TestCase_ConcurrentMapPerfromance<TDeepData, TConcurrentMap<size_t, TDeepData, 32u, ERehashPolicy::Always>>::PerformanceTests);
 		}
+#endif
+
+		runner.AddMultithreaded("map/contention/TConcurrentMap", &TestCase_MapContention<TConcurrentMap<size_t, size_t>>::PerformanceTests);
+		runner.AddMultithreaded("map/contention/TConcurrentHashMap", &TestCase_MapContention<TConcurrentHashMap<size_t, size_t>>::PerformanceTests);
+	}
+
+	void RunMapBenchmark()
+	{
+		printf("\nStarting Map benchmark...\n");
 
-		printf("\n\n");
+		Benchmark::Runner runner;
+		RegisterMapBenchmarks(runner);
+		Benchmark::Print(runner.Run(Benchmark::Settings()));
 	}
 }
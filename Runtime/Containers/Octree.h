@@ -10,9 +10,8 @@
 #include "Math/Math.h"
 #include "Memory/Memory.h"
 #include "Containers/Concepts.h"
-#include "Containers/Map.h"
+#include "Containers/FlatMap.h"
 #include "Containers/Vector.h"
-#include "RHI/DebugContext.h"
 #include "Math/Bounds.h"
 
 namespace Sailor
@@ -94,7 +93,7 @@ namespace Sailor
 			uint32_t m_size = 1;
 			glm::ivec3 m_center{};
 			TNode* m_internal = nullptr;
-			TMap<TElementType, TBounds> m_elements{ NumElementsInNode };
+			TFlatMap<TElementType, TBounds> m_elements{ NumElementsInNode };
 		};
 
 	public:
@@ -235,7 +234,9 @@ namespace Sailor
 		}
 
 		__forceinline void Resolve() { Resolve_Internal(*m_root); }
-		__forceinline void DrawOctree(RHI::DebugContext& context, float duration = 0.0f) const { DrawOctree_Internal(*m_root, context, duration); }
+		// The context is RHI::DebugContext, the template keeps the container free of the renderer
+		template<typename TDebugContext>
+		__forceinline void DrawOctree(TDebugContext& context, float duration = 0.0f) const { DrawOctree_Internal(*m_root, context, duration); }
 		__forceinline void Trace(const Math::Frustum& frustum, TVector<TElementType>& outElements) const
 		{
 			outElements.Clear(false);
@@ -291,7 +292,8 @@ namespace Sailor
 			}
 		}
 
-		void DrawOctree_Internal(const TNode& node, RHI::DebugContext& context, float duration = 0.0f) const
+		template<typename TDebugContext>
+		void DrawOctree_Internal(const TNode& node, TDebugContext& context, float duration = 0.0f) const
 		{
 			if (!node.IsLeaf())
 			{
@@ -477,7 +479,7 @@ namespace Sailor
 		uint32_t m_minSize = 1;
 		size_t m_numNodes = 1u;
 		TAllocator m_allocator{};
-		TMap<TElementType, TNode*> m_map{};
+		TFlatMap<TElementType, TNode*> m_map{};
 	};
 
 	SAILOR_API void RunOctreeBenchmark();
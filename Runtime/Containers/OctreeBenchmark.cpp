@@ -1,39 +1,30 @@
 #include "Containers/Octree.h"
-#include "Containers/Octree2.h"
-#include "Core/Utils.h"
+#include "Containers/LooseOctree.h"
+#include "Containers/AABBTree.h"
+#include "Containers/ContainersBenchmark.h"
+#include "Core/Benchmark.h"
 #include <random>
 
 namespace Sailor
 {
 	using namespace Sailor::Memory;
-	using Timer = Utils::Timer;
 
 	template<typename TContainer>
 	class TestCase_OctreePerfromance
 	{
 	public:
 
-		static void RunTests()
-		{
-			const std::string tOctreeClassName = typeid(TContainer).name();
-
-			printf("%s\n", tOctreeClassName.c_str());
-			printf("Sanity check passed: %d\n", SanityCheck());
-			printf("\n");
-			PerformanceTests(10000);
-			printf("\n");
-			PerformanceTests(25000);
-			printf("\n");
-			PerformanceTests(1000000);
-			printf("\n");
-		}
+		static constexpr size_t NumFrustums = 64;
 
-		static bool SanityCheck()
+		static void Register(Benchmark::Runner& runner, const char* className)
 		{
-			return true;
+			for (const uint32_t count : { 10000u, 25000u, 1000000u })
+			{
+				runner.Add(std::string("octree/") + className + "/" + std::to_string(count), [count](Benchmark::State& state) { PerformanceTests(state, count); });
+			}
 		}
 
-		static void PerformanceTests(const uint32_t count)
+		static void PerformanceTests(Benchmark::State& state, const uint32_t count)
 		{
 			struct Data
 			{
@@ -42,6 +33,9 @@ namespace Sailor
 				size_t m_data;
 			};
 
+			// The same data for all containers
+			srand(count);
+
 			TVector<Data> data(count);
 
 			for (size_t i = 0; i < count; i++)
@@ -51,60 +45,96 @@ namespace Sailor
 				data[i].m_data = i;
 			}
 
-			Timer tOctree;
 			TContainer container(glm::ivec3(0, 0, 0), 2048u, 2u);
 
-			tOctree.Start();
-			for (size_t i = 0; i < count; i++)
-			{
-				const bool bInserted = container.Insert(data[i].m_pos, data[i].m_extents, data[i].m_data);
+			state.Measure("insert", count, [&]()
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						container.Insert(data[i].m_pos, data[i].m_extents, data[i].m_data);
+					}
+				});
+
+			state.SetCounter("insert", "nodes", (double)container.NumNodes());
+			state.SetCounter("insert", "elements", (double)container.Num());
 
-				if (!bInserted) continue;
-				check(bInserted);
+			TVector<Math::Frustum> frustums;
+			for (size_t i = 0; i < NumFrustums; i++)
+			{
+				const glm::vec3 eye = glm::vec3(rand() % 1600 - 800, rand() % 1600 - 800, rand() % 1600 - 800);
+				const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+				frustums.Add(Math::Frustum(projection * glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), Math::vec3_Up)));
 			}
-			tOctree.Stop();
-			SAILOR_LOG("Performance test insert:\n\t TOctree %llums, nodes:%llu, elements:%llu", tOctree.ResultMs(), container.NumNodes(), container.Num());
 
-			tOctree.Clear();
-			tOctree.Start();
+			size_t numTraced = 0;
+			TVector<size_t> traced;
+
+			state.Measure("trace", NumFrustums, [&]()
+				{
+					for (const auto& frustum : frustums)
+					{
+						container.Trace(frustum, traced);
+						numTraced += traced.Num();
+					}
+				});
+
+			state.SetCounter("trace", "traced", (double)numTraced);
+
 			const auto shiftMax = 4;
-			for (size_t i = 0; i < count; i++)
-			{
-				const auto shift = glm::ivec3(rand() % shiftMax - shiftMax / 2, rand() % shiftMax - shiftMax / 2, rand() % shiftMax - shiftMax / 2);
-				const bool bUpdated = container.Update(data[i].m_pos + shift, data[i].m_extents, data[i].m_data);
 
-				if (!bUpdated) continue;
-				//check(bUpdated);
-			}
-			tOctree.Stop();
-			SAILOR_LOG("Performance test update:\n\t TOctree %llums, nodes:%llu, elements:%llu", tOctree.ResultMs(), container.NumNodes(), container.Num());
+			state.Measure("update", count, [&]()
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						const auto shift = glm::ivec3(rand() % shiftMax - shiftMax / 2, rand() % shiftMax - shiftMax / 2, rand() % shiftMax - shiftMax / 2);
+						container.Update(data[i].m_pos + shift, data[i].m_extents, data[i].m_data);
+					}
+				});
 
-			tOctree.Clear();
-			tOctree.Start();
-			for (size_t i = 0; i < count; i++)
+			state.SetCounter("update", "nodes", (double)container.NumNodes());
+
+			if constexpr (requires { container.UpdateBatch(TVector<TPair<size_t, Math::AABB>>()); })
 			{
-				const bool bRemoved = container.Remove(data[i].m_data);
+				TVector<TPair<size_t, Math::AABB>> batch;
+				batch.Reserve(count);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					const auto shift = glm::ivec3(rand() % shiftMax - shiftMax / 2, rand() % shiftMax - shiftMax / 2, rand() % shiftMax - shiftMax / 2);
+					batch.Emplace(TPair<size_t, Math::AABB>(data[i].m_data, Math::AABB(glm::vec3(data[i].m_pos + shift), glm::vec3(data[i].m_extents))));
+				}
 
-				if (!bRemoved) continue;
-				//check(bRemoved);
+				state.Measure("batch_update", count, [&]() { container.UpdateBatch(batch); });
+				state.SetCounter("batch_update", "nodes", (double)container.NumNodes());
 			}
-			tOctree.Stop();
-			SAILOR_LOG("Performance test remove:\n\t TOctree %llums, nodes:%llu, elements:%llu", tOctree.ResultMs(), container.NumNodes(), container.Num());
-
-			tOctree.Clear();
-			tOctree.Start();
-			container.Resolve();
-			tOctree.Stop();
-			SAILOR_LOG("Performance test resolve:\n\t TOctree %llums, nodes:%llu, elements:%llu", tOctree.ResultMs(), container.NumNodes(), container.Num());
+
+			state.Measure("remove", count, [&]()
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						container.Remove(data[i].m_data);
+					}
+				});
+
+			state.Measure("resolve", [&]() { container.Resolve(); });
+			state.SetCounter("resolve", "nodes", (double)container.NumNodes());
+			state.SetCounter("resolve", "elements", (double)container.Num());
 		}
 	};
 
+	void RegisterOctreeBenchmarks(Benchmark::Runner& runner)
+	{
+		TestCase_OctreePerfromance<TOctree<size_t>>::Register(runner, "TOctree");
+		TestCase_OctreePerfromance<TLooseOctree<size_t>>::Register(runner, "TLooseOctree");
+		TestCase_OctreePerfromance<TAABBTree<size_t>>::Register(runner, "TAABBTree");
+	}
 
 	void RunOctreeBenchmark()
 	{
 		printf("\nStarting Octree benchmark...\n");
 
-		TestCase_OctreePerfromance<Sailor::TOctree<size_t>>::RunTests();
-		//TestCase_OctreePerfromance<Sailor::TOctree2<size_t>>::RunTests();
+		Benchmark::Runner runner;
+		RegisterOctreeBenchmarks(runner);
+		Benchmark::Print(runner.Run(Benchmark::Settings()));
 	}
-}
\ No newline at end of file
+}
@@ -86,4 +86,7 @@ namespace Sailor
 		TKeyType m_first{};
 		TValueType m_second{};
 	};
+
+	template<typename TKeyType, typename TValueType>
+	struct TIsTriviallyRelocatable<TPair<TKeyType, TValueType>> : std::bool_constant<IsTriviallyRelocatable<TKeyType> && IsTriviallyRelocatable<TValueType>> {};
 }
@@ -0,0 +1,190 @@
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Containers/ConcurrentQueue.h"
+#include "Core/Utils.h"
+
+#ifdef _MSC_VER
+#include <concurrent_queue.h>
+#endif
+
+using Timer = Sailor::Utils::Timer;
+
+namespace Sailor
+{
+	// The baseline
+	template<typename TElementType>
+	class TLockedQueue
+	{
+	public:
+
+		void Push(TElementType element)
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_queue.push_back(std::move(element));
+		}
+
+		bool TryPop(TElementType& out)
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (m_queue.empty())
+			{
+				return false;
+			}
+
+			out = std::move(m_queue.front());
+			m_queue.pop_front();
+			return true;
+		}
+
+	protected:
+
+		std::mutex m_lock;
+		std::deque<TElementType> m_queue;
+	};
+
+	template<typename TContainer>
+	class TestCase_QueuePerformance
+	{
+	public:
+
+		static constexpr size_t NumOpsPerProducer = 1 << 18;
+		static constexpr size_t BoundedCapacity = 1 << 16;
+
+		static void RunTests(const char* className, std::initializer_list<size_t> threads)
+		{
+			SAILOR_LOG("\nClassName: %s", className);
+
+			for (const size_t numThreads : threads)
+			{
+				TContainer* pContainer = Create();
+
+				std::atomic<size_t> numPopped = 0;
+				std::atomic<uint64_t> checksum = 0;
+				std::vector<std::thread> producers;
+				std::vector<std::thread> consumers;
+
+				const size_t numOps = numThreads * NumOpsPerProducer;
+
+				Timer timer;
+				timer.Start();
+				for (size_t t = 0; t < numThreads; t++)
+				{
+					producers.emplace_back([pContainer, t]()
+						{
+							for (size_t i = 0; i < NumOpsPerProducer; i++)
+							{
+								Push(*pContainer, t * NumOpsPerProducer + i);
+							}
+						});
+
+					consumers.emplace_back([pContainer, &numPopped, &checksum, numOps]()
+						{
+							uint64_t localChecksum = 0;
+							size_t value = 0;
+
+							while (numPopped.load(std::memory_order_relaxed) < numOps)
+							{
+								if (TryPop(*pContainer, value))
+								{
+									localChecksum += value;
+									numPopped.fetch_add(1, std::memory_order_relaxed);
+								}
+								else
+								{
+									std::this_thread::yield();
+								}
+							}
+
+							checksum += localChecksum;
+						});
+				}
+
+				for (auto& thread : producers)
+				{
+					thread.join();
+				}
+
+				for (auto& thread : consumers)
+				{
+					thread.join();
+				}
+				timer.Stop();
+
+				delete pContainer;
+
+				const uint64_t expectedChecksum = (uint64_t)numOps * (numOps - 1) / 2;
+				const double mops = (double)numOps / (std::max)((double)timer.ResultMs(), 1.0) / 1000.0;
+				SAILOR_LOG("Producers/Consumers %2llu: %6llums, %8.2f Mops/s, sanity check passed: %d", (uint64_t)numThreads, timer.ResultMs(), mops, checksum.load() == expectedChecksum);
+			}
+		}
+
+	protected:
+
+		static TContainer* Create()
+		{
+			if constexpr (std::is_constructible_v<TContainer, size_t>)
+			{
+				return new TContainer(BoundedCapacity);
+			}
+			else
+			{
+				return new TContainer();
+			}
+		}
+
+		static void Push(TContainer& container, size_t value)
+		{
+			if constexpr (requires { container.TryPush(value); })
+			{
+				while (!container.TryPush(value))
+				{
+					std::this_thread::yield();
+				}
+			}
+			else if constexpr (requires { container.Push(value); })
+			{
+				container.Push(value);
+			}
+			else
+			{
+				container.push(value);
+			}
+		}
+
+		static bool TryPop(TContainer& container, size_t& value)
+		{
+			if constexpr (requires { container.TryPop(value); })
+			{
+				return container.TryPop(value);
+			}
+			else
+			{
+				return container.try_pop(value);
+			}
+		}
+	};
+
+	void RunQueueBenchmark()
+	{
+		printf("\nStarting Queue benchmark...\n");
+
+		const std::initializer_list<size_t> mpmc = { 1, 2, 4, 8, 16 };
+
+		TestCase_QueuePerformance<TLockedQueue<size_t>>::RunTests("std::deque + std::mutex", mpmc);
+#ifdef _MSC_VER
+		TestCase_QueuePerformance<concurrency::concurrent_queue<size_t>>::RunTests("concurrency::concurrent_queue", mpmc);
+#endif
+		TestCase_QueuePerformance<TBoundedConcurrentQueue<size_t>>::RunTests("TBoundedConcurrentQueue", mpmc);
+		TestCase_QueuePerformance<TConcurrentQueue<size_t>>::RunTests("TConcurrentQueue", mpmc);
+
+		printf("\nStarting SPSC Queue benchmark...\n");
+
+		TestCase_QueuePerformance<TBoundedConcurrentQueue<size_t>>::RunTests("TBoundedConcurrentQueue", { 1 });
+		TestCase_QueuePerformance<TConcurrentQueue<size_t>>::RunTests("TConcurrentQueue", { 1 });
+		TestCase_QueuePerformance<TSpscQueue<size_t>>::RunTests("TSpscQueue", { 1 });
+
+		printf("\n\n");
+	}
+}
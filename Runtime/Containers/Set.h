@@ -20,7 +20,11 @@ namespace Sailor
 	{
 	public:
 
-		using TElementContainer = TList<TElementType, Memory::TInlineAllocator<sizeof(TElementType)* ReservedElements, TAllocator>>;
+		// The buckets hold a few elements on average, so the first nodes live in the bucket itself
+		static constexpr size_t InlineBucketNodes = 4;
+
+		using TElementContainer = TList<TElementType, Memory::TNodePoolAllocator<ReservedElements, TAllocator, 2,
+			sizeof(typename TList<TElementType>::TNode)* InlineBucketNodes>>;
 
 		class SAILOR_API TEntry
 		{
@@ -441,7 +445,7 @@ namespace Sailor
 namespace std
 {
 	template<typename TKeyType, typename TValueType>
-	struct std::hash<Sailor::TPair<TKeyType, TValueType>>
+	struct hash<Sailor::TPair<TKeyType, TValueType>>
 	{
 		SAILOR_API std::size_t operator()(const Sailor::TPair<TKeyType, TValueType>& p) const
 		{
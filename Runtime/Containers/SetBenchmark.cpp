@@ -1,133 +1,102 @@
 #include <unordered_set>
 #include "Containers/Set.h"
+#include "Containers/FlatSet.h"
 #include "Containers/ConcurrentSet.h"
-#include "Core/Utils.h"
+#include "Containers/ContainersBenchmark.h"
+#include "Core/Benchmark.h"
 #include <random>
-#include "Tasks/Tasks.h"
-#include "Tasks/Scheduler.h"
 
 using namespace Sailor;
 using namespace Sailor::Memory;
-using Timer = Utils::Timer;
+
+// The default policy never rehashes, the buckets degrade to the long lists on the big sets
+template<typename TElementType>
+class TRehashedConcurrentSet : public TConcurrentSet<TElementType>
+{
+public:
+
+	TRehashedConcurrentSet() : TConcurrentSet<TElementType>(16, ERehashPolicy::Always) {}
+};
 
 template<typename TContainer>
 class TestCase_SetPerfromance
 {
 public:
 
-	static void RunTests()
-	{
-		const std::string tSetClassName = typeid(TContainer).name();
-
-		printf("%s\n", tSetClassName.c_str());
-		printf("Sanity check passed: %d\n", SanityCheck());
-		PerformanceTests();
-		printf("\n");
-	}
+	static constexpr size_t Count = 1000000;
 
-	static void PerformanceTests()
+	static void PerformanceTests(Benchmark::State& state)
 	{
-		const size_t count = 10000600;
-
-		Timer stdSet;
-		Timer tSet;
-
 		TContainer container;
-		std::unordered_set<size_t> ideal;
-
-		stdSet.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			ideal.insert(i);
-		}
-		stdSet.Stop();
 
-		tSet.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			container.Insert(i);
-		}
-		tSet.Stop();
-
-		SAILOR_LOG("Performance test insert:\n\tstd::set %llums\n\tTSet %llums", stdSet.ResultMs(), tSet.ResultMs());
-
-		/////////////////////////////////////////////
-		stdSet.Clear();
-		tSet.Clear();
-
-		std::random_device rd;
-		std::mt19937 g(rd());
+		state.Measure("insert", Count, [&]()
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					Insert(container, i);
+				}
+			});
 
-		g.seed(0);
-		stdSet.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			const size_t value = count + g();
-			auto res = ideal.find(value);
-			if (res == ideal.end()) continue;
-		}
-		stdSet.Stop();
+		std::mt19937 g;
+		size_t numFound = 0;
 
 		g.seed(0);
-		tSet.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			const size_t value = count + g();
-			container.Contains(value);
-		}
-		tSet.Stop();
+		state.Measure("contains_misses", Count, [&]()
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					const size_t value = Count + g();
+					numFound += Contains(container, value);
+				}
+			});
 
-		SAILOR_LOG("Performance test contains(only misses):\n\tstd::set %llums\n\tTSet %llums", stdSet.ResultMs(), tSet.ResultMs());
-		/////////////////////////////////////////////
-		stdSet.Clear();
-		tSet.Clear();
 		g.seed(0);
-		stdSet.Start();
-		for (size_t i = 0; i < count; i++)
+		state.Measure("contains_hits", Count, [&]()
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					const size_t value = g() % Count;
+					numFound += Contains(container, value);
+				}
+			});
+
+		if (numFound != Count)
 		{
-			const size_t value = g() % count;
-			auto res = ideal.find(value);
-
-			if (res == ideal.end()) 
-				continue;
+			state.Fail("Wrong amount of the found elements");
 		}
-		stdSet.Stop();
 
-		g.seed(0);
-		tSet.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			const size_t value = g() % count;
-			container.Contains(value);
-		}
-		tSet.Stop();
+		state.Measure("remove", Count / 2, [&]()
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					if (i % 2)
+					{
+						Remove(container, i);
+					}
+				}
+			});
+	}
 
-		SAILOR_LOG("Performance test contains(never miss):\n\tstd::set %llums\n\tTSet %llums", stdSet.ResultMs(), tSet.ResultMs());
-		/////////////////////////////////////////////
-		stdSet.Clear();
-		tSet.Clear();
+	// Steady amount of the elements with the constant insert/remove, the buckets are emptied and refilled
+	static void ChurnTests(Benchmark::State& state)
+	{
+		const size_t numAlive = 65536;
+		const size_t count = 1000000;
 
-		tSet.Start();
-		for (size_t i = 0; i < count; i++)
+		TContainer container;
+		for (size_t i = 0; i < numAlive; i++)
 		{
-			if (i % 2)
-			{
-				container.Remove(i);
-			}
+			Insert(container, i);
 		}
-		tSet.Stop();
 
-		stdSet.Start();
-		for (size_t i = 0; i < count; i++)
-		{
-			if (i % 2)
+		state.Measure("insert_remove_churn", count, [&]()
 			{
-				ideal.erase(i);
-			}
-		}
-		stdSet.Stop();
-
-		SAILOR_LOG("Performance test remove:\n\tstd::set %llums\n\tTSet %llums", stdSet.ResultMs(), tSet.ResultMs());
+				for (size_t i = numAlive; i < numAlive + count; i++)
+				{
+					Remove(container, i - numAlive);
+					Insert(container, i);
+				}
+			});
 	}
 
 	static bool SanityCheck()
@@ -183,13 +152,65 @@ public:
 
 		return true;
 	}
+protected:
+
+	static void Insert(TContainer& container, size_t value)
+	{
+		if constexpr (requires { container.insert(value); })
+		{
+			container.insert(value);
+		}
+		else
+		{
+			container.Insert(value);
+		}
+	}
+
+	static bool Contains(const TContainer& container, size_t value)
+	{
+		if constexpr (requires { container.contains(value); })
+		{
+			return container.contains(value);
+		}
+		else
+		{
+			return container.Contains(value);
+		}
+	}
+
+	static void Remove(TContainer& container, size_t value)
+	{
+		if constexpr (requires { container.erase(value); })
+		{
+			container.erase(value);
+		}
+		else
+		{
+			container.Remove(value);
+		}
+	}
 };
 
+void Sailor::RegisterSetBenchmarks(Benchmark::Runner& runner)
+{
+	runner.AddCheck("set/sanity/TSet", &TestCase_SetPerfromance<TSet<size_t>>::SanityCheck);
+	runner.AddCheck("set/sanity/TFlatSet", &TestCase_SetPerfromance<TFlatSet<size_t>>::SanityCheck);
+	runner.AddCheck("set/sanity/TConcurrentSet", &TestCase_SetPerfromance<TConcurrentSet<size_t>>::SanityCheck);
+
+	runner.Add("set/std::unordered_set", &TestCase_SetPerfromance<std::unordered_set<size_t>>::PerformanceTests);
+	runner.Add("set/TSet", &TestCase_SetPerfromance<TSet<size_t>>::PerformanceTests);
+	runner.Add("set/TFlatSet", &TestCase_SetPerfromance<TFlatSet<size_t>>::PerformanceTests);
+	runner.Add("set/TConcurrentSet", &TestCase_SetPerfromance<TRehashedConcurrentSet<size_t>>::PerformanceTests);
+
+	runner.Add("set/churn/std::unordered_set", &TestCase_SetPerfromance<std::unordered_set<size_t>>::ChurnTests);
+	runner.Add("set/churn/TSet", &TestCase_SetPerfromance<TSet<size_t>>::ChurnTests);
+}
+
 void Sailor::RunSetBenchmark()
 {
 	printf("\nStarting set benchmark...\n");
-	TestCase_SetPerfromance<Sailor::TSet<size_t>>::RunTests();
 
-	printf("\nStarting concurrent set benchmark...\n");
-	TestCase_SetPerfromance<Sailor::TConcurrentSet<size_t>>::RunTests();
+	Benchmark::Runner runner;
+	RegisterSetBenchmarks(runner);
+	Benchmark::Print(runner.Run(Benchmark::Settings()));
 }
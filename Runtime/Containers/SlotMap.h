@@ -0,0 +1,186 @@
+#pragma once
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Containers/Concepts.h"
+#include "Containers/Vector.h"
+
+namespace Sailor
+{
+	// Stable handle into TSlotMap, the generation detects the reused slots
+	struct SlotHandle
+	{
+		static constexpr uint32_t InvalidIndex = (uint32_t)-1;
+
+		uint32_t m_index = InvalidIndex;
+		uint32_t m_generation = 0;
+
+		__forceinline bool IsValid() const { return m_index != InvalidIndex; }
+
+		__forceinline bool operator==(const SlotHandle& rhs) const { return m_index == rhs.m_index && m_generation == rhs.m_generation; }
+		__forceinline bool operator!=(const SlotHandle& rhs) const { return !(*this == rhs); }
+
+		__forceinline size_t GetHash() const { return ((size_t)m_generation << 32) | m_index; }
+	};
+
+	// Generational slot map: O(1) insert/remove/lookup by handle.
+	// Elements are tightly packed, so the iteration walks the live elements only.
+	// Removing swaps the last element into the hole, so the order is not preserved
+	// and the raw pointers are invalidated, but the handles remain valid.
+	// Free slots store the index of the next free slot, so there is no separate free list.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TSlotMap final
+	{
+		struct Slot
+		{
+			// Index in the dense array for the alive slot, next free slot otherwise
+			uint32_t m_index = SlotHandle::InvalidIndex;
+
+			// Odd generations are alive
+			uint32_t m_generation = 0;
+
+			__forceinline bool IsAlive() const { return (m_generation & 1) != 0; }
+		};
+
+	public:
+
+		using TIterator = typename TVector<TElementType, TAllocator>::TIterator;
+		using TConstIterator = typename TVector<TElementType, TAllocator>::TConstIterator;
+
+		TSlotMap() = default;
+		TSlotMap(const TSlotMap&) = default;
+		TSlotMap& operator=(const TSlotMap&) = default;
+		TSlotMap(TSlotMap&&) = default;
+		TSlotMap& operator=(TSlotMap&&) = default;
+		~TSlotMap() = default;
+
+		__forceinline size_t Num() const { return m_elements.Num(); }
+		__forceinline bool IsEmpty() const { return m_elements.Num() == 0; }
+
+		void Reserve(size_t num)
+		{
+			m_elements.Reserve(num);
+			m_denseToSlot.Reserve(num);
+			m_slots.Reserve(num);
+		}
+
+		template<typename... TArgs>
+		SlotHandle Emplace(TArgs&& ... args)
+		{
+			uint32_t slotIndex = m_freeHead;
+			if (slotIndex == SlotHandle::InvalidIndex)
+			{
+				slotIndex = (uint32_t)m_slots.Num();
+				m_slots.Add(Slot());
+			}
+			else
+			{
+				m_freeHead = m_slots[slotIndex].m_index;
+			}
+
+			Slot& slot = m_slots[slotIndex];
+			slot.m_index = (uint32_t)m_elements.Num();
+			slot.m_generation++;
+
+			m_elements.Emplace(std::forward<TArgs>(args)...);
+			m_denseToSlot.Add(slotIndex);
+
+			return SlotHandle{ slotIndex, slot.m_generation };
+		}
+
+		__forceinline SlotHandle Add(const TElementType& element) requires IsCopyConstructible<TElementType> { return Emplace(element); }
+		__forceinline SlotHandle Add(TElementType&& element) requires IsMoveConstructible<TElementType> { return Emplace(std::move(element)); }
+
+		bool Remove(const SlotHandle& handle)
+		{
+			if (!Contains(handle))
+			{
+				return false;
+			}
+
+			Slot& slot = m_slots[handle.m_index];
+			const uint32_t denseIndex = slot.m_index;
+			const uint32_t lastIndex = (uint32_t)m_elements.Num() - 1;
+
+			if (denseIndex != lastIndex)
+			{
+				m_elements[denseIndex] = std::move(m_elements[lastIndex]);
+				m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+				m_slots[m_denseToSlot[denseIndex]].m_index = denseIndex;
+			}
+
+			m_elements.RemoveLast();
+			m_denseToSlot.RemoveLast();
+
+			slot.m_generation++;
+			slot.m_index = m_freeHead;
+			m_freeHead = handle.m_index;
+
+			return true;
+		}
+
+		__forceinline bool Contains(const SlotHandle& handle) const
+		{
+			return handle.m_index < m_slots.Num() && m_slots[handle.m_index].m_generation == handle.m_generation && m_slots[handle.m_index].IsAlive();
+		}
+
+		// Returns nullptr for the stale handle
+		__forceinline TElementType* Find(const SlotHandle& handle) { return Contains(handle) ? &m_elements[m_slots[handle.m_index].m_index] : nullptr; }
+		__forceinline const TElementType* Find(const SlotHandle& handle) const { return Contains(handle) ? &m_elements[m_slots[handle.m_index].m_index] : nullptr; }
+
+		__forceinline TElementType& operator[](const SlotHandle& handle)
+		{
+			check(Contains(handle));
+			return m_elements[m_slots[handle.m_index].m_index];
+		}
+
+		__forceinline const TElementType& operator[](const SlotHandle& handle) const
+		{
+			check(Contains(handle));
+			return m_elements[m_slots[handle.m_index].m_index];
+		}
+
+		// Maps the dense index (the position during the iteration) back to the handle
+		__forceinline SlotHandle GetHandle(size_t denseIndex) const
+		{
+			const uint32_t slotIndex = m_denseToSlot[denseIndex];
+			return SlotHandle{ slotIndex, m_slots[slotIndex].m_generation };
+		}
+
+		__forceinline TElementType& GetByDenseIndex(size_t denseIndex) { return m_elements[denseIndex]; }
+		__forceinline const TElementType& GetByDenseIndex(size_t denseIndex) const { return m_elements[denseIndex]; }
+
+		__forceinline TElementType* GetData() { return m_elements.GetData(); }
+		__forceinline const TElementType* GetData() const { return m_elements.GetData(); }
+
+		// The outstanding handles become stale
+		void Clear(bool bResetCapacity = true)
+		{
+			for (size_t i = 0; i < m_denseToSlot.Num(); i++)
+			{
+				const uint32_t slotIndex = m_denseToSlot[i];
+				m_slots[slotIndex].m_generation++;
+				m_slots[slotIndex].m_index = m_freeHead;
+				m_freeHead = slotIndex;
+			}
+
+			m_elements.Clear(bResetCapacity);
+			m_denseToSlot.Clear(bResetCapacity);
+		}
+
+		// Support ranged for
+		TIterator begin() { return m_elements.begin(); }
+		TIterator end() { return m_elements.end(); }
+
+		TConstIterator begin() const { return m_elements.begin(); }
+		TConstIterator end() const { return m_elements.end(); }
+
+	protected:
+
+		TVector<TElementType, TAllocator> m_elements;
+		TVector<uint32_t, TAllocator> m_denseToSlot;
+		TVector<Slot, TAllocator> m_slots;
+		uint32_t m_freeHead = SlotHandle::InvalidIndex;
+	};
+}
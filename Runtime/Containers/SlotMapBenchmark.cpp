@@ -0,0 +1,182 @@
+#include <unordered_map>
+#include <vector>
+#include <random>
+#include "Containers/SlotMap.h"
+#include "Containers/ContainersBenchmark.h"
+#include "Core/Benchmark.h"
+
+using namespace Sailor;
+using namespace Sailor::Memory;
+
+class TestCase_SlotMapPerformance
+{
+public:
+
+	static constexpr size_t Count = 100000;
+
+	struct TData
+	{
+		TData(size_t value = 0) : m_value(value) { numInstances++; }
+		TData(const TData& rhs) : m_value(rhs.m_value) { numInstances++; }
+		~TData() { numInstances--; }
+
+		TData& operator=(const TData& rhs) = default;
+
+		size_t m_value = 0;
+	};
+
+	// The handles of the removed elements are stale even if the slot is reused,
+	// the live handles survive the churn and the iteration walks the live elements only
+	static bool SanityCheck()
+	{
+		bool bRes = true;
+
+		{
+			TSlotMap<TData> container;
+			std::unordered_map<size_t, SlotHandle> ideal;
+			std::vector<SlotHandle> removed;
+			std::mt19937 g(0);
+
+			for (size_t i = 0; i < Count; i++)
+			{
+				if (ideal.empty() || g() % 3 != 0)
+				{
+					ideal[i] = container.Add(TData(i));
+					continue;
+				}
+
+				auto it = ideal.begin();
+				std::advance(it, g() % std::min(ideal.size(), (size_t)16));
+
+				bRes &= container.Remove(it->second);
+				bRes &= !container.Contains(it->second) && container.Find(it->second) == nullptr;
+
+				removed.push_back(it->second);
+				ideal.erase(it);
+			}
+
+			bRes &= container.Num() == ideal.size();
+
+			for (const auto& [value, handle] : ideal)
+			{
+				const TData* pData = container.Find(handle);
+				bRes &= pData && pData->m_value == value;
+			}
+
+			// The slots are reused, but the generation doesn't match
+			for (const auto& handle : removed)
+			{
+				bRes &= !container.Contains(handle) && !container.Remove(handle);
+			}
+
+			size_t numIterated = 0;
+			for (const auto& data : container)
+			{
+				bRes &= ideal.contains(data.m_value);
+				numIterated++;
+			}
+			bRes &= numIterated == ideal.size();
+
+			for (size_t i = 0; i < container.Num(); i++)
+			{
+				bRes &= container.Find(container.GetHandle(i)) == &container.GetByDenseIndex(i);
+			}
+
+			// The reused slot gets the new generation
+			const SlotHandle stale = ideal.begin()->second;
+			container.Remove(stale);
+			const SlotHandle reused = container.Add(TData(Count));
+			bRes &= reused.m_index == stale.m_index && reused != stale && !container.Contains(stale);
+
+			const SlotHandle beforeClear = reused;
+			container.Clear();
+			bRes &= container.IsEmpty() && !container.Contains(beforeClear);
+		}
+
+		return bRes && numInstances == 0;
+	}
+
+	// Add, lookup by handle, remove the random elements and iterate the rest
+	template<typename TContainer>
+	static void PerformanceTests(Benchmark::State& state)
+	{
+		TContainer container;
+		std::vector<SlotHandle> handles;
+		handles.reserve(Count);
+
+		state.Measure("add", Count, [&]()
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					handles.push_back(Add(container, i));
+				}
+			});
+
+		size_t sum = 0;
+		state.Measure("find", Count, [&]()
+			{
+				for (const auto& handle : handles)
+				{
+					sum += Find(container, handle);
+				}
+			});
+
+		std::mt19937 g(0);
+		std::shuffle(handles.begin(), handles.end(), g);
+
+		const size_t countToRemove = Count / 2;
+		state.Measure("remove", countToRemove, [&]()
+			{
+				for (size_t i = 0; i < countToRemove; i++)
+				{
+					Remove(container, handles[i]);
+				}
+			});
+
+		state.Measure("iterate", Count - countToRemove, [&]()
+			{
+				for (const auto& el : container)
+				{
+					if constexpr (requires { el.second; })
+					{
+						sum += el.second.m_value;
+					}
+					else
+					{
+						sum += el.m_value;
+					}
+				}
+			});
+
+		Benchmark::DoNotOptimize(sum);
+	}
+
+	static size_t numInstances;
+
+protected:
+
+	static SlotHandle Add(TSlotMap<TData>& container, size_t value) { return container.Add(TData(value)); }
+	static size_t Find(TSlotMap<TData>& container, const SlotHandle& handle) { return container[handle].m_value; }
+	static void Remove(TSlotMap<TData>& container, const SlotHandle& handle) { container.Remove(handle); }
+
+	// The map by the incremented id, that is the usual alternative to the handles
+	static SlotHandle Add(std::unordered_map<uint32_t, TData>& container, size_t value)
+	{
+		const uint32_t id = (uint32_t)value;
+		container.emplace(id, TData(value));
+		return SlotHandle{ id, 1 };
+	}
+
+	static size_t Find(std::unordered_map<uint32_t, TData>& container, const SlotHandle& handle) { return container.find(handle.m_index)->second.m_value; }
+	static void Remove(std::unordered_map<uint32_t, TData>& container, const SlotHandle& handle) { container.erase(handle.m_index); }
+};
+
+size_t TestCase_SlotMapPerformance::numInstances = 0;
+
+void Sailor::RegisterSlotMapBenchmarks(Benchmark::Runner& runner)
+{
+	runner.AddCheck("slotmap/sanity/TSlotMap", &TestCase_SlotMapPerformance::SanityCheck);
+
+	runner.Add("slotmap/std::unordered_map", &TestCase_SlotMapPerformance::PerformanceTests<std::unordered_map<uint32_t, TestCase_SlotMapPerformance::TData>>);
+	runner.Add("slotmap/TSlotMap", &TestCase_SlotMapPerformance::PerformanceTests<TSlotMap<TestCase_SlotMapPerformance::TData>>);
+}
@@ -6,8 +6,12 @@
 #include <type_traits>
 #include <iterator>
 #include <algorithm>
+#include <bit>
+#include <cstring>
 #include "Core/Defines.h"
 #include "Math/Math.h"
+#include "Memory/MallocAllocator.hpp"
+#include "Memory/LockFreeHeapAllocator.h"
 #include "Containers/Concepts.h"
 
 namespace Sailor
@@ -104,7 +108,26 @@ namespace Sailor
 	template<typename TDataType>
 	using TConstVectorIterator = TVectorIterator<const TDataType>;
 
-	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	// Growth policies decide the new capacity when the vector runs out of space
+	struct PowerOfTwoGrowthPolicy
+	{
+		static __forceinline size_t GetNewCapacity(size_t capacity, size_t requiredNum) { return std::bit_ceil(requiredNum); }
+	};
+
+	// Less memory overhead for the huge arrays, i.e. <3, 2> grows by 1.5
+	template<size_t Numerator, size_t Denominator>
+	struct TFactorGrowthPolicy
+	{
+		static_assert(Numerator > Denominator, "Growth factor should be greater than 1");
+
+		static __forceinline size_t GetNewCapacity(size_t capacity, size_t requiredNum)
+		{
+			constexpr size_t MinCapacity = 4;
+			return (std::max)(requiredNum, (std::max)(MinCapacity, capacity + capacity * (Numerator - Denominator) / Denominator));
+		}
+	};
+
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator, typename TGrowthPolicy = PowerOfTwoGrowthPolicy>
 	class SAILOR_API TVector final
 	{
 	public:
@@ -239,7 +262,7 @@ namespace Sailor
 			}
 
 			ResizeIfNeeded(count);
-			ConstructElements(m_arrayNum, count - m_arrayNum);
+			ConstructDefaultElements(m_arrayNum, count - m_arrayNum);
 			m_arrayNum = count;
 		}
 
@@ -247,7 +270,7 @@ namespace Sailor
 		{
 			ResizeIfNeeded(m_arrayNum + count);
 
-			ConstructElements(m_arrayNum, count);
+			ConstructDefaultElements(m_arrayNum, count);
 			m_arrayNum += count;
 		}
 
@@ -256,6 +279,17 @@ namespace Sailor
 			return Emplace(std::move(item));
 		}
 
+		// Adds the elements without the construction, the caller should fill them.
+		// Returns the index of the first added element
+		size_t AddUninitialized(size_t count) requires IsTriviallyCopyable<TElementType>
+		{
+			ResizeIfNeeded(m_arrayNum + count);
+
+			const size_t index = m_arrayNum;
+			m_arrayNum += count;
+			return index;
+		}
+
 		void MoveRange(TElementType* first, size_t count) requires IsMoveConstructible<TElementType>
 		{
 			if (count == 0)
@@ -513,18 +547,28 @@ namespace Sailor
 
 		void RemoveAtSwap(size_t index, size_t count = 1)
 		{
+			check(index + count <= m_arrayNum);
+
 			DestructElements(index, count);
 
-			if constexpr (IsMoveConstructible<TElementType>)
-			{
-				ConstructMoveElements(index, m_pRawPtr[m_arrayNum - count], count);
-			}
-			else
+			// Only the tail that doesn't overlap the removed range is moved, the removed last element is not moved onto itself
+			const size_t first = (std::max)(index + count, m_arrayNum - count);
+			const size_t numToMove = m_arrayNum - first;
+
+			if (numToMove > 0)
 			{
-				ConstructElements(index, m_pRawPtr[m_arrayNum - count], count);
+				if constexpr (IsMoveConstructible<TElementType>)
+				{
+					ConstructMoveElements(index, m_pRawPtr[first], numToMove);
+				}
+				else
+				{
+					ConstructElements(index, m_pRawPtr[first], numToMove);
+				}
+
+				DestructElements(first, numToMove);
 			}
 
-			DestructElements(m_arrayNum - count, count);
 			m_arrayNum -= count;
 		}
 
@@ -569,8 +613,6 @@ namespace Sailor
 				return;
 			}
 
-			const size_t slack = newCapacity - m_capacity;
-
 			m_capacity = newCapacity;
 
 			if (m_pRawPtr && m_allocator.Reallocate(m_pRawPtr, newCapacity * sizeof(TElementType)))
@@ -583,24 +625,32 @@ namespace Sailor
 
 			if (m_arrayNum > 0)
 			{
-				if constexpr (IsMoveConstructible<TElementType>)
-				{
-					ConstructMoveElements(0, pRawPtr[0], newCapacity - slack);
-				}
-				else if constexpr (IsCopyConstructible<TElementType>)
+				if constexpr (IsTriviallyRelocatable<TElementType>)
 				{
-					ConstructElements(0, pRawPtr[0], newCapacity - slack);
+					// The old memory is released without the destruction
+					memcpy((void*)m_pRawPtr, (const void*)pRawPtr, m_arrayNum * sizeof(TElementType));
 				}
 				else
 				{
-					// No way to save elements
-					check(false);
-				}
+					if constexpr (IsMoveConstructible<TElementType>)
+					{
+						ConstructMoveElements(0, pRawPtr[0], m_arrayNum);
+					}
+					else if constexpr (IsCopyConstructible<TElementType>)
+					{
+						ConstructElements(0, pRawPtr[0], m_arrayNum);
+					}
+					else
+					{
+						// No way to save elements
+						check(false);
+					}
 
-				// Destruct old elements
-				for (size_t i = 0; i < newCapacity - slack; i++)
-				{
-					pRawPtr[i].~TElementType();
+					// Destruct old elements
+					for (size_t i = 0; i < m_arrayNum; i++)
+					{
+						pRawPtr[i].~TElementType();
+					}
 				}
 			}
 
@@ -668,8 +718,7 @@ namespace Sailor
 		{
 			if (m_capacity < newSize)
 			{
-				const size_t optimalSize = Math::UpperPowOf2((uint32_t)(newSize));
-				Reserve(optimalSize);
+				Reserve(TGrowthPolicy::GetNewCapacity(m_capacity, newSize));
 			}
 		}
 
@@ -688,7 +737,7 @@ namespace Sailor
 		size_t m_capacity = 0;
 		TAllocator m_allocator{};
 
-		__forceinline void ConstructElements(size_t index, size_t count = 1)
+		__forceinline void ConstructDefaultElements(size_t index, size_t count = 1)
 		{
 			for (size_t i = 0; i < count; i++)
 			{
@@ -780,5 +829,9 @@ namespace Sailor
 		friend class TVector;
 	};
 
+	// The inline allocators point to themselves, the rest are stateless
+	template<typename TElementType, typename TAllocator, typename TGrowthPolicy>
+	struct TIsTriviallyRelocatable<TVector<TElementType, TAllocator, TGrowthPolicy>> : std::bool_constant<IsTriviallyRelocatable<TAllocator>> {};
+
 	SAILOR_API void RunVectorBenchmark();
 }
\ No newline at end of file
@@ -1,18 +1,23 @@
-#include "Memory.h"
+#include <atomic>
 #include <cstdlib>
 #include <vector>
 #include <cassert>
 #include <cctype>
-#include "Core/Utils.h"
+#include "Core/Benchmark.h"
+#include "ContainersBenchmark.h"
 #include "Vector.h"
+#include "InlineVector.h"
 #include "Memory/Memory.h"
+
+#ifndef SAILOR_BENCHMARKS_STANDALONE
 #include "Tasks/Tasks.h"
 #include "Tasks/Scheduler.h"
+#include "Tasks/ParallelSort.h"
+#endif
 
 namespace Sailor
 {
 	using namespace Sailor::Memory;
-	using Timer = Utils::Timer;
 
 	template<uint32_t numBytes>
 	struct TPlainData
@@ -101,124 +106,80 @@ namespace Sailor
 		uint32_t m_value;
 	};
 
-	struct Result
-	{
-		std::string m_className;
-
-		Result() = default;
-		Result(std::string className) : m_className(className) {}
-
-		size_t m_addEmplace = 0;
-		size_t m_removeAtSwap = 0;
-		size_t m_removeAt = 0;
-		size_t m_removeFirst = 0;
-		size_t m_insert = 0;
-
-		bool m_bSanityPassed = false;
-
-		void PrintLog()
-		{
-			SAILOR_LOG("\nClassName: %s", m_className.c_str());
-			SAILOR_LOG("Sanity check passed: %d", m_bSanityPassed);
-			SAILOR_LOG("Performance test Add/Emplace: %llums", m_addEmplace);
-			SAILOR_LOG("Performance test Insert: %llums", m_insert);
-			SAILOR_LOG("Performance test RemoveAtSwap: %llums", m_removeAtSwap);
-			SAILOR_LOG("Performance test RemoveAt: %llums", m_removeAt);
-			SAILOR_LOG("Performance test RemoveFirst: %llums\n", m_removeFirst);
-		}
-	};
-
 	template<typename TElement, typename TContainer>
 	class TestCase_VectorPerfromance
 	{
 	public:
 
-		static Result RunTests()
-		{
-			Result r = PerformanceTests();
-			r.m_bSanityPassed = SanityCheck();
-			return r;
-		}
+		static constexpr size_t Count = 163600;
 
-		static Result PerformanceTests()
+		static void PerformanceTests(Benchmark::State& state)
 		{
-			Timer tVector;
-			Timer tVectorRemoveSwap;
-			Timer tVectorRemoveAt;
-			Timer tVectorRemoveFirst;
-			Timer tVectorInsert;
-
-			const size_t count = 163600;
-
 			TContainer container;
 
 			srand(0);
-			tVector.Start();
-			for (size_t i = 0; i < count; i++)
-			{
-				const int32_t value = rand();
-
-				if (i % 2 == 0)
-				{
-					container.Add(value);
-				}
-				else
+			state.Measure("add_emplace", Count, [&]()
 				{
-					container.Emplace(value);
-				}
-			}
-			tVector.Stop();
-
-			uint32_t countToRemoveSwap = count / 2;
+					for (size_t i = 0; i < Count; i++)
+					{
+						const int32_t value = rand();
+
+						if (i % 2 == 0)
+						{
+							container.Add(value);
+						}
+						else
+						{
+							container.Emplace(value);
+						}
+					}
+				});
+
+			const uint32_t countToRemoveSwap = Count / 2;
 			srand(0);
-			tVectorRemoveSwap.Start();
-			for (size_t i = 0; i < countToRemoveSwap; i++)
-			{
-				const size_t pos = rand() % container.Num();
-				container.RemoveAtSwap(pos);
-			}
-			tVectorRemoveSwap.Stop();
-
+			state.Measure("remove_at_swap", countToRemoveSwap, [&]()
+				{
+					for (size_t i = 0; i < countToRemoveSwap; i++)
+					{
+						const size_t pos = rand() % container.Num();
+						container.RemoveAtSwap(pos);
+					}
+				});
+
+			const uint32_t countToDelete = Count / 128;
 			srand(0);
-			uint32_t countToDelete = count / 128;
-			tVectorRemoveAt.Start();
-			for (size_t i = 0; i < countToDelete; i++)
-			{
-				const int32_t value = rand() % container.Num();
-				container.RemoveAt(value);
-			}
-			tVectorRemoveAt.Stop();
-
-			uint32_t countToRemove = count / 128;
+			state.Measure("remove_at", countToDelete, [&]()
+				{
+					for (size_t i = 0; i < countToDelete; i++)
+					{
+						const int32_t value = rand() % container.Num();
+						container.RemoveAt(value);
+					}
+				});
+
+			const uint32_t countToRemove = Count / 128;
 			srand(0);
-			tVectorRemoveFirst.Start();
-			for (size_t i = 0; i < countToRemove; i++)
-			{
-				const size_t pos = rand() % container.Num();
-				const auto& valueToRemove = container[pos];
+			state.Measure("remove_first", countToRemove, [&]()
+				{
+					for (size_t i = 0; i < countToRemove; i++)
+					{
+						const size_t pos = rand() % container.Num();
+						const auto& valueToRemove = container[pos];
 
-				container.RemoveFirst(valueToRemove);
-			}
-			tVectorRemoveFirst.Stop();
+						container.RemoveFirst(valueToRemove);
+					}
+				});
 
-			uint32_t countToAdd = count / 256;
+			const uint32_t countToAdd = Count / 256;
 			srand(0);
-			tVectorInsert.Start();
-			for (size_t i = 0; i < countToAdd; i++)
-			{
-				const size_t pos = rand() % container.Num();
-				container.Insert(TElement((uint32_t)i), pos);
-			}
-			tVectorInsert.Stop();
-
-			Result r(typeid(TContainer).name());
-			r.m_addEmplace = tVector.ResultMs();
-			r.m_removeAtSwap = tVectorRemoveSwap.ResultMs();
-			r.m_removeAt = tVectorRemoveAt.ResultMs();
-			r.m_removeFirst = tVectorRemoveFirst.ResultMs();
-			r.m_insert = tVectorInsert.ResultMs();
-
-			return r;
+			state.Measure("insert", countToAdd, [&]()
+				{
+					for (size_t i = 0; i < countToAdd; i++)
+					{
+						const size_t pos = rand() % container.Num();
+						container.Insert(TElement((uint32_t)i), pos);
+					}
+				});
 		}
 
 		static bool SanityCheck()
@@ -319,116 +280,285 @@ namespace Sailor
 	{
 	public:
 
-		static Result RunTests()
+		static constexpr size_t Count = 163600;
+
+		static void PerformanceTests(Benchmark::State& state)
+		{
+			std::vector<T> ideal;
+
+			srand(0);
+			state.Measure("add_emplace", Count, [&]()
+				{
+					for (size_t i = 0; i < Count; i++)
+					{
+						const int32_t value = rand();
+
+						if (i % 2 == 0)
+						{
+							ideal.push_back(value);
+						}
+						else
+						{
+							ideal.emplace_back(value);
+						}
+					}
+				});
+
+			const uint32_t countToRemoveSwap = Count / 2;
+			srand(0);
+			state.Measure("remove_at_swap", countToRemoveSwap, [&]()
+				{
+					for (size_t i = 0; i < countToRemoveSwap; i++)
+					{
+						const size_t pos = rand() % ideal.size();
+
+						std::iter_swap(ideal.begin() + pos, ideal.end() - 1);
+						ideal.pop_back();
+					}
+				});
+
+			const uint32_t countToDelete = Count / 128;
+			srand(0);
+			state.Measure("remove_at", countToDelete, [&]()
+				{
+					for (size_t i = 0; i < countToDelete; i++)
+					{
+						const int32_t value = rand() % ideal.size();
+						ideal.erase(ideal.begin() + value);
+					}
+				});
+
+			const uint32_t countToRemove = Count / 128;
+			srand(0);
+			state.Measure("remove_first", countToRemove, [&]()
+				{
+					for (size_t i = 0; i < countToRemove; i++)
+					{
+						const size_t pos = rand() % ideal.size();
+						const auto valueToRemove = ideal[pos];
+
+						ideal.erase(std::find(ideal.begin(), ideal.end(), valueToRemove));
+					}
+				});
+
+			const uint32_t countToAdd = Count / 256;
+			srand(0);
+			state.Measure("insert", countToAdd, [&]()
+				{
+					for (size_t i = 0; i < countToAdd; i++)
+					{
+						const size_t pos = rand() % ideal.size();
+
+						ideal.insert(ideal.begin() + pos, 1u, T((uint32_t)i));
+					}
+				});
+		}
+	};
+
+	class TestCase_SortPerformance
+	{
+	public:
+
+		struct DrawCall
+		{
+			float m_depth = 0.0f;
+			uint32_t m_material = 0;
+			uint32_t m_mesh = 0;
+		};
+
+		static void Register(Benchmark::Runner& runner, size_t count)
 		{
-			Result r = PerformanceTests();
-			r.m_bSanityPassed = SanityCheck();
-			return r;
+			const std::string suffix = "/" + std::to_string(count);
+
+#ifndef SAILOR_BENCHMARKS_STANDALONE
+			// Without the scheduler the parallel sorts fall back to the serial ones
+			const bool bParallel = App::GetSubmodule<Tasks::Scheduler>() != nullptr;
+#else
+			// The standalone runs are built without the tasks, only the serial sorts are measured
+			const bool bParallel = false;
+#endif
+
+			runner.AddMultithreaded("vector/sort_uint32" + suffix, [count, bParallel](Benchmark::State& state)
+				{
+					TVector<uint32_t> indices;
+
+					srand(0);
+					for (size_t i = 0; i < count; i++)
+					{
+						indices.Add((uint32_t)rand() * (uint32_t)rand());
+					}
+
+					Measure(state, "TVector::Sort", indices, [](auto& data) { data.Sort(); });
+					Measure(state, "std::sort", indices, [](auto& data) { std::sort(data.GetData(), data.GetData() + data.Num()); });
+#ifndef SAILOR_BENCHMARKS_STANDALONE
+					Measure(state, "Tasks::RadixSort", indices, [](auto& data) { Tasks::RadixSort(data); });
+
+					if (bParallel)
+					{
+						Measure(state, "Tasks::ParallelSort", indices, [](auto& data) { Tasks::ParallelSort(data); });
+					}
+#endif
+				});
+
+			runner.AddMultithreaded("vector/sort_draw_calls_by_depth" + suffix, [count, bParallel](Benchmark::State& state)
+				{
+					TVector<DrawCall> drawCalls;
+
+					srand(0);
+					for (size_t i = 0; i < count; i++)
+					{
+						drawCalls.Add(DrawCall{ (float)rand() / (float)RAND_MAX * 1000.0f, (uint32_t)i, (uint32_t)rand() });
+					}
+
+					const auto byDepth = [](const DrawCall& lhs, const DrawCall& rhs) { return lhs.m_depth < rhs.m_depth; };
+
+					Measure(state, "TVector::Sort", drawCalls, [&](auto& data) { data.Sort(byDepth); });
+					Measure(state, "std::sort", drawCalls, [&](auto& data) { std::sort(data.GetData(), data.GetData() + data.Num(), byDepth); });
+#ifndef SAILOR_BENCHMARKS_STANDALONE
+					Measure(state, "Tasks::RadixSort", drawCalls, [](auto& data) { Tasks::RadixSort(data, [](const DrawCall& drawCall) { return drawCall.m_depth; }); });
+
+					if (bParallel)
+					{
+						Measure(state, "Tasks::ParallelSort", drawCalls, [&](auto& data) { Tasks::ParallelSort(data, byDepth); });
+					}
+#endif
+				});
 		}
 
-		static Result PerformanceTests()
+	protected:
+
+		template<typename TElementType, typename TSort>
+		static void Measure(Benchmark::State& state, const char* name, const TVector<TElementType>& source, TSort&& sort)
 		{
-			Timer stdVector;
-			Timer stdVectorRemoveSwap;
-			Timer stdVectorRemoveAt;
-			Timer stdVectorRemoveFirst;
-			Timer stdVectorInsert;
+			TVector<TElementType> data(source);
 
-			const size_t count = 163600;
-			std::vector<T> ideal;
-			srand(0);
-			stdVector.Start();
-			for (size_t i = 0; i < count; i++)
-			{
-				const int32_t value = rand();
+			state.Measure(name, data.Num(), [&]() { sort(data); });
 
-				if (i % 2 == 0)
+			bool bSorted = true;
+			for (size_t i = 1; i < data.Num(); i++)
+			{
+				if constexpr (std::is_same_v<TElementType, DrawCall>)
 				{
-					ideal.push_back(value);
+					bSorted &= !(data[i].m_depth < data[i - 1].m_depth);
 				}
 				else
 				{
-					ideal.emplace_back(value);
+					bSorted &= !(data[i] < data[i - 1]);
 				}
 			}
-			stdVector.Stop();
 
-			uint32_t countToRemoveSwap = count / 2;
-			srand(0);
-			stdVectorRemoveSwap.Start();
-			for (size_t i = 0; i < countToRemoveSwap; i++)
+			if (!bSorted)
 			{
-				const size_t pos = rand() % ideal.size();
-
-				std::iter_swap(ideal.begin() + pos, ideal.end() - 1);
-				ideal.pop_back();
+				state.Fail(name);
 			}
-			stdVectorRemoveSwap.Stop();
+		}
+	};
 
-			srand(0);
-			stdVectorRemoveAt.Start();
-			uint32_t countToDelete = count / 128;
-			for (size_t i = 0; i < countToDelete; i++)
-			{
-				const int32_t value = rand() % ideal.size();
-				ideal.erase(ideal.begin() + value);
-			}
-			stdVectorRemoveAt.Stop();
+	// Counts the heap allocations done by the container
+	class CountingAllocator
+	{
+	public:
 
-			uint32_t countToRemove = count / 128;
-			srand(0);
-			stdVectorRemoveFirst.Start();
-			for (size_t i = 0; i < countToRemove; i++)
-			{
-				const size_t pos = rand() % ideal.size();
-				const auto valueToRemove = ideal[pos];
+		static inline std::atomic<size_t> s_numAllocations = 0;
+		static inline std::atomic<size_t> s_allocatedBytes = 0;
 
-				ideal.erase(std::find(ideal.begin(), ideal.end(), valueToRemove));
-			}
-			stdVectorRemoveFirst.Stop();
+		void* Allocate(size_t size, size_t alignment = 8)
+		{
+			s_numAllocations++;
+			s_allocatedBytes += size;
+			return m_allocator.Allocate(size, alignment);
+		}
 
-			uint32_t countToAdd = count / 256;
-			stdVectorInsert.Start();
-			for (size_t i = 0; i < countToAdd; i++)
-			{
-				const size_t pos = rand() % ideal.size();
+		bool Reallocate(void* ptr, size_t size, size_t alignment = 8) { return m_allocator.Reallocate(ptr, size, alignment); }
+		void Free(void* ptr, size_t size = 0) { m_allocator.Free(ptr, size); }
 
-				ideal.insert(ideal.begin() + pos, 1u, T((uint32_t)i));
-			}
-			stdVectorInsert.Stop();
+		static void Reset()
+		{
+			s_numAllocations = 0;
+			s_allocatedBytes = 0;
+		}
 
-			Result r(typeid(std::vector<T>).name());
-			r.m_addEmplace = stdVector.ResultMs();
-			r.m_removeAtSwap = stdVectorRemoveSwap.ResultMs();
-			r.m_removeAt = stdVectorRemoveAt.ResultMs();
-			r.m_removeFirst = stdVectorRemoveFirst.ResultMs();
-			r.m_insert = stdVectorInsert.ResultMs();
+	protected:
 
-			return r;
+		Memory::DefaultGlobalAllocator m_allocator{};
+	};
+
+	// Lots of small lists, like the children of transforms or the chained tasks
+	template<typename TContainer>
+	class TestCase_SmallVectorPerformance
+	{
+	public:
+
+		static constexpr size_t NumContainers = 100000;
+		static constexpr size_t MaxElements = 8;
+
+		static void PerformanceTests(Benchmark::State& state)
+		{
+			CountingAllocator::Reset();
+
+			size_t checksum = 0;
+			state.Measure("fill_iterate_destroy", NumContainers, [&]()
+				{
+					TContainer* pContainers = new TContainer[NumContainers];
+
+					srand(0);
+					for (size_t i = 0; i < NumContainers; i++)
+					{
+						const size_t count = rand() % MaxElements;
+						for (size_t j = 0; j < count; j++)
+						{
+							pContainers[i].Add(j);
+						}
+					}
+
+					for (size_t i = 0; i < NumContainers; i++)
+					{
+						pContainers[i].RemoveFirst(1);
+
+						for (const auto& el : pContainers[i])
+						{
+							checksum += el;
+						}
+					}
+
+					delete[] pContainers;
+				});
+
+			Benchmark::DoNotOptimize(checksum);
+
+			state.SetCounter("fill_iterate_destroy", "sizeof", (double)sizeof(TContainer));
+			state.SetCounter("fill_iterate_destroy", "heap_allocations", (double)CountingAllocator::s_numAllocations.load());
+			state.SetCounter("fill_iterate_destroy", "heap_bytes", (double)CountingAllocator::s_allocatedBytes.load());
 		}
-		static bool SanityCheck() { return true; }
 	};
 
-	void RunVectorBenchmark()
+	void RegisterVectorBenchmarks(Benchmark::Runner& runner)
 	{
 		using TDeepData = TDeepData<513>;
 		using TPlainData = TPlainData<511>;
 
-		printf("\nStarting Vector benchmark...\n");
+		runner.AddCheck("vector/sanity/TVector<TPlainData>", &TestCase_VectorPerfromance<TPlainData, TVector<TPlainData>>::SanityCheck);
+		runner.AddCheck("vector/sanity/TVector<TDeepData>", &TestCase_VectorPerfromance<TDeepData, TVector<TDeepData>>::SanityCheck);
 
-		TVector<Result> res;
+		runner.Add("vector/TVector<TPlainData>", &TestCase_VectorPerfromance<TPlainData, TVector<TPlainData>>::PerformanceTests);
+		runner.Add("vector/TVector<TDeepData>", &TestCase_VectorPerfromance<TDeepData, TVector<TDeepData>>::PerformanceTests);
+		runner.Add("vector/std::vector<TPlainData>", &TestCase_VectorPerfromance<TPlainData, std::vector<TPlainData>>::PerformanceTests);
+		runner.Add("vector/std::vector<TDeepData>", &TestCase_VectorPerfromance<TDeepData, std::vector<TDeepData>>::PerformanceTests);
 
-		res.Add(TestCase_VectorPerfromance<TPlainData, TVector<TPlainData>> ::RunTests());
-		res.Add(TestCase_VectorPerfromance<TDeepData, TVector<TDeepData>>::RunTests());
+		runner.Add("vector/small/TVector", &TestCase_SmallVectorPerformance<TVector<size_t, CountingAllocator>>::PerformanceTests);
+		runner.Add("vector/small/TVector+TInlineAllocator<4>", &TestCase_SmallVectorPerformance<TVector<size_t, Memory::TInlineAllocator<4 * sizeof(size_t), CountingAllocator>>>::PerformanceTests);
+		runner.Add("vector/small/TInlineVector<4>", &TestCase_SmallVectorPerformance<TInlineVector<size_t, 4, CountingAllocator>>::PerformanceTests);
 
-		res.Add(TestCase_VectorPerfromance<TPlainData, std::vector<TPlainData>> ::RunTests());
-		res.Add(TestCase_VectorPerfromance<TDeepData, std::vector<TDeepData>>::RunTests());
+		TestCase_SortPerformance::Register(runner, 100000);
+		TestCase_SortPerformance::Register(runner, 4000000);
+	}
 
-		for (auto& r : res)
-		{
-			r.PrintLog();
-		}
+	void RunVectorBenchmark()
+	{
+		printf("\nStarting Vector benchmark...\n");
 
-		printf("\n\n");
+		Benchmark::Runner runner;
+		RegisterVectorBenchmarks(runner);
+		Benchmark::Print(runner.Run(Benchmark::Settings()));
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Memory/Memory.h"
+
+namespace Sailor
+{
+	// Lock-free work stealing deque (Chase-Lev, with the memory orders from Le et al. 2013).
+	// The owner thread pushes and pops at the bottom (LIFO), any other thread steals from the top (FIFO).
+	// The buffer grows by the owner, the previous buffers are kept until destruction
+	// since the thieves could still read them, so the memory is bounded by the 2x of the peak size.
+	// The elements are stored in the atomics, so only the trivially copyable types (pointers, handles) are allowed.
+	template<typename TElementType, typename TAllocator = Memory::DefaultGlobalAllocator>
+	class TWorkStealingDeque final
+	{
+		static_assert(std::is_trivially_copyable_v<TElementType>, "The elements are copied by the thieves before the ownership is resolved");
+
+		struct Buffer
+		{
+			int64_t m_capacity = 0;
+			Buffer* m_pPrevious = nullptr;
+			std::atomic<TElementType>* m_elements = nullptr;
+
+			__forceinline TElementType Get(int64_t index) const { return m_elements[index & (m_capacity - 1)].load(std::memory_order_relaxed); }
+			__forceinline void Put(int64_t index, TElementType element) { m_elements[index & (m_capacity - 1)].store(element, std::memory_order_relaxed); }
+		};
+
+	public:
+
+		TWorkStealingDeque(int64_t capacity = 256)
+		{
+			int64_t powerOfTwo = 2;
+			while (powerOfTwo < capacity)
+			{
+				powerOfTwo *= 2;
+			}
+
+			m_pBuffer.store(CreateBuffer(powerOfTwo, nullptr), std::memory_order_relaxed);
+		}
+
+		TWorkStealingDeque(const TWorkStealingDeque&) = delete;
+		TWorkStealingDeque& operator=(const TWorkStealingDeque&) = delete;
+
+		~TWorkStealingDeque()
+		{
+			Buffer* pBuffer = m_pBuffer.load();
+			while (pBuffer)
+			{
+				Buffer* pPrevious = pBuffer->m_pPrevious;
+				DestroyBuffer(pBuffer);
+				pBuffer = pPrevious;
+			}
+		}
+
+		// Owner only
+		void Push(TElementType element)
+		{
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+			const int64_t top = m_top.load(std::memory_order_acquire);
+			Buffer* pBuffer = m_pBuffer.load(std::memory_order_relaxed);
+
+			if (bottom - top > pBuffer->m_capacity - 1)
+			{
+				pBuffer = Grow(pBuffer, top, bottom);
+			}
+
+			pBuffer->Put(bottom, element);
+			m_bottom.store(bottom + 1, std::memory_order_release);
+		}
+
+		// Owner only, takes the last pushed element
+		bool TryPop(TElementType& out)
+		{
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+			Buffer* pBuffer = m_pBuffer.load(std::memory_order_relaxed);
+			m_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				// Empty
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			out = pBuffer->Get(bottom);
+			if (top == bottom)
+			{
+				// The last element, race with the thieves
+				const bool bWon = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return bWon;
+			}
+
+			return true;
+		}
+
+		// Any thread, takes the oldest element. Returns false if the deque is empty or the race is lost
+		bool TrySteal(TElementType& out)
+		{
+			int64_t top = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+			{
+				return false;
+			}
+
+			Buffer* pBuffer = m_pBuffer.load(std::memory_order_acquire);
+			const TElementType element = pBuffer->Get(top);
+
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return false;
+			}
+
+			out = element;
+			return true;
+		}
+
+		// Approximate under the contention
+		size_t Num() const
+		{
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+			const int64_t top = m_top.load(std::memory_order_relaxed);
+			return bottom > top ? (size_t)(bottom - top) : 0;
+		}
+
+		__forceinline bool IsEmpty() const { return Num() == 0; }
+
+	protected:
+
+		static Buffer* CreateBuffer(int64_t capacity, Buffer* pPrevious)
+		{
+			Buffer* pBuffer = new (TAllocator::allocate(sizeof(Buffer), alignof(Buffer))) Buffer();
+			pBuffer->m_capacity = capacity;
+			pBuffer->m_pPrevious = pPrevious;
+			pBuffer->m_elements = static_cast<std::atomic<TElementType>*>(TAllocator::allocate(sizeof(std::atomic<TElementType>) * capacity, alignof(std::atomic<TElementType>)));
+
+			for (int64_t i = 0; i < capacity; i++)
+			{
+				new (&pBuffer->m_elements[i]) std::atomic<TElementType>();
+			}
+
+			return pBuffer;
+		}
+
+		static void DestroyBuffer(Buffer* pBuffer)
+		{
+			TAllocator::free(pBuffer->m_elements, sizeof(std::atomic<TElementType>) * pBuffer->m_capacity);
+			pBuffer->~Buffer();
+			TAllocator::free(pBuffer, sizeof(Buffer));
+		}
+
+		Buffer* Grow(Buffer* pBuffer, int64_t top, int64_t bottom)
+		{
+			Buffer* pNewBuffer = CreateBuffer(pBuffer->m_capacity * 2, pBuffer);
+			for (int64_t i = top; i < bottom; i++)
+			{
+				pNewBuffer->Put(i, pBuffer->Get(i));
+			}
+
+			m_pBuffer.store(pNewBuffer, std::memory_order_release);
+			return pNewBuffer;
+		}
+
+		alignas(64) std::atomic<int64_t> m_top = 0;
+		alignas(64) std::atomic<int64_t> m_bottom = 0;
+		alignas(64) std::atomic<Buffer*> m_pBuffer = nullptr;
+	};
+}
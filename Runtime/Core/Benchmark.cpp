@@ -0,0 +1,436 @@
+#include "Benchmark.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <nlohmann_json/include/nlohmann/json.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace Sailor;
+using namespace Sailor::Benchmark;
+
+namespace
+{
+#ifdef _WIN32
+	DWORD_PTR g_initialAffinity = 0;
+#else
+	cpu_set_t g_initialAffinity;
+	bool g_bHasInitialAffinity = false;
+#endif
+
+	const char* GetArgValue(const char** args, int32_t& i, int32_t num)
+	{
+		if (i + 1 < num)
+		{
+			return args[++i];
+		}
+
+		printf("Missing value for %s\n", args[i]);
+		return "";
+	}
+}
+
+Statistics Sailor::Benchmark::CalculateStatistics(const std::vector<double>& samples)
+{
+	Statistics res{};
+	if (samples.empty())
+	{
+		return res;
+	}
+
+	std::vector<double> sorted(samples);
+	std::sort(sorted.begin(), sorted.end());
+
+	const size_t num = sorted.size();
+
+	res.m_min = sorted.front();
+	res.m_max = sorted.back();
+	res.m_median = (num % 2) ? sorted[num / 2] : (sorted[num / 2 - 1] + sorted[num / 2]) * 0.5;
+
+	double sum = 0.0;
+	for (const double sample : sorted)
+	{
+		sum += sample;
+	}
+	res.m_mean = sum / (double)num;
+
+	if (num > 1)
+	{
+		double variance = 0.0;
+		for (const double sample : sorted)
+		{
+			variance += (sample - res.m_mean) * (sample - res.m_mean);
+		}
+		res.m_stdDev = std::sqrt(variance / (double)(num - 1));
+	}
+
+	return res;
+}
+
+bool Sailor::Benchmark::PinCurrentThread(int32_t cpu)
+{
+#ifdef _WIN32
+	if (cpu < 0)
+	{
+		if (g_initialAffinity)
+		{
+			SetThreadAffinityMask(GetCurrentThread(), g_initialAffinity);
+		}
+		return true;
+	}
+
+	if (cpu >= (int32_t)(sizeof(DWORD_PTR) * 8))
+	{
+		return false;
+	}
+
+	const DWORD_PTR prevAffinity = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+	if (prevAffinity == 0)
+	{
+		return false;
+	}
+
+	if (!g_initialAffinity)
+	{
+		g_initialAffinity = prevAffinity;
+	}
+
+	return true;
+#else
+	const pthread_t thread = pthread_self();
+
+	if (cpu < 0)
+	{
+		if (g_bHasInitialAffinity)
+		{
+			pthread_setaffinity_np(thread, sizeof(cpu_set_t), &g_initialAffinity);
+		}
+		return true;
+	}
+
+	if (cpu >= CPU_SETSIZE)
+	{
+		return false;
+	}
+
+	if (!g_bHasInitialAffinity)
+	{
+		if (pthread_getaffinity_np(thread, sizeof(cpu_set_t), &g_initialAffinity) != 0)
+		{
+			return false;
+		}
+		g_bHasInitialAffinity = true;
+	}
+
+	cpu_set_t affinity;
+	CPU_ZERO(&affinity);
+	CPU_SET(cpu, &affinity);
+
+	return pthread_setaffinity_np(thread, sizeof(cpu_set_t), &affinity) == 0;
+#endif
+}
+
+void Sailor::Benchmark::Print(const Report& report)
+{
+	for (const auto& check : report.m_checks)
+	{
+		printf("%s %s\n", check.m_bPassed ? "[PASSED]" : "[FAILED]", check.m_name.c_str());
+	}
+
+	printf("\n%-72s %10s %10s %10s %8s %10s\n", "Benchmark", "Median ms", "Min ms", "Max ms", "StdDev%", "ns/item");
+
+	for (const auto& summary : report.m_summaries)
+	{
+		const Statistics& stats = summary.m_statistics;
+		const double stdDevPercent = stats.m_mean > 0.0 ? stats.m_stdDev / stats.m_mean * 100.0 : 0.0;
+
+		printf("%-72s %10.3f %10.3f %10.3f %8.2f", summary.m_name.c_str(), stats.m_median, stats.m_min, stats.m_max, stdDevPercent);
+
+		if (summary.m_numItems)
+		{
+			printf(" %10.2f", summary.GetNsPerItem());
+		}
+
+		for (const auto& counter : summary.m_counters)
+		{
+			printf(" %s: %.2f", counter.first.c_str(), counter.second);
+		}
+
+		printf("\n");
+	}
+
+	printf("\n");
+}
+
+bool Sailor::Benchmark::WriteJson(const std::string& path, const Report& report)
+{
+	nlohmann::ordered_json json;
+
+	json["settings"] = {
+		{ "warmups", report.m_settings.m_numWarmups },
+		{ "repetitions", report.m_settings.m_numRepetitions },
+		{ "cpu", report.m_settings.m_cpu },
+		{ "filter", report.m_settings.m_filter } };
+
+	json["checks"] = nlohmann::ordered_json::array();
+	for (const auto& check : report.m_checks)
+	{
+		json["checks"].push_back({ { "name", check.m_name }, { "passed", check.m_bPassed } });
+	}
+
+	json["results"] = nlohmann::ordered_json::array();
+	for (const auto& summary : report.m_summaries)
+	{
+		nlohmann::ordered_json result;
+		result["name"] = summary.m_name;
+		result["items"] = summary.m_numItems;
+		result["median_ms"] = summary.m_statistics.m_median;
+		result["mean_ms"] = summary.m_statistics.m_mean;
+		result["min_ms"] = summary.m_statistics.m_min;
+		result["max_ms"] = summary.m_statistics.m_max;
+		result["stddev_ms"] = summary.m_statistics.m_stdDev;
+		result["ns_per_item"] = summary.GetNsPerItem();
+		result["samples_ms"] = summary.m_samples;
+
+		result["counters"] = nlohmann::ordered_json::object();
+		for (const auto& counter : summary.m_counters)
+		{
+			result["counters"][counter.first] = counter.second;
+		}
+
+		json["results"].push_back(std::move(result));
+	}
+
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		printf("Cannot write benchmark report %s\n", path.c_str());
+		return false;
+	}
+
+	file << json.dump(2) << std::endl;
+	printf("Results are saved to %s\n", path.c_str());
+
+	return true;
+}
+
+bool Sailor::Benchmark::ReadJson(const std::string& path, Report& outReport)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		printf("Cannot read benchmark report %s\n", path.c_str());
+		return false;
+	}
+
+	const nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+	if (json.is_discarded() || !json.contains("results"))
+	{
+		printf("Wrong benchmark report %s\n", path.c_str());
+		return false;
+	}
+
+	outReport = Report();
+
+	if (json.contains("settings"))
+	{
+		const auto& settings = json["settings"];
+		outReport.m_settings.m_numWarmups = settings.value("warmups", 0u);
+		outReport.m_settings.m_numRepetitions = settings.value("repetitions", 0u);
+		outReport.m_settings.m_cpu = settings.value("cpu", -1);
+		outReport.m_settings.m_filter = settings.value("filter", std::string());
+	}
+
+	if (json.contains("checks"))
+	{
+		for (const auto& check : json["checks"])
+		{
+			outReport.m_checks.push_back(CheckResult{ check.value("name", std::string()), check.value("passed", false) });
+		}
+	}
+
+	for (const auto& result : json["results"])
+	{
+		Summary& summary = outReport.m_summaries.emplace_back();
+		summary.m_name = result.value("name", std::string());
+		summary.m_numItems = result.value("items", (size_t)0);
+
+		if (result.contains("samples_ms"))
+		{
+			summary.m_samples = result["samples_ms"].get<std::vector<double>>();
+		}
+
+		if (result.contains("counters"))
+		{
+			for (const auto& [name, value] : result["counters"].items())
+			{
+				summary.m_counters.emplace_back(name, value.get<double>());
+			}
+		}
+
+		// The raw samples are the source of truth, the stored statistics are for the readers
+		summary.m_statistics = CalculateStatistics(summary.m_samples);
+		if (summary.m_samples.empty())
+		{
+			summary.m_statistics.m_median = result.value("median_ms", 0.0);
+			summary.m_statistics.m_mean = result.value("mean_ms", 0.0);
+			summary.m_statistics.m_min = result.value("min_ms", 0.0);
+			summary.m_statistics.m_max = result.value("max_ms", 0.0);
+			summary.m_statistics.m_stdDev = result.value("stddev_ms", 0.0);
+		}
+	}
+
+	return true;
+}
+
+uint32_t Sailor::Benchmark::Compare(const Report& baseline, const Report& current, double threshold)
+{
+	uint32_t numRegressions = 0;
+	uint32_t numImprovements = 0;
+
+	printf("\n%-72s %12s %12s %9s\n", "Benchmark", "Baseline ms", "Current ms", "Delta");
+
+	for (const auto& summary : current.m_summaries)
+	{
+		const Summary* pBaseline = baseline.Find(summary.m_name);
+		if (!pBaseline)
+		{
+			printf("%-72s %12s %12.3f %9s\n", summary.m_name.c_str(), "-", summary.m_statistics.m_median, "new");
+			continue;
+		}
+
+		const Statistics& base = pBaseline->m_statistics;
+		const Statistics& curr = summary.m_statistics;
+
+		const double diff = curr.m_median - base.m_median;
+		const double delta = base.m_median > 0.0 ? diff / base.m_median : 0.0;
+		const double noise = 2.0 * (std::max)(base.m_stdDev, curr.m_stdDev);
+		const bool bSignificant = std::abs(delta) > threshold && std::abs(diff) > noise;
+
+		const char* verdict = "";
+		if (bSignificant && diff > 0.0)
+		{
+			verdict = "REGRESSION";
+			numRegressions++;
+		}
+		else if (bSignificant)
+		{
+			verdict = "improvement";
+			numImprovements++;
+		}
+
+		printf("%-72s %12.3f %12.3f %+8.1f%% %s\n", summary.m_name.c_str(), base.m_median, curr.m_median, delta * 100.0, verdict);
+	}
+
+	for (const auto& summary : baseline.m_summaries)
+	{
+		if (!current.Find(summary.m_name))
+		{
+			printf("%-72s %12.3f %12s %9s\n", summary.m_name.c_str(), summary.m_statistics.m_median, "-", "missing");
+		}
+	}
+
+	printf("\nRegressions: %u, improvements: %u, threshold: %.1f%%\n", numRegressions, numImprovements, threshold * 100.0);
+
+	return numRegressions;
+}
+
+int32_t Sailor::Benchmark::RunFromCommandLine(const Runner& runner, const char** args, int32_t num)
+{
+	Settings settings{};
+	std::string outputPath;
+	std::string baselinePath;
+	std::string comparePath;
+	double threshold = 0.05;
+
+	for (int32_t i = 1; i < num; i++)
+	{
+		const char* arg = args[i];
+
+		if (strcmp(arg, "--filter") == 0)
+		{
+			settings.m_filter = GetArgValue(args, i, num);
+		}
+		else if (strcmp(arg, "--warmup") == 0)
+		{
+			settings.m_numWarmups = (uint32_t)atoi(GetArgValue(args, i, num));
+		}
+		else if (strcmp(arg, "--repetitions") == 0)
+		{
+			settings.m_numRepetitions = (uint32_t)atoi(GetArgValue(args, i, num));
+		}
+		else if (strcmp(arg, "--cpu") == 0)
+		{
+			settings.m_cpu = atoi(GetArgValue(args, i, num));
+		}
+		else if (strcmp(arg, "--out") == 0)
+		{
+			outputPath = GetArgValue(args, i, num);
+		}
+		else if (strcmp(arg, "--baseline") == 0)
+		{
+			baselinePath = GetArgValue(args, i, num);
+		}
+		else if (strcmp(arg, "--threshold") == 0)
+		{
+			threshold = atof(GetArgValue(args, i, num)) / 100.0;
+		}
+		else if (strcmp(arg, "--compare") == 0)
+		{
+			baselinePath = GetArgValue(args, i, num);
+			comparePath = GetArgValue(args, i, num);
+		}
+		else if (strcmp(arg, "--list") == 0)
+		{
+			for (const auto& name : runner.GetCaseNames())
+			{
+				printf("%s\n", name.c_str());
+			}
+			return 0;
+		}
+		else
+		{
+			printf("Unknown argument %s\n", arg);
+			return 1;
+		}
+	}
+
+	Report baseline;
+	if (!baselinePath.empty() && !ReadJson(baselinePath, baseline))
+	{
+		return 1;
+	}
+
+	// Diff two stored reports
+	if (!comparePath.empty())
+	{
+		Report current;
+		if (!ReadJson(comparePath, current))
+		{
+			return 1;
+		}
+
+		return Compare(baseline, current, threshold) ? 1 : 0;
+	}
+
+	const Report report = runner.Run(settings);
+	Print(report);
+
+	if (!outputPath.empty() && !WriteJson(outputPath, report))
+	{
+		return 1;
+	}
+
+	uint32_t numRegressions = 0;
+	if (!baselinePath.empty())
+	{
+		numRegressions = Compare(baseline, report, threshold);
+	}
+
+	return (report.AllChecksPassed() && numRegressions == 0) ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Core/Defines.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Micro-benchmark harness: the cases are registered in the Runner,
+// each case is executed with the warmup and the repetitions, the samples are summarized per phase
+// and could be stored to JSON and compared against the baseline.
+// The harness uses std containers, so it doesn't depend on the containers it measures.
+namespace Sailor::Benchmark
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Settings
+	{
+		uint32_t m_numWarmups = 1;
+		uint32_t m_numRepetitions = 5;
+
+		// The single threaded cases are pinned to the CPU, -1 keeps the affinity untouched
+		int32_t m_cpu = -1;
+
+		// Only the cases that contain the substring are executed
+		std::string m_filter;
+	};
+
+	struct Statistics
+	{
+		double m_min = 0.0;
+		double m_max = 0.0;
+		double m_mean = 0.0;
+		double m_median = 0.0;
+		double m_stdDev = 0.0;
+	};
+
+	struct Summary
+	{
+		std::string m_name;
+		size_t m_numItems = 0;
+
+		// Milliseconds per repetition
+		Statistics m_statistics;
+		std::vector<double> m_samples;
+
+		// The values reported by the case, the last repetition wins
+		std::vector<std::pair<std::string, double>> m_counters;
+
+		double GetNsPerItem() const { return m_numItems ? m_statistics.m_median * 1000000.0 / (double)m_numItems : 0.0; }
+	};
+
+	struct CheckResult
+	{
+		std::string m_name;
+		bool m_bPassed = false;
+	};
+
+	struct Report
+	{
+		Settings m_settings;
+		std::vector<CheckResult> m_checks;
+		std::vector<Summary> m_summaries;
+
+		bool AllChecksPassed() const
+		{
+			for (const auto& check : m_checks)
+			{
+				if (!check.m_bPassed)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		const Summary* Find(const std::string& name) const
+		{
+			for (const auto& summary : m_summaries)
+			{
+				if (summary.m_name == name)
+				{
+					return &summary;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	SAILOR_API Statistics CalculateStatistics(const std::vector<double>& samples);
+
+	// Pins the calling thread to the CPU, the negative index restores the initial affinity
+	SAILOR_API bool PinCurrentThread(int32_t cpu);
+
+	SAILOR_API void Print(const Report& report);
+
+	SAILOR_API bool WriteJson(const std::string& path, const Report& report);
+	SAILOR_API bool ReadJson(const std::string& path, Report& outReport);
+
+	// Prints the difference of the medians, the change is significant if it exceeds the threshold
+	// and the noise of both runs (2 standard deviations). Returns the number of regressions.
+	SAILOR_API uint32_t Compare(const Report& baseline, const Report& current, double threshold);
+
+	// Prevents the compiler from throwing away the computed value
+	template<typename T>
+	__forceinline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static volatile const void* s_pSink = nullptr;
+		s_pSink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	// Passed to the case on each repetition.
+	// The case measures its phases, the phases are reported as '<case>/<phase>'.
+	// If there are no measured phases the whole call is measured.
+	class State
+	{
+	public:
+
+		template<typename TFunction>
+		void Measure(const char* phase, size_t numItems, TFunction&& func)
+		{
+			const auto start = Clock::now();
+			func();
+			const auto end = Clock::now();
+
+			Sample& sample = GetSample(phase);
+			sample.m_ms += std::chrono::duration<double, std::milli>(end - start).count();
+			sample.m_numItems += numItems;
+		}
+
+		template<typename TFunction>
+		void Measure(const char* phase, TFunction&& func) { Measure(phase, 0, std::forward<TFunction>(func)); }
+
+		// Reports the value, like the amount of allocations or the collisions
+		void SetCounter(const char* phase, const char* name, double value)
+		{
+			auto& counters = GetSample(phase).m_counters;
+			for (auto& counter : counters)
+			{
+				if (counter.first == name)
+				{
+					counter.second = value;
+					return;
+				}
+			}
+			counters.emplace_back(name, value);
+		}
+
+		// The case reports the broken result
+		void Fail(const char* reason) { m_failure = reason; }
+
+	protected:
+
+		struct Sample
+		{
+			std::string m_phase;
+			double m_ms = 0.0;
+			size_t m_numItems = 0;
+			std::vector<std::pair<std::string, double>> m_counters;
+		};
+
+		Sample& GetSample(const char* phase)
+		{
+			for (auto& sample : m_samples)
+			{
+				if (sample.m_phase == phase)
+				{
+					return sample;
+				}
+			}
+
+			m_samples.push_back(Sample{ phase });
+			return m_samples.back();
+		}
+
+		std::vector<Sample> m_samples;
+		std::string m_failure;
+
+		friend class Runner;
+	};
+
+	class Runner
+	{
+	public:
+
+		using TCase = std::function<void(State&)>;
+		using TCheck = std::function<bool()>;
+
+		void Add(std::string name, TCase func) { m_cases.push_back(Case{ std::move(name), std::move(func), false }); }
+
+		// The case spawns the threads, it is not pinned since the threads inherit the affinity
+		void AddMultithreaded(std::string name, TCase func) { m_cases.push_back(Case{ std::move(name), std::move(func), true }); }
+
+		// The sanity check is executed once before the measurements
+		void AddCheck(std::string name, TCheck func) { m_checks.push_back(Check{ std::move(name), std::move(func) }); }
+
+		std::vector<std::string> GetCaseNames() const
+		{
+			std::vector<std::string> res;
+			for (const auto& check : m_checks)
+			{
+				res.push_back(check.m_name);
+			}
+
+			for (const auto& benchmark : m_cases)
+			{
+				res.push_back(benchmark.m_name);
+			}
+			return res;
+		}
+
+		Report Run(const Settings& settings) const
+		{
+			Report report;
+			report.m_settings = settings;
+
+			for (const auto& check : m_checks)
+			{
+				if (IsFiltered(check.m_name, settings))
+				{
+					continue;
+				}
+
+				printf("Check %s...\n", check.m_name.c_str());
+				report.m_checks.push_back(CheckResult{ check.m_name, check.m_func() });
+			}
+
+			for (const auto& benchmark : m_cases)
+			{
+				if (IsFiltered(benchmark.m_name, settings))
+				{
+					continue;
+				}
+
+				printf("Benchmark %s...\n", benchmark.m_name.c_str());
+
+				const bool bPinned = !benchmark.m_bMultithreaded && settings.m_cpu >= 0 && PinCurrentThread(settings.m_cpu);
+				RunCase(benchmark, settings, report);
+
+				if (bPinned)
+				{
+					PinCurrentThread(-1);
+				}
+			}
+
+			return report;
+		}
+
+	protected:
+
+		struct Case
+		{
+			std::string m_name;
+			TCase m_func;
+			bool m_bMultithreaded = false;
+		};
+
+		struct Check
+		{
+			std::string m_name;
+			TCheck m_func;
+		};
+
+		static bool IsFiltered(const std::string& name, const Settings& settings)
+		{
+			return !settings.m_filter.empty() && name.find(settings.m_filter) == std::string::npos;
+		}
+
+		static void RunCase(const Case& benchmark, const Settings& settings, Report& report)
+		{
+			for (uint32_t i = 0; i < settings.m_numWarmups; i++)
+			{
+				State state;
+				benchmark.m_func(state);
+			}
+
+			const size_t first = report.m_summaries.size();
+			const uint32_t numRepetitions = (std::max)(settings.m_numRepetitions, 1u);
+			bool bFailed = false;
+
+			for (uint32_t i = 0; i < numRepetitions; i++)
+			{
+				State state;
+
+				const auto start = Clock::now();
+				benchmark.m_func(state);
+				const auto end = Clock::now();
+
+				if (!state.m_failure.empty() && !bFailed)
+				{
+					report.m_checks.push_back(CheckResult{ benchmark.m_name + ": " + state.m_failure, false });
+					bFailed = true;
+				}
+
+				if (state.m_samples.empty())
+				{
+					state.m_samples.push_back(State::Sample{ "", std::chrono::duration<double, std::milli>(end - start).count() });
+				}
+
+				for (auto& sample : state.m_samples)
+				{
+					const std::string name = sample.m_phase.empty() ? benchmark.m_name : benchmark.m_name + "/" + sample.m_phase;
+
+					Summary* pSummary = nullptr;
+					for (size_t j = first; j < report.m_summaries.size(); j++)
+					{
+						if (report.m_summaries[j].m_name == name)
+						{
+							pSummary = &report.m_summaries[j];
+							break;
+						}
+					}
+
+					if (!pSummary)
+					{
+						pSummary = &report.m_summaries.emplace_back();
+						pSummary->m_name = name;
+					}
+
+					pSummary->m_samples.push_back(sample.m_ms);
+					pSummary->m_numItems = sample.m_numItems;
+					pSummary->m_counters = std::move(sample.m_counters);
+				}
+			}
+
+			for (size_t j = first; j < report.m_summaries.size(); j++)
+			{
+				report.m_summaries[j].m_statistics = CalculateStatistics(report.m_summaries[j].m_samples);
+			}
+		}
+
+		std::vector<Case> m_cases;
+		std::vector<Check> m_checks;
+	};
+
+	// Command line front end, returns the process exit code:
+	//   --filter <substring> --warmup <n> --repetitions <n> --cpu <index> --out <report.json>
+	//   --baseline <report.json> --threshold <percent> compares the run against the stored report
+	//   --compare <baseline.json> <current.json> compares two stored reports without running
+	//   --list prints the case names
+	// Non zero is returned if any sanity check fails or there are regressions.
+	SAILOR_API int32_t RunFromCommandLine(const Runner& runner, const char** args, int32_t num);
+}
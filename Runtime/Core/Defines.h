@@ -2,10 +2,16 @@
 
 struct IUnknown; // Workaround for "combaseapi.h(229): error C2187: syntax error: 'identifier' was unexpected here" when using /permissive-
 
-#ifndef _SAILOR_IMPORT_
-# define SAILOR_API __declspec(dllexport)
+#if defined(_MSC_VER)
+# ifndef _SAILOR_IMPORT_
+#  define SAILOR_API __declspec(dllexport)
+# else
+#  define SAILOR_API __declspec(dllimport)
+# endif
 #else
-# define SAILOR_API __declspec(dllimport)
+// The standalone benchmarks are built with GCC/Clang, without the shared library
+# define SAILOR_API
+# define __forceinline
 #endif
 
 #include <cassert>
@@ -44,6 +50,14 @@ typedef unsigned long DWORD;
 #define SAILOR_PROFILE_ALLOC(ptr, size) TracyAlloc(ptr, size)
 #define SAILOR_PROFILE_FREE(ptr) TracyFree(ptr)
 
+#ifdef TRACY_FIBERS
+#define SAILOR_PROFILE_FIBER_ENTER(FiberName) TracyFiberEnter(FiberName)
+#define SAILOR_PROFILE_FIBER_LEAVE() TracyFiberLeave
+#else
+#define SAILOR_PROFILE_FIBER_ENTER(FiberName)
+#define SAILOR_PROFILE_FIBER_LEAVE()
+#endif
+
 #else 
 #define SAILOR_PROFILE_FUNCTION()
 #define SAILOR_PROFILE_SCOPE(Msg)
@@ -52,6 +66,10 @@ typedef unsigned long DWORD;
 #define SAILOR_PROFILE_END_BLOCK(HashMsg)
 #define SAILOR_PROFILE_END_FRAME()
 #define SAILOR_PROFILE_THREAD_NAME(ThreadName)
+#define SAILOR_PROFILE_FIBER_ENTER(FiberName)
+#define SAILOR_PROFILE_FIBER_LEAVE()
+#define SAILOR_PROFILE_ALLOC(ptr, size)
+#define SAILOR_PROFILE_FREE(ptr)
 #endif
 
 #define SAILOR_EDITOR
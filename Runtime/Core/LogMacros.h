@@ -1,6 +1,17 @@
 #pragma once
 #include <string>
 #include <iostream>
+
+#ifdef SAILOR_BENCHMARKS_STANDALONE
+
+// The standalone benchmarks are built without the engine: no editor and no scheduler to dispatch the messages to
+#include <cstdio>
+
+#define SAILOR_LOG(Format, ...) { printf(Format "\n", ##__VA_ARGS__); }
+#define SAILOR_LOG_ERROR(Format, ...) { fprintf(stderr, Format "\n", ##__VA_ARGS__); }
+
+#else
+
 #include <windows.h>
 #include "Submodules/Editor.h"
 
@@ -16,7 +27,7 @@
 	if (scheduler && !scheduler->IsMainThread()) \
 	{ \
 		const bool bIsRendererThread = scheduler->IsRendererThread(); \
-		Tasks::CreateTask("Log", [=]() \
+		Tasks::CreateLightTask("Log", [buffer = std::string(buffer), bIsRendererThread]() \
 		{ \
 			if(!bIsRendererThread) \
 			{ \
@@ -47,7 +58,7 @@
 	if (scheduler && !scheduler->IsMainThread()) \
 	{ \
 		const bool bIsRendererThread = scheduler->IsRendererThread(); \
-		Tasks::CreateTask("LogError", [=]() \
+		Tasks::CreateLightTask("LogError", [buffer = std::string(buffer), bIsRendererThread]() \
 		{ \
 			auto hConsole = GetStdHandle(STD_OUTPUT_HANDLE); \
 			SetConsoleTextAttribute(hConsole, 4); \
@@ -70,4 +81,6 @@
 		std::cerr /*<< "Main thread: " */ << (buffer) << std::endl; \
 		SetConsoleTextAttribute(hConsole, 7); \
 	} \
-}
\ No newline at end of file
+}
+
+#endif
\ No newline at end of file
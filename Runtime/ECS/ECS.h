@@ -146,7 +146,7 @@ namespace Sailor::ECS
 	protected:
 
 		TVector<TData> m_components;
-		TList<size_t> m_freeList;
+		TPooledList<size_t> m_freeList;
 
 		class SAILOR_API RegistrationFactoryMethod
 		{
@@ -5,6 +5,7 @@
 #include "AssetRegistry/Material/MaterialImporter.h"
 #include "RHI/Material.h"
 #include "RHI/Fence.h"
+#include "Tasks/ParallelFor.h"
 
 using namespace Sailor;
 using namespace Sailor::Tasks;
@@ -16,86 +17,57 @@ void StaticMeshRendererECS::BeginPlay()
 
 Tasks::ITaskPtr StaticMeshRendererECS::Tick(float deltaTime)
 {
-	const uint32_t NumComponentsPerTask = 1024;
+	const uint32_t MinComponentsPerTask = 256;
 
 	SAILOR_PROFILE_FUNCTION();
 
+	using TStationaryProxies = TVector<TPair<RHI::RHIMeshProxy, Math::AABB>>;
+
 	//TODO: Resolve New/Delete components
-	TVector<Tasks::TaskPtr<TVector<TPair<RHI::RHIMeshProxy, Math::AABB>>>> tasks;
-	for (uint32_t i = 0; i < (m_components.Num() / NumComponentsPerTask + 1); i++)
-	{
-		auto task = Tasks::CreateTask<TVector<TPair<RHI::RHIMeshProxy, Math::AABB>>>("StaticMeshRendererECS:Update Stationary Objects",
-			[this, i]()
+	TStationaryProxies stationaryProxies = Tasks::ParallelReduce("StaticMeshRendererECS:Update Stationary Objects", 0, m_components.Num(), TStationaryProxies(),
+		[this](size_t begin, size_t end, TStationaryProxies& temp)
+		{
+			for (size_t index = begin; index < end; index++)
 			{
-				TVector<TPair<RHI::RHIMeshProxy, Math::AABB>> temp;
+				auto& data = m_components[index];
+				auto ownerGameObject = data.m_owner.StaticCast<GameObject>();
+				EMobilityType mobilityType = ownerGameObject->GetMobilityType();
 
-				for (uint32_t j = 0; j < NumComponentsPerTask; j++)
+				if (mobilityType == EMobilityType::Stationary && data.m_bIsActive && data.GetModel() && data.GetModel()->IsReady())
 				{
-					const uint32_t index = i * NumComponentsPerTask + j;
-					if (index >= m_components.Num())
-					{
-						break;
-					}
-
-					auto& data = m_components[index];
-					auto ownerGameObject = data.m_owner.StaticCast<GameObject>();
-					EMobilityType mobilityType = ownerGameObject->GetMobilityType();
+					const auto& ownerTransform = ownerGameObject->GetTransformComponent();
+					Math::AABB adjustedBounds = data.GetModel()->GetBoundsAABB();
 
-					if (mobilityType == EMobilityType::Stationary && data.m_bIsActive && data.GetModel() && data.GetModel()->IsReady())
+					// Should we update only when transform changed?
+					if ((data.m_bIsDirty || data.m_frameLastChange == 0 || ownerTransform.GetFrameLastChange() > data.m_frameLastChange) && adjustedBounds.IsValid())
 					{
-						const auto& ownerTransform = ownerGameObject->GetTransformComponent();
-						Math::AABB adjustedBounds = data.GetModel()->GetBoundsAABB();
-
-						// Should we update only when transform changed?
-						if ((data.m_bIsDirty || data.m_frameLastChange == 0 || ownerTransform.GetFrameLastChange() > data.m_frameLastChange) && adjustedBounds.IsValid())
-						{
-							RHI::RHIMeshProxy proxy;
-							proxy.m_staticMeshEcs = GetComponentIndex(&data);
-							proxy.m_worldMatrix = ownerTransform.GetCachedWorldMatrix();
-
-							adjustedBounds.Apply(proxy.m_worldMatrix);
+						RHI::RHIMeshProxy proxy;
+						proxy.m_staticMeshEcs = GetComponentIndex(&data);
+						proxy.m_worldMatrix = ownerTransform.GetCachedWorldMatrix();
 
-							temp.Emplace(TPair(std::move(proxy), std::move(adjustedBounds)));
+						adjustedBounds.Apply(proxy.m_worldMatrix);
 
-							data.m_frameLastChange = ownerTransform.GetFrameLastChange();
+						temp.Emplace(TPair(std::move(proxy), std::move(adjustedBounds)));
 
-							if (data.m_frameLastChange != ownerGameObject->GetFrameLastChange())
-							{
-								UpdateGameObject(ownerGameObject, GetWorld()->GetCurrentFrame());
-							}
+						data.m_frameLastChange = ownerTransform.GetFrameLastChange();
 
-							data.m_bIsDirty = false;
+						if (data.m_frameLastChange != ownerGameObject->GetFrameLastChange())
+						{
+							UpdateGameObject(ownerGameObject, GetWorld()->GetCurrentFrame());
 						}
+
+						data.m_bIsDirty = false;
 					}
 				}
-
-				return temp;
-			}, EThreadType::Worker);
-
-		if (m_components.Num() < NumComponentsPerTask)
-		{
-			task->Execute();
-
-			for (auto& t : task->m_result)
-			{
-				m_sceneViewProxiesCache->m_stationaryOctree.Update(glm::vec4(t.m_second.GetCenter(), 1), t.m_second.GetExtents(), t.m_first);
 			}
-
-			break;
-		}
-
-		task->Run();
-		tasks.Add(task);
-	}
-
-	for (auto& task : tasks)
-	{
-		task->Wait();
-		for (auto& t : task->m_result)
+		},
+		[](TStationaryProxies lhs, TStationaryProxies rhs)
 		{
-			m_sceneViewProxiesCache->m_stationaryOctree.Update(glm::vec4(t.m_second.GetCenter(), 1), t.m_second.GetExtents(), t.m_first);
-		}
-	}
+			lhs.AddRange(std::move(rhs));
+			return lhs;
+		}, MinComponentsPerTask);
+
+	m_sceneViewProxiesCache->m_stationaryOctree.UpdateBatch(stationaryProxies);
 
 	auto updateStaticTask = Tasks::CreateTask("StaticMeshRendererECS:Update Static Objects",
 		[this]()
@@ -142,7 +114,7 @@ Tasks::ITaskPtr StaticMeshRendererECS::Tick(float deltaTime)
 					}
 				}
 			}
-		}, EThreadType::RHI)->Run();
+		}, EThreadType::RHI, ETaskPriority::FrameCritical)->Run();
 
 	updateStaticTask->Wait();
 
@@ -1,5 +1,6 @@
 #include "ECS/TransformECS.h"
 #include "Engine/GameObject.h"
+#include "Tasks/ParallelSort.h"
 
 using namespace Sailor;
 using namespace Sailor::Tasks;
@@ -83,7 +84,7 @@ Tasks::ITaskPtr TransformECS::Tick(float deltaTime)
 	{
 		// We should sort the dirty components to make the pass
 		// more cache-friendly
-		m_dirtyComponents.Sort();
+		Tasks::RadixSort(m_dirtyComponents);
 
 		// Update only changed transforms
 		for (auto& i : m_dirtyComponents)
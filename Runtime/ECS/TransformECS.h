@@ -5,6 +5,7 @@
 #include "ECS/ECS.h"
 #include "Components/Component.h"
 #include "Memory/Memory.h"
+#include "Containers/InlineVector.h"
 #include "Math/Transform.h"
 
 namespace Sailor
@@ -22,7 +23,7 @@ namespace Sailor
 		SAILOR_API __forceinline const Math::Transform& GetTransform() const { return m_transform; }
 		SAILOR_API __forceinline size_t GetParent() const { return m_parent; }
 		SAILOR_API __forceinline void SetNewParent(const TransformComponent* parent);
-		SAILOR_API __forceinline const TVector<size_t, Memory::TInlineAllocator<4 * sizeof(size_t)>>& GetChildren() const { return m_children; }
+		SAILOR_API __forceinline const TInlineVector<size_t, 4>& GetChildren() const { return m_children; }
 
 		__forceinline ObjectPtr& GetOwner() { return m_owner; }
 
@@ -48,7 +49,7 @@ namespace Sailor
 		Math::Transform m_transform;
 		size_t m_parent = ECS::InvalidIndex;
 		size_t m_newParent = ECS::InvalidIndex;
-		TVector<size_t, Memory::TInlineAllocator<4 * sizeof(size_t)>> m_children;
+		TInlineVector<size_t, 4> m_children;
 
 		friend class TransformECS;
 	};
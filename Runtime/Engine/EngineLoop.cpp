@@ -45,6 +45,19 @@ TSharedPtr<World> EngineLoop::InstantiateWorld(WorldPrefabPtr worldPrefab, EWorl
 	return newWorld;
 }
 
+void EngineLoop::UnloadWorld(const TSharedPtr<World>& world)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	check(world && m_worlds.Contains(world));
+
+	// Clear releases the heap of the world, the global heap is released once the objects of the world are gone
+	world->Clear();
+	m_worlds.RemoveFirst(world);
+
+	Memory::DefaultGlobalAllocator::ReleaseUnused();
+}
+
 void EngineLoop::ProcessCpuFrame(FrameState& currentInputState)
 {
 	SAILOR_PROFILE_FUNCTION();
@@ -31,6 +31,9 @@ namespace Sailor
 		SAILOR_API TSharedPtr<World> CreateEmptyWorld(std::string name, EWorldBehaviourMask mask);
 		SAILOR_API TSharedPtr<World> InstantiateWorld(WorldPrefabPtr worldPrefab, EWorldBehaviourMask mask);
 
+		// The level transition, the world is cleared and the empty pages of the heaps are returned to the OS
+		SAILOR_API void UnloadWorld(const TSharedPtr<World>& world);
+
 		SAILOR_API const TVector<TSharedPtr<World>>& GetWorlds() const { return m_worlds; }
 		SAILOR_API TSharedPtr<World> GetWorld() const { return m_worlds[0]; }
 
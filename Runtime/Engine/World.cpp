@@ -323,4 +323,7 @@ void World::Clear()
 	}
 
 	check(m_objectsMap.Num() == 0);
+
+	// The world is unloaded, there is no reason to keep the empty pages of its heap
+	m_allocator->ReleaseUnused();
 }
\ No newline at end of file
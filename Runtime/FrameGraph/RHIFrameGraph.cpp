@@ -277,7 +277,7 @@ void RHIFrameGraph::Process(RHI::RHISceneViewPtr rhiSceneView,
 							auto fence = RHIFencePtr::Make();
 							RHI::Renderer::GetDriver()->SetDebugName(fence, std::format("Submit chaining cmd lists"));
 							RHI::Renderer::GetDriver()->SubmitCommandList(transferCmdList, fence, newChainSemaphore, chainSemaphore);
-						}, EThreadType::RHI);
+						}, EThreadType::RHI, ETaskPriority::FrameCritical);
 
 					if (tasks.Num() > 0)
 					{
@@ -295,7 +295,7 @@ void RHIFrameGraph::Process(RHI::RHISceneViewPtr rhiSceneView,
 							auto fence = RHIFencePtr::Make();
 							RHI::Renderer::GetDriver()->SetDebugName(fence, std::format("Submit chaining cmd lists"));
 							RHI::Renderer::GetDriver()->SubmitCommandList(cmdList, fence, chainSemaphore, newChainSemaphore);
-						}, EThreadType::RHI);
+						}, EThreadType::RHI, ETaskPriority::FrameCritical);
 
 					submitCmdList2->Join(submitCmdList1);
 					submitCmdList2->Run();
@@ -199,7 +199,7 @@ void RenderSceneNode::Process(RHIFrameGraphPtr frameGraph, RHI::RHICommandListPt
 		}
 
 		TVector<RHICommandListPtr> secondaryCommandLists(m_batches.Num() > numThreads ? (numThreads - 1) : 0);
-		TVector<Tasks::ITaskPtr> tasks;
+		TVector<Tasks::LightTaskPtr> tasks;
 
 		auto vecBatches = m_batches.ToVector();
 		TVector<uint32_t> storageIndex(vecBatches.Num());
@@ -236,7 +236,7 @@ void RenderSceneNode::Process(RHIFrameGraphPtr frameGraph, RHI::RHICommandListPt
 			const uint32_t start = (uint32_t)materialsPerThread * i;
 			const uint32_t end = (uint32_t)materialsPerThread * (i + 1);
 
-			auto task = Tasks::CreateTask("Record draw calls in secondary command list",
+			auto task = Tasks::CreateLightTask("Record draw calls in secondary command list",
 				[&, i = i, start = start, end = end, transferCommandList = transferCommandList]()
 				{
 					RHICommandListPtr cmdList = driver->CreateCommandList(true, RHI::ECommandListQueue::Graphics);
@@ -280,7 +280,7 @@ void RenderSceneNode::Process(RHIFrameGraphPtr frameGraph, RHI::RHICommandListPt
 
 					commands->EndCommandList(cmdList);
 					secondaryCommandLists[i] = std::move(cmdList);
-				}, EThreadType::RHI);
+				}, EThreadType::RHI, ETaskPriority::FrameCritical);
 
 			task->Run();
 			tasks.Add(task);
@@ -15,6 +15,7 @@
 #include "AssetRegistry/Texture/TextureImporter.h"
 #include "AssetRegistry/AssetRegistry.h"
 #include "EnvironmentNode.h"
+#include "Tasks/ParallelFor.h"
 
 using namespace Sailor;
 using namespace Sailor::RHI;
@@ -122,43 +123,30 @@ TVector<uint8_t> SkyNode::GenerateCloudsNoiseLow() const
 	TVector<uint8_t> res;
 	res.Resize(CloudsNoiseLowResolution * CloudsNoiseLowResolution * CloudsNoiseLowResolution);
 
-	TVector<Tasks::ITaskPtr> tasks;
-	tasks.Reserve(CloudsNoiseLowResolution);
+	// Row per item, the rows are split between the idle workers
+	Tasks::ParallelFor("Generate Clouds Noise Low", 0, CloudsNoiseLowResolution * CloudsNoiseLowResolution, [=, this, &res](size_t row)
+		{
+			const uint32_t y = (uint32_t)row % CloudsNoiseLowResolution;
+			const uint32_t z = (uint32_t)row / CloudsNoiseLowResolution;
 
-	for (uint32_t z = 0; z < CloudsNoiseLowResolution; z++)
-	{
-		auto pTask = Tasks::CreateTask("Generate Clouds Noise Low", [=, this, &res]()
+			for (uint32_t x = 0; x < CloudsNoiseLowResolution; x++)
 			{
-				for (uint32_t y = 0; y < CloudsNoiseLowResolution; y++)
-				{
-					for (uint32_t x = 0; x < CloudsNoiseLowResolution; x++)
-					{
-						uint8_t& value = res[x + y * CloudsNoiseLowResolution + z * CloudsNoiseLowResolution * CloudsNoiseLowResolution];
-
-						vec3 uv = vec3((float)x / CloudsNoiseLowResolution, (float)y / CloudsNoiseLowResolution, (float)z / CloudsNoiseLowResolution) + (0.5f / CloudsNoiseLowResolution);
+				uint8_t& value = res[x + y * CloudsNoiseLowResolution + z * CloudsNoiseLowResolution * CloudsNoiseLowResolution];
 
-						const float tiling = 5.0f;
+				vec3 uv = vec3((float)x / CloudsNoiseLowResolution, (float)y / CloudsNoiseLowResolution, (float)z / CloudsNoiseLowResolution) + (0.5f / CloudsNoiseLowResolution);
 
-						const float perlinNoiseLow = (Math::fBmTiledPerlin(uv * tiling, 4, (int32_t)tiling) + 1) * 0.5f;
-						const float cellularNoiseLow = Math::fBmTiledWorley(uv * tiling, 4, (int32_t)tiling);
-						const float cellularNoiseMid = Math::fBmTiledWorley(uv * tiling * 2.0f, 4, (int32_t)tiling * 2);
-						const float cellularNoiseHigh = Math::fBmTiledWorley(uv * tiling * 3.0f, 4, (int32_t)tiling * 3);
-
-						const float noise = Remap(perlinNoiseLow, (cellularNoiseLow * 0.625f + cellularNoiseMid * 0.25f + cellularNoiseHigh * 0.125f) - 1.0f, 1.0f, 0.0f, 1.0f);
-
-						value = uint8_t(noise * 255.0f);
-					}
-				}
+				const float tiling = 5.0f;
 
-			})->Run();
+				const float perlinNoiseLow = (Math::fBmTiledPerlin(uv * tiling, 4, (int32_t)tiling) + 1) * 0.5f;
+				const float cellularNoiseLow = Math::fBmTiledWorley(uv * tiling, 4, (int32_t)tiling);
+				const float cellularNoiseMid = Math::fBmTiledWorley(uv * tiling * 2.0f, 4, (int32_t)tiling * 2);
+				const float cellularNoiseHigh = Math::fBmTiledWorley(uv * tiling * 3.0f, 4, (int32_t)tiling * 3);
 
-		tasks.Add(pTask);
-	}
+				const float noise = Remap(perlinNoiseLow, (cellularNoiseLow * 0.625f + cellularNoiseMid * 0.25f + cellularNoiseHigh * 0.125f) - 1.0f, 1.0f, 0.0f, 1.0f);
 
-	for (uint32_t i = 0; i < tasks.Num(); i++)
-	{
-		tasks[i]->Wait();
-	}
+				value = uint8_t(noise * 255.0f);
+			}
+		});
 
 	return res;
 }
@@ -291,7 +279,7 @@ void SkyNode::Process(RHIFrameGraphPtr frameGraph, RHI::RHICommandListPtr transf
 				{
 					auto cache = GenerateCloudsNoiseHigh();
 					AssetRegistry::WriteBinaryFile(pathNoiseHigh, cache);
-				})->Run();
+				}, EThreadType::Worker, ETaskPriority::Background)->Run();
 
 			bShouldReturn = true;
 		}
@@ -305,7 +293,7 @@ void SkyNode::Process(RHIFrameGraphPtr frameGraph, RHI::RHICommandListPtr transf
 				{
 					auto cache = GenerateCloudsNoiseLow();
 					AssetRegistry::WriteBinaryFile(pathNoiseLow, cache);
-				})->Run();
+				}, EThreadType::Worker, ETaskPriority::Background)->Run();
 
 			bShouldReturn = true;
 		}
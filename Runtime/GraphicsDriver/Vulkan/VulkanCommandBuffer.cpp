@@ -14,6 +14,7 @@
 #include "VulkanDescriptors.h"
 #include "VulkanSwapchain.h"
 #include "Tasks/Scheduler.h"
+#include "Tasks/LightTask.h"
 #include "VulkanImage.h"
 #include "Containers/Pair.h"
 #include "Memory/RefPtr.hpp"
@@ -45,29 +46,32 @@ VulkanCommandBuffer::~VulkanCommandBuffer()
 {
 	DWORD currentThreadId = GetCurrentThreadId();
 
-	auto pReleaseResource = Tasks::CreateTask("Release command buffer",
-		[
-			duplicatedCommandBuffer = m_commandBuffer,
-				duplicatedCommandPool = m_commandPool,
-				duplicatedDevice = m_device
-		]()
+	if (m_currentThreadId == currentThreadId)
+	{
+		if (m_commandBuffer)
 		{
-			if (duplicatedCommandBuffer)
+			vkFreeCommandBuffers(*m_device, *m_commandPool, 1, &m_commandBuffer);
+		}
+		m_device.Clear();
+	}
+	else
+	{
+		// The command pool is bound to the thread
+		Tasks::CreateLightTask("Release command buffer",
+			[
+				duplicatedCommandBuffer = m_commandBuffer,
+					duplicatedCommandPool = m_commandPool,
+					duplicatedDevice = m_device
+			]()
 			{
-				vkFreeCommandBuffers(*duplicatedDevice, *duplicatedCommandPool, 1, &duplicatedCommandBuffer);
-			}
-		});
+				if (duplicatedCommandBuffer)
+				{
+					vkFreeCommandBuffers(*duplicatedDevice, *duplicatedCommandPool, 1, &duplicatedCommandBuffer);
+				}
+			})->Run(m_currentThreadId);
+	}
 
-			if (m_currentThreadId == currentThreadId)
-			{
-				pReleaseResource->Execute();
-				m_device.Clear();
-			}
-			else
-			{
-				App::GetSubmodule<Tasks::Scheduler>()->Run(pReleaseResource, m_currentThreadId);
-			}
-			ClearDependencies();
+	ClearDependencies();
 }
 
 VulkanCommandPoolPtr VulkanCommandBuffer::GetCommandPool() const
@@ -5,6 +5,7 @@
 #include "VulkanImageView.h"
 #include "VulkanSamplers.h"
 #include "AssetRegistry/Shader/ShaderCompiler.h"
+#include "Tasks/LightTask.h"
 
 using namespace Sailor;
 using namespace Sailor::GraphicsDriver::Vulkan;
@@ -189,7 +190,8 @@ void VulkanDescriptorSet::Release()
 		check(m_descriptorPool.IsValid());
 		check(m_device.IsValid());
 
-		auto pReleaseResource = Tasks::CreateTask("Release descriptor set",
+		// The descriptor pool is bound to the thread
+		Tasks::CreateLightTask("Release descriptor set",
 			[
 				duplicatedPool = std::move(m_descriptorPool),
 					duplicatedSet = std::move(m_descriptorSet),
@@ -200,9 +202,7 @@ void VulkanDescriptorSet::Release()
 				{
 					vkFreeDescriptorSets(*duplicatedDevice, *duplicatedPool, 1, &duplicatedSet);
 				}
-			});
-
-				App::GetSubmodule<Tasks::Scheduler>()->Run(pReleaseResource, m_currentThreadId);
+			})->Run(m_currentThreadId);
 	}
 }
 
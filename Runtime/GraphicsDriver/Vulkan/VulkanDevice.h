@@ -8,6 +8,7 @@
 #include "Memory/UniquePtr.hpp"
 #include "RHI/Types.h"
 #include "VulkanMemory.h"
+#include "Memory/MemoryTlsfAllocator.hpp"
 #include "VulkanBufferMemory.h"
 #include "VulkanPipileneStates.h"
 
@@ -23,7 +24,11 @@ using namespace Sailor::Memory;
 
 namespace Sailor::GraphicsDriver::Vulkan
 {
+#ifdef SAILOR_VULKAN_TLSF_DEVICE_MEMORY_ALLOCATOR
+	using VulkanDeviceMemoryAllocator = TTlsfAllocator<Sailor::Memory::GlobalVulkanMemoryAllocator, VulkanMemoryPtr>;
+#else
 	using VulkanDeviceMemoryAllocator = TBlockAllocator<Sailor::Memory::GlobalVulkanMemoryAllocator, VulkanMemoryPtr>;
+#endif
 	using VulkanBufferAllocator = TBlockAllocator<Sailor::Memory::GlobalVulkanBufferAllocator, VulkanBufferMemoryPtr>;
 
 	// Thread independent resources
@@ -1555,42 +1555,39 @@ void VulkanGraphicsDriver::UpdateShaderBinding(RHI::RHIShaderBindingSetPtr bindi
 
 VulkanComputePipelinePtr VulkanGraphicsDriver::GetOrAddComputePipeline(RHI::RHIShaderPtr computeShader, uint32_t sizePushConstantsData)
 {
-	auto& computePipeline = m_cachedComputePipelines.At_Lock(computeShader);
-
-	if (!computePipeline)
-	{
-		auto device = m_vkInstance->GetMainDevice();
-
-		TVector<VulkanDescriptorSetLayoutPtr> descriptorSetLayouts;
-		TVector<RHI::ShaderLayoutBinding> bindings;
-		TVector<VkPushConstantRange> pushConstants;
+	// The pipelines are read every dispatch, the lookup doesn't take the lock
+	return m_cachedComputePipelines.GetOrAdd(computeShader, [&]()
+		{
+			auto device = m_vkInstance->GetMainDevice();
 
-		// We need debug shaders to get full names from reflection
-		VulkanApi::CreateDescriptorSetLayouts(device, { computeShader->m_vulkan.m_shader }, descriptorSetLayouts, bindings);
+			TVector<VulkanDescriptorSetLayoutPtr> descriptorSetLayouts;
+			TVector<RHI::ShaderLayoutBinding> bindings;
+			TVector<VkPushConstantRange> pushConstants;
 
-		// We blindly believe the passed arguments
-		check((sizePushConstantsData > 4) == (computeShader->m_vulkan.m_shader->GetPushConstants().Num() > 0));
+			// We need debug shaders to get full names from reflection
+			VulkanApi::CreateDescriptorSetLayouts(device, { computeShader->m_vulkan.m_shader }, descriptorSetLayouts, bindings);
 
-		if (const bool bRequestPushConstants = (sizePushConstantsData > 4) || (computeShader->m_vulkan.m_shader->GetPushConstants().Num() > 0))
-		{
-			check(sizePushConstantsData > 4);
+			// We blindly believe the passed arguments
+			check((sizePushConstantsData > 4) == (computeShader->m_vulkan.m_shader->GetPushConstants().Num() > 0));
 
-			VkPushConstantRange vkPushConstant;
-			vkPushConstant.offset = 0;
-			vkPushConstant.size = 256;
-			vkPushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+			if (const bool bRequestPushConstants = (sizePushConstantsData > 4) || (computeShader->m_vulkan.m_shader->GetPushConstants().Num() > 0))
+			{
+				check(sizePushConstantsData > 4);
 
-			pushConstants.Emplace(vkPushConstant);
-		}
+				VkPushConstantRange vkPushConstant;
+				vkPushConstant.offset = 0;
+				vkPushConstant.size = 256;
+				vkPushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
 
-		auto pipelineLayout = VulkanPipelineLayoutPtr::Make(device, descriptorSetLayouts, bindings, pushConstants, 0);
-		computePipeline = VulkanComputePipelinePtr::Make(device, pipelineLayout, computeShader->m_vulkan.m_shader);
-		computePipeline->Compile();
-	}
+				pushConstants.Emplace(vkPushConstant);
+			}
 
-	m_cachedComputePipelines.Unlock(computeShader);
+			auto pipelineLayout = VulkanPipelineLayoutPtr::Make(device, descriptorSetLayouts, bindings, pushConstants, 0);
+			auto computePipeline = VulkanComputePipelinePtr::Make(device, pipelineLayout, computeShader->m_vulkan.m_shader);
+			computePipeline->Compile();
 
-	return computePipeline;
+			return computePipeline;
+		});
 }
 
 RHI::RHITexturePtr VulkanGraphicsDriver::GetOrAddMsaaFramebufferRenderTarget(RHI::EFormat textureFormat, glm::ivec2 extent)
@@ -14,6 +14,7 @@
 #include "GraphicsDriver/Vulkan/VulkanDevice.h"
 #include "Platform/Win32/Window.h"
 #include "Containers/ConcurrentMap.h"
+#include "Containers/ConcurrentHashMap.h"
 
 #ifdef SAILOR_BUILD_WITH_VULKAN
 
@@ -292,7 +293,7 @@ namespace Sailor::GraphicsDriver::Vulkan
 		// Cached MSAA render targets to support MSAA for rendering to framebuffer
 		TConcurrentMap<size_t, RHI::RHITexturePtr> m_cachedMsaaRenderTargets{};
 
-		TConcurrentMap<RHI::RHIShaderPtr, VulkanComputePipelinePtr> m_cachedComputePipelines{};
+		TConcurrentHashMap<RHI::RHIShaderPtr, VulkanComputePipelinePtr> m_cachedComputePipelines{};
 		TConcurrentMap<CachedDescriptorSet, TPair<VulkanDescriptorSetPtr, uint32_t>> m_cachedDescriptorSets{ 24 };
 
 		GraphicsDriver::Vulkan::VulkanApi* m_vkInstance{};
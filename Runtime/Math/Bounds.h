@@ -1,4 +1,6 @@
 #pragma once
+#include <cfloat>
+#include <immintrin.h>
 #include <glm/glm/glm.hpp>
 #include <glm/glm/gtx/hash.hpp>
 #include "Memory/Memory.h"
@@ -49,9 +51,9 @@ namespace Sailor::Math
 
 	protected:
 
-		union { struct { vec3 m_origin; float dummy1; }; __m128 O4; };
-		union { struct { vec3 m_direction; float dummy2; }; __m128 D4; };
-		union { struct { vec3 m_rDirection; float dummy3; }; __m128 rD4; };
+		union { vec3 m_origin; __m128 O4; };
+		union { vec3 m_direction; __m128 D4; };
+		union { vec3 m_rDirection; __m128 rD4; };
 
 		friend float IntersectRayAABB(const Ray& ray, const __m128 bmin4, const __m128 bmax4, float maxRayLength);
 	};
@@ -96,13 +98,10 @@ namespace Sailor::Math
 
 	struct Sphere
 	{
-		union
-		{
-			struct { glm::vec3 m_center; float m_radius; };
-			glm::vec4 m_vec4;
-		};
+		glm::vec3 m_center;
+		float m_radius;
 
-		const vec4& GetVec4() const { return m_vec4; }
+		vec4 GetVec4() const { return vec4(m_center, m_radius); }
 		Sphere() : m_center(0.0f, 0.0f, 0.0f), m_radius(1.0f) {}
 		Sphere(glm::vec3 center, float radius) : m_center(center), m_radius(radius) {}
 	};
@@ -166,6 +165,7 @@ namespace Sailor::Math
 		SAILOR_API __forceinline glm::mat4 CalculateOrthoMatrixByView(const glm::mat4& view, float zMult) const;
 
 		SAILOR_API __forceinline const TVector<glm::vec3>& GetCorners() const;
+		SAILOR_API __forceinline const Plane& GetPlane(uint32_t index) const { return m_planes[index]; }
 
 		SAILOR_API __forceinline void ExtractFrustumPlanes(const glm::mat4& projectionViewMatrix, bool bNormalizePlanes = true);
 		SAILOR_API __forceinline void ExtractFrustumPlanes(const glm::mat4& worldMatrix, float aspect, float fovY, float zNear, float zFar);
@@ -265,7 +265,7 @@ namespace Sailor::Math
 namespace std
 {
 	template<>
-	struct std::hash<Sailor::Math::AABB>
+	struct hash<Sailor::Math::AABB>
 	{
 		SAILOR_API size_t operator()(Sailor::Math::AABB const& instance) const
 		{
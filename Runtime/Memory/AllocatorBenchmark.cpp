@@ -0,0 +1,707 @@
+#include "AllocatorBenchmark.h"
+#include "Memory.h"
+#include <cstdlib>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include "MallocAllocator.hpp"
+#include "HeapAllocator.h"
+#include "MemoryBlockAllocator.hpp"
+#include "MemoryTlsfAllocator.hpp"
+#include "MemoryPoolAllocator.hpp"
+#include "MemoryPtr.hpp"
+#include "LockFreeHeapAllocator.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include "psapi.h"
+#else
+#include <unistd.h>
+#endif
+
+using namespace Sailor;
+using namespace Sailor::Memory;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Resident set size of the process
+	size_t GetResidentMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS pmc;
+		GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+		return (size_t)pmc.WorkingSetSize;
+#else
+		std::ifstream statm("/proc/self/statm");
+		size_t totalPages = 0;
+		size_t residentPages = 0;
+		statm >> totalPages >> residentPages;
+		return residentPages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	// HeapAllocator is not thread safe, so the instance is shared under the lock
+	class HeapAllocatorAdapter
+	{
+	public:
+
+		static constexpr const char* Name = "HeapAllocator";
+		static constexpr bool bThreadLocal = false;
+
+		void* Allocate(size_t size)
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			return m_allocator.Allocate(size);
+		}
+
+		void Free(void* ptr, size_t size)
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			m_allocator.Free(ptr);
+		}
+
+	protected:
+
+		std::mutex m_mutex;
+		HeapAllocator m_allocator;
+	};
+
+	template<typename TAllocator>
+	class TGlobalAllocatorAdapter
+	{
+	public:
+
+		static constexpr bool bThreadLocal = false;
+
+		void* Allocate(size_t size) { return TAllocator::allocate(size); }
+		void Free(void* ptr, size_t size) { TAllocator::free(ptr, size); }
+	};
+
+	class LockFreeHeapAllocatorAdapter : public TGlobalAllocatorAdapter<LockFreeHeapAllocator>
+	{
+	public:
+		static constexpr const char* Name = "LockFreeHeapAllocator";
+	};
+
+	class MallocAllocatorAdapter : public TGlobalAllocatorAdapter<MallocAllocator>
+	{
+	public:
+		static constexpr const char* Name = "MallocAllocator";
+	};
+
+	// TInlineAllocator lives on the stack of the thread, the memory cannot be passed to other threads
+	class InlineAllocatorAdapter
+	{
+	public:
+
+		static constexpr const char* Name = "TInlineAllocator";
+		static constexpr bool bThreadLocal = true;
+
+		void* Allocate(size_t size) { return m_allocator.Allocate(size); }
+		void Free(void* ptr, size_t size) { m_allocator.Free(ptr, size); }
+
+	protected:
+
+		TInlineAllocator<16384, MallocAllocator> m_allocator;
+	};
+
+	enum class EWorkload : uint8_t
+	{
+		ProducerConsumer = 0,
+		CrossThreadFree,
+		BurstPerFrame,
+		Fragmentation
+	};
+
+	const char* GetWorkloadName(EWorkload workload)
+	{
+		switch (workload)
+		{
+		case EWorkload::ProducerConsumer: return "producerConsumer";
+		case EWorkload::CrossThreadFree: return "crossThreadFree";
+		case EWorkload::BurstPerFrame: return "burstPerFrame";
+		case EWorkload::Fragmentation: return "fragmentation";
+		}
+		return "";
+	}
+
+	bool IsCrossThreadWorkload(EWorkload workload)
+	{
+		return workload == EWorkload::ProducerConsumer || workload == EWorkload::CrossThreadFree;
+	}
+
+	struct Allocation
+	{
+		void* m_ptr = nullptr;
+		size_t m_size = 0;
+	};
+
+	struct Mailbox
+	{
+		std::mutex m_mutex;
+		std::vector<Allocation> m_allocations;
+
+		void Push(std::vector<Allocation>& batch)
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			m_allocations.insert(m_allocations.end(), batch.begin(), batch.end());
+			batch.clear();
+		}
+
+		void Pop(std::vector<Allocation>& outBatch)
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			std::swap(outBatch, m_allocations);
+		}
+	};
+
+	struct BenchmarkResult
+	{
+		const char* m_allocator = nullptr;
+		EWorkload m_workload = EWorkload::BurstPerFrame;
+		size_t m_numThreads = 0;
+		size_t m_numOps = 0;
+		double m_seconds = 0.0;
+		uint64_t m_p99Ns = 0;
+		int64_t m_rssDelta = 0;
+		size_t m_liveBytes = 0;
+
+		double GetOpsPerSecond() const { return m_seconds > 0.0 ? (double)m_numOps / m_seconds : 0.0; }
+
+		// Resident memory that is not occupied by the live allocations
+		int64_t GetRssOverhead() const { return m_rssDelta - (int64_t)m_liveBytes; }
+	};
+
+	// Shared state of the single run
+	struct RunContext
+	{
+		RunContext(size_t numThreads) : m_mailboxes(numThreads) {}
+
+		std::atomic<size_t> m_numReady = 0;
+		std::atomic<bool> m_bStart = false;
+		std::atomic<size_t> m_numSent = 0;
+		std::atomic<size_t> m_numFinished = 0;
+		std::atomic<bool> m_bRelease = false;
+		std::atomic<size_t> m_numOps = 0;
+		std::atomic<size_t> m_liveBytes = 0;
+
+		std::vector<Mailbox> m_mailboxes;
+
+		std::mutex m_latencyMutex;
+		std::vector<uint32_t> m_latencies;
+	};
+
+	// Only each N-th operation is timed to keep the clock overhead low
+	constexpr size_t LatencySamplingRate = 8;
+
+	constexpr size_t BatchSize = 64;
+	constexpr size_t BurstSize = 256;
+	constexpr size_t NumLiveSlots = 4096;
+
+	template<typename TAdapter>
+	class TAllocatorBenchmark
+	{
+	public:
+
+		static BenchmarkResult Run(Benchmark::State& state, EWorkload workload, size_t numThreads, size_t totalOps)
+		{
+			BenchmarkResult result;
+			result.m_allocator = TAdapter::Name;
+			result.m_workload = workload;
+			result.m_numThreads = numThreads;
+
+			RunContext context(numThreads);
+			TAdapter sharedAdapter;
+
+			const size_t opsPerThread = std::max(totalOps / numThreads, BurstSize);
+			const size_t rssBefore = GetResidentMemory();
+
+			std::vector<std::thread> threads;
+			threads.reserve(numThreads);
+
+			for (size_t i = 0; i < numThreads; i++)
+			{
+				threads.emplace_back([&, i]()
+					{
+						if constexpr (TAdapter::bThreadLocal)
+						{
+							TAdapter localAdapter;
+							RunThread(localAdapter, workload, context, i, numThreads, opsPerThread);
+						}
+						else
+						{
+							RunThread(sharedAdapter, workload, context, i, numThreads, opsPerThread);
+						}
+					});
+			}
+
+			while (context.m_numReady.load() != numThreads)
+			{
+				std::this_thread::yield();
+			}
+
+			// The threads are spawned outside of the measured phase
+			const auto start = Clock::now();
+			state.Measure("run", [&context, numThreads]()
+				{
+					context.m_bStart = true;
+
+					while (context.m_numFinished.load() != numThreads)
+					{
+						std::this_thread::yield();
+					}
+				});
+			const auto finish = Clock::now();
+
+			// All the threads are waiting with their live allocations
+			result.m_rssDelta = (int64_t)GetResidentMemory() - (int64_t)rssBefore;
+			result.m_liveBytes = context.m_liveBytes.load();
+
+			context.m_bRelease = true;
+
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+
+			result.m_seconds = std::chrono::duration<double>(finish - start).count();
+			result.m_numOps = context.m_numOps.load();
+
+			if (!context.m_latencies.empty())
+			{
+				const size_t p99 = (context.m_latencies.size() * 99) / 100;
+				std::nth_element(context.m_latencies.begin(), context.m_latencies.begin() + p99, context.m_latencies.end());
+				result.m_p99Ns = context.m_latencies[p99];
+			}
+
+			return result;
+		}
+
+	protected:
+
+		struct ThreadState
+		{
+			ThreadState(size_t threadIndex) : m_random((uint32_t)threadIndex + 1) {}
+
+			std::mt19937 m_random;
+			std::vector<uint32_t> m_latencies;
+			size_t m_numOps = 0;
+		};
+
+		static __forceinline void* Allocate(TAdapter& adapter, ThreadState& state, size_t size)
+		{
+			void* ptr = nullptr;
+
+			if (state.m_numOps++ % LatencySamplingRate == 0)
+			{
+				const auto start = Clock::now();
+				ptr = adapter.Allocate(size);
+				state.m_latencies.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+			}
+			else
+			{
+				ptr = adapter.Allocate(size);
+			}
+
+			// Touch the memory to get it into the resident set
+			*static_cast<uint8_t*>(ptr) = (uint8_t)size;
+
+			return ptr;
+		}
+
+		static __forceinline void Free(TAdapter& adapter, ThreadState& state, const Allocation& allocation)
+		{
+			if (state.m_numOps++ % LatencySamplingRate == 0)
+			{
+				const auto start = Clock::now();
+				adapter.Free(allocation.m_ptr, allocation.m_size);
+				state.m_latencies.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+			}
+			else
+			{
+				adapter.Free(allocation.m_ptr, allocation.m_size);
+			}
+		}
+
+		static void DrainMailbox(TAdapter& adapter, ThreadState& state, Mailbox& mailbox, std::vector<Allocation>& batch)
+		{
+			mailbox.Pop(batch);
+			for (const auto& allocation : batch)
+			{
+				Free(adapter, state, allocation);
+			}
+			batch.clear();
+		}
+
+		static void RunThread(TAdapter& adapter, EWorkload workload, RunContext& context, size_t threadIndex, size_t numThreads, size_t opsPerThread)
+		{
+			ThreadState state(threadIndex);
+			std::vector<Allocation> batch;
+			std::vector<Allocation> live;
+
+			batch.reserve(BurstSize);
+
+			context.m_numReady++;
+			while (!context.m_bStart.load())
+			{
+				std::this_thread::yield();
+			}
+
+			switch (workload)
+			{
+			case EWorkload::ProducerConsumer:
+			{
+				// Even threads produce, odd threads consume the memory of the previous one
+				const bool bProducer = threadIndex % 2 == 0;
+				const bool bHasConsumer = threadIndex + 1 < numThreads;
+
+				if (bProducer && bHasConsumer)
+				{
+					std::uniform_int_distribution<size_t> sizes(16, 512);
+					Mailbox& mailbox = context.m_mailboxes[threadIndex + 1];
+
+					for (size_t i = 0; i < opsPerThread; i++)
+					{
+						const size_t size = sizes(state.m_random);
+						batch.push_back({ Allocate(adapter, state, size), size });
+
+						if (batch.size() == BatchSize)
+						{
+							mailbox.Push(batch);
+						}
+					}
+					mailbox.Push(batch);
+					context.m_numFinished++;
+				}
+				else if (!bProducer)
+				{
+					Mailbox& mailbox = context.m_mailboxes[threadIndex];
+
+					// The consumer frees exactly the same amount of blocks as the paired producer allocates
+					while (state.m_numOps < opsPerThread)
+					{
+						DrainMailbox(adapter, state, mailbox, batch);
+						std::this_thread::yield();
+					}
+					context.m_numFinished++;
+				}
+				else
+				{
+					context.m_numFinished++;
+				}
+				break;
+			}
+			case EWorkload::CrossThreadFree:
+			{
+				std::uniform_int_distribution<size_t> sizes(16, 512);
+				Mailbox& neighbour = context.m_mailboxes[(threadIndex + 1) % numThreads];
+				Mailbox& mailbox = context.m_mailboxes[threadIndex];
+				std::vector<Allocation> received;
+
+				for (size_t i = 0; i < opsPerThread; i += BatchSize)
+				{
+					for (size_t j = 0; j < BatchSize; j++)
+					{
+						const size_t size = sizes(state.m_random);
+						batch.push_back({ Allocate(adapter, state, size), size });
+					}
+
+					neighbour.Push(batch);
+					DrainMailbox(adapter, state, mailbox, received);
+				}
+
+				context.m_numSent++;
+				while (context.m_numSent.load() < numThreads)
+				{
+					DrainMailbox(adapter, state, mailbox, received);
+					std::this_thread::yield();
+				}
+				DrainMailbox(adapter, state, mailbox, received);
+
+				context.m_numFinished++;
+				break;
+			}
+			case EWorkload::BurstPerFrame:
+			{
+				// Transient per frame allocations that are released in the reverse order at the end of frame
+				std::uniform_int_distribution<size_t> sizes(16, 1024);
+
+				for (size_t frame = 0; frame < opsPerThread / BurstSize; frame++)
+				{
+					for (size_t j = 0; j < BurstSize; j++)
+					{
+						const size_t size = sizes(state.m_random);
+						batch.push_back({ Allocate(adapter, state, size), size });
+					}
+
+					for (auto it = batch.rbegin(); it != batch.rend(); ++it)
+					{
+						Free(adapter, state, *it);
+					}
+					batch.clear();
+				}
+
+				context.m_numFinished++;
+				break;
+			}
+			case EWorkload::Fragmentation:
+			{
+				// Each 8th slot is long lived and pins the memory, the rest is constantly replaced by the random sizes
+				std::uniform_int_distribution<size_t> sizes(8, 4096);
+				std::uniform_int_distribution<size_t> slots(0, NumLiveSlots - 1);
+
+				live.resize(NumLiveSlots);
+				for (auto& allocation : live)
+				{
+					allocation.m_size = sizes(state.m_random);
+					allocation.m_ptr = Allocate(adapter, state, allocation.m_size);
+				}
+
+				while (state.m_numOps < opsPerThread)
+				{
+					const size_t slot = slots(state.m_random);
+					if (slot % 8 == 0)
+					{
+						continue;
+					}
+
+					Free(adapter, state, live[slot]);
+					live[slot].m_size = sizes(state.m_random);
+					live[slot].m_ptr = Allocate(adapter, state, live[slot].m_size);
+				}
+
+				size_t liveBytes = 0;
+				for (const auto& allocation : live)
+				{
+					liveBytes += allocation.m_size;
+				}
+				context.m_liveBytes += liveBytes;
+
+				context.m_numFinished++;
+				break;
+			}
+			}
+
+			context.m_numOps += state.m_numOps;
+
+			{
+				std::unique_lock<std::mutex> lk(context.m_latencyMutex);
+				context.m_latencies.insert(context.m_latencies.end(), state.m_latencies.begin(), state.m_latencies.end());
+			}
+
+			// Wait for the RSS measurement before the live memory is released
+			while (!context.m_bRelease.load())
+			{
+				std::this_thread::yield();
+			}
+
+			for (auto it = live.rbegin(); it != live.rend(); ++it)
+			{
+				adapter.Free(it->m_ptr, it->m_size);
+			}
+		}
+	};
+
+	template<typename TAdapter>
+	void RegisterAllocatorCases(Benchmark::Runner& runner, const std::vector<size_t>& numThreads, size_t totalOps)
+	{
+		const EWorkload workloads[] = { EWorkload::ProducerConsumer, EWorkload::CrossThreadFree, EWorkload::BurstPerFrame, EWorkload::Fragmentation };
+
+		for (EWorkload workload : workloads)
+		{
+			if (TAdapter::bThreadLocal && IsCrossThreadWorkload(workload))
+			{
+				continue;
+			}
+
+			for (size_t threads : numThreads)
+			{
+				if (workload == EWorkload::ProducerConsumer && threads < 2)
+				{
+					continue;
+				}
+
+				const std::string name = std::string("allocator/") + GetWorkloadName(workload) + "/" + TAdapter::Name + "/" + std::to_string(threads);
+
+				runner.AddMultithreaded(name, [workload, threads, totalOps](Benchmark::State& state)
+					{
+						const BenchmarkResult result = TAllocatorBenchmark<TAdapter>::Run(state, workload, threads, totalOps);
+
+						state.SetCounter("run", "opsPerSecond", result.GetOpsPerSecond());
+						state.SetCounter("run", "p99LatencyNs", (double)result.m_p99Ns);
+						state.SetCounter("run", "rssOverheadMb", (double)result.GetRssOverhead() / 1048576.0);
+					});
+			}
+		}
+	}
+
+	// The device memory like pattern: mostly small buffers with the rare large textures, random lifetime
+	template<typename TSubAllocator>
+	void BenchmarkSubAllocator(const char* name)
+	{
+		const size_t NumOperations = 500000;
+		const size_t MaxLiveAllocations = 4096;
+
+		TSubAllocator allocator(32 * 1024 * 1024, 512 * 1024, 64 * 1024 * 1024);
+		std::vector<TMemoryPtr<void*>> live;
+		std::mt19937 random(0);
+
+		live.reserve(MaxLiveAllocations);
+
+		size_t peakSpace = 0;
+		size_t liveBytes = 0;
+		size_t peakLiveBytes = 0;
+
+		const auto start = Clock::now();
+		for (size_t i = 0; i < NumOperations; i++)
+		{
+			if (live.empty() || (live.size() < MaxLiveAllocations && random() % 3 != 0))
+			{
+				const size_t alignment = (size_t)1 << (4 + random() % 9);
+				const size_t size = 256 + random() % (random() % 8 != 0 ? 16384 : 2 * 1024 * 1024);
+
+				live.push_back(allocator.Allocate(size, alignment));
+				liveBytes += size;
+			}
+			else
+			{
+				const size_t index = random() % live.size();
+				std::swap(live[index], live.back());
+
+				liveBytes -= live.back().m_size;
+				allocator.Free(live.back());
+				live.pop_back();
+			}
+
+			peakSpace = std::max(peakSpace, allocator.GetOccupiedSpace());
+			peakLiveBytes = std::max(peakLiveBytes, liveBytes);
+		}
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		for (auto& ptr : live)
+		{
+			allocator.Free(ptr);
+		}
+
+		printf("%-16s %8.2f ms, %6.1f ns/op, peak reserved: %8.2f Mb, peak live: %8.2f Mb\n",
+			name, ms, ms * 1000000.0 / NumOperations, (double)peakSpace / 1048576.0, (double)peakLiveBytes / 1048576.0);
+	}
+
+	// Fragments the allocator and defragments it with the budget: the moved data is preserved,
+	// the destinations don't overlap the live allocations and the evacuated blocks are released
+	template<typename TSubAllocator>
+	bool DefragmentationSanityCheck()
+	{
+		const size_t BlockSize = 64 * 1024;
+		const size_t BytesBudget = 16 * 1024;
+		const size_t NumAllocations = 2048;
+
+		TSubAllocator allocator(BlockSize, 256, 0);
+		std::vector<TMemoryPtr<void*>> live;
+		std::mt19937 random(0);
+
+		for (size_t i = 0; i < NumAllocations; i++)
+		{
+			TMemoryPtr<void*> ptr = allocator.Allocate((size_t)(64 + random() % 512), (size_t)16);
+			memset(*ptr, (int)(i % 251) + 1, ptr.m_size);
+			live.push_back(ptr);
+		}
+
+		// Each block keeps a quarter of the allocations
+		for (auto& ptr : live)
+		{
+			if (random() % 4 != 0)
+			{
+				allocator.Free(ptr);
+			}
+		}
+		live.erase(std::remove_if(live.begin(), live.end(), [](const TMemoryPtr<void*>& ptr) { return !ptr.m_ptr; }), live.end());
+
+		const size_t occupiedBefore = allocator.GetOccupiedSpace();
+
+		auto overlaps = [&live](const TMemoryPtr<void*>& ptr)
+			{
+				const uint8_t* pBegin = static_cast<const uint8_t*>(*ptr);
+				for (const auto& other : live)
+				{
+					const uint8_t* pOther = static_cast<const uint8_t*>(*other);
+					if (pBegin < pOther + other.m_size && pOther < pBegin + ptr.m_size)
+					{
+						return true;
+					}
+				}
+				return false;
+			};
+
+		bool bPassed = true;
+		for (size_t pass = 0; pass < NumAllocations; pass++)
+		{
+			const size_t movedBytes = allocator.Defragment(BytesBudget, [&](const TMemoryPtr<void*>& src, const TMemoryPtr<void*>& dst)
+				{
+					auto it = std::find_if(live.begin(), live.end(), [&src](const TMemoryPtr<void*>& ptr) { return ptr.m_ptr == src.m_ptr && ptr.m_offset == src.m_offset; });
+
+					if (it == live.end() || dst.m_size != src.m_size || overlaps(dst) || ((uintptr_t)*dst) % 16 != 0)
+					{
+						bPassed = false;
+						return false;
+					}
+
+					memcpy(*dst, *src, src.m_size);
+					*it = dst;
+					return true;
+				});
+
+			bPassed &= movedBytes <= BytesBudget;
+
+			if (movedBytes == 0)
+			{
+				break;
+			}
+		}
+
+		for (const auto& ptr : live)
+		{
+			const uint8_t* pData = static_cast<const uint8_t*>(*ptr);
+			bPassed &= std::all_of(pData, pData + ptr.m_size, [pData](uint8_t value) { return value == pData[0]; });
+		}
+
+		bPassed &= allocator.GetOccupiedSpace() < occupiedBefore;
+
+		for (auto& ptr : live)
+		{
+			allocator.Free(ptr);
+		}
+
+		return bPassed;
+	}
+}
+
+void Sailor::RegisterAllocatorBenchmarks(Benchmark::Runner& runner)
+{
+	runner.AddCheck("allocator/sanity/defragment/TBlockAllocator", &DefragmentationSanityCheck<TBlockAllocator<MallocAllocator, void*>>);
+	runner.AddCheck("allocator/sanity/defragment/TPoolAllocator", &DefragmentationSanityCheck<TPoolAllocator<MallocAllocator, void*>>);
+
+	const std::vector<size_t> numThreads = { 1, 2, 4, 8, 16, 32, 64 };
+	const size_t totalOps = 1 << 21;
+
+	RegisterAllocatorCases<MallocAllocatorAdapter>(runner, numThreads, totalOps);
+	RegisterAllocatorCases<HeapAllocatorAdapter>(runner, numThreads, totalOps);
+	RegisterAllocatorCases<LockFreeHeapAllocatorAdapter>(runner, numThreads, totalOps);
+	RegisterAllocatorCases<InlineAllocatorAdapter>(runner, numThreads, totalOps);
+}
+
+void Sailor::Memory::RunSubAllocatorBenchmark()
+{
+	printf("Starting sub-allocators benchmark...\n");
+
+	BenchmarkSubAllocator<TBlockAllocator<MallocAllocator, void*>>("TBlockAllocator");
+	BenchmarkSubAllocator<TTlsfAllocator<MallocAllocator, void*>>("TTlsfAllocator");
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "Core/Defines.h"
+#include "Core/Benchmark.h"
+
+namespace Sailor
+{
+	// Compares the allocators under the multithreaded workloads: 'allocator/<workload>/<allocator>/<threads>',
+	// the counters report the throughput, p99 latency and the resident memory overhead.
+	// LockFreeHeapAllocator is Win32 only and is skipped on the other platforms.
+	SAILOR_API void RegisterAllocatorBenchmarks(Benchmark::Runner& runner);
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include "Core/Defines.h"
+#include "Memory/MallocAllocator.hpp"
+#include "Containers/Vector.h"
+
+namespace Sailor::Memory
+{
+	// Epoch based reclamation for the lock-free containers.
+	// Threads register in the current epoch with Guard while they access the shared nodes,
+	// the retired nodes are released when no thread could observe them.
+	// The epoch is advanced only if there are no threads registered in the previous one.
+	class EpochReclaimer final
+	{
+		static constexpr size_t NumSlots = 64;
+
+		struct alignas(64) Slot
+		{
+			std::atomic<uint32_t> m_numActive[2]{ 0, 0 };
+		};
+
+		struct Retired
+		{
+			void* m_ptr = nullptr;
+			void (*m_pDeleter)(void*) = nullptr;
+			uint64_t m_epoch = 0;
+		};
+
+	public:
+
+		class Guard
+		{
+		public:
+
+			Guard(const EpochReclaimer& reclaimer) : m_slot(reclaimer.m_slots[GetSlotIndex()])
+			{
+				while (true)
+				{
+					const uint64_t epoch = reclaimer.m_epoch.load();
+					m_parity = (uint32_t)(epoch & 1);
+					m_slot.m_numActive[m_parity].fetch_add(1);
+
+					// The epoch could be advanced before we've registered
+					if (reclaimer.m_epoch.load() == epoch)
+					{
+						break;
+					}
+
+					m_slot.m_numActive[m_parity].fetch_sub(1, std::memory_order_release);
+				}
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+			~Guard() { m_slot.m_numActive[m_parity].fetch_sub(1, std::memory_order_release); }
+
+		protected:
+
+			Slot& m_slot;
+			uint32_t m_parity = 0;
+		};
+
+		// The reclamation is tried each reclaimThreshold retired nodes
+		EpochReclaimer(size_t reclaimThreshold = 64) : m_reclaimThreshold(reclaimThreshold), m_nextReclaim(reclaimThreshold) {}
+
+		EpochReclaimer(const EpochReclaimer&) = delete;
+		EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+		// The owner should guarantee that there are no threads registered
+		~EpochReclaimer()
+		{
+			for (auto& retired : m_retired)
+			{
+				retired.m_pDeleter(retired.m_ptr);
+			}
+		}
+
+		// The node should be unreachable for the new readers
+		void Retire(void* ptr, void (*pDeleter)(void*))
+		{
+			std::lock_guard<std::mutex> lock(m_retiredLock);
+
+			m_retired.Add(Retired{ ptr, pDeleter, m_epoch.load() });
+
+			if (m_retired.Num() >= m_nextReclaim)
+			{
+				Reclaim();
+				m_nextReclaim = m_retired.Num() + m_reclaimThreshold;
+			}
+		}
+
+		// Releases the retired nodes right away if there are no registered threads,
+		// returns false if some nodes could still be observed
+		bool Flush()
+		{
+			std::lock_guard<std::mutex> lock(m_retiredLock);
+
+			// The node is released once the epoch is advanced twice after it's retired
+			Reclaim();
+			Reclaim();
+
+			m_nextReclaim = m_retired.Num() + m_reclaimThreshold;
+			return m_retired.Num() == 0;
+		}
+
+	protected:
+
+		static size_t GetSlotIndex()
+		{
+			static std::atomic<size_t> s_numThreads = 0;
+			thread_local size_t s_slot = s_numThreads++ % NumSlots;
+			return s_slot;
+		}
+
+		// Called under m_retiredLock
+		void Reclaim()
+		{
+			const uint64_t epoch = m_epoch.load();
+
+			// The nodes retired before the previous epoch couldn't be observed after that
+			const uint32_t parity = (uint32_t)((epoch + 1) & 1);
+			for (const auto& slot : m_slots)
+			{
+				if (slot.m_numActive[parity].load() != 0)
+				{
+					return;
+				}
+			}
+
+			m_epoch.store(epoch + 1);
+
+			size_t numAlive = 0;
+			for (size_t i = 0; i < m_retired.Num(); i++)
+			{
+				if (m_retired[i].m_epoch < epoch)
+				{
+					m_retired[i].m_pDeleter(m_retired[i].m_ptr);
+				}
+				else
+				{
+					m_retired[numAlive++] = m_retired[i];
+				}
+			}
+
+			if (numAlive < m_retired.Num())
+			{
+				m_retired.RemoveAt(numAlive, m_retired.Num() - numAlive);
+			}
+		}
+
+		mutable Slot m_slots[NumSlots];
+		std::atomic<uint64_t> m_epoch = 0;
+
+		std::mutex m_retiredLock;
+		TVector<Retired, MallocAllocator> m_retired;
+		size_t m_reclaimThreshold = 64;
+		size_t m_nextReclaim = 64;
+	};
+}
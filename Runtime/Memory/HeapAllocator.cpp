@@ -1,9 +1,11 @@
 #include "HeapAllocator.h"
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <stdint.h>
 #include <cassert>
 #include <algorithm>
+#include <limits>
 #include "Core/Defines.h"
 
 using namespace Sailor;
@@ -15,7 +17,7 @@ using SmallPage = Memory::Internal::SmallPoolAllocator::SmallPage;
 using Page = Memory::Internal::PoolAllocator::Page;
 using Header = Memory::Internal::PoolAllocator::Header;
 
-#define SAILOR_SMALLEST_DATA_SIZE (255ull + sizeof(Header))
+#define SAILOR_SMALLEST_DATA_SIZE ((size_t)255 + sizeof(Header))
 
 #define ShiftPtr(ptr, numBytes) (void*)((intptr_t)ptr + numBytes)
 #define Offset(to, from) ((int64_t)to - (int64_t)from)
@@ -29,6 +31,7 @@ bool PoolAllocator::RequestPage(Page& page, size_t size, size_t pageIndex) const
 	page.m_firstFree = 0;
 	page.m_first = 0;
 	page.m_bIsInFreeList = true;
+	page.m_bTrimCandidate = false;
 
 	SAILOR_PROFILE_ALLOC(page.m_pData, size);
 
@@ -61,7 +64,7 @@ void Page::Clear()
 
 size_t PoolAllocator::Page::GetMinAllowedEmptySpace() const
 {
-	return std::min(2048ull, std::max((size_t)(m_totalSize * 0.05f), SAILOR_SMALLEST_DATA_SIZE * 2ull));
+	return std::min((size_t)2048, std::max((size_t)(m_totalSize * 0.05f), SAILOR_SMALLEST_DATA_SIZE * (size_t)2));
 }
 
 Header* Page::MoveHeader(Header* block, int64_t shift)
@@ -170,9 +173,12 @@ void* Page::Allocate(size_t size, size_t alignment)
 			{
 				freeBlock = MoveHeader(freeBlock, freeSpaceLeft);
 
-				//we never shift the first block
-				check(pPrev);
-				m_occupiedSpace += pPrev->m_bIsFree ? -freeSpaceLeft : freeSpaceLeft;
+				// The padding is merged into the free block on the left,
+				// otherwise it's occupied until the block is freed
+				if (!pPrev || !pPrev->m_bIsFree)
+				{
+					m_occupiedSpace += freeSpaceLeft;
+				}
 			}
 
 			const size_t freeSpaceRight = freeBlock->m_size - size;
@@ -239,6 +245,7 @@ void* Page::Allocate(size_t size, size_t alignment)
 			freeBlock->m_bIsFree = 0;
 
 			m_occupiedSpace += freeBlock->m_size;
+			m_bTrimCandidate = false;
 
 			return pNewStartData;
 		}
@@ -261,6 +268,12 @@ void Page::Free(void* pData)
 
 	check(!block->m_bIsFree);
 
+	// The first block was shifted for the alignment, move it back to return the padding with the block
+	if (!pPrev && Offset(block, m_pData) > 0)
+	{
+		block = MoveHeader(block, -Offset(block, m_pData));
+	}
+
 	const bool bShouldMergeRight = pNext && pNext->m_bIsFree;
 	const bool bShouldMergeLeft = pPrev && pPrev->m_bIsFree;
 
@@ -414,9 +427,8 @@ void* PoolAllocator::Allocate(size_t size, size_t alignment)
 	}
 
 	const size_t quadraticGrow = (size_t)pow(2.0, (double)m_pages.Num());
-	const size_t neededPlace = size + sizeof(Header);
-	const size_t maxBlockSize = 1024ull * 1024ull * 1024ull * 1u;
-	const size_t newPageSize = std::max(neededPlace, std::min(maxBlockSize, quadraticGrow * m_pageSize));
+	const size_t neededPlace = size + sizeof(Header) + alignment;
+	const size_t newPageSize = std::max(neededPlace, std::min(MaxPageSize, quadraticGrow * m_pageSize));
 
 	size_t index = m_pages.Num();
 
@@ -440,8 +452,10 @@ void* PoolAllocator::Allocate(size_t size, size_t alignment)
 		m_pages.Emplace(std::move(newPage));
 	}
 
-	// If we are out of maxBlockSize then we have one block per allocation
-	if (newPageSize <= maxBlockSize)
+	m_reservedSpace += newPageSize;
+
+	// If we are out of MaxPageSize then we have one block per allocation
+	if (newPageSize <= MaxPageSize)
 	{
 		m_freeList.Add(index);
 	}
@@ -454,28 +468,77 @@ void PoolAllocator::Free(void* ptr)
 	const int32_t headerSize = sizeof(Header);
 	Header* block = static_cast<Header*>(ShiftPtr(ptr, -headerSize));
 
-	Page& page = m_pages[block->m_pageIndex];
+	// The header could be moved while the block is freed
+	const size_t pageIndex = block->m_pageIndex;
+	Page& page = m_pages[pageIndex];
 
 	page.Free(ptr);
 
 	if (!page.m_bIsInFreeList && (page.m_totalSize - page.m_occupiedSpace) > page.GetMinAllowedEmptySpace())
 	{
-		m_freeList.Add(block->m_pageIndex);
+		m_freeList.Add(pageIndex);
 		page.m_bIsInFreeList = true;
 	}
 
 #ifndef SAILOR_MEMORY_HEAP_DISABLE_FREE
-	if (page.IsEmpty() && m_freeList.Num() > 1)
+	// Dedicated pages are released immediately, the rest empty pages are handled by Trim
+	if (page.IsEmpty() && page.m_totalSize > MaxPageSize)
 	{
-		m_emptyPages.Add(block->m_pageIndex);
+		ReleasePage(pageIndex);
+	}
+#endif
+}
 
-		auto it = std::find(m_freeList.begin(), m_freeList.end(), block->m_pageIndex);
+void PoolAllocator::ReleasePage(size_t pageIndex)
+{
+	Page& page = m_pages[pageIndex];
 
-		std::iter_swap(m_freeList.end() - 1, it);
-		m_freeList.RemoveLast();
-		page.Clear();
+	if (page.m_bIsInFreeList)
+	{
+		auto it = std::find(m_freeList.begin(), m_freeList.end(), pageIndex);
+		if (it != m_freeList.end())
+		{
+			std::iter_swap(m_freeList.end() - 1, it);
+			m_freeList.RemoveLast();
+		}
+	}
+
+	m_reservedSpace -= page.m_totalSize;
+	m_emptyPages.Add(pageIndex);
+
+	page.Clear();
+	page.m_bIsInFreeList = false;
+	page.m_bTrimCandidate = false;
+}
+
+size_t PoolAllocator::Trim(size_t bytesToRelease, bool bIgnoreHysteresis)
+{
+	size_t releasedBytes = 0;
+
+#ifndef SAILOR_MEMORY_HEAP_DISABLE_FREE
+	for (size_t i = 0; i < m_pages.Num(); i++)
+	{
+		Page& page = m_pages[i];
+
+		if (!page.m_pData || !page.IsEmpty())
+		{
+			continue;
+		}
+
+		if ((bIgnoreHysteresis || page.m_bTrimCandidate) && releasedBytes < bytesToRelease)
+		{
+			releasedBytes += page.m_totalSize;
+			ReleasePage(i);
+		}
+		else
+		{
+			// Release the page next time if it is still empty
+			page.m_bTrimCandidate = true;
+		}
 	}
 #endif
+
+	return releasedBytes;
 }
 
 PoolAllocator::~PoolAllocator()
@@ -531,6 +594,7 @@ void* SmallPoolAllocator::SmallPage::Allocate()
 	header->m_size = m_blockSize;
 
 	m_numAllocs++;
+	m_bTrimCandidate = false;
 
 	return ShiftPtr(m_pData, id * m_blockSize);
 }
@@ -612,6 +676,8 @@ void* SmallPoolAllocator::Allocate()
 		m_pages.Emplace(std::move(newPage));
 	}
 
+	m_reservedSpace += SmallPage::m_size;
+
 	m_freeList.Add(index);
 	return m_pages[index].Allocate();
 }
@@ -622,7 +688,6 @@ void SmallPoolAllocator::Free(void* ptr)
 	SmallHeader* block = (SmallHeader*)ShiftPtr(ptr, -headerSize);
 
 	SmallPage& page = m_pages[block->m_pageIndex];
-	const uint16_t blockIndex = block->m_pageIndex;
 
 	page.Free(ptr);
 
@@ -633,20 +698,58 @@ void SmallPoolAllocator::Free(void* ptr)
 		m_freeList.Add(block->m_pageIndex);
 		page.m_bIsInFreeList = true;
 	}
+}
+
+void SmallPoolAllocator::ReleasePage(uint16_t pageIndex)
+{
+	SmallPage& page = m_pages[pageIndex];
+
+	if (page.m_bIsInFreeList)
+	{
+		auto it = std::find(m_freeList.begin(), m_freeList.end(), pageIndex);
+		if (it != m_freeList.end())
+		{
+			std::iter_swap(m_freeList.end() - 1, it);
+			m_freeList.RemoveLast();
+		}
+	}
+
+	m_reservedSpace -= SmallPage::m_size;
+	m_emptyPages.Add(pageIndex);
+
+	page.Clear();
+	page.m_freeList.Clear();
+	page.m_bIsInFreeList = false;
+	page.m_bTrimCandidate = false;
+}
+
+size_t SmallPoolAllocator::Trim(size_t bytesToRelease, bool bIgnoreHysteresis)
+{
+	size_t releasedBytes = 0;
 
 #ifndef SAILOR_MEMORY_HEAP_DISABLE_FREE
-	if (page.IsEmpty() && m_freeList.Num() > 1)
+	for (uint16_t i = 0; i < (uint16_t)m_pages.Num(); i++)
 	{
-		m_emptyPages.Add(blockIndex);
+		SmallPage& page = m_pages[i];
 
-		auto it = std::find(m_freeList.begin(), m_freeList.end(), blockIndex);
-		std::iter_swap(m_freeList.end() - 1, it);
-		m_freeList.RemoveLast();
+		if (!page.m_pData || !page.IsEmpty())
+		{
+			continue;
+		}
 
-		page.Clear();
+		if ((bIgnoreHysteresis || page.m_bTrimCandidate) && releasedBytes < bytesToRelease)
+		{
+			releasedBytes += SmallPage::m_size;
+			ReleasePage(i);
+		}
+		else
+		{
+			page.m_bTrimCandidate = true;
+		}
 	}
 #endif
 
+	return releasedBytes;
 }
 
 SmallPoolAllocator::~SmallPoolAllocator()
@@ -677,7 +780,8 @@ HeapAllocator::HeapAllocator()
 void* HeapAllocator::Allocate(size_t size, size_t alignment)
 {
 	size_t alignedSize = CalculateAlignedSize(size);
-	bool bSmallAllocator = alignedSize < 256 && size < 256;
+	// The small pools keep only 8 bytes alignment
+	bool bSmallAllocator = alignedSize < 256 && size < 256 && alignment <= 8;
 
 	void* res = nullptr;
 	if (bSmallAllocator)
@@ -759,6 +863,48 @@ void HeapAllocator::Free(void* ptr)
 	}
 }
 
+size_t HeapAllocator::GetReservedSpace() const
+{
+	size_t res = m_allocator.GetReservedSpace();
+
+	for (const auto& smallAllocator : m_smallAllocators)
+	{
+		if (smallAllocator)
+		{
+			res += smallAllocator->GetReservedSpace();
+		}
+	}
+
+	return res;
+}
+
+size_t HeapAllocator::Trim(size_t targetBytes)
+{
+	const size_t reservedSpace = GetReservedSpace();
+	return Trim_Internal(reservedSpace > targetBytes ? reservedSpace - targetBytes : 0, false);
+}
+
+size_t HeapAllocator::ReleaseUnused()
+{
+	return Trim_Internal(std::numeric_limits<size_t>::max(), true);
+}
+
+size_t HeapAllocator::Trim_Internal(size_t bytesToRelease, bool bIgnoreHysteresis)
+{
+	// We release the large pages first, the small pages are cheap to reacquire
+	size_t releasedBytes = m_allocator.Trim(bytesToRelease, bIgnoreHysteresis);
+
+	for (auto& smallAllocator : m_smallAllocators)
+	{
+		if (smallAllocator)
+		{
+			releasedBytes += smallAllocator->Trim(bytesToRelease > releasedBytes ? bytesToRelease - releasedBytes : 0, bIgnoreHysteresis);
+		}
+	}
+
+	return releasedBytes;
+}
+
 size_t HeapAllocator::CalculateAlignedSize(size_t blockSize) const
 {
 	const size_t alignment = 8;
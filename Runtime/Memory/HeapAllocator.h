@@ -41,6 +41,9 @@ namespace Sailor::Memory
 				size_t m_first = InvalidIndexUINT64;
 				bool m_bIsInFreeList = true;
 
+				// The page was found empty by the previous Trim pass
+				bool m_bTrimCandidate = false;
+
 				bool IsEmpty() const { return m_occupiedSpace == sizeof(Header); }
 				inline Header* MoveHeader(Header* block, int64_t shift);
 
@@ -53,21 +56,33 @@ namespace Sailor::Memory
 				size_t GetMinAllowedEmptySpace() const;
 			};
 
+			// Pages larger than that are dedicated to the single allocation
+			static constexpr size_t MaxPageSize = 1024ull * 1024ull * 1024ull * 1u;
+
 			void* Allocate(size_t size, size_t alignment);
 			bool TryAddMoreSpace(void* ptr, size_t newSize);
 			void Free(void* ptr);
 
+			// Releases the empty pages that stayed empty since the previous Trim call,
+			// returns the num of released bytes
+			size_t Trim(size_t bytesToRelease, bool bIgnoreHysteresis = false);
+
 			size_t GetOccupiedSpace() const
 			{
 				return 0;
 			}
+
+			size_t GetReservedSpace() const { return m_reservedSpace; }
+
 			~PoolAllocator();
 
 		private:
 
 			bool RequestPage(Page& page, size_t size, size_t pageIndex) const;
+			void ReleasePage(size_t pageIndex);
 
 			const size_t m_pageSize = 2048;
+			size_t m_reservedSpace = 0;
 		
 			Sailor::TVector<Page, Memory::MallocAllocator> m_pages;
 			Sailor::TVector<size_t, Memory::MallocAllocator> m_freeList;
@@ -100,6 +115,7 @@ namespace Sailor::Memory
 				void* m_pData = nullptr;
 				uint8_t m_blockSize = 0;
 				bool m_bIsInFreeList = true;
+				bool m_bTrimCandidate = false;
 				TVector<uint16_t, Sailor::Memory::MallocAllocator> m_freeList;
 
 				void* Allocate();
@@ -121,9 +137,15 @@ namespace Sailor::Memory
 			void* Allocate();
 			void Free(void* ptr);
 
+			size_t Trim(size_t bytesToRelease, bool bIgnoreHysteresis = false);
+			size_t GetReservedSpace() const { return m_reservedSpace; }
+
 		private:
 
+			void ReleasePage(uint16_t pageIndex);
+
 			uint8_t m_blockSize = 0;
+			size_t m_reservedSpace = 0;
 			TVector<SmallPage, Memory::MallocAllocator> m_pages;
 			TVector<uint16_t, Memory::MallocAllocator> m_freeList;
 			TVector<uint16_t, Memory::MallocAllocator> m_emptyPages;
@@ -142,8 +164,20 @@ namespace Sailor::Memory
 		bool Reallocate(void* ptr, size_t size, size_t alignment = 8);
 		void Free(void* ptr);
 
+		// Empty pages are not released on Free to prevent the page thrashing.
+		// Trim returns them to the system if they stayed empty since the previous Trim call,
+		// until the reserved space reaches targetBytes.
+		size_t Trim(size_t targetBytes = 0);
+
+		// Releases all empty pages immediately, i.e. after world unload
+		size_t ReleaseUnused();
+
+		size_t GetReservedSpace() const;
+
 	private:
 
+		size_t Trim_Internal(size_t bytesToRelease, bool bIgnoreHysteresis);
+
 		inline size_t CalculateAlignedSize(size_t blockSize) const;
 		TVector<TUniquePtr<Internal::SmallPoolAllocator>, Memory::MallocAllocator> m_smallAllocators;
 		Internal::PoolAllocator m_allocator;
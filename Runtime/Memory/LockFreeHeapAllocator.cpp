@@ -1,6 +1,14 @@
 #include "LockFreeHeapAllocator.h"
-#include <windows.h>
+#include <cstdint>
 #include <mutex>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 
 #include "Memory/UniquePtr.hpp"
 #include "Containers/ConcurrentMap.h"
@@ -9,12 +17,42 @@
 using namespace Sailor;
 using namespace Sailor::Memory;
 
+// The heaps are owned by the OS threads, the ids of the finished threads are reused by the new ones as well as their heaps
+using ThreadId = uint32_t;
+
+static ThreadId GetOwnerThreadId()
+{
+#ifdef _WIN32
+	return (ThreadId)GetCurrentThreadId();
+#else
+	thread_local const ThreadId t_threadId = (ThreadId)syscall(SYS_gettid);
+	return t_threadId;
+#endif
+}
+
+// The header is placed right before the block, so the block keeps the requested alignment
+struct BlockHeader
+{
+	uint32_t m_offset = 0;
+	ThreadId m_threadId = 0;
+};
+
+static __forceinline size_t GetHeaderOffset(size_t alignment)
+{
+	return std::max(alignment, sizeof(BlockHeader));
+}
+
+static __forceinline BlockHeader* GetHeader(void* ptr)
+{
+	return ((BlockHeader*)ptr) - 1;
+}
+
 // For now TConcurrentMap doesn't have dll interface, so cannot 
 // handle that in class
-std::unique_ptr<TConcurrentMap<DWORD, TUniquePtr<HeapAllocator>, 8, ERehashPolicy::Never, Memory::MallocAllocator>>& GetAllocator()
+std::unique_ptr<TConcurrentMap<ThreadId, TUniquePtr<HeapAllocator>, 8, ERehashPolicy::Never, Memory::MallocAllocator>>& GetAllocator()
 {
-	static std::unique_ptr<TConcurrentMap<DWORD, TUniquePtr<HeapAllocator>, 8, ERehashPolicy::Never, Memory::MallocAllocator>> g_lockFreeAllocators =
-		std::make_unique<TConcurrentMap<DWORD, TUniquePtr<HeapAllocator>, 8, ERehashPolicy::Never, Memory::MallocAllocator>>();
+	static std::unique_ptr<TConcurrentMap<ThreadId, TUniquePtr<HeapAllocator>, 8, ERehashPolicy::Never, Memory::MallocAllocator>> g_lockFreeAllocators =
+		std::make_unique<TConcurrentMap<ThreadId, TUniquePtr<HeapAllocator>, 8, ERehashPolicy::Never, Memory::MallocAllocator>>();
 
 	return g_lockFreeAllocators;
 }
@@ -22,7 +60,7 @@ std::unique_ptr<TConcurrentMap<DWORD, TUniquePtr<HeapAllocator>, 8, ERehashPolic
 void* LockFreeHeapAllocator::allocate(size_t size, size_t alignment)
 {
 	auto& allocator = GetAllocator();
-	const DWORD currentThreadId = GetCurrentThreadId();
+	const ThreadId currentThreadId = GetOwnerThreadId();
 	void* res = nullptr;
 
 	check(currentThreadId < 100000000);
@@ -34,8 +72,8 @@ void* LockFreeHeapAllocator::allocate(size_t size, size_t alignment)
 		pAllocator = TUniquePtr<HeapAllocator>::Make();
 	}
 
-	res = pAllocator->Allocate(size + sizeof(DWORD), alignment);
-	((DWORD*)res)[0] = currentThreadId;
+	const size_t offset = GetHeaderOffset(alignment);
+	res = pAllocator->Allocate(size + offset, alignment);
 	allocator->Unlock(currentThreadId);
 
 	if (!res)
@@ -43,19 +81,23 @@ void* LockFreeHeapAllocator::allocate(size_t size, size_t alignment)
 		return nullptr;
 	}
 
-	return &((DWORD*)res)[1];
+	res = (uint8_t*)res + offset;
+	GetHeader(res)->m_offset = (uint32_t)offset;
+	GetHeader(res)->m_threadId = currentThreadId;
+
+	return res;
 }
 
 bool LockFreeHeapAllocator::reallocate(void* ptr, size_t size, size_t alignment)
 {
 	auto& allocator = GetAllocator();
-	void* pRaw = (((DWORD*)ptr) - 1);
-	const DWORD allocatedThreadId = *(DWORD*)pRaw;
+	const BlockHeader header = *GetHeader(ptr);
+	void* pRaw = (uint8_t*)ptr - header.m_offset;
 
-	bool res = allocator->At_Lock(allocatedThreadId)->Reallocate(pRaw, size + sizeof(DWORD), alignment);
-	allocator->Unlock(allocatedThreadId);
+	bool res = allocator->At_Lock(header.m_threadId)->Reallocate(pRaw, size + header.m_offset, alignment);
+	allocator->Unlock(header.m_threadId);
 
-	check(((DWORD*)pRaw)[0] == allocatedThreadId);
+	check(GetHeader(ptr)->m_threadId == header.m_threadId);
 
 	return res;
 }
@@ -65,11 +107,96 @@ void LockFreeHeapAllocator::free(void* ptr, size_t size)
 	if (ptr != nullptr)
 	{
 		auto& allocator = GetAllocator();
-		void* pRaw = (((DWORD*)ptr) - 1);
-		const DWORD allocatedThreadId = *((DWORD*)pRaw);
+		const BlockHeader header = *GetHeader(ptr);
+		void* pRaw = (uint8_t*)ptr - header.m_offset;
+
+		check(allocator->ContainsKey(header.m_threadId));
+		allocator->At_Lock(header.m_threadId)->Free(pRaw);
+		allocator->Unlock(header.m_threadId);
+	}
+}
+
+
+// We cannot allocate with LockFreeHeapAllocator while the allocators are locked
+static TVector<ThreadId, Memory::MallocAllocator> GetAllocatorThreadIds()
+{
+	auto& allocator = GetAllocator();
+	TVector<ThreadId, Memory::MallocAllocator> threadIds;
+
+	allocator->LockAll();
+	for (const auto& pair : *allocator)
+	{
+		threadIds.Add(pair.First());
+	}
+	allocator->UnlockAll();
 
-		check(allocator->ContainsKey(allocatedThreadId));
-		allocator->At_Lock(allocatedThreadId)->Free(pRaw);
-		allocator->Unlock(allocatedThreadId);
+	return threadIds;
+}
+
+size_t LockFreeHeapAllocator::GetReservedSpace()
+{
+	auto& allocator = GetAllocator();
+	size_t res = 0;
+
+	for (const auto& threadId : GetAllocatorThreadIds())
+	{
+		auto& pAllocator = allocator->At_Lock(threadId);
+		if (pAllocator)
+		{
+			res += pAllocator->GetReservedSpace();
+		}
+		allocator->Unlock(threadId);
 	}
+
+	return res;
+}
+
+size_t LockFreeHeapAllocator::Trim(size_t targetBytes)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	auto& allocator = GetAllocator();
+	const auto threadIds = GetAllocatorThreadIds();
+
+	const size_t reservedSpace = GetReservedSpace();
+	size_t bytesToRelease = reservedSpace > targetBytes ? reservedSpace - targetBytes : 0;
+	size_t releasedBytes = 0;
+
+	// We have to visit all heaps even if there is nothing to release, to mark the empty pages
+	for (const auto& threadId : threadIds)
+	{
+		auto& pAllocator = allocator->At_Lock(threadId);
+		if (pAllocator)
+		{
+			const size_t threadReservedSpace = pAllocator->GetReservedSpace();
+			const size_t threadTarget = threadReservedSpace > bytesToRelease ? threadReservedSpace - bytesToRelease : 0;
+			const size_t threadReleasedBytes = pAllocator->Trim(threadTarget);
+
+			bytesToRelease -= std::min(bytesToRelease, threadReleasedBytes);
+			releasedBytes += threadReleasedBytes;
+		}
+		allocator->Unlock(threadId);
+	}
+
+	return releasedBytes;
+}
+
+size_t LockFreeHeapAllocator::ReleaseUnused()
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	auto& allocator = GetAllocator();
+	size_t releasedBytes = 0;
+
+	for (const auto& threadId : GetAllocatorThreadIds())
+	{
+		auto& pAllocator = allocator->At_Lock(threadId);
+		if (pAllocator)
+		{
+			releasedBytes += pAllocator->ReleaseUnused();
+		}
+		allocator->Unlock(threadId);
+	}
+
+	return releasedBytes;
 }
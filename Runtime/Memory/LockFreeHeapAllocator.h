@@ -19,6 +19,15 @@ namespace Sailor::Memory
 		static bool reallocate(void* ptr, size_t size, size_t alignment = 8);
 		static void free(void* ptr, size_t size = 0);
 
+		// Trim per thread heaps until the total reserved space reaches targetBytes,
+		// only the pages that stayed empty since the previous call are released
+		static size_t Trim(size_t targetBytes = 0);
+
+		// Release all empty pages of all per thread heaps
+		static size_t ReleaseUnused();
+
+		static size_t GetReservedSpace();
+
 	protected:
 	};
 }
\ No newline at end of file
@@ -44,5 +44,10 @@ namespace Sailor::Memory
 			SAILOR_PROFILE_FREE(ptr);
 			std::free(ptr);
 		}
+
+		// CRT manages the heap by itself
+		static size_t Trim(size_t targetBytes = 0) { return 0; }
+		static size_t ReleaseUnused() { return 0; }
+		static size_t GetReservedSpace() { return 0; }
 	};
 }
\ No newline at end of file
@@ -117,6 +117,9 @@ namespace Sailor::Memory
 	template<typename TGlobalAllocator = Sailor::Memory::DefaultGlobalAllocator, typename TPtr = void*>
 	class TMultiPoolAllocator;
 
+	template<typename TGlobalAllocator = Sailor::Memory::DefaultGlobalAllocator, typename TPtr = void*>
+	class TTlsfAllocator;
+
 	template<typename TPtr = void*>
 	class TMemoryPtr;
 
@@ -180,4 +183,7 @@ namespace Sailor::Memory
 	}
 
 	void SAILOR_API RunMemoryBenchmark();
+
+	// Compares the device memory sub-allocators on CPU
+	void SAILOR_API RunSubAllocatorBenchmark();
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 ﻿#pragma once
 #include "Memory.h"
 #include <algorithm>
+#include <functional>
 #include "Core/SpinLock.h"
+#include "Containers/Pair.h"
 
 namespace Sailor::Memory
 {
@@ -10,10 +12,23 @@ namespace Sailor::Memory
 	{
 	public:
 
+		// Called for each planned move, the owner should copy the data and rebind the resources to dst.
+		// Returns false if the allocation cannot be moved at the moment.
+		using MoveCallback = std::function<bool(const TMemoryPtr<TPtr>& src, const TMemoryPtr<TPtr>& dst)>;
+
 		class MemoryBlock
 		{
 		public:
 
+			// The live allocation, that is tracked to be moved by defragmentation
+			struct Allocation
+			{
+				size_t m_offset = 0;
+				size_t m_alignmentOffset = 0;
+				size_t m_size = 0;
+				size_t m_alignment = 1;
+			};
+
 			MemoryBlock(size_t size, TBlockAllocator* owner) :
 				m_blockSize(size),
 				m_emptySpace(size),
@@ -52,12 +67,16 @@ namespace Sailor::Memory
 					m_blockIndex = memoryBlock.m_blockIndex;
 					m_owner = memoryBlock.m_owner;
 					m_layout = std::move(memoryBlock.m_layout);
+					m_allocations = std::move(memoryBlock.m_allocations);
+					m_freedOffsets = std::move(memoryBlock.m_freedOffsets);
 
 					memoryBlock.m_owner = nullptr;
 					memoryBlock.m_blockIndex = InvalidIndexUINT32;
 					memoryBlock.m_emptySpace = 0;
 					memoryBlock.m_blockSize = 0;
 					memoryBlock.m_layout.Clear();
+					memoryBlock.m_allocations.Clear();
+					memoryBlock.m_freedOffsets.Clear();
 				}
 
 				return *this;
@@ -71,15 +90,19 @@ namespace Sailor::Memory
 				m_blockIndex = memoryBlock.m_blockIndex;
 				m_owner = memoryBlock.m_owner;
 				m_layout = std::move(memoryBlock.m_layout);
+				m_allocations = std::move(memoryBlock.m_allocations);
+				m_freedOffsets = std::move(memoryBlock.m_freedOffsets);
 
 				memoryBlock.m_owner = nullptr;
 				memoryBlock.m_blockIndex = InvalidIndexUINT32;
 				memoryBlock.m_emptySpace = 0;
 				memoryBlock.m_blockSize = 0;
 				memoryBlock.m_layout.Clear();
+				memoryBlock.m_allocations.Clear();
+				memoryBlock.m_freedOffsets.Clear();
 			}
 
-			TMemoryPtr<TPtr> Allocate(uint32_t layoutIndex, size_t size, uint32_t alignmentOffset)
+			TMemoryPtr<TPtr> Allocate(uint32_t layoutIndex, size_t size, uint32_t alignmentOffset, size_t alignment)
 			{
 				check(layoutIndex != InvalidIndexUINT32);
 
@@ -99,6 +122,9 @@ namespace Sailor::Memory
 				}
 
 				m_emptySpace -= (size + alignmentOffset);
+
+				m_allocations.Add(Allocation{ offset, alignmentOffset, size, alignment });
+
 				return TMemoryPtr<TPtr>(offset, alignmentOffset, size, m_ptr.m_ptr, m_blockIndex);
 			}
 
@@ -109,6 +135,13 @@ namespace Sailor::Memory
 					return;
 				}
 
+				// The log is compacted once the released offsets take a half of it, so the cost is amortized
+				m_freedOffsets.Add(ptr.m_offset);
+				if (m_freedOffsets.Num() > MinFreedOffsetsToCompact && m_freedOffsets.Num() * 2 > m_allocations.Num())
+				{
+					CompactAllocations();
+				}
+
 				m_emptySpace += ptr.m_size + ptr.m_alignmentOffset;
 
 				auto lower = std::lower_bound(m_layout.begin(), m_layout.end(), TPair(ptr.m_offset, ptr.m_size + ptr.m_alignmentOffset), [](auto& lhs, auto& rhs) { return lhs.m_first < rhs.m_first; });
@@ -175,6 +208,57 @@ namespace Sailor::Memory
 				return false;
 			}
 
+			// Leaves only the live allocations sorted by offset
+			void CompactAllocations()
+			{
+				// The sort is stable, so the latest allocation at the reused offset goes last
+				m_allocations.Sort([](const Allocation& lhs, const Allocation& rhs) { return lhs.m_offset < rhs.m_offset; });
+
+				if (m_freedOffsets.Num() == 0)
+				{
+					return;
+				}
+
+				m_freedOffsets.Sort();
+
+				size_t numLive = 0;
+				size_t freed = 0;
+				for (size_t first = 0; first < m_allocations.Num();)
+				{
+					const size_t offset = m_allocations[first].m_offset;
+
+					size_t last = first;
+					while (last < m_allocations.Num() && m_allocations[last].m_offset == offset)
+					{
+						last++;
+					}
+
+					while (freed < m_freedOffsets.Num() && m_freedOffsets[freed] < offset)
+					{
+						freed++;
+					}
+
+					size_t numFreed = 0;
+					while (freed < m_freedOffsets.Num() && m_freedOffsets[freed] == offset)
+					{
+						numFreed++;
+						freed++;
+					}
+
+					check(numFreed <= last - first);
+
+					for (size_t i = first + numFreed; i < last; i++)
+					{
+						m_allocations[numLive++] = m_allocations[i];
+					}
+
+					first = last;
+				}
+
+				m_allocations.Resize(numLive);
+				m_freedOffsets.Clear(false);
+			}
+
 			uint32_t GetBlockIndex() const { return m_blockIndex; }
 			size_t GetBlockSize() const { return m_blockSize; }
 			float GetOccupation() const { return 1.0f - (float)m_emptySpace / m_blockSize; }
@@ -188,11 +272,15 @@ namespace Sailor::Memory
 				m_blockSize = 0;
 				m_emptySpace = 0;
 				m_layout.Clear();
+				m_allocations.Clear();
+				m_freedOffsets.Clear();
 				m_blockIndex = InvalidIndexUINT32;
 			}
 
 		private:
 
+			static constexpr size_t MinFreedOffsetsToCompact = 64;
+
 			TMemoryPtr<TPtr> m_ptr;
 			size_t m_blockSize;
 			size_t m_emptySpace;
@@ -201,6 +289,10 @@ namespace Sailor::Memory
 
 			TVector<TPair<size_t, size_t>> m_layout;
 
+			// The log of the allocations and the released offsets, the live allocations are resolved lazily
+			TVector<Allocation> m_allocations;
+			TVector<size_t> m_freedOffsets;
+
 			friend class TBlockAllocator;
 		};
 
@@ -233,7 +325,7 @@ namespace Sailor::Memory
 
 			const auto blockIndex = m_layout[layoutIndex];
 			auto& block = m_blocks[blockIndex];
-			auto res = block.Allocate(blockLayoutIndex, size, alignmentOffset);
+			auto res = block.Allocate(blockLayoutIndex, size, alignmentOffset, alignment);
 
 			if (HeuristicToSkipBlocks(block.GetOccupation()))
 			{
@@ -271,6 +363,38 @@ namespace Sailor::Memory
 			m_lock.Unlock();
 		}
 
+		// Incremental defragmentation: moves the allocations from the sparse blocks to the denser ones,
+		// no more than bytesBudget per call, so it could be called each frame.
+		// The moves are planned under the lock and onMove is called without it, so the callback can allocate.
+		// The source allocation is released by the allocator after the successful move, the owner should not release it.
+		// Returns the amount of moved bytes.
+		// VulkanDevice doesn't call it yet: the buffers and images are bound to the memory once,
+		// so the move needs the owner to recreate the resource, copy it on GPU and update the descriptors that reference it.
+		size_t Defragment(size_t bytesBudget, const MoveCallback& onMove)
+		{
+			TVector<TPair<TMemoryPtr<TPtr>, TMemoryPtr<TPtr>>> moves;
+
+			m_lock.Lock();
+			PlanDefragmentation(bytesBudget, moves);
+			m_lock.Unlock();
+
+			size_t movedBytes = 0;
+			for (auto& move : moves)
+			{
+				if (onMove(move.m_first, move.m_second))
+				{
+					movedBytes += move.m_first.m_size;
+					Free(move.m_first);
+				}
+				else
+				{
+					Free(move.m_second);
+				}
+			}
+
+			return movedBytes;
+		}
+
 		virtual ~TBlockAllocator()
 		{
 			m_lock.Lock();
@@ -292,6 +416,94 @@ namespace Sailor::Memory
 		SpinLock m_lock;
 		static constexpr uint32_t InvalidIndexUINT32 = (uint32_t)-1;
 
+		// The denser blocks are not worth to be evacuated
+		static constexpr float DefragmentationOccupationThreshold = 0.5f;
+
+		void PlanDefragmentation(size_t bytesBudget, TVector<TPair<TMemoryPtr<TPtr>, TMemoryPtr<TPtr>>>& outMoves)
+		{
+			TVector<uint32_t> blocks;
+			for (uint32_t i = 0; i < (uint32_t)m_blocks.Num(); i++)
+			{
+				if (m_blocks[i].m_blockIndex != InvalidIndexUINT32 && !m_blocks[i].IsEmpty())
+				{
+					blocks.Add(i);
+				}
+			}
+
+			if (blocks.Num() < 2)
+			{
+				return;
+			}
+
+			// The sparsest blocks go first
+			blocks.Sort([this](const uint32_t& lhs, const uint32_t& rhs) { return m_blocks[lhs].GetOccupation() < m_blocks[rhs].GetOccupation(); });
+
+			// The blocks that received the allocations should not be evacuated during the same pass
+			TVector<uint32_t> destinations;
+			size_t plannedBytes = 0;
+
+			for (size_t src = 0; src < blocks.Num() - 1 && plannedBytes < bytesBudget; src++)
+			{
+				auto& srcBlock = m_blocks[blocks[src]];
+
+				if (srcBlock.GetOccupation() > DefragmentationOccupationThreshold)
+				{
+					break;
+				}
+
+				if (destinations.Contains(blocks[src]))
+				{
+					continue;
+				}
+
+				srcBlock.CompactAllocations();
+
+				for (int32_t i = (int32_t)srcBlock.m_allocations.Num() - 1; i >= 0; i--)
+				{
+					const auto allocation = srcBlock.m_allocations[i];
+
+					if (plannedBytes > 0 && plannedBytes + allocation.m_size > bytesBudget)
+					{
+						return;
+					}
+
+					// The densest blocks are filled first
+					for (size_t dst = blocks.Num() - 1; dst > src; dst--)
+					{
+						auto& dstBlock = m_blocks[blocks[dst]];
+
+						uint32_t layoutIndex;
+						uint32_t alignmentOffset;
+						if (!dstBlock.FindLocationInLayout(allocation.m_size, allocation.m_alignment, layoutIndex, alignmentOffset))
+						{
+							continue;
+						}
+
+						auto dstPtr = dstBlock.Allocate(layoutIndex, allocation.m_size, alignmentOffset, allocation.m_alignment);
+						auto srcPtr = TMemoryPtr<TPtr>(allocation.m_offset, allocation.m_alignmentOffset, allocation.m_size, srcBlock.m_ptr.m_ptr, srcBlock.m_blockIndex);
+
+						if (HeuristicToSkipBlocks(dstBlock.GetOccupation()))
+						{
+							const size_t layoutIndexToSkip = m_layout.Find(dstBlock.m_blockIndex);
+							if (layoutIndexToSkip != TVector<uint32_t>::InvalidIndex)
+							{
+								m_layout.RemoveAtSwap(layoutIndexToSkip);
+							}
+						}
+
+						if (!destinations.Contains(dstBlock.m_blockIndex))
+						{
+							destinations.Add(dstBlock.m_blockIndex);
+						}
+
+						outMoves.Add({ srcPtr, dstPtr });
+						plannedBytes += allocation.m_size;
+						break;
+					}
+				}
+			}
+		}
+
 		bool HeuristicToSkipBlocks(float occupation) const
 		{
 			const float border = 1.0f - (float)m_averageElementSize / m_blockSize;
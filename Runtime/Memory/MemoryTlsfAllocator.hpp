@@ -0,0 +1,408 @@
+#pragma once
+#include "Memory.h"
+#include <algorithm>
+#include <bit>
+#include "Core/SpinLock.h"
+
+namespace Sailor::Memory
+{
+	// Two-level segregated fit allocator, the drop-in replacement for TBlockAllocator.
+	// The free ranges of all blocks are stored in the segregated lists, so allocation and free are O(1).
+	// TMemoryPtr::m_blockIndex stores the index of the allocation's node.
+	template<typename TGlobalAllocator, typename TPtr>
+	class TTlsfAllocator : public IBaseAllocator
+	{
+	public:
+
+		// averageElementSize is not used, the argument is kept to be compatible with TBlockAllocator
+		TTlsfAllocator(size_t blockSize = 2 * 1024 * 1024, size_t averageElementSize = 2048, size_t reservedSize = 4 * 1024 * 1024) :
+			m_blockSize(blockSize),
+			m_reservedSize(reservedSize)
+		{
+			std::fill(&m_freeLists[0][0], &m_freeLists[0][0] + FirstLevelCount * SecondLevelCount, InvalidIndex);
+		}
+
+		TTlsfAllocator(const TTlsfAllocator&) = delete;
+		TTlsfAllocator& operator= (const TTlsfAllocator&) = delete;
+
+		template<typename TDataType>
+		TMemoryPtr<TPtr> Allocate(uint32_t count)
+		{
+			size_t size = count * sizeof(TDataType);
+			return Allocate(size, alignof(TDataType));
+		}
+
+		TMemoryPtr<TPtr> Allocate(size_t size, size_t alignment)
+		{
+			m_lock.Lock();
+
+			alignment = std::max(alignment, (size_t)1);
+			const size_t requestSize = std::max(size, MinNodeSize);
+
+			uint32_t nodeIndex = FindFreeNode(requestSize);
+			uint32_t alignmentOffset = 0;
+
+			// The head of the list could be unsuitable due to alignment, the bigger class is guaranteed to fit
+			if (nodeIndex == InvalidIndex || !Align(size, alignment, nodeIndex, alignmentOffset))
+			{
+				nodeIndex = FindFreeNode(requestSize + alignment - 1);
+			}
+
+			if (nodeIndex == InvalidIndex)
+			{
+				AddBlock(std::max(m_blockSize, requestSize + alignment - 1));
+				nodeIndex = FindFreeNode(requestSize + alignment - 1);
+			}
+
+			check(nodeIndex != InvalidIndex);
+
+			RemoveFreeNode(nodeIndex);
+			Align(size, alignment, nodeIndex, alignmentOffset);
+
+			// Return the alignment padding back if it is big enough
+			if (alignmentOffset >= MinNodeSize)
+			{
+				const uint32_t alignedIndex = SplitNode(nodeIndex, alignmentOffset);
+				InsertFreeNode(nodeIndex);
+
+				nodeIndex = alignedIndex;
+				alignmentOffset = 0;
+			}
+
+			const size_t usedSize = std::max(alignmentOffset + size, MinNodeSize);
+			if (m_nodes[nodeIndex].m_size - usedSize >= MinNodeSize)
+			{
+				const uint32_t tailIndex = SplitNode(nodeIndex, usedSize);
+				InsertFreeNode(tailIndex);
+			}
+
+			Node& node = m_nodes[nodeIndex];
+			node.m_bIsFree = false;
+
+			auto res = TMemoryPtr<TPtr>(node.m_offset, alignmentOffset, size, m_blocks[node.m_blockIndex].m_ptr.m_ptr, nodeIndex);
+
+			m_lock.Unlock();
+
+			return res;
+		}
+
+		void Free(TMemoryPtr<TPtr>& data)
+		{
+			m_lock.Lock();
+
+			if (data.m_ptr)
+			{
+				uint32_t nodeIndex = data.m_blockIndex;
+				check(nodeIndex < m_nodes.Num() && !m_nodes[nodeIndex].m_bIsFree);
+
+				m_nodes[nodeIndex].m_bIsFree = true;
+
+				const uint32_t prevIndex = m_nodes[nodeIndex].m_prevPhysical;
+				if (prevIndex != InvalidIndex && m_nodes[prevIndex].m_bIsFree)
+				{
+					RemoveFreeNode(prevIndex);
+					MergeWithNext(prevIndex);
+					nodeIndex = prevIndex;
+				}
+
+				const uint32_t nextIndex = m_nodes[nodeIndex].m_nextPhysical;
+				if (nextIndex != InvalidIndex && m_nodes[nextIndex].m_bIsFree)
+				{
+					RemoveFreeNode(nextIndex);
+					MergeWithNext(nodeIndex);
+				}
+
+				const Node& node = m_nodes[nodeIndex];
+				const size_t blockSize = m_blocks[node.m_blockIndex].m_size;
+				const bool bIsBlockEmpty = node.m_prevPhysical == InvalidIndex && node.m_nextPhysical == InvalidIndex;
+
+				if (bIsBlockEmpty && HeuristicToFreeBlock(blockSize))
+				{
+					FreeBlock(node.m_blockIndex, nodeIndex);
+				}
+				else
+				{
+					InsertFreeNode(nodeIndex);
+				}
+
+				data.Clear();
+			}
+
+			m_lock.Unlock();
+		}
+
+		virtual ~TTlsfAllocator()
+		{
+			m_lock.Lock();
+
+			for (auto& block : m_blocks)
+			{
+				if (block.m_ptr)
+				{
+					Sailor::Memory::Free<TMemoryPtr<TPtr>, TPtr, TGlobalAllocator>(block.m_ptr, &m_dataAllocator);
+				}
+			}
+
+			m_blocks.Clear();
+			m_nodes.Clear();
+
+			m_lock.Unlock();
+		}
+
+		size_t GetOccupiedSpace() const { return m_usedDataSpace; }
+
+		TGlobalAllocator& GetGlobalAllocator() { return m_dataAllocator; }
+
+	private:
+
+		static constexpr uint32_t InvalidIndex = (uint32_t)-1;
+
+		// The ranges smaller than that are not tracked and remain the part of allocation
+		static constexpr size_t MinNodeSize = 256;
+
+		static constexpr uint32_t SecondLevelLog2 = 4;
+		static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog2;
+		static constexpr uint32_t FirstLevelCount = 64;
+
+		static_assert(MinNodeSize >= SecondLevelCount, "The second level should split the smallest class");
+
+		struct Node
+		{
+			size_t m_offset = 0;
+			size_t m_size = 0;
+			uint32_t m_blockIndex = InvalidIndex;
+
+			uint32_t m_prevPhysical = InvalidIndex;
+			uint32_t m_nextPhysical = InvalidIndex;
+
+			uint32_t m_prevFree = InvalidIndex;
+			uint32_t m_nextFree = InvalidIndex;
+
+			bool m_bIsFree = false;
+		};
+
+		struct Block
+		{
+			TMemoryPtr<TPtr> m_ptr{};
+			size_t m_size = 0;
+		};
+
+		__forceinline static void Mapping(size_t size, uint32_t& outFirstLevel, uint32_t& outSecondLevel)
+		{
+			outFirstLevel = (uint32_t)std::bit_width(size) - 1;
+			outSecondLevel = (uint32_t)(size >> (outFirstLevel - SecondLevelLog2)) & (SecondLevelCount - 1);
+		}
+
+		bool HeuristicToFreeBlock(size_t blockSize) const
+		{
+			return m_usedDataSpace - blockSize > m_reservedSize;
+		}
+
+		bool Align(size_t size, size_t alignment, uint32_t nodeIndex, uint32_t& outAlignmentOffset)
+		{
+			const Node& node = m_nodes[nodeIndex];
+			return Memory::Align(size, alignment, Memory::Shift(*m_blocks[node.m_blockIndex].m_ptr, node.m_offset), node.m_size, outAlignmentOffset);
+		}
+
+		uint32_t FindFreeNode(size_t size) const
+		{
+			// Round up to the next class, so any node of the found list fits
+			const uint32_t firstLevel = (uint32_t)std::bit_width(size) - 1;
+			size += ((size_t)1 << (firstLevel - SecondLevelLog2)) - 1;
+
+			uint32_t fl, sl;
+			Mapping(size, fl, sl);
+
+			uint32_t slMap = m_secondLevelBitmaps[fl] & (~0u << sl);
+			if (!slMap)
+			{
+				const uint64_t flMap = fl + 1 < FirstLevelCount ? m_firstLevelBitmap & (~0ull << (fl + 1)) : 0;
+				if (!flMap)
+				{
+					return InvalidIndex;
+				}
+
+				fl = (uint32_t)std::countr_zero(flMap);
+				slMap = m_secondLevelBitmaps[fl];
+			}
+
+			sl = (uint32_t)std::countr_zero(slMap);
+			return m_freeLists[fl][sl];
+		}
+
+		void InsertFreeNode(uint32_t nodeIndex)
+		{
+			Node& node = m_nodes[nodeIndex];
+
+			uint32_t fl, sl;
+			Mapping(node.m_size, fl, sl);
+
+			const uint32_t head = m_freeLists[fl][sl];
+			node.m_bIsFree = true;
+			node.m_prevFree = InvalidIndex;
+			node.m_nextFree = head;
+
+			if (head != InvalidIndex)
+			{
+				m_nodes[head].m_prevFree = nodeIndex;
+			}
+
+			m_freeLists[fl][sl] = nodeIndex;
+			m_firstLevelBitmap |= 1ull << fl;
+			m_secondLevelBitmaps[fl] |= 1u << sl;
+		}
+
+		void RemoveFreeNode(uint32_t nodeIndex)
+		{
+			Node& node = m_nodes[nodeIndex];
+
+			uint32_t fl, sl;
+			Mapping(node.m_size, fl, sl);
+
+			if (node.m_prevFree != InvalidIndex)
+			{
+				m_nodes[node.m_prevFree].m_nextFree = node.m_nextFree;
+			}
+
+			if (node.m_nextFree != InvalidIndex)
+			{
+				m_nodes[node.m_nextFree].m_prevFree = node.m_prevFree;
+			}
+
+			if (m_freeLists[fl][sl] == nodeIndex)
+			{
+				m_freeLists[fl][sl] = node.m_nextFree;
+
+				if (m_freeLists[fl][sl] == InvalidIndex)
+				{
+					m_secondLevelBitmaps[fl] &= ~(1u << sl);
+					if (!m_secondLevelBitmaps[fl])
+					{
+						m_firstLevelBitmap &= ~(1ull << fl);
+					}
+				}
+			}
+
+			node.m_prevFree = InvalidIndex;
+			node.m_nextFree = InvalidIndex;
+			node.m_bIsFree = false;
+		}
+
+		uint32_t CreateNode()
+		{
+			if (m_emptyNodes.Num() > 0)
+			{
+				const uint32_t nodeIndex = m_emptyNodes[m_emptyNodes.Num() - 1];
+				m_emptyNodes.RemoveLast();
+				m_nodes[nodeIndex] = Node();
+				return nodeIndex;
+			}
+
+			m_nodes.Add(Node());
+			return (uint32_t)m_nodes.Num() - 1;
+		}
+
+		// Splits the node at offset, returns the right part
+		uint32_t SplitNode(uint32_t nodeIndex, size_t offset)
+		{
+			const uint32_t rightIndex = CreateNode();
+
+			Node& node = m_nodes[nodeIndex];
+			Node& right = m_nodes[rightIndex];
+
+			right.m_offset = node.m_offset + offset;
+			right.m_size = node.m_size - offset;
+			right.m_blockIndex = node.m_blockIndex;
+			right.m_prevPhysical = nodeIndex;
+			right.m_nextPhysical = node.m_nextPhysical;
+
+			if (node.m_nextPhysical != InvalidIndex)
+			{
+				m_nodes[node.m_nextPhysical].m_prevPhysical = rightIndex;
+			}
+
+			node.m_size = offset;
+			node.m_nextPhysical = rightIndex;
+
+			return rightIndex;
+		}
+
+		void MergeWithNext(uint32_t nodeIndex)
+		{
+			Node& node = m_nodes[nodeIndex];
+			const uint32_t nextIndex = node.m_nextPhysical;
+			Node& next = m_nodes[nextIndex];
+
+			node.m_size += next.m_size;
+			node.m_nextPhysical = next.m_nextPhysical;
+
+			if (next.m_nextPhysical != InvalidIndex)
+			{
+				m_nodes[next.m_nextPhysical].m_prevPhysical = nodeIndex;
+			}
+
+			m_emptyNodes.Add(nextIndex);
+		}
+
+		void AddBlock(size_t size)
+		{
+			uint32_t blockIndex = 0;
+
+			if (m_emptyBlocks.Num() == 0)
+			{
+				blockIndex = (uint32_t)m_blocks.Num();
+				m_blocks.Add(Block());
+			}
+			else
+			{
+				blockIndex = m_emptyBlocks[m_emptyBlocks.Num() - 1];
+				m_emptyBlocks.RemoveLast();
+			}
+
+			Block& block = m_blocks[blockIndex];
+			block.m_ptr = Sailor::Memory::Allocate<TMemoryPtr<TPtr>, TPtr, TGlobalAllocator>(size, &m_dataAllocator);
+			block.m_size = size;
+
+			const uint32_t nodeIndex = CreateNode();
+			Node& node = m_nodes[nodeIndex];
+			node.m_offset = 0;
+			node.m_size = size;
+			node.m_blockIndex = blockIndex;
+
+			InsertFreeNode(nodeIndex);
+
+			m_usedDataSpace += size;
+		}
+
+		void FreeBlock(uint32_t blockIndex, uint32_t nodeIndex)
+		{
+			Block& block = m_blocks[blockIndex];
+
+			m_usedDataSpace -= block.m_size;
+
+			Sailor::Memory::Free<TMemoryPtr<TPtr>, TPtr, TGlobalAllocator>(block.m_ptr, &m_dataAllocator);
+			block.m_size = 0;
+
+			m_emptyBlocks.Add(blockIndex);
+			m_emptyNodes.Add(nodeIndex);
+		}
+
+		SpinLock m_lock;
+
+		TGlobalAllocator m_dataAllocator;
+
+		size_t m_blockSize = 1024;
+		size_t m_reservedSize = 2048;
+		size_t m_usedDataSpace = 0;
+
+		TVector<Block> m_blocks;
+		TVector<uint32_t> m_emptyBlocks;
+
+		TVector<Node> m_nodes;
+		TVector<uint32_t> m_emptyNodes;
+
+		uint64_t m_firstLevelBitmap = 0;
+		uint32_t m_secondLevelBitmaps[FirstLevelCount]{};
+		uint32_t m_freeLists[FirstLevelCount][SecondLevelCount];
+	};
+}
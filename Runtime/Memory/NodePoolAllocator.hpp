@@ -0,0 +1,200 @@
+#pragma once
+#include <cstdlib>
+#include "Core/Defines.h"
+#include "BaseAllocator.hpp"
+#include "MallocAllocator.hpp"
+#include "LockFreeHeapAllocator.h"
+
+namespace Sailor::Memory
+{
+	// The inline nodes of TNodePoolAllocator, the base is empty if there are no inline nodes
+	template<size_t InlineSize>
+	class TNodePoolInlineStorage : public IBaseAllocator
+	{
+	protected:
+
+		alignas(16) uint8_t m_inlineNodes[InlineSize];
+	};
+
+	template<>
+	class TNodePoolInlineStorage<0> : public IBaseAllocator {};
+
+	// Per container pool of the equal nodes (list nodes, tree nodes, etc).
+	// The node size is taken from the first allocation, the nodes are carved from the chunks
+	// and the released ones are kept in the intrusive free list, so the insert/remove don't hit the heap.
+	// The chunks grow from MinNodesPerChunk up to MaxNodesPerChunk, so the small containers stay small.
+	// The chunks are released only on destruction, the bigger allocations go to TAllocator.
+	// InlineSize bytes are kept in the pool itself as the first chunk, so the tiny containers don't hit the heap at all,
+	// such pool cannot be moved since the nodes point to each other.
+	// Not thread safe, the same as the containers that own it.
+	template<size_t MaxNodesPerChunk = 64, typename TAllocator = DefaultGlobalAllocator, size_t MinNodesPerChunk = 2, size_t InlineSize = 0>
+	class TNodePoolAllocator final : public TNodePoolInlineStorage<InlineSize>
+	{
+		static_assert(MinNodesPerChunk > 0 && MinNodesPerChunk <= MaxNodesPerChunk, "Wrong chunk size");
+
+		static constexpr size_t Alignment = 16;
+
+		struct FreeNode
+		{
+			FreeNode* m_pNext = nullptr;
+		};
+
+		struct Chunk
+		{
+			Chunk* m_pNext = nullptr;
+			size_t m_size = 0;
+		};
+
+		static constexpr size_t AlignUp(size_t size, size_t alignment) { return ((size + alignment - 1) / alignment) * alignment; }
+
+	public:
+
+		TNodePoolAllocator() = default;
+
+		// The nodes are owned by the source container, so there is nothing to copy
+		TNodePoolAllocator(const TNodePoolAllocator&) {}
+		TNodePoolAllocator& operator=(const TNodePoolAllocator&) { return *this; }
+
+		TNodePoolAllocator(TNodePoolAllocator&& other) noexcept requires (InlineSize == 0) { Swap(other); }
+
+		TNodePoolAllocator& operator=(TNodePoolAllocator&& other) noexcept requires (InlineSize == 0)
+		{
+			if (this != &other)
+			{
+				ReleaseChunks();
+				Swap(other);
+			}
+			return *this;
+		}
+
+		~TNodePoolAllocator() { ReleaseChunks(); }
+
+		__forceinline void* Allocate(size_t size, size_t alignment = 8)
+		{
+			if (m_nodeSize == 0)
+			{
+				m_nodeAlignment = (std::max)(alignment, alignof(FreeNode));
+				m_nodeSize = AlignUp((std::max)(size, sizeof(FreeNode)), m_nodeAlignment);
+				AddInlineNodes();
+			}
+
+			// The same predicate as in Free, since Free has no alignment
+			if (size > m_nodeSize)
+			{
+				return m_allocator.Allocate(size, alignment);
+			}
+
+			check(alignment <= m_nodeAlignment);
+
+			if (!m_pFreeList)
+			{
+				AllocateChunk();
+			}
+
+			FreeNode* pNode = m_pFreeList;
+			m_pFreeList = pNode->m_pNext;
+			return pNode;
+		}
+
+		__forceinline bool Reallocate(void* ptr, size_t size, size_t alignment = 8) { return false; }
+
+		// The size should be passed, otherwise the node is treated as the pooled one
+		__forceinline void Free(void* ptr, size_t size = 0)
+		{
+			if (!ptr)
+			{
+				return;
+			}
+
+			if (size > m_nodeSize)
+			{
+				m_allocator.Free(ptr, size);
+				return;
+			}
+
+			FreeNode* pNode = static_cast<FreeNode*>(ptr);
+			pNode->m_pNext = m_pFreeList;
+			m_pFreeList = pNode;
+		}
+
+		size_t GetNumChunks() const
+		{
+			size_t res = 0;
+			for (Chunk* pChunk = m_pChunks; pChunk; pChunk = pChunk->m_pNext)
+			{
+				res++;
+			}
+			return res;
+		}
+
+	protected:
+
+		void AddNodes(uint8_t* pFirstNode, size_t numNodes)
+		{
+			// Keep the nodes in the address order
+			for (size_t i = numNodes; i > 0; i--)
+			{
+				FreeNode* pNode = reinterpret_cast<FreeNode*>(pFirstNode + (i - 1) * m_nodeSize);
+				pNode->m_pNext = m_pFreeList;
+				m_pFreeList = pNode;
+			}
+		}
+
+		void AddInlineNodes()
+		{
+			if constexpr (InlineSize > 0)
+			{
+				if (m_nodeAlignment <= Alignment)
+				{
+					AddNodes(this->m_inlineNodes, InlineSize / m_nodeSize);
+				}
+			}
+		}
+
+		void AllocateChunk()
+		{
+			const size_t numNodes = m_nextChunkSize;
+			m_nextChunkSize = (std::min)(m_nextChunkSize * 2, MaxNodesPerChunk);
+
+			const size_t chunkAlignment = (std::max)(Alignment, m_nodeAlignment);
+			const size_t headerSize = AlignUp(sizeof(Chunk), chunkAlignment);
+			const size_t chunkSize = headerSize + numNodes * m_nodeSize;
+
+			Chunk* pChunk = static_cast<Chunk*>(m_allocator.Allocate(chunkSize, chunkAlignment));
+			pChunk->m_pNext = m_pChunks;
+			pChunk->m_size = chunkSize;
+			m_pChunks = pChunk;
+
+			AddNodes(reinterpret_cast<uint8_t*>(pChunk) + headerSize, numNodes);
+		}
+
+		void ReleaseChunks()
+		{
+			while (m_pChunks)
+			{
+				Chunk* pNext = m_pChunks->m_pNext;
+				m_allocator.Free(m_pChunks, m_pChunks->m_size);
+				m_pChunks = pNext;
+			}
+
+			m_pFreeList = nullptr;
+			m_nextChunkSize = MinNodesPerChunk;
+		}
+
+		void Swap(TNodePoolAllocator& other)
+		{
+			std::swap(m_pFreeList, other.m_pFreeList);
+			std::swap(m_pChunks, other.m_pChunks);
+			std::swap(m_nodeSize, other.m_nodeSize);
+			std::swap(m_nodeAlignment, other.m_nodeAlignment);
+			std::swap(m_nextChunkSize, other.m_nextChunkSize);
+		}
+
+		FreeNode* m_pFreeList = nullptr;
+		Chunk* m_pChunks = nullptr;
+		size_t m_nodeSize = 0;
+		size_t m_nodeAlignment = alignof(FreeNode);
+		size_t m_nextChunkSize = MinNodesPerChunk;
+		TAllocator m_allocator{};
+	};
+}
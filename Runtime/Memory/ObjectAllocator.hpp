@@ -84,6 +84,22 @@ namespace Sailor::Memory
 			}
 		}
 
+		SAILOR_API size_t ReleaseUnused()
+		{
+			switch (m_policy)
+			{
+			case EAllocationPolicy::SharedMemory_MultiThreaded:
+				return DefaultGlobalAllocator::ReleaseUnused();
+				break;
+
+			case EAllocationPolicy::LocalMemory_SingleThread:
+				return GetAllocator<HeapAllocator>()->ReleaseUnused();
+				break;
+			}
+
+			return 0;
+		}
+
 		SAILOR_API ObjectAllocator() = default;
 
 		ObjectAllocator(const ObjectAllocator&) = delete;
@@ -272,7 +272,7 @@ namespace Sailor
 
 			if (pRawPtr)
 			{
-				m_pControlBlock = pControlBlock ? pControlBlock : new (m_pAllocator->Allocate(sizeof(TSmartPtrControlBlock))) TSmartPtrControlBlock();
+				m_pControlBlock = pControlBlock ? pControlBlock : TSmartPtrControlBlock::Allocate<Memory::DefaultGlobalAllocator>();
 				m_pRawPtr = pRawPtr;
 				IncrementRefCounter();
 			}
@@ -295,7 +295,7 @@ namespace Sailor
 
 				check(m_pAllocator);
 
-				m_pAllocator->Free(m_pControlBlock);
+				TSmartPtrControlBlock::Free<Memory::DefaultGlobalAllocator>(m_pControlBlock);
 				m_pControlBlock = nullptr;
 				m_pAllocator.Clear();
 			}
@@ -332,7 +332,7 @@ namespace Sailor
 namespace std
 {
 	template<typename T>
-	struct std::hash<Sailor::TObjectPtr<T>>
+	struct hash<Sailor::TObjectPtr<T>>
 	{
 		SAILOR_API std::size_t operator()(const Sailor::TObjectPtr<T>& p) const
 		{
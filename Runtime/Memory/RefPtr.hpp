@@ -236,12 +236,16 @@ namespace Sailor
 	{
 		return TRefPtr<T>(static_cast<T*>(this));
 	}
+
+	// Holds the raw pointer only
+	template<typename T>
+	struct TIsTriviallyRelocatable<TRefPtr<T>> : std::true_type {};
 }
 
 namespace std
 {
 	template<>
-	struct std::hash<Sailor::TRefPtrBase>
+	struct hash<Sailor::TRefPtrBase>
 	{
 		SAILOR_API std::size_t operator()(const Sailor::TRefPtrBase& p) const
 		{
@@ -250,7 +254,7 @@ namespace std
 	};
 
 	template<typename T>
-	struct std::hash<Sailor::TRefPtr<T>>
+	struct hash<Sailor::TRefPtr<T>>
 	{
 		SAILOR_API std::size_t operator()(const Sailor::TRefPtr<T>& p) const
 		{
@@ -6,6 +6,7 @@
 #include "Containers/Concepts.h"
 #include "Memory/MallocAllocator.hpp"
 #include "Memory/LockFreeHeapAllocator.h"
+#include "Memory/SlabAllocator.hpp"
 
 namespace Sailor
 {
@@ -19,6 +20,24 @@ namespace Sailor
 	public:
 		TSmartPtrCounter m_weakPtrCounter = 0;
 		TSmartPtrCounter m_sharedPtrCounter = 0;
+
+		// The object is placed right after the control block if the allocation is bigger than control block
+		uint32_t m_allocationSize = (uint32_t)sizeof(TSmartPtrControlBlock);
+		uint16_t m_allocationAlignment = (uint16_t)alignof(TSmartPtrControlBlock);
+
+		__forceinline bool IsObjectInplace() const { return m_allocationSize > sizeof(TSmartPtrControlBlock); }
+
+		template<typename TGlobalAllocator>
+		static TSmartPtrControlBlock* Allocate()
+		{
+			return new (Memory::TSmallObjectAllocator<TGlobalAllocator>::allocate(sizeof(TSmartPtrControlBlock))) TSmartPtrControlBlock();
+		}
+
+		template<typename TGlobalAllocator>
+		static void Free(TSmartPtrControlBlock* pControlBlock)
+		{
+			Memory::TSmallObjectAllocator<TGlobalAllocator>::free(pControlBlock, pControlBlock->m_allocationSize, pControlBlock->m_allocationAlignment);
+		}
 	};
 
 	template<typename T, typename TGlobalAllocator = Sailor::Memory::DefaultGlobalAllocator>
@@ -29,7 +48,22 @@ namespace Sailor
 		template<typename... TArgs>
 		static TSharedPtr<T> Make(TArgs&&... args)
 		{
-			auto pRes = TSharedPtr<T>(new T(std::forward<TArgs>(args)...));
+			// The control block and the object share the same allocation
+			constexpr size_t objectOffset = ((sizeof(TSmartPtrControlBlock) + alignof(T) - 1) / alignof(T)) * alignof(T);
+			constexpr size_t allocationSize = objectOffset + sizeof(T);
+			constexpr size_t alignment = alignof(T) > alignof(TSmartPtrControlBlock) ? alignof(T) : alignof(TSmartPtrControlBlock);
+
+			uint8_t* pData = static_cast<uint8_t*>(Memory::TSmallObjectAllocator<TGlobalAllocator>::allocate(allocationSize, alignment));
+
+			TSmartPtrControlBlock* pControlBlock = new (pData) TSmartPtrControlBlock();
+			pControlBlock->m_allocationSize = (uint32_t)allocationSize;
+			pControlBlock->m_allocationAlignment = (uint16_t)alignment;
+
+			TSharedPtr<T> pRes;
+			pRes.m_pRawPtr = new (pData + objectOffset) T(std::forward<TArgs>(args)...);
+			pRes.m_pControlBlock = pControlBlock;
+			pRes.IncrementRefCounter();
+
 			return pRes;
 		}
 
@@ -158,7 +192,7 @@ namespace Sailor
 			{
 				if (!pControlBlock)
 				{
-					m_pControlBlock = new (TGlobalAllocator::allocate(sizeof(TSmartPtrControlBlock))) TSmartPtrControlBlock();
+					m_pControlBlock = TSmartPtrControlBlock::Allocate<TGlobalAllocator>();
 				}
 				else
 				{
@@ -181,13 +215,20 @@ namespace Sailor
 			{
 				if (--m_pControlBlock->m_sharedPtrCounter == 0)
 				{
-					delete m_pRawPtr;
+					if (m_pControlBlock->IsObjectInplace())
+					{
+						m_pRawPtr->~T();
+					}
+					else
+					{
+						delete m_pRawPtr;
+					}
 					m_pRawPtr = nullptr;
 				}
 
 				if (--m_pControlBlock->m_weakPtrCounter == 0)
 				{
-					TGlobalAllocator::free(m_pControlBlock);
+					TSmartPtrControlBlock::Free<TGlobalAllocator>(m_pControlBlock);
 					m_pControlBlock = nullptr;
 				}
 			}
@@ -219,12 +260,16 @@ namespace Sailor
 		template<typename, typename>
 		friend class TWeakPtr;
 	};
+
+	// Holds the raw pointers only
+	template<typename T, typename TGlobalAllocator>
+	struct TIsTriviallyRelocatable<TSharedPtr<T, TGlobalAllocator>> : std::true_type {};
 }
 
 namespace std
 {
 	template<typename T>
-	struct std::hash<Sailor::TSharedPtr<T>>
+	struct hash<Sailor::TSharedPtr<T>>
 	{
 		SAILOR_API std::size_t operator()(const Sailor::TSharedPtr<T>& p) const
 		{
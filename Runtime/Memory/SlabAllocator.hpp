@@ -0,0 +1,259 @@
+#pragma once
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include "Core/Defines.h"
+#include "Core/SpinLock.h"
+#include "BaseAllocator.hpp"
+#include "MallocAllocator.hpp"
+
+namespace Sailor::Memory
+{
+	// Fixed size blocks allocator for the hot small objects (smart ptr's control blocks, tasks, etc).
+	// Each thread owns its slabs with the intrusive free list, so the allocation doesn't take any lock.
+	// The block could be freed from any thread, remote frees are pushed to the owner and collected lazily.
+	// The slabs are never released and the per thread pools outlive the threads,
+	// since the blocks could be freed remotely after the thread is finished.
+	// The pool of the finished thread is orphaned and adopted by the next thread with its slabs and remote frees.
+	template<size_t blockSize, size_t slabSize = 65536>
+	class TSlabAllocator final : public IBaseAllocator
+	{
+		static_assert((slabSize& (slabSize - 1)) == 0, "Slab size must be a power of 2");
+		static_assert(blockSize >= sizeof(void*), "Block must be able to store the free list pointer");
+
+		struct FreeBlock
+		{
+			FreeBlock* m_pNext = nullptr;
+		};
+
+		struct ThreadPool;
+
+		struct Slab
+		{
+			ThreadPool* m_pOwner = nullptr;
+			Slab* m_pNext = nullptr;
+		};
+
+		struct ThreadPool
+		{
+			FreeBlock* m_pFreeList = nullptr;
+			std::atomic<FreeBlock*> m_pRemoteFreeList = nullptr;
+			Slab* m_pSlabs = nullptr;
+			ThreadPool* m_pNextOrphan = nullptr;
+		};
+
+		// Orphans the pool on the thread exit
+		struct ThreadPoolOwner
+		{
+			ThreadPool* m_pPool = nullptr;
+
+			~ThreadPoolOwner()
+			{
+				if (m_pPool)
+				{
+					TSlabAllocator::OrphanThreadPool(m_pPool);
+					m_pPool = nullptr;
+				}
+			}
+		};
+
+	public:
+
+		static constexpr size_t Alignment = 16;
+		static constexpr size_t SlabHeaderSize = ((sizeof(Slab) + Alignment - 1) / Alignment) * Alignment;
+		static constexpr size_t NumBlocksPerSlab = (slabSize - SlabHeaderSize) / blockSize;
+
+		__forceinline void* Allocate(size_t size = blockSize, size_t alignment = 8)
+		{
+			check(size <= blockSize && alignment <= Alignment);
+			return TSlabAllocator::allocate();
+		}
+
+		__forceinline bool Reallocate(void* ptr, size_t size, size_t alignment = 8) { return size <= blockSize; }
+		__forceinline void Free(void* ptr, size_t size = 0) { TSlabAllocator::free(ptr); }
+
+		static void* allocate()
+		{
+			ThreadPool& pool = GetThreadPool();
+
+			if (!pool.m_pFreeList)
+			{
+				// Collect the blocks that were released by other threads
+				pool.m_pFreeList = pool.m_pRemoteFreeList.exchange(nullptr, std::memory_order_acquire);
+
+				if (!pool.m_pFreeList && !RequestSlab(pool))
+				{
+					return nullptr;
+				}
+			}
+
+			FreeBlock* pBlock = pool.m_pFreeList;
+			pool.m_pFreeList = pBlock->m_pNext;
+
+			return pBlock;
+		}
+
+		static void free(void* ptr)
+		{
+			if (!ptr)
+			{
+				return;
+			}
+
+			Slab* pSlab = reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(slabSize - 1));
+			ThreadPool* pOwner = pSlab->m_pOwner;
+			FreeBlock* pBlock = static_cast<FreeBlock*>(ptr);
+
+			if (pOwner == GetThreadPoolRef())
+			{
+				pBlock->m_pNext = pOwner->m_pFreeList;
+				pOwner->m_pFreeList = pBlock;
+				return;
+			}
+
+			// The owner takes the whole list at once, so there is no ABA problem
+			FreeBlock* pHead = pOwner->m_pRemoteFreeList.load(std::memory_order_relaxed);
+			do
+			{
+				pBlock->m_pNext = pHead;
+			} while (!pOwner->m_pRemoteFreeList.compare_exchange_weak(pHead, pBlock, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+	protected:
+
+		static ThreadPool*& GetThreadPoolRef()
+		{
+			thread_local ThreadPoolOwner owner;
+			return owner.m_pPool;
+		}
+
+		static ThreadPool& GetThreadPool()
+		{
+			ThreadPool*& pPool = GetThreadPoolRef();
+
+			if (!pPool)
+			{
+				pPool = AdoptThreadPool();
+			}
+
+			if (!pPool)
+			{
+				pPool = new (MallocAllocator::allocate(sizeof(ThreadPool))) ThreadPool();
+			}
+
+			return *pPool;
+		}
+
+		static SpinLock& GetOrphansLock()
+		{
+			static SpinLock lock;
+			return lock;
+		}
+
+		static ThreadPool*& GetOrphans()
+		{
+			static ThreadPool* pOrphans = nullptr;
+			return pOrphans;
+		}
+
+		static void OrphanThreadPool(ThreadPool* pPool)
+		{
+			SpinLock& lock = GetOrphansLock();
+			lock.Lock();
+			pPool->m_pNextOrphan = GetOrphans();
+			GetOrphans() = pPool;
+			lock.Unlock();
+		}
+
+		// The slabs keep the pointer to the pool, so the new owner gets the blocks that are freed remotely
+		static ThreadPool* AdoptThreadPool()
+		{
+			SpinLock& lock = GetOrphansLock();
+			lock.Lock();
+			ThreadPool* pPool = GetOrphans();
+			if (pPool)
+			{
+				GetOrphans() = pPool->m_pNextOrphan;
+				pPool->m_pNextOrphan = nullptr;
+			}
+			lock.Unlock();
+
+			return pPool;
+		}
+
+		static bool RequestSlab(ThreadPool& pool)
+		{
+#ifdef _WIN32
+			void* pData = _aligned_malloc(slabSize, slabSize);
+#else
+			void* pData = std::aligned_alloc(slabSize, slabSize);
+#endif
+			if (!pData)
+			{
+				return false;
+			}
+
+			SAILOR_PROFILE_ALLOC(pData, slabSize);
+
+			Slab* pSlab = new (pData) Slab();
+			pSlab->m_pOwner = &pool;
+			pSlab->m_pNext = pool.m_pSlabs;
+			pool.m_pSlabs = pSlab;
+
+			// Build the intrusive free list in the address order
+			uint8_t* pFirstBlock = static_cast<uint8_t*>(pData) + SlabHeaderSize;
+			for (size_t i = NumBlocksPerSlab; i > 0; i--)
+			{
+				FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pFirstBlock + (i - 1) * blockSize);
+				pBlock->m_pNext = pool.m_pFreeList;
+				pool.m_pFreeList = pBlock;
+			}
+
+			return true;
+		}
+	};
+
+	// Routes the small allocations to the per thread slabs by size classes,
+	// the large or overaligned allocations are handled by TGlobalAllocator.
+	// The size of allocation must be passed to free.
+	template<typename TGlobalAllocator = DefaultGlobalAllocator>
+	class TSmallObjectAllocator final : public IBaseAllocator
+	{
+	public:
+
+		static constexpr size_t MaxSmallObjectSize = 512;
+
+		__forceinline void* Allocate(size_t size, size_t alignment = 8) { return TSmallObjectAllocator::allocate(size, alignment); }
+		__forceinline void Free(void* ptr, size_t size) { TSmallObjectAllocator::free(ptr, size); }
+
+		static void* allocate(size_t size, size_t alignment = 8)
+		{
+			if (alignment <= TSlabAllocator<16>::Alignment)
+			{
+				if (size <= 16) return TSlabAllocator<16>::allocate();
+				if (size <= 32) return TSlabAllocator<32>::allocate();
+				if (size <= 64) return TSlabAllocator<64>::allocate();
+				if (size <= 128) return TSlabAllocator<128>::allocate();
+				if (size <= 256) return TSlabAllocator<256>::allocate();
+				if (size <= 512) return TSlabAllocator<512>::allocate();
+			}
+
+			return TGlobalAllocator::allocate(size, alignment);
+		}
+
+		static void free(void* ptr, size_t size, size_t alignment = 8)
+		{
+			if (alignment <= TSlabAllocator<16>::Alignment)
+			{
+				if (size <= 16) return TSlabAllocator<16>::free(ptr);
+				if (size <= 32) return TSlabAllocator<32>::free(ptr);
+				if (size <= 64) return TSlabAllocator<64>::free(ptr);
+				if (size <= 128) return TSlabAllocator<128>::free(ptr);
+				if (size <= 256) return TSlabAllocator<256>::free(ptr);
+				if (size <= 512) return TSlabAllocator<512>::free(ptr);
+			}
+
+			TGlobalAllocator::free(ptr, size);
+		}
+	};
+}
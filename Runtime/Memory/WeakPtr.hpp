@@ -174,7 +174,7 @@ namespace Sailor
 				--m_pControlBlock->m_weakPtrCounter == 0 &&
 				m_pControlBlock->m_sharedPtrCounter == 0)
 			{
-				TGlobalAllocator::free(m_pControlBlock);
+				TSmartPtrControlBlock::Free<TGlobalAllocator>(m_pControlBlock);
 				m_pControlBlock = nullptr;
 				m_pRawPtr = nullptr;
 			}
@@ -208,7 +208,7 @@ namespace Sailor
 namespace std
 {
 	template<typename T>
-	struct std::hash<Sailor::TWeakPtr<T>>
+	struct hash<Sailor::TWeakPtr<T>>
 	{
 		SAILOR_API std::size_t operator()(const Sailor::TWeakPtr<T>& p) const
 		{
@@ -1,5 +1,6 @@
 #pragma once
 #include "Containers/Map.h"
+#include "Containers/FlatMap.h"
 #include "RHI/Types.h"
 #include "RHI/VertexDescription.h"
 #include "RHI/SceneView.h"
@@ -47,7 +48,7 @@ namespace Sailor::RHI
 	};
 
 	template<typename TPerInstanceData>
-	using TDrawCalls = TMap<RHIBatch, TMap<RHI::RHIMeshPtr, TVector<TPerInstanceData>>>;
+	using TDrawCalls = TFlatMap<RHIBatch, TFlatMap<RHI::RHIMeshPtr, TVector<TPerInstanceData>>>;
 
 	template<typename TPerInstanceData>
 	void RHIRecordDrawCallGPUCulling(uint32_t start,
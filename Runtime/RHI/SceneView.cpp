@@ -9,6 +9,7 @@
 #include "AssetRegistry/Material/MaterialImporter.h"
 #include "RHI/DebugContext.h"
 #include "RHI/CommandList.h"
+#include "Tasks/ParallelFor.h"
 
 using namespace Sailor;
 using namespace Sailor::RHI;
@@ -55,85 +56,59 @@ void RHISceneView::Clear()
 
 TVector<RHISceneViewProxy> RHISceneView::TraceScene(const Math::Frustum& frustum, bool bSkipMaterials) const
 {
-	const uint32_t NumProxiesPerTask = 1024;
+	const uint32_t MinProxiesPerTask = 256;
 
 	SAILOR_PROFILE_FUNCTION();
 
-	TVector<RHISceneViewProxy> res;
-
 	// Stationary
 	TVector<RHIMeshProxy> meshProxies;
 	m_stationaryOctree.Trace(frustum, meshProxies);
-	TVector<Tasks::TaskPtr<TVector<RHISceneViewProxy>>> tasks;
-	for (uint32_t i = 0; i < meshProxies.Num() / NumProxiesPerTask + 1; i++)
-	{
-		Tasks::TaskPtr<TVector<RHISceneViewProxy>> task = Tasks::CreateTaskWithResult<TVector<RHISceneViewProxy>>("Create list of scene view proxies",
-			[i, &meshProxies, &m_world = m_world, bSkipMaterials]()
+
+	TVector<RHISceneViewProxy> res = Tasks::ParallelReduce("Create list of scene view proxies", 0, meshProxies.Num(), TVector<RHISceneViewProxy>(),
+		[&meshProxies, &m_world = m_world, bSkipMaterials](size_t begin, size_t end, TVector<RHISceneViewProxy>& temp)
+		{
+			for (size_t index = begin; index < end; index++)
 			{
-				TVector<RHISceneViewProxy> temp;
-				temp.Reserve(NumProxiesPerTask);
-				for (uint32_t j = 0; j < NumProxiesPerTask; j++)
-				{
-					if (i * NumProxiesPerTask + j >= meshProxies.Num())
-					{
-						break;
-					}
+				auto& meshProxy = meshProxies[index];
+				auto& ecsData = m_world->GetECS<StaticMeshRendererECS>()->GetComponentData(meshProxy.m_staticMeshEcs);
 
-					auto& meshProxy = meshProxies[i * NumProxiesPerTask + j];
-					auto& ecsData = m_world->GetECS<StaticMeshRendererECS>()->GetComponentData(meshProxy.m_staticMeshEcs);
+				if (ecsData.GetMaterials().Num() == 0)
+				{
+					continue;
+				}
 
-					if (ecsData.GetMaterials().Num() == 0)
-					{
-						continue;
-					}
+				RHISceneViewProxy viewProxy;
+				viewProxy.m_staticMeshEcs = meshProxy.m_staticMeshEcs;
+				viewProxy.m_worldMatrix = meshProxy.m_worldMatrix;
+				viewProxy.m_meshes = ecsData.GetModel()->GetMeshes();
+				viewProxy.m_overrideMaterials.Clear();
+				viewProxy.m_frame = ecsData.GetFrameLastChange();
+				viewProxy.m_bCastShadows = ecsData.ShouldCastShadow();
+				viewProxy.m_worldAabb = ecsData.GetModel()->GetBoundsAABB();
+				viewProxy.m_worldAabb.Apply(viewProxy.m_worldMatrix);
 
-					RHISceneViewProxy viewProxy;
-					viewProxy.m_staticMeshEcs = meshProxy.m_staticMeshEcs;
-					viewProxy.m_worldMatrix = meshProxy.m_worldMatrix;
-					viewProxy.m_meshes = ecsData.GetModel()->GetMeshes();
-					viewProxy.m_overrideMaterials.Clear();
-					viewProxy.m_frame = ecsData.GetFrameLastChange();
-					viewProxy.m_bCastShadows = ecsData.ShouldCastShadow();
-					viewProxy.m_worldAabb = ecsData.GetModel()->GetBoundsAABB();
-					viewProxy.m_worldAabb.Apply(viewProxy.m_worldMatrix);
+				viewProxy.m_overrideMaterials.Reserve(viewProxy.m_meshes.Num());
+				// TODO: Should we check AABB for each mesh in model?
 
-					viewProxy.m_overrideMaterials.Reserve(viewProxy.m_meshes.Num());
-					// TODO: Should we check AABB for each mesh in model?
+				for (size_t i = 0; i < viewProxy.m_meshes.Num(); i++)
+				{
+					size_t materialIndex = (std::min)(i, ecsData.GetMaterials().Num() - 1);
 
-					for (size_t i = 0; i < viewProxy.m_meshes.Num(); i++)
+					auto& material = ecsData.GetMaterials()[materialIndex];
+					if (material && material->IsReady() && !bSkipMaterials)
 					{
-						size_t materialIndex = (std::min)(i, ecsData.GetMaterials().Num() - 1);
-
-						auto& material = ecsData.GetMaterials()[materialIndex];
-						if (material && material->IsReady() && !bSkipMaterials)
-						{
-							viewProxy.m_overrideMaterials.Add(material->GetOrAddRHI(viewProxy.m_meshes[i]->m_vertexDescription));
-						}
+						viewProxy.m_overrideMaterials.Add(material->GetOrAddRHI(viewProxy.m_meshes[i]->m_vertexDescription));
 					}
-
-					temp.Emplace(std::move(viewProxy));
 				}
 
-				return temp;
-			});
-
-		if (meshProxies.Num() < NumProxiesPerTask)
+				temp.Emplace(std::move(viewProxy));
+			}
+		},
+		[](TVector<RHISceneViewProxy> lhs, TVector<RHISceneViewProxy> rhs)
 		{
-			task->Execute();
-			res.AddRange(std::move(task->m_result));
-
-			break;
-		}
-
-		task->Run();
-		tasks.Add(task);
-	}
-
-	for (auto& t : tasks)
-	{
-		t->Wait();
-		res.AddRange(std::move(t->m_result));
-	}
+			lhs.AddRange(std::move(rhs));
+			return lhs;
+		}, MinProxiesPerTask);
 
 	// Static
 	TVector<RHISceneViewProxy> proxies;
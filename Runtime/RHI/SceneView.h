@@ -1,7 +1,7 @@
 #pragma once
 #include "Core/Defines.h"
 #include "Memory/Memory.h"
-#include "Containers/Octree.h"
+#include "Containers/LooseOctree.h"
 #include "Engine/Types.h"
 #include "RHI/Mesh.h"
 #include "RHI/Material.h"
@@ -88,8 +88,8 @@ namespace Sailor::RHI
 		SAILOR_API void PrepareSnapshots();
 		SAILOR_API void PrepareDebugDrawCommandLists(WorldPtr world);
 
-		TOctree<RHIMeshProxy> m_stationaryOctree{ glm::ivec3(0,0,0), 16536 * 16, 4 };
-		TOctree<RHISceneViewProxy> m_staticOctree{ glm::ivec3(0,0,0), 16536 * 16, 4 };
+		TLooseOctree<RHIMeshProxy> m_stationaryOctree{ glm::ivec3(0,0,0), 16536 * 16, 4 };
+		TLooseOctree<RHISceneViewProxy> m_staticOctree{ glm::ivec3(0,0,0), 16536 * 16, 4 };
 
 		uint32_t m_totalNumLights = 0;
 		RHI::RHIShaderBindingSetPtr m_rhiLightsData{};
@@ -115,6 +115,13 @@ namespace Sailor::RHI
 	using RHISceneViewPtr = TSharedPtr<RHISceneView>;
 };
 
+namespace Sailor
+{
+	// Smart pointers, containers and POD data, could be moved by memcpy
+	template<>
+	struct TIsTriviallyRelocatable<RHI::RHISceneViewProxy> : std::true_type {};
+}
+
 namespace std
 {
 	template<>
@@ -1,5 +1,6 @@
 ﻿#include "PathTracer.h"
 #include "Tasks/Scheduler.h"
+#include "Tasks/ParallelFor.h"
 #include "Core/LogMacros.h"
 #include "Core/Utils.h"
 #include "glm/glm/glm.hpp"
@@ -404,99 +405,71 @@ void PathTracer::Run(const PathTracer::Params& params)
 
 	// Raytracing
 	{
-		SAILOR_PROFILE_SCOPE("Prepare raytracing tasks");
+		SAILOR_PROFILE_SCOPE("Raytracing tiles");
 
-		TVector<Tasks::ITaskPtr> tasks;
-		TVector<Tasks::ITaskPtr> tasksThisThread;
+		const uint32_t numTilesX = (width + GroupSize - 1) / GroupSize;
+		const uint32_t numTilesY = (height + GroupSize - 1) / GroupSize;
+		const uint32_t numTasks = numTilesX * numTilesY;
 
 		std::atomic<uint32_t> finishedTasks = 0;
-		const uint32_t numTasks = (height * width) / (GroupSize * GroupSize);
-
-		tasks.Reserve(numTasks);
-		tasksThisThread.Reserve(numTasks / 32);
+		const std::thread::id callingThreadId = std::this_thread::get_id();
+		float lastPrg = 0.0f;
+		float eta = 0.0f;
 
-		for (uint32_t y = 0; y < height; y += GroupSize)
-		{
-			for (uint32_t x = 0; x < width; x += GroupSize)
+		// Tile per item, the calling thread processes the tiles as well and reports the progress
+		Tasks::ParallelFor("Calculate raytracing", 0, numTasks,
+			[&, this](size_t tile)
 			{
-				auto task = Tasks::CreateTask("Calculate raytracing",
-					[=,
-					&finishedTasks,
-					&outputTex,
-					&bvh,
-					this]() mutable
-					{
-						Ray ray;
-						ray.SetOrigin(cameraPos);
+				const uint32_t x = (uint32_t)(tile % numTilesX) * GroupSize;
+				const uint32_t y = (uint32_t)(tile / numTilesX) * GroupSize;
+
+				Ray ray;
+				ray.SetOrigin(cameraPos);
 
 #ifdef _DEBUG
-						uint32_t debugX = 975u;
-						uint32_t debugY = height - 355u - 1;
+				uint32_t debugX = 975u;
+				uint32_t debugY = height - 355u - 1;
 
-						if (!(x < debugX && (x + GroupSize) > debugX &&
-							y < debugY && (y + GroupSize) > debugY))
-						{
-							return;
-						}
+				if (!(x < debugX && (x + GroupSize) > debugX &&
+					y < debugY && (y + GroupSize) > debugY))
+				{
+					return;
+				}
 #endif
-						for (uint32_t v = 0; (v < GroupSize) && (y + v) < height; v++)
-						{
-							const float tv = (y + v) / (float)height;
-							for (uint32_t u = 0; u < GroupSize && (u + x) < width; u++)
-							{
-								SAILOR_PROFILE_SCOPE("Raycasting");
+				for (uint32_t v = 0; (v < GroupSize) && (y + v) < height; v++)
+				{
+					const float tv = (y + v) / (float)height;
+					for (uint32_t u = 0; u < GroupSize && (u + x) < width; u++)
+					{
+						SAILOR_PROFILE_SCOPE("Raycasting");
 
-								const uint32_t index = (height - (y + v) - 1) * width + (x + u);
-								const float tu = (x + u) / (float)width;
+						const uint32_t index = (height - (y + v) - 1) * width + (x + u);
+						const float tu = (x + u) / (float)width;
 #ifdef _DEBUG
-								if (((x + u) == debugX) && ((y + v) == debugY))
-								{
-									volatile uint8_t a = 0;
-								}
+						if (((x + u) == debugX) && ((y + v) == debugY))
+						{
+							volatile uint8_t a = 0;
+						}
 #endif
-								vec3 accumulator = vec3(0);
-								for (uint32_t sample = 0; sample < params.m_msaa; sample++)
-								{
-									const vec2 offset = sample == 0 ? vec2(0.5f, 0.5f) : glm::linearRand(vec2(0, 0), vec2(1.0f, 1.0f));
-									const vec3 pixelDir = _pixel00Dir + ((float)(u + x) + offset.x) * _pixelDeltaU + ((float)(y + v) - offset.y) * _pixelDeltaV;
-
-									ray.SetDirection(glm::normalize(pixelDir));
-
-									accumulator += Raytrace(ray, bvh, params.m_maxBounces, (uint32_t)(-1), params, 1.0f, 1.0f);
-								}
-
-								vec3 res = accumulator / (float)params.m_msaa;
-								outputTex.SetPixel(x + u, height - (y + v) - 1, res);
-								}
-							}
+						vec3 accumulator = vec3(0);
+						for (uint32_t sample = 0; sample < params.m_msaa; sample++)
+						{
+							const vec2 offset = sample == 0 ? vec2(0.5f, 0.5f) : glm::linearRand(vec2(0, 0), vec2(1.0f, 1.0f));
+							const vec3 pixelDir = _pixel00Dir + ((float)(u + x) + offset.x) * _pixelDeltaU + ((float)(y + v) - offset.y) * _pixelDeltaV;
 
-						finishedTasks++;
+							ray.SetDirection(glm::normalize(pixelDir));
 
-					}, EThreadType::Worker);
+							accumulator += Raytrace(ray, bvh, params.m_maxBounces, (uint32_t)(-1), params, 1.0f, 1.0f);
+						}
 
-				if (((x + y) / GroupSize) % 32 == 0)
-				{
-					tasksThisThread.Emplace(task);
-				}
-				else
-				{
-					task->Run();
-					tasks.Emplace(std::move(task));
+						vec3 res = accumulator / (float)params.m_msaa;
+						outputTex.SetPixel(x + u, height - (y + v) - 1, res);
+					}
 				}
-			}
-		}
 
-		float lastPrg = 0.0f;
-		{
-			SAILOR_PROFILE_SCOPE("Calcs on Main thread");
-			float eta = 0.0f;
-			for (auto& task : tasksThisThread)
-			{
-				task->Execute();
-
-				const float progress = finishedTasks.load() / (float)numTasks;
+				const float progress = (finishedTasks.fetch_add(1) + 1) / (float)numTasks;
 
-				if (progress - lastPrg > 0.05f)
+				if (std::this_thread::get_id() == callingThreadId && progress - lastPrg > 0.05f)
 				{
 					if (eta == 0.0f)
 					{
@@ -507,26 +480,7 @@ void PathTracer::Run(const PathTracer::Params& params)
 					SAILOR_LOG("PathTracer Progress: %.2f", progress);
 					lastPrg = progress;
 				}
-			}
-		}
-
-		{
-			SAILOR_PROFILE_SCOPE("Wait all calcs");
-			for (auto& task : tasks)
-			{
-				if (!task->IsFinished())
-				{
-					task->Wait();
-
-					const float progress = finishedTasks.load() / (float)numTasks;
-					if (progress - lastPrg > 0.05f)
-					{
-						SAILOR_LOG("PathTracer Progress: %.2f", progress);
-						lastPrg = progress;
-					}
-				}
-			}
-		}
+			}, 1);
 	}
 
 	raytracingTimer.Stop();
@@ -17,7 +17,9 @@
 #include "Containers/Set.h"
 #include "Containers/Map.h"
 #include "Containers/List.h"
+#include "Containers/ConcurrentQueue.h"
 #include "Containers/Octree.h"
+#include "Containers/ContainersBenchmark.h"
 #include "Engine/EngineLoop.h"
 #include "Memory/MemoryBlockAllocator.hpp"
 #include "ECS/ECS.h"
@@ -69,6 +71,14 @@ AppArgs ParseCommandLineArgs(const char** args, int32_t num)
 		{
 			params.m_bRunConsole = false;
 		}
+		else if (arg == "--noworkstealing")
+		{
+			params.m_bWorkStealing = false;
+		}
+		else if (arg == "--fibers")
+		{
+			params.m_bFibers = true;
+		}
 		else if (arg == "--world")
 		{
 			params.m_world = Utils::GetArgValue(args, i, num);
@@ -146,7 +156,7 @@ void App::Initialize(const char** commandLineArgs, int32_t num)
 		s_pInstance->AddSubmodule(TSubmodule<Editor>::Make(params.m_editorHwnd, params.m_editorPort, s_pInstance->m_pMainWindow.GetRawPtr()));
 	}
 
-	s_pInstance->AddSubmodule(TSubmodule<Tasks::Scheduler>::Make())->Initialize();
+	s_pInstance->AddSubmodule(TSubmodule<Tasks::Scheduler>::Make())->Initialize(params.m_bWorkStealing, params.m_bFibers);
 	s_pInstance->AddSubmodule(TSubmodule<Renderer>::Make(s_pInstance->m_pMainWindow.GetRawPtr(), RHI::EMsaaSamples::Samples_8, bEnableRenderValidationLayers));
 
 	auto assetRegistry = s_pInstance->AddSubmodule(TSubmodule<AssetRegistry>::Make());
@@ -219,12 +229,18 @@ void App::Start()
 	TMap<std::string, std::function<void()>> consoleVars;
 	consoleVars["scan"] = std::bind(&AssetRegistry::ScanContentFolder, GetSubmodule<AssetRegistry>());
 	consoleVars["memory.benchmark"] = &Memory::RunMemoryBenchmark;
+	consoleVars["memory.suballocator_benchmark"] = &Memory::RunSubAllocatorBenchmark;
 	consoleVars["vector.benchmark"] = &Sailor::RunVectorBenchmark;
 	consoleVars["set.benchmark"] = &Sailor::RunSetBenchmark;
 	consoleVars["map.benchmark"] = &Sailor::RunMapBenchmark;
 	consoleVars["list.benchmark"] = &Sailor::RunListBenchmark;
+	consoleVars["queue.benchmark"] = &Sailor::RunQueueBenchmark;
 	consoleVars["octree.benchmark"] = &Sailor::RunOctreeBenchmark;
+	consoleVars["containers.benchmark"] = &Sailor::RunContainersBenchmark;
 	consoleVars["stats.memory"] = &Sailor::RHI::Renderer::MemoryStats;
+	consoleVars["stats.tasks"] = std::bind(&Tasks::Scheduler::LogStats, GetSubmodule<Tasks::Scheduler>());
+	consoleVars["tasks.trace"] = std::bind(&Tasks::Scheduler::ToggleTrace, GetSubmodule<Tasks::Scheduler>());
+	consoleVars["memory.trim"] = []() { SAILOR_LOG("Released %zu bytes of heap memory", Memory::DefaultGlobalAllocator::ReleaseUnused()); };
 
 	FrameInputState systemInputState = (Sailor::FrameInputState)GlobalInput::GetInputState();
 
@@ -342,6 +358,10 @@ void App::Start()
 
 			pMainWindow->SetWindowTitle(Buff);
 
+			// The garbage collected by the submodules leaves the empty heap pages,
+			// return the ones that stayed empty for the last second
+			Memory::DefaultGlobalAllocator::Trim();
+
 			frameCounter = 0U;
 			timer.Clear();
 		}
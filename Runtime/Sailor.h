@@ -18,6 +18,8 @@ namespace Sailor
 		bool m_bRunConsole = true;
 		bool m_bIsEditor = false;
 		bool m_bEnableRenderValidationLayers = true;
+		bool m_bWorkStealing = true;
+		bool m_bFibers = false;
 
 		uint32_t m_editorPort = 32800;
 		HWND m_editorHwnd{};
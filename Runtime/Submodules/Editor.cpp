@@ -161,13 +161,13 @@ void Editor::PushMessage(const std::string& msg)
 		std::ostringstream oss;
 		oss << '[' << std::put_time(&localTime, "%H:%M:%S") << "] " << msg;
 
-		m_messagesQueue.push(oss.str());
+		m_messagesQueue.Push(oss.str());
 	}
 }
 
 bool Editor::PullMessage(std::string& msg)
 {
-	if (m_messagesQueue.try_pop(msg))
+	if (m_messagesQueue.TryPop(msg))
 	{
 		return true;
 	}
@@ -1,7 +1,7 @@
 #pragma once
 #include "Core/Submodule.h"
 #include "yaml-cpp/include/yaml-cpp/yaml.h"
-#include <concurrent_queue.h>
+#include "Containers/ConcurrentQueue.h"
 #include <wtypes.h>
 
 namespace Sailor
@@ -22,7 +22,7 @@ namespace Sailor
 		void PushMessage(const std::string& msg);
 		bool PullMessage(std::string& msg);
 
-		__forceinline size_t NumMessages() const { return m_messagesQueue.unsafe_size(); }
+		__forceinline size_t NumMessages() const { return m_messagesQueue.Num(); }
 
 		YAML::Node SerializeWorld() const;
 
@@ -36,7 +36,7 @@ namespace Sailor
 
 	protected:
 
-		concurrency::concurrent_queue<std::string> m_messagesQueue;
+		TConcurrentQueue<std::string> m_messagesQueue;
 
 		RECT m_windowRect{};
 		uint32_t m_editorPort;
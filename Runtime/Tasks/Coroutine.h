@@ -0,0 +1,246 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include "Sailor.h"
+#include "Memory/SharedPtr.hpp"
+#include "Tasks/Tasks.h"
+#include "Tasks/Scheduler.h"
+
+namespace Sailor
+{
+	namespace Tasks
+	{
+		/* The coroutine is executed as the single task on the scheduler.
+		*  co_await suspends the coroutine and enqueues its task again once the awaited task is finished
+		*  or on the requested thread type, so no thread is blocked and no tasks are allocated per step.
+		*  As the other tasks the coroutine doesn't start until it is run and it could be awaited/chained/joined as TaskPtr.
+		*
+		*  Tasks::Coroutine<TexturePtr> Load()
+		*  {
+		*      ByteCode data = Decode();                      // Worker thread
+		*      co_await Tasks::ResumeOn(EThreadType::RHI);
+		*      co_return CreateTexture(data);                 // RHI thread
+		*  }
+		*/
+
+		template<typename TResult = void>
+		class Coroutine;
+
+		// co_await Tasks::ResumeOn(EThreadType::RHI) continues the coroutine on the RHI thread
+		struct ResumeOn
+		{
+			ResumeOn(EThreadType thread) : m_thread(thread) {}
+
+			EThreadType m_thread;
+		};
+
+		// Owns the coroutine frame, each resume is the execution of the same task
+		template<typename TResult = void>
+		class CoroutineTask final : public Task<TResult, void>
+		{
+		public:
+
+			CoroutineTask(const std::string& name, EThreadType thread) : Task<TResult, void>(name, typename Task<TResult, void>::Function(), thread) {}
+
+			SAILOR_API virtual ~CoroutineTask() override
+			{
+				if (m_handle)
+				{
+					m_handle.destroy();
+				}
+			}
+
+			// The suspended coroutine is started already, it waits only for the awaited tasks
+			SAILOR_API bool IsReadyToStart() const override
+			{
+				return !ITask::IsFinished() && ITask::m_numBlockers == 0;
+			}
+
+			SAILOR_API void Execute() override
+			{
+				ITask::m_state |= ITask::StateMask::IsStartedBit;
+
+				// The coroutine could be enqueued and resumed by another thread before resume() returns,
+				// so nothing is touched after
+				m_handle.resume();
+			}
+
+			// Called from await_suspend
+			SAILOR_API void SuspendUntilFinished(const ITaskPtr& pTask)
+			{
+				ITaskPtr pSelf = ITask::m_self.Lock();
+
+				// The finished task is not joined, so the coroutine continues right away
+				pSelf->Join(pTask);
+				App::GetSubmodule<Scheduler>()->Resume(pSelf);
+			}
+
+			SAILOR_API void SuspendToThread(EThreadType thread)
+			{
+				ITask::m_threadType = thread;
+				App::GetSubmodule<Scheduler>()->Resume(ITask::m_self.Lock());
+			}
+
+			// Called from final_suspend, the frame lives until the task is destroyed
+			SAILOR_API void Finish()
+			{
+				Task<TResult, void>::PassResultToChainedTasks();
+				ITask::Complete();
+			}
+
+			static TSharedPtr<CoroutineTask> Create(std::coroutine_handle<> handle)
+			{
+				auto pTask = TSharedPtr<CoroutineTask>::Make("Coroutine", EThreadType::Worker);
+				pTask->m_self = pTask;
+				pTask->m_taskSyncBlockHandle = App::GetSubmodule<Scheduler>()->AcquireTaskSyncBlock();
+				pTask->m_handle = handle;
+
+				return pTask;
+			}
+
+		protected:
+
+			std::coroutine_handle<> m_handle;
+		};
+
+		namespace Internal
+		{
+			template<typename TTask>
+			struct TaskResultType { using Type = void; };
+
+			template<typename TResult, typename TArgs>
+			struct TaskResultType<Task<TResult, TArgs>> { using Type = TResult; };
+
+			template<typename TCoroutineResult, typename TTask>
+			struct TaskAwaiter
+			{
+				using TResult = typename TaskResultType<TTask>::Type;
+
+				CoroutineTask<TCoroutineResult>* m_pCoroutine = nullptr;
+				TSharedPtr<TTask> m_pTask;
+
+				bool await_ready() const { return !m_pTask || m_pTask->IsFinished(); }
+
+				void await_suspend(std::coroutine_handle<>)
+				{
+					// Nobody has run the awaited task
+					if (!m_pTask->IsInQueue() && !m_pTask->IsStarted())
+					{
+						m_pTask->Run();
+					}
+
+					m_pCoroutine->SuspendUntilFinished(m_pTask);
+				}
+
+				auto await_resume() const
+				{
+					if constexpr (NotVoid<TResult>)
+					{
+						return m_pTask->GetResult();
+					}
+				}
+			};
+
+			template<typename TCoroutineResult>
+			struct ThreadAwaiter
+			{
+				CoroutineTask<TCoroutineResult>* m_pCoroutine = nullptr;
+				EThreadType m_thread;
+
+				bool await_ready() const { return m_pCoroutine->GetThreadType() == m_thread; }
+				void await_suspend(std::coroutine_handle<>) { m_pCoroutine->SuspendToThread(m_thread); }
+				void await_resume() const {}
+			};
+
+			template<typename TResult>
+			class CoroutinePromise;
+
+			template<typename TResult>
+			class CoroutinePromiseBase
+			{
+			public:
+
+				struct FinalAwaiter
+				{
+					CoroutineTask<TResult>* m_pTask = nullptr;
+
+					bool await_ready() const noexcept { return false; }
+					void await_suspend(std::coroutine_handle<>) const noexcept { m_pTask->Finish(); }
+					void await_resume() const noexcept {}
+				};
+
+				Coroutine<TResult> get_return_object()
+				{
+					auto handle = std::coroutine_handle<CoroutinePromise<TResult>>::from_promise(static_cast<CoroutinePromise<TResult>&>(*this));
+					auto pTask = CoroutineTask<TResult>::Create(handle);
+					m_pTask = pTask.GetRawPtr();
+
+					return Coroutine<TResult>(std::move(pTask));
+				}
+
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+				FinalAwaiter final_suspend() const noexcept { return FinalAwaiter{ m_pTask }; }
+
+				void unhandled_exception() const { std::terminate(); }
+
+				// Only the scheduler resumes the coroutine, so only the tasks and the thread switches could be awaited
+				template<typename TAwaitedResult, typename TArgs>
+				TaskAwaiter<TResult, Task<TAwaitedResult, TArgs>> await_transform(const TaskPtr<TAwaitedResult, TArgs>& pTask) const { return { m_pTask, pTask }; }
+
+				TaskAwaiter<TResult, ITask> await_transform(const ITaskPtr& pTask) const { return { m_pTask, pTask }; }
+
+				template<typename TAwaitedResult>
+				TaskAwaiter<TResult, Task<TAwaitedResult, void>> await_transform(const Coroutine<TAwaitedResult>& coroutine) const { return { m_pTask, coroutine.GetTask() }; }
+
+				ThreadAwaiter<TResult> await_transform(ResumeOn resumeOn) const { return { m_pTask, resumeOn.m_thread }; }
+
+			protected:
+
+				CoroutineTask<TResult>* m_pTask = nullptr;
+			};
+
+			template<typename TResult>
+			class CoroutinePromise final : public CoroutinePromiseBase<TResult>
+			{
+			public:
+
+				void return_value(TResult value) { CoroutinePromiseBase<TResult>::m_pTask->m_result = std::move(value); }
+			};
+
+			template<>
+			class CoroutinePromise<void> final : public CoroutinePromiseBase<void>
+			{
+			public:
+
+				void return_void() {}
+			};
+		}
+
+		// Returned by the coroutine, the rest of the code sees the regular task
+		template<typename TResult>
+		class Coroutine final
+		{
+		public:
+
+			using promise_type = Internal::CoroutinePromise<TResult>;
+
+			Coroutine(TaskPtr<TResult> pTask) : m_pTask(std::move(pTask)) {}
+
+			operator TaskPtr<TResult>() const { return m_pTask; }
+			operator ITaskPtr() const { return m_pTask; }
+
+			const TaskPtr<TResult>& GetTask() const { return m_pTask; }
+
+			TaskPtr<TResult> Run()
+			{
+				m_pTask->Run();
+				return m_pTask;
+			}
+
+		protected:
+
+			TaskPtr<TResult> m_pTask;
+		};
+	}
+}
@@ -0,0 +1,127 @@
+#include "Fiber.h"
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace Sailor;
+using namespace Sailor::Tasks;
+
+struct Fiber::Platform
+{
+#ifdef _WIN32
+	static void WINAPI Entry(LPVOID pArg)
+	{
+		Fiber* pFiber = static_cast<Fiber*>(pArg);
+		pFiber->m_entry(pFiber->m_pArg);
+
+		// The thread would exit if the fiber returns
+		std::abort();
+	}
+#else
+	// makecontext passes only the int arguments
+	static void Entry(uint32_t low, uint32_t high)
+	{
+		Fiber* pFiber = reinterpret_cast<Fiber*>(((uintptr_t)high << 32) | (uintptr_t)low);
+		pFiber->m_entry(pFiber->m_pArg);
+
+		std::abort();
+	}
+#endif
+};
+
+Fiber* Fiber::ConvertCurrentThread(std::string name)
+{
+	Fiber* pFiber = new Fiber();
+	pFiber->m_name = std::move(name);
+
+#ifdef _WIN32
+	pFiber->m_pContext = ::ConvertThreadToFiber(nullptr);
+#else
+	// The context is filled on the first switch
+	pFiber->m_pContext = new ucontext_t();
+#endif
+
+	check(pFiber->m_pContext);
+
+	return pFiber;
+}
+
+void Fiber::RevertCurrentThread(Fiber* pThreadFiber)
+{
+#ifdef _WIN32
+	::ConvertFiberToThread();
+#else
+	delete static_cast<ucontext_t*>(pThreadFiber->m_pContext);
+#endif
+
+	delete pThreadFiber;
+}
+
+Fiber* Fiber::Create(std::string name, size_t stackSize, EntryFunction entry, void* pArg)
+{
+	Fiber* pFiber = new Fiber();
+	pFiber->m_name = std::move(name);
+	pFiber->m_entry = entry;
+	pFiber->m_pArg = pArg;
+
+#ifdef _WIN32
+	// Only the stack is reserved, the pages are committed on demand by the system
+	pFiber->m_stackSize = stackSize;
+	pFiber->m_pContext = ::CreateFiberEx(0, stackSize, 0, &Platform::Entry, pFiber);
+#else
+	// The guard page turns the stack overflow into the crash instead of the memory corruption
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	pFiber->m_stackSize = (stackSize + pageSize - 1) / pageSize * pageSize + pageSize;
+
+	void* pStack = mmap(nullptr, pFiber->m_stackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	check(pStack != MAP_FAILED);
+	mprotect(pStack, pageSize, PROT_NONE);
+	pFiber->m_pStack = pStack;
+
+	ucontext_t* pContext = new ucontext_t();
+	getcontext(pContext);
+	pContext->uc_stack.ss_sp = static_cast<uint8_t*>(pStack) + pageSize;
+	pContext->uc_stack.ss_size = pFiber->m_stackSize - pageSize;
+	pContext->uc_link = nullptr;
+
+	const uintptr_t address = reinterpret_cast<uintptr_t>(pFiber);
+	makecontext(pContext, reinterpret_cast<void(*)()>(&Platform::Entry), 2, (uint32_t)address, (uint32_t)(address >> 32));
+
+	pFiber->m_pContext = pContext;
+#endif
+
+	check(pFiber->m_pContext);
+
+	return pFiber;
+}
+
+void Fiber::Destroy(Fiber* pFiber)
+{
+#ifdef _WIN32
+	::DeleteFiber(pFiber->m_pContext);
+#else
+	delete static_cast<ucontext_t*>(pFiber->m_pContext);
+	munmap(pFiber->m_pStack, pFiber->m_stackSize);
+#endif
+
+	delete pFiber;
+}
+
+void Fiber::Switch(Fiber* pFrom, Fiber* pTo)
+{
+	check(pFrom != pTo);
+
+#ifdef _WIN32
+	(void)pFrom;
+	::SwitchToFiber(pTo->m_pContext);
+#else
+	swapcontext(static_cast<ucontext_t*>(pFrom->m_pContext), static_cast<ucontext_t*>(pTo->m_pContext));
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include "Core/Defines.h"
+
+namespace Sailor::Tasks
+{
+	// The execution context with its own stack that is switched cooperatively,
+	// Win32 fibers on Windows and ucontext on the other platforms.
+	// The fiber is created, switched and destroyed by the same thread, so the thread locals stay valid.
+	class Fiber final
+	{
+	public:
+
+		// The entry should never return, the fiber switches away at the end instead
+		using EntryFunction = void(*)(void* pArg);
+
+		// The thread has to be converted before it switches to the other fibers
+		SAILOR_API static Fiber* ConvertCurrentThread(std::string name);
+		SAILOR_API static void RevertCurrentThread(Fiber* pThreadFiber);
+
+		SAILOR_API static Fiber* Create(std::string name, size_t stackSize, EntryFunction entry, void* pArg);
+		SAILOR_API static void Destroy(Fiber* pFiber);
+
+		// Saves the current context to pFrom, returns once somebody switches back to pFrom
+		SAILOR_API static void Switch(Fiber* pFrom, Fiber* pTo);
+
+		SAILOR_API const std::string& GetName() const { return m_name; }
+
+	protected:
+
+		// The platform entry point, defined in the translation unit
+		struct Platform;
+
+		Fiber() = default;
+		~Fiber() = default;
+
+		std::string m_name;
+
+		// LPVOID of the fiber on Windows, ucontext_t on the other platforms
+		void* m_pContext = nullptr;
+
+		void* m_pStack = nullptr;
+		size_t m_stackSize = 0;
+
+		EntryFunction m_entry = nullptr;
+		void* m_pArg = nullptr;
+	};
+}
@@ -0,0 +1,154 @@
+#include "LightTask.h"
+#include <algorithm>
+#include "Core/Submodule.h"
+
+using namespace Sailor;
+using namespace Sailor::Tasks;
+
+LightTask::~LightTask()
+{
+	// The task that has never been executed still owns the callable
+	if (m_pInvoke)
+	{
+		m_pDestroy(m_storage);
+	}
+
+	delete m_pMoreSuccessors;
+}
+
+const char* LightTask::GetName() const
+{
+	return m_pName ? m_pName : m_nameHash.ToString().c_str();
+}
+
+void LightTask::Join(const LightTaskPtr& pDependency)
+{
+	check(!IsInQueue() && pDependency.GetRawPtr() != this);
+
+	m_numBlockers.fetch_add(1, std::memory_order_relaxed);
+	if (!pDependency.GetRawPtr()->AddSuccessor(this))
+	{
+		m_numBlockers.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void LightTask::Run()
+{
+	check(!IsInQueue());
+
+	m_state.fetch_or(StateMask::IsInQueueBit, std::memory_order_acq_rel);
+
+	auto scheduler = App::GetSubmodule<Scheduler>();
+	scheduler->OnTaskPending(m_threadType);
+
+	// Releases the guard that is taken on the creation
+	if (m_numBlockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		scheduler->Enqueue(this);
+	}
+}
+
+void LightTask::Run(DWORD threadId)
+{
+	check(!IsInQueue());
+
+	m_threadId = threadId;
+	m_threadType = App::GetSubmodule<Scheduler>()->GetThreadType(threadId);
+
+	Run();
+}
+
+void LightTask::Wait()
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	if (IsFinished())
+	{
+		return;
+	}
+
+	App::GetSubmodule<Scheduler>()->WaitUntilCompleted(m_syncBlock);
+}
+
+bool LightTask::AddSuccessor(LightTask* pSuccessor)
+{
+	m_syncBlock.Lock();
+	if (m_syncBlock.IsCompleted())
+	{
+		m_syncBlock.Unlock();
+		return false;
+	}
+
+	if (m_numSuccessors < NumInlineSuccessors)
+	{
+		m_successors[m_numSuccessors] = pSuccessor;
+	}
+	else
+	{
+		if (!m_pMoreSuccessors)
+		{
+			m_pMoreSuccessors = new TVector<LightTaskPtr>();
+		}
+
+		m_pMoreSuccessors->Add(LightTaskPtr(pSuccessor));
+	}
+
+	m_numSuccessors++;
+	m_syncBlock.Unlock();
+	return true;
+}
+
+void LightTask::OnDependencyFinished()
+{
+	if (m_numBlockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		App::GetSubmodule<Scheduler>()->Enqueue(this);
+	}
+}
+
+void LightTask::Execute()
+{
+	m_state.fetch_or(StateMask::IsStartedBit, std::memory_order_acq_rel);
+
+	m_pInvoke(m_storage);
+
+	// The captures are released before the successors are started
+	m_pDestroy(m_storage);
+	m_pInvoke = nullptr;
+
+	Complete();
+}
+
+void LightTask::Complete()
+{
+	m_syncBlock.Lock();
+	SuspendedFiber* pSuspended = m_syncBlock.CompleteAndUnlock();
+
+	// The successors are not added after the completion, so the list is owned by this thread now
+	for (uint32_t i = 0; i < (std::min)(m_numSuccessors, NumInlineSuccessors); i++)
+	{
+		LightTaskPtr pSuccessor = std::move(m_successors[i]);
+		pSuccessor->OnDependencyFinished();
+	}
+
+	if (m_pMoreSuccessors)
+	{
+		for (auto& pSuccessor : *m_pMoreSuccessors)
+		{
+			pSuccessor->OnDependencyFinished();
+		}
+
+		delete m_pMoreSuccessors;
+		m_pMoreSuccessors = nullptr;
+	}
+
+	m_numSuccessors = 0;
+
+	while (pSuspended)
+	{
+		// The node is on the stack of the fiber, so it could be gone once the fiber is resumed
+		SuspendedFiber* pNext = pSuspended->m_pNext;
+		pSuspended->m_pWorker->ResumeFiber(pSuspended->m_pFiber);
+		pSuspended = pNext;
+	}
+}
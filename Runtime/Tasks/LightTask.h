@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Core/StringHash.h"
+#include "Memory/RefPtr.hpp"
+#include "Memory/SlabAllocator.hpp"
+#include "Containers/Vector.h"
+#include "Tasks/TaskSyncBlock.h"
+#include "Tasks/Scheduler.h"
+
+namespace Sailor::Tasks
+{
+	class LightTask;
+	using LightTaskPtr = TRefPtr<LightTask>;
+
+	template<typename TLambda>
+	LightTaskPtr CreateLightTask(const char* name, TLambda&& lambda, EThreadType thread = EThreadType::Worker, ETaskPriority priority = ETaskPriority::Normal);
+
+	template<typename TLambda>
+	LightTaskPtr CreateLightTask(StringHash name, TLambda&& lambda, EThreadType thread = EThreadType::Worker, ETaskPriority priority = ETaskPriority::Normal);
+
+	/* The light task is the unit of the fine-grained work (the helpers of ParallelFor, the small jobs spawned by thousands per frame).
+	*  The creation costs the single block from the per thread slab: the callable is stored inline (the big ones fall back to the heap),
+	*  the name is not copied and the counter of the references lives in the task.
+	*  There are no results and no chaining, the task could only wait for the other light tasks,
+	*  it is enqueued once all of them are finished, so the queues never hold the blocked light tasks.
+	*/
+	class LightTask final : public TRefBase
+	{
+	public:
+
+		// The size class of the slab allocator that is shared with the small objects
+		static constexpr size_t BlockSize = 256;
+		static constexpr size_t InlineStorageSize = 128;
+		static constexpr uint32_t NumInlineSuccessors = 2;
+
+		SAILOR_API virtual ~LightTask() override;
+
+		// Static string or the resolved hash, the hash should be registered in the hashed strings table
+		SAILOR_API const char* GetName() const;
+
+		SAILOR_API EThreadType GetThreadType() const { return m_threadType; }
+		SAILOR_API ETaskPriority GetPriority() const { return m_priority; }
+
+		SAILOR_API bool IsInQueue() const { return m_state.load(std::memory_order_acquire) & StateMask::IsInQueueBit; }
+		SAILOR_API bool IsStarted() const { return m_state.load(std::memory_order_acquire) & StateMask::IsStartedBit; }
+		SAILOR_API bool IsFinished() const { return m_syncBlock.IsCompleted(); }
+
+		// Wait other task's completion before start, should be called before Run
+		SAILOR_API void Join(const LightTaskPtr& pDependency);
+
+		// The task is enqueued once the dependencies are finished
+		SAILOR_API void Run();
+
+		// The same, but the task is executed by the thread with the id (the resources that are bound to the thread)
+		SAILOR_API void Run(DWORD threadId);
+
+		// Lock this thread while task is executing, the worker continues with the other tasks in the fiber mode
+		SAILOR_API void Wait();
+
+		static void* operator new(size_t size)
+		{
+			check(size <= BlockSize);
+			return Memory::TSlabAllocator<BlockSize>::allocate();
+		}
+
+		static void operator delete(void* ptr) { Memory::TSlabAllocator<BlockSize>::free(ptr); }
+
+	protected:
+
+		enum StateMask : uint8_t
+		{
+			IsInQueueBit = (uint8_t)(1),
+			IsStartedBit = (uint8_t)(1 << 1)
+		};
+
+		using InvokeFunc = void(*)(void* pStorage);
+
+		LightTask(EThreadType thread, ETaskPriority priority) : m_threadType(thread), m_priority(priority) {}
+
+		template<typename TLambda>
+		void SetCallable(TLambda&& lambda)
+		{
+			using TCallable = std::decay_t<TLambda>;
+
+			if constexpr (sizeof(TCallable) <= InlineStorageSize && alignof(TCallable) <= alignof(std::max_align_t))
+			{
+				new (m_storage) TCallable(std::forward<TLambda>(lambda));
+				m_pInvoke = [](void* pStorage) { (*static_cast<TCallable*>(pStorage))(); };
+				m_pDestroy = [](void* pStorage) { static_cast<TCallable*>(pStorage)->~TCallable(); };
+			}
+			else
+			{
+				new (m_storage) TCallable*(new TCallable(std::forward<TLambda>(lambda)));
+				m_pInvoke = [](void* pStorage) { (**static_cast<TCallable**>(pStorage))(); };
+				m_pDestroy = [](void* pStorage) { delete *static_cast<TCallable**>(pStorage); };
+			}
+		}
+
+		SAILOR_API void Execute();
+		SAILOR_API void Complete();
+
+		// Returns false if the task is already finished
+		SAILOR_API bool AddSuccessor(LightTask* pSuccessor);
+		SAILOR_API void OnDependencyFinished();
+
+		// The storage goes first to keep its alignment
+		alignas(std::max_align_t) uint8_t m_storage[InlineStorageSize];
+		InvokeFunc m_pInvoke = nullptr;
+		InvokeFunc m_pDestroy = nullptr;
+
+		TaskSyncBlock m_syncBlock;
+
+		// The tasks that wait for this one, guarded by m_syncBlock
+		LightTaskPtr m_successors[NumInlineSuccessors];
+		TVector<LightTaskPtr>* m_pMoreSuccessors = nullptr;
+		uint32_t m_numSuccessors = 0;
+
+		// Unfinished dependencies + 1 until the task is run
+		std::atomic<uint32_t> m_numBlockers = 1;
+
+		EThreadType m_threadType;
+		ETaskPriority m_priority;
+		std::atomic<uint8_t> m_state = 0;
+
+		// Any thread of m_threadType if 0
+		DWORD m_threadId = 0;
+
+		const char* m_pName = nullptr;
+		StringHash m_nameHash{};
+
+		// The queue wait latency is measured from it
+		int64_t m_enqueueTimeNs = 0;
+
+		// Keeps the task alive while it is in the lock-free queues that store the raw pointers
+		LightTaskPtr m_pQueueReference;
+
+		friend class Scheduler;
+		friend class WorkerThread;
+
+		template<typename TLambda>
+		friend LightTaskPtr CreateLightTask(const char* name, TLambda&& lambda, EThreadType thread, ETaskPriority priority);
+
+		template<typename TLambda>
+		friend LightTaskPtr CreateLightTask(StringHash name, TLambda&& lambda, EThreadType thread, ETaskPriority priority);
+	};
+
+	template<typename TLambda>
+	LightTaskPtr CreateLightTask(const char* name, TLambda&& lambda, EThreadType thread, ETaskPriority priority)
+	{
+		static_assert(sizeof(LightTask) <= LightTask::BlockSize, "LightTask doesn't fit the block, decrease LightTask::InlineStorageSize");
+
+		LightTaskPtr task(new LightTask(thread, priority));
+		task->m_pName = name;
+		task->SetCallable(std::forward<TLambda>(lambda));
+		return task;
+	}
+
+	template<typename TLambda>
+	LightTaskPtr CreateLightTask(StringHash name, TLambda&& lambda, EThreadType thread, ETaskPriority priority)
+	{
+		LightTaskPtr task = CreateLightTask(static_cast<const char*>(nullptr), std::forward<TLambda>(lambda), thread, priority);
+		task->m_nameHash = name;
+		return task;
+	}
+}
@@ -0,0 +1,336 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Memory/SharedPtr.hpp"
+#include "Tasks/Tasks.h"
+#include "Tasks/LightTask.h"
+#include "Tasks/Scheduler.h"
+
+namespace Sailor::Tasks
+{
+	// The amount of the threads that could take the part of the single range
+	constexpr uint32_t MaxParallelForParticipants = 64;
+
+	namespace Internal
+	{
+		// The part of the range that belongs to the participant, [begin, end) is packed into the single atomic.
+		// The owner takes the chunks from the front, the idle participants split off the back half.
+		struct alignas(64) ParallelForSlot
+		{
+			static __forceinline uint64_t Pack(uint32_t begin, uint32_t end) { return ((uint64_t)begin << 32) | end; }
+			static __forceinline uint32_t GetBegin(uint64_t range) { return (uint32_t)(range >> 32); }
+			static __forceinline uint32_t GetEnd(uint64_t range) { return (uint32_t)range; }
+
+			__forceinline uint32_t GetNumLeft() const
+			{
+				const uint64_t range = m_range.load(std::memory_order_relaxed);
+				return GetEnd(range) > GetBegin(range) ? GetEnd(range) - GetBegin(range) : 0;
+			}
+
+			// Owner only
+			bool TryTakeChunk(uint32_t grainSize, uint32_t& outBegin, uint32_t& outEnd)
+			{
+				uint64_t range = m_range.load(std::memory_order_acquire);
+				while (true)
+				{
+					const uint32_t begin = GetBegin(range);
+					const uint32_t end = GetEnd(range);
+
+					if (begin >= end)
+					{
+						return false;
+					}
+
+					const uint32_t chunkEnd = begin + (std::min)(grainSize, end - begin);
+					if (m_range.compare_exchange_weak(range, Pack(chunkEnd, end), std::memory_order_acq_rel, std::memory_order_acquire))
+					{
+						outBegin = begin;
+						outEnd = chunkEnd;
+						return true;
+					}
+				}
+			}
+
+			// Any thread, the split happens only if there is more than one chunk left
+			bool TrySplit(uint32_t grainSize, uint32_t& outBegin, uint32_t& outEnd)
+			{
+				uint64_t range = m_range.load(std::memory_order_acquire);
+				while (true)
+				{
+					const uint32_t begin = GetBegin(range);
+					const uint32_t end = GetEnd(range);
+
+					if (begin >= end || end - begin <= grainSize)
+					{
+						return false;
+					}
+
+					const uint32_t middle = begin + (end - begin + 1) / 2;
+					if (m_range.compare_exchange_weak(range, Pack(begin, middle), std::memory_order_acq_rel, std::memory_order_acquire))
+					{
+						outBegin = middle;
+						outEnd = end;
+						return true;
+					}
+				}
+			}
+
+			std::atomic<uint64_t> m_range{ 0 };
+		};
+
+		struct ParallelForState
+		{
+			ParallelForSlot m_slots[MaxParallelForParticipants];
+
+			std::atomic<uint32_t> m_numParticipants{ 1 };
+			std::atomic<uint32_t> m_numProcessed{ 0 };
+			std::atomic<bool> m_bIsHelperPending{ false };
+
+			uint32_t m_num = 0;
+			uint32_t m_grainSize = 1;
+			uint32_t m_maxParticipants = 1;
+
+			// The helpers have the priority of the caller
+			ETaskPriority m_priority = ETaskPriority::Normal;
+
+			// Moves the biggest part of the others to the participant's slot
+			bool TrySteal(uint32_t participant)
+			{
+				const uint32_t numParticipants = (std::min)(m_numParticipants.load(std::memory_order_acquire), m_maxParticipants);
+
+				while (true)
+				{
+					uint32_t victim = participant;
+					uint32_t numLeft = m_grainSize;
+
+					for (uint32_t i = 0; i < numParticipants; i++)
+					{
+						const uint32_t left = m_slots[i].GetNumLeft();
+						if (i != participant && left > numLeft)
+						{
+							victim = i;
+							numLeft = left;
+						}
+					}
+
+					if (victim == participant)
+					{
+						return false;
+					}
+
+					uint32_t begin = 0;
+					uint32_t end = 0;
+					if (m_slots[victim].TrySplit(m_grainSize, begin, end))
+					{
+						m_slots[participant].m_range.store(ParallelForSlot::Pack(begin, end), std::memory_order_release);
+						return true;
+					}
+				}
+			}
+
+			template<typename TFunction>
+			void Participate(uint32_t participant, TFunction& func)
+			{
+				ParallelForSlot& slot = m_slots[participant];
+
+				do
+				{
+					uint32_t begin = 0;
+					uint32_t end = 0;
+					while (slot.TryTakeChunk(m_grainSize, begin, end))
+					{
+						func(participant, (size_t)begin, (size_t)end);
+
+						if (m_numProcessed.fetch_add(end - begin, std::memory_order_acq_rel) + (end - begin) == m_num)
+						{
+							m_numProcessed.notify_all();
+						}
+					}
+				} while (TrySteal(participant));
+			}
+		};
+
+		// Returns the grain size and the max amount of the participants (the calling thread included),
+		// single participant means the range should be processed inline
+		__forceinline void GetParallelForSettings(size_t num, size_t grainSize, uint32_t& outGrainSize, uint32_t& outMaxParticipants)
+		{
+			auto* pScheduler = App::GetSubmodule<Scheduler>();
+			uint32_t numThreads = 1;
+			if (pScheduler)
+			{
+				// The calling thread is the extra participant only if it is not the one of the workers
+				const WorkerThread* pCurrentWorker = pScheduler->GetCurrentWorkerThread();
+				const bool bIsWorker = pCurrentWorker && pCurrentWorker->GetThreadType() == EThreadType::Worker;
+				numThreads = (std::max)(pScheduler->GetNumWorkerThreads(EThreadType::Worker) + (bIsWorker ? 0u : 1u), 1u);
+			}
+
+			// Enough chunks to balance the uneven work, the chunks could be split only by the idle threads anyway
+			if (grainSize == 0)
+			{
+				grainSize = (std::max)(num / ((size_t)numThreads * 8), (size_t)1);
+			}
+
+			check(num <= UINT32_MAX);
+
+			outGrainSize = (uint32_t)(std::min)(grainSize, num);
+			outMaxParticipants = (uint32_t)(std::min)({ (size_t)numThreads, (size_t)MaxParallelForParticipants, (num + outGrainSize - 1) / outGrainSize });
+		}
+
+		// The helper joins only if there is something to split, and only then brings the next one.
+		// So at most one helper is waiting in the queue and the range is split as fast as the workers become idle.
+		// The late helper could outlive the call, it touches func only after the successful split,
+		// that is impossible once the whole range is taken.
+		// The helpers are the light tasks, so spawning them doesn't allocate.
+		template<typename TFunction>
+		void RunParallelForHelper(const char* name, const TSharedPtr<ParallelForState>& pState, TFunction& func)
+		{
+			ParallelForState& state = *pState.GetRawPtr();
+
+			if (state.m_numParticipants.load(std::memory_order_relaxed) >= state.m_maxParticipants ||
+				state.m_bIsHelperPending.exchange(true, std::memory_order_acq_rel))
+			{
+				return;
+			}
+
+			Tasks::CreateLightTask(name, [pState, name, &func]()
+				{
+					ParallelForState& state = *pState.GetRawPtr();
+					state.m_bIsHelperPending.store(false, std::memory_order_release);
+
+					if (state.m_numProcessed.load(std::memory_order_acquire) == state.m_num)
+					{
+						return;
+					}
+
+					const uint32_t participant = state.m_numParticipants.fetch_add(1, std::memory_order_acq_rel);
+					if (participant >= state.m_maxParticipants || !state.TrySteal(participant))
+					{
+						return;
+					}
+
+					RunParallelForHelper(name, pState, func);
+					state.Participate(participant, func);
+				}, EThreadType::Worker, state.m_priority)->Run();
+		}
+
+		// Runs func(participant, begin, end) over [0, num) on the calling thread and on the idle worker threads.
+		// The calling thread processes the range inline and waits only for the parts taken by the helpers,
+		// so that is safe to call from the worker threads.
+		template<typename TFunction>
+		void RunParallelFor(const char* name, size_t num, uint32_t grainSize, uint32_t maxParticipants, TFunction&& func)
+		{
+			if (num == 0)
+			{
+				return;
+			}
+
+			if (maxParticipants <= 1)
+			{
+				func(0u, (size_t)0, num);
+				return;
+			}
+
+			TSharedPtr<ParallelForState> pState = TSharedPtr<ParallelForState>::Make();
+			pState->m_num = (uint32_t)num;
+			pState->m_grainSize = grainSize;
+			pState->m_maxParticipants = maxParticipants;
+			pState->m_priority = App::GetSubmodule<Scheduler>()->GetCurrentTaskPriority();
+			pState->m_slots[0].m_range.store(ParallelForSlot::Pack(0, (uint32_t)num), std::memory_order_release);
+
+			RunParallelForHelper(name, pState, func);
+			pState->Participate(0, func);
+
+			uint32_t numProcessed = 0;
+			while ((numProcessed = pState->m_numProcessed.load(std::memory_order_acquire)) != pState->m_num)
+			{
+				pState->m_numProcessed.wait(numProcessed, std::memory_order_acquire);
+			}
+		}
+	}
+
+	// Calls body(i) or body(begin, end) for the whole [begin, end), the range is split only when there are idle workers.
+	// The grain size is the minimal amount of the items processed at once, 0 picks it by the range and the amount of the threads.
+	// Falls back to the serial loop without the scheduler.
+	template<typename TBody>
+	void ParallelFor(const char* name, size_t begin, size_t end, TBody&& body, size_t grainSize = 0)
+	{
+		SAILOR_PROFILE_FUNCTION();
+
+		const size_t num = end > begin ? end - begin : 0;
+
+		uint32_t grain = 1;
+		uint32_t maxParticipants = 1;
+		Internal::GetParallelForSettings(num, grainSize, grain, maxParticipants);
+
+		Internal::RunParallelFor(name, num, grain, maxParticipants, [&body, begin](uint32_t, size_t first, size_t last)
+			{
+				if constexpr (std::is_invocable_v<TBody&, size_t, size_t>)
+				{
+					body(begin + first, begin + last);
+				}
+				else
+				{
+					for (size_t i = begin + first; i < begin + last; i++)
+					{
+						body(i);
+					}
+				}
+			});
+	}
+
+	template<typename TBody>
+	void ParallelFor(size_t begin, size_t end, TBody&& body, size_t grainSize = 0)
+	{
+		ParallelFor("Parallel for", begin, end, std::forward<TBody>(body), grainSize);
+	}
+
+	// Calls body(begin, end, accumulator) for the parts of [begin, end), each thread has its own accumulator that starts from the identity.
+	// The accumulators are merged with combine(lhs, rhs) on the calling thread,
+	// the order of the items is not preserved so combine should be associative and commutative.
+	template<typename TResult, typename TBody, typename TCombine>
+	TResult ParallelReduce(const char* name, size_t begin, size_t end, const TResult& identity, TBody&& body, TCombine&& combine, size_t grainSize = 0)
+	{
+		SAILOR_PROFILE_FUNCTION();
+
+		// The padding keeps the neighbours out of the cache line, TVector doesn't respect the over alignment
+		struct Accumulator
+		{
+			TResult m_value;
+			uint8_t m_padding[64];
+		};
+
+		const size_t num = end > begin ? end - begin : 0;
+
+		uint32_t grain = 1;
+		uint32_t maxParticipants = 1;
+		Internal::GetParallelForSettings(num, grainSize, grain, maxParticipants);
+
+		TVector<Accumulator> accumulators;
+		accumulators.Reserve(maxParticipants);
+		for (uint32_t i = 0; i < maxParticipants; i++)
+		{
+			accumulators.Add(Accumulator{ identity, {} });
+		}
+
+		Internal::RunParallelFor(name, num, grain, maxParticipants, [&body, &accumulators, begin](uint32_t participant, size_t first, size_t last)
+			{
+				body(begin + first, begin + last, accumulators[participant].m_value);
+			});
+
+		TResult res = std::move(accumulators[0].m_value);
+		for (uint32_t i = 1; i < maxParticipants; i++)
+		{
+			res = combine(std::move(res), std::move(accumulators[i].m_value));
+		}
+
+		return res;
+	}
+
+	template<typename TResult, typename TBody, typename TCombine>
+	TResult ParallelReduce(size_t begin, size_t end, const TResult& identity, TBody&& body, TCombine&& combine, size_t grainSize = 0)
+	{
+		return ParallelReduce("Parallel reduce", begin, end, identity, std::forward<TBody>(body), std::forward<TCombine>(combine), grainSize);
+	}
+}
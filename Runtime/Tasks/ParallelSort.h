@@ -0,0 +1,330 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include "Core/Defines.h"
+#include "Containers/Vector.h"
+#include "Memory/SharedPtr.hpp"
+#include "Tasks/Tasks.h"
+#include "Tasks/Scheduler.h"
+#include "Tasks/ParallelFor.h"
+
+namespace Sailor::Tasks
+{
+	// Below that amount the task overhead is bigger than the gain, so the sorting is serial
+	constexpr size_t ParallelSortThreshold = 16384;
+
+	namespace Internal
+	{
+		__forceinline uint32_t GetNumSortChunks(size_t num)
+		{
+			auto* pScheduler = App::GetSubmodule<Scheduler>();
+			if (!pScheduler || num < ParallelSortThreshold)
+			{
+				return 1;
+			}
+
+			// The calling thread takes the chunks as well
+			const size_t numThreads = (size_t)pScheduler->GetNumWorkerThreads() + 1;
+			const size_t numChunks = (std::min)(numThreads, num / (ParallelSortThreshold / 2));
+
+			return (uint32_t)std::bit_floor((std::max)(numChunks, (size_t)1));
+		}
+
+		// Runs func(chunkIndex) for each chunk on the worker threads and on the calling thread.
+		// The calling thread waits only for the chunks that are taken by the others,
+		// so that is safe to call from the worker threads.
+		template<typename TFunction>
+		void RunChunks(const char* name, uint32_t numChunks, TFunction&& func)
+		{
+			const uint32_t maxParticipants = (std::min)(numChunks, MaxParallelForParticipants);
+
+			RunParallelFor(name, numChunks, 1, maxParticipants, [&func](uint32_t, size_t begin, size_t end)
+				{
+					for (size_t chunk = begin; chunk < end; chunk++)
+					{
+						func((uint32_t)chunk);
+					}
+				});
+		}
+
+		// Maps the key to the unsigned integer with the same order
+		template<typename TKey>
+		__forceinline auto ToRadixKey(TKey key)
+		{
+			if constexpr (std::is_floating_point_v<TKey>)
+			{
+				using TBits = std::conditional_t<sizeof(TKey) == 4, uint32_t, uint64_t>;
+				constexpr TBits SignBit = TBits(1) << (sizeof(TBits) * 8 - 1);
+
+				const TBits bits = std::bit_cast<TBits>(key);
+				return (bits & SignBit) ? ~bits : (bits | SignBit);
+			}
+			else if constexpr (std::is_signed_v<TKey>)
+			{
+				using TBits = std::make_unsigned_t<TKey>;
+				constexpr TBits SignBit = TBits(1) << (sizeof(TBits) * 8 - 1);
+
+				return (TBits)key ^ SignBit;
+			}
+			else
+			{
+				static_assert(std::is_unsigned_v<TKey>, "Radix key should be integral or floating point");
+				return key;
+			}
+		}
+
+		template<typename TKey, typename TBits>
+		__forceinline TKey FromRadixKey(TBits bits)
+		{
+			if constexpr (std::is_floating_point_v<TKey>)
+			{
+				constexpr TBits SignBit = TBits(1) << (sizeof(TBits) * 8 - 1);
+				return std::bit_cast<TKey>((bits & SignBit) ? (bits & ~SignBit) : ~bits);
+			}
+			else if constexpr (std::is_signed_v<TKey>)
+			{
+				constexpr TBits SignBit = TBits(1) << (sizeof(TBits) * 8 - 1);
+				return (TKey)(bits ^ SignBit);
+			}
+			else
+			{
+				return bits;
+			}
+		}
+
+		// LSD radix sort by bytes, the payload (if any) follows the keys.
+		// The passes with the same byte for all keys are skipped.
+		// Returns true if the result is in the temporary buffers (odd amount of the performed passes).
+		template<typename TBits, typename TPayload>
+		bool RadixSort(TBits* keys, TPayload* payload, TBits* tmpKeys, TPayload* tmpPayload, size_t num)
+		{
+			constexpr uint32_t NumBuckets = 256;
+			constexpr uint32_t NumPasses = sizeof(TBits);
+			constexpr bool bHasPayload = !std::is_same_v<TPayload, std::nullptr_t>;
+
+			const uint32_t numChunks = GetNumSortChunks(num);
+			const size_t chunkSize = (num + numChunks - 1) / numChunks;
+
+			TVector<size_t> histograms;
+			histograms.AddUninitialized((size_t)numChunks * NumBuckets);
+
+			bool bSwapped = false;
+
+			for (uint32_t pass = 0; pass < NumPasses; pass++)
+			{
+				const uint32_t shift = pass * 8;
+
+				memset(histograms.GetData(), 0, histograms.Num() * sizeof(size_t));
+
+				RunChunks("Radix sort histogram", numChunks, [&](uint32_t chunk)
+					{
+						size_t* pHistogram = &histograms[(size_t)chunk * NumBuckets];
+						const size_t end = (std::min)(num, (chunk + 1) * chunkSize);
+
+						for (size_t i = chunk * chunkSize; i < end; i++)
+						{
+							pHistogram[(keys[i] >> shift) & 0xFF]++;
+						}
+					});
+
+				// Skip the pass if all keys have the same digit
+				bool bSkipPass = false;
+				for (uint32_t bucket = 0; bucket < NumBuckets; bucket++)
+				{
+					size_t total = 0;
+					for (uint32_t chunk = 0; chunk < numChunks; chunk++)
+					{
+						total += histograms[(size_t)chunk * NumBuckets + bucket];
+					}
+
+					if (total == num)
+					{
+						bSkipPass = true;
+						break;
+					}
+
+					if (total != 0)
+					{
+						break;
+					}
+				}
+
+				if (bSkipPass)
+				{
+					continue;
+				}
+
+				// Exclusive prefix sum over (bucket, chunk) keeps the sort stable
+				size_t offset = 0;
+				for (uint32_t bucket = 0; bucket < NumBuckets; bucket++)
+				{
+					for (uint32_t chunk = 0; chunk < numChunks; chunk++)
+					{
+						size_t& count = histograms[(size_t)chunk * NumBuckets + bucket];
+						const size_t value = count;
+						count = offset;
+						offset += value;
+					}
+				}
+
+				RunChunks("Radix sort scatter", numChunks, [&](uint32_t chunk)
+					{
+						size_t* pOffsets = &histograms[(size_t)chunk * NumBuckets];
+						const size_t end = (std::min)(num, (chunk + 1) * chunkSize);
+
+						for (size_t i = chunk * chunkSize; i < end; i++)
+						{
+							const size_t dst = pOffsets[(keys[i] >> shift) & 0xFF]++;
+							tmpKeys[dst] = keys[i];
+
+							if constexpr (bHasPayload)
+							{
+								tmpPayload[dst] = payload[i];
+							}
+						}
+					});
+
+				bSwapped = !bSwapped;
+				std::swap(keys, tmpKeys);
+				if constexpr (bHasPayload)
+				{
+					std::swap(payload, tmpPayload);
+				}
+			}
+
+			return bSwapped;
+		}
+	}
+
+	// Stable sort, the chunks are sorted in parallel and then merged pairwise in parallel.
+	// Falls back to the serial sort for the small inputs or without the scheduler.
+	template<typename TElementType, typename TAllocator, typename TGrowthPolicy, typename TCompare = std::less<TElementType>>
+	void ParallelSort(TVector<TElementType, TAllocator, TGrowthPolicy>& elements, TCompare compare = TCompare())
+	{
+		SAILOR_PROFILE_FUNCTION();
+
+		const size_t num = elements.Num();
+		const uint32_t numChunks = Internal::GetNumSortChunks(num);
+
+		TElementType* pData = elements.GetData();
+
+		if (numChunks <= 1)
+		{
+			std::stable_sort(pData, pData + num, compare);
+			return;
+		}
+
+		const size_t chunkSize = (num + numChunks - 1) / numChunks;
+
+		Internal::RunChunks("Parallel sort", numChunks, [&](uint32_t chunk)
+			{
+				const size_t begin = (std::min)(num, chunk * chunkSize);
+				const size_t end = (std::min)(num, (chunk + 1) * chunkSize);
+
+				std::stable_sort(pData + begin, pData + end, compare);
+			});
+
+		for (size_t width = chunkSize; width < num; width *= 2)
+		{
+			const uint32_t numMerges = (uint32_t)((num + 2 * width - 1) / (2 * width));
+
+			Internal::RunChunks("Parallel merge", numMerges, [&](uint32_t merge)
+				{
+					const size_t begin = merge * 2 * width;
+					const size_t middle = (std::min)(num, begin + width);
+					const size_t end = (std::min)(num, begin + 2 * width);
+
+					if (middle < end)
+					{
+						std::inplace_merge(pData + begin, pData + middle, pData + end, compare);
+					}
+				});
+		}
+	}
+
+	// Stable radix sort by the integral or floating point key: keyExtractor(element) -> key.
+	// The elements are moved once into the sorted order after the keys are sorted.
+	template<typename TElementType, typename TAllocator, typename TGrowthPolicy, typename TKeyExtractor>
+	void RadixSort(TVector<TElementType, TAllocator, TGrowthPolicy>& elements, TKeyExtractor&& keyExtractor)
+	{
+		SAILOR_PROFILE_FUNCTION();
+
+		using TKey = std::decay_t<decltype(keyExtractor(elements[0]))>;
+		using TBits = decltype(Internal::ToRadixKey(TKey()));
+
+		const size_t num = elements.Num();
+		if (num < 2)
+		{
+			return;
+		}
+
+		check(num <= std::numeric_limits<uint32_t>::max());
+
+		TVector<TBits> keys;
+		TVector<TBits> tmpKeys;
+		TVector<uint32_t> indices;
+		TVector<uint32_t> tmpIndices;
+
+		keys.AddUninitialized(num);
+		tmpKeys.AddUninitialized(num);
+		indices.AddUninitialized(num);
+		tmpIndices.AddUninitialized(num);
+
+		for (size_t i = 0; i < num; i++)
+		{
+			keys[i] = Internal::ToRadixKey(keyExtractor(elements[i]));
+			indices[i] = (uint32_t)i;
+		}
+
+		const bool bSwapped = Internal::RadixSort(keys.GetData(), indices.GetData(), tmpKeys.GetData(), tmpIndices.GetData(), num);
+		const TVector<uint32_t>& order = bSwapped ? tmpIndices : indices;
+
+		TVector<TElementType, TAllocator, TGrowthPolicy> sorted;
+		sorted.Reserve(num);
+
+		for (size_t i = 0; i < num; i++)
+		{
+			sorted.Emplace(std::move(elements[order[i]]));
+		}
+
+		TVector<TElementType, TAllocator, TGrowthPolicy>::Swap(elements, sorted);
+	}
+
+	// Radix sort of the integral or floating point elements
+	template<typename TElementType, typename TAllocator, typename TGrowthPolicy>
+	void RadixSort(TVector<TElementType, TAllocator, TGrowthPolicy>& elements) requires std::is_arithmetic_v<TElementType>
+	{
+		SAILOR_PROFILE_FUNCTION();
+
+		using TBits = decltype(Internal::ToRadixKey(TElementType()));
+
+		const size_t num = elements.Num();
+		if (num < 2)
+		{
+			return;
+		}
+
+		TVector<TBits> keys;
+		TVector<TBits> tmpKeys;
+
+		keys.AddUninitialized(num);
+		tmpKeys.AddUninitialized(num);
+
+		for (size_t i = 0; i < num; i++)
+		{
+			keys[i] = Internal::ToRadixKey(elements[i]);
+		}
+
+		const bool bSwapped = Internal::RadixSort<TBits, std::nullptr_t>(keys.GetData(), nullptr, tmpKeys.GetData(), nullptr, num);
+		const TVector<TBits>& result = bSwapped ? tmpKeys : keys;
+
+		for (size_t i = 0; i < num; i++)
+		{
+			elements[i] = Internal::FromRadixKey<TElementType>(result[i]);
+		}
+	}
+}
@@ -10,23 +10,113 @@
 #include "Core/StringHash.h"
 
 #include "Tasks/Tasks.h"
+#include "Tasks/LightTask.h"
 #include "Memory/SharedPtr.hpp"
 
 using namespace std;
 using namespace Sailor;
 using namespace Sailor::Tasks;
 
+namespace
+{
+	thread_local WorkerThread* t_pCurrentWorkerThread = nullptr;
+}
+
+void WorkerParkingLot::PrepareToPark(WorkerThread* pWorker)
+{
+	{
+		const std::lock_guard<std::mutex> lock(m_mutex);
+		m_parked.Add(pWorker);
+		m_numParked.fetch_add(1, std::memory_order_seq_cst);
+	}
+
+	// The queues are re-checked after the registration is visible
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool WorkerParkingLot::CancelPark(WorkerThread* pWorker)
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+
+	const auto index = m_parked.Find(pWorker);
+	if (index == -1)
+	{
+		return false;
+	}
+
+	m_parked.RemoveAtSwap(index);
+	m_numParked.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool WorkerParkingLot::UnparkOne()
+{
+	// The task is published before the check
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_numParked.load(std::memory_order_relaxed) == 0)
+	{
+		return false;
+	}
+
+	WorkerThread* pWorker = nullptr;
+	{
+		const std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_parked.Num() == 0)
+		{
+			return false;
+		}
+
+		// The last parked worker has the warmest cache
+		pWorker = m_parked[m_parked.Num() - 1];
+		m_parked.RemoveLast();
+		m_numParked.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	pWorker->Wake();
+	return true;
+}
+
+bool WorkerParkingLot::Unpark(WorkerThread* pWorker)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_numParked.load(std::memory_order_relaxed) == 0)
+	{
+		return false;
+	}
+
+	if (!CancelPark(pWorker))
+	{
+		return false;
+	}
+
+	pWorker->Wake();
+	return true;
+}
+
+void WorkerParkingLot::UnparkAll()
+{
+	TVector<WorkerThread*> parked;
+	{
+		const std::lock_guard<std::mutex> lock(m_mutex);
+		std::swap(parked, m_parked);
+		m_numParked.store(0, std::memory_order_relaxed);
+	}
+
+	for (auto& pWorker : parked)
+	{
+		pWorker->Wake();
+	}
+}
+
 WorkerThread::WorkerThread(
 	std::string threadName,
 	EThreadType threadType,
-	std::condition_variable& refresh,
-	std::mutex& mutex,
-	TVector<ITaskPtr>& pTasksQueue) :
+	WorkerParkingLot& parkingLot,
+	bool bFibers) :
 	m_threadName(std::move(threadName)),
 	m_threadType(threadType),
-	m_refresh(refresh),
-	m_sharedQueueMutex(mutex),
-	m_pSharedTaskQueue(pTasksQueue)
+	m_bFibers(bFibers),
+	m_parkingLot(parkingLot)
 {
 	m_pThread = TUniquePtr<std::thread>::Make(&WorkerThread::Process, this);
 	HANDLE threadHandle = m_pThread->native_handle();
@@ -35,6 +125,30 @@ WorkerThread::WorkerThread(
 
 WorkerThread::~WorkerThread()
 {
+	// Break the self references of the tasks that are left
+	for (auto& localQueue : m_localQueue)
+	{
+		ITask* pTask = nullptr;
+		while (localQueue.TryPop(pTask))
+		{
+			pTask->m_pQueueReference.Clear();
+		}
+	}
+
+	for (auto& localQueue : m_localLightQueue)
+	{
+		LightTask* pTask = nullptr;
+		while (localQueue.TryPop(pTask))
+		{
+			// The reference is moved out, the task could be destroyed with it
+			LightTaskPtr task = std::move(pTask->m_pQueueReference);
+		}
+	}
+
+	for (auto& pTask : m_pLightTaskQueue)
+	{
+		LightTaskPtr task = std::move(pTask->m_pQueueReference);
+	}
 }
 
 void WorkerThread::Join()
@@ -46,7 +160,10 @@ void WorkerThread::Join()
 void WorkerThread::WaitIdle()
 {
 	SAILOR_PROFILE_FUNCTION();
-	while (m_bIsBusy);
+	while (m_bIsBusy)
+	{
+		m_bIsBusy.wait(true);
+	}
 }
 
 void WorkerThread::ForcelyPushTask(const ITaskPtr& pTask)
@@ -57,23 +174,293 @@ void WorkerThread::ForcelyPushTask(const ITaskPtr& pTask)
 		m_pTaskQueue.Add(pTask);
 	}
 
-	if (!m_bIsBusy)
+	m_parkingLot.Unpark(this);
+}
+
+void WorkerThread::ForcelyPushLightTask(LightTask* pTask)
+{
+	SAILOR_PROFILE_FUNCTION();
 	{
-		m_refresh.notify_all();
+		const std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_pLightTaskQueue.Add(pTask);
 	}
+
+	m_parkingLot.Unpark(this);
 }
 
-bool WorkerThread::TryFetchTask(ITaskPtr& pOutTask)
+void WorkerThread::ResumeFiber(Fiber* pFiber)
 {
-	SAILOR_PROFILE_FUNCTION();
+	{
+		const std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_resumedFibers.Add(pFiber);
+	}
 
+	m_parkingLot.Unpark(this);
+}
+
+bool WorkerThread::TryPopResumedFiber(Fiber*& pOutFiber)
+{
 	const std::lock_guard<std::mutex> lock(m_queueMutex);
-	if (m_pTaskQueue.Num() > 0)
+	if (m_resumedFibers.Num() > 0)
 	{
-		pOutTask = m_pTaskQueue[m_pTaskQueue.Num() - 1];
-		m_pTaskQueue.RemoveLast();
+		pOutFiber = m_resumedFibers[m_resumedFibers.Num() - 1];
+		m_resumedFibers.RemoveLast();
 		return true;
 	}
+
+	return false;
+}
+
+void WorkerThread::SuspendUntilFinished(TaskSyncBlock& syncBlock)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	check(t_pCurrentWorkerThread == this && m_bFibers);
+
+	// The node stays valid while the fiber is suspended
+	SuspendedFiber suspended{ this, m_pCurrentFiber };
+
+	syncBlock.Lock();
+	if (syncBlock.IsCompleted())
+	{
+		syncBlock.Unlock();
+		return;
+	}
+
+	syncBlock.AddSuspendedFiber(&suspended);
+	syncBlock.Unlock();
+
+	// The fiber could be resumed before the switch, but it is continued only by this thread after the switch
+	SwitchToFiber(AcquireFiber(), false);
+}
+
+size_t WorkerThread::GetNumLocalTasks() const
+{
+	size_t res = 0;
+	for (const auto& localQueue : m_localQueue)
+	{
+		res += localQueue.Num();
+	}
+
+	for (const auto& localQueue : m_localLightQueue)
+	{
+		res += localQueue.Num();
+	}
+
+	return res;
+}
+
+Fiber* WorkerThread::AcquireFiber()
+{
+	if (m_freeFibers.Num() > 0)
+	{
+		Fiber* pFiber = m_freeFibers[m_freeFibers.Num() - 1];
+		m_freeFibers.RemoveLast();
+		return pFiber;
+	}
+
+	Fiber* pFiber = Fiber::Create(m_threadName + " Fiber " + std::to_string(m_fibers.Num()), FiberStackSize, &WorkerThread::FiberMain, this);
+	m_fibers.Add(pFiber);
+
+	return pFiber;
+}
+
+void WorkerThread::SwitchToFiber(Fiber* pFiber, bool bRecycleCurrent)
+{
+	Fiber* pCurrentFiber = m_pCurrentFiber;
+	ITask* pCurrentTask = m_pCurrentTask;
+	LightTask* pCurrentLightTask = m_pCurrentLightTask;
+	const bool bIsBusy = m_bIsBusy.load(std::memory_order_relaxed);
+	m_pFiberToRecycle = bRecycleCurrent ? pCurrentFiber : nullptr;
+	m_pCurrentFiber = pFiber;
+
+	if (pCurrentFiber != m_pThreadFiber)
+	{
+		SAILOR_PROFILE_FIBER_LEAVE();
+	}
+
+	Fiber::Switch(pCurrentFiber, pFiber);
+
+	// Continued by the other fiber of this thread, the suspended task is executed again
+	m_pCurrentTask = pCurrentTask;
+	m_pCurrentLightTask = pCurrentLightTask;
+	m_bIsBusy = bIsBusy;
+	OnFiberEntered();
+}
+
+void WorkerThread::OnFiberEntered()
+{
+	// The previous fiber is switched out only now, so it could be reused
+	if (m_pFiberToRecycle)
+	{
+		m_freeFibers.Add(m_pFiberToRecycle);
+		m_pFiberToRecycle = nullptr;
+	}
+
+	if (m_pCurrentFiber != m_pThreadFiber)
+	{
+		SAILOR_PROFILE_FIBER_ENTER(m_pCurrentFiber->GetName().c_str());
+	}
+}
+
+void WorkerThread::FiberMain(void* pArg)
+{
+	WorkerThread* pWorker = static_cast<WorkerThread*>(pArg);
+
+	pWorker->m_pCurrentTask = nullptr;
+	pWorker->m_pCurrentLightTask = nullptr;
+
+	// The task of the previous fiber is suspended, so the worker is not busy until it takes the next one
+	pWorker->m_bIsBusy = false;
+	pWorker->m_bIsBusy.notify_all();
+	pWorker->OnFiberEntered();
+	pWorker->RunLoop();
+
+	// Terminating, the thread's own stack finishes the thread
+	pWorker->SwitchToFiber(pWorker->m_pThreadFiber, false);
+}
+
+void WorkerThread::Wake()
+{
+	m_wakeSignal.store(1, std::memory_order_release);
+	m_wakeSignal.notify_one();
+}
+
+void WorkerThread::Park()
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	// The spurious wakeups are fine, the worker re-checks the queues
+	while (m_wakeSignal.exchange(0, std::memory_order_acquire) == 0)
+	{
+		m_wakeSignal.wait(0, std::memory_order_acquire);
+	}
+}
+
+bool WorkerThread::TryFetchTask(ITaskPtr& pOutTask, LightTask*& pOutLightTask)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	ETaskPriority priority;
+	{
+		const std::lock_guard<std::mutex> lock(m_queueMutex);
+		if (m_pTaskQueue.Num() > 0)
+		{
+			pOutTask = m_pTaskQueue[m_pTaskQueue.Num() - 1];
+			m_pTaskQueue.RemoveLast();
+			priority = pOutTask->GetPriority();
+		}
+		else if (m_pLightTaskQueue.Num() > 0)
+		{
+			pOutLightTask = m_pLightTaskQueue[m_pLightTaskQueue.Num() - 1];
+			m_pLightTaskQueue.RemoveLast();
+			priority = pOutLightTask->GetPriority();
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// The task is addressed to this thread, so it ignores the cap
+	if (priority == ETaskPriority::Background)
+	{
+		App::GetSubmodule<Tasks::Scheduler>()->AcquireBackgroundSlot(m_threadType);
+	}
+
+	return true;
+}
+
+bool WorkerThread::TryFetchTask(ITaskPtr& pOutTask, ETaskPriority priority)
+{
+	Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
+
+	if (TryPopLocalTask(pOutTask, priority) || scheduler->TryFetchNextAvailiableTask(pOutTask, m_threadType, priority))
+	{
+		return true;
+	}
+
+	if (scheduler->TryStealTask(pOutTask, this, priority))
+	{
+		Internal::AddToCounter(m_stats.m_numStolenTasks, 1);
+		return true;
+	}
+
+	return false;
+}
+
+bool WorkerThread::TryFetchLightTask(LightTask*& pOutTask, ETaskPriority priority)
+{
+	Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
+
+	if (m_localLightQueue[(uint32_t)priority].TryPop(pOutTask) || scheduler->TryFetchLightTask(pOutTask, m_threadType, priority))
+	{
+		return true;
+	}
+
+	if (scheduler->TryStealLightTask(pOutTask, this, priority))
+	{
+		Internal::AddToCounter(m_stats.m_numStolenTasks, 1);
+		return true;
+	}
+
+	return false;
+}
+
+void WorkerThread::PushLocalTask(const ITaskPtr& pTask)
+{
+	check(t_pCurrentWorkerThread == this);
+
+	pTask.GetRawPtr()->m_pQueueReference = pTask;
+	m_localQueue[(uint32_t)pTask->GetPriority()].Push(pTask.GetRawPtr());
+}
+
+bool WorkerThread::TryPopLocalTask(ITaskPtr& pOutTask, ETaskPriority priority)
+{
+	ITask* pTask = nullptr;
+	while (m_localQueue[(uint32_t)priority].TryPop(pTask))
+	{
+		ITaskPtr task = std::move(pTask->m_pQueueReference);
+		if (task->IsReadyToStart())
+		{
+			pOutTask = std::move(task);
+			return true;
+		}
+
+		// The dependency was joined after the task has been run
+		App::GetSubmodule<Tasks::Scheduler>()->PushSharedTask(task, m_threadType);
+	}
+
+	return false;
+}
+
+void WorkerThread::PushLocalLightTask(LightTask* pTask)
+{
+	check(t_pCurrentWorkerThread == this);
+
+	m_localLightQueue[(uint32_t)pTask->GetPriority()].Push(pTask);
+}
+
+bool WorkerThread::TryStealLightTask(LightTask*& pOutTask, ETaskPriority priority)
+{
+	return m_localLightQueue[(uint32_t)priority].TrySteal(pOutTask);
+}
+
+bool WorkerThread::TryStealTask(ITaskPtr& pOutTask, ETaskPriority priority)
+{
+	ITask* pTask = nullptr;
+	while (m_localQueue[(uint32_t)priority].TrySteal(pTask))
+	{
+		ITaskPtr task = std::move(pTask->m_pQueueReference);
+		if (task->IsReadyToStart())
+		{
+			pOutTask = std::move(task);
+			return true;
+		}
+
+		App::GetSubmodule<Tasks::Scheduler>()->PushSharedTask(task, m_threadType);
+	}
+
 	return false;
 }
 
@@ -86,17 +473,147 @@ void WorkerThread::ProcessTask(ITaskPtr& task)
 		SAILOR_PROFILE_SCOPE("Task Execution");
 		SAILOR_PROFILE_TEXT(task->GetName().c_str());
 
+		Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
+
+		const bool bIsBackground = task->GetPriority() == ETaskPriority::Background;
+		ITask* pPreviousTask = m_pCurrentTask;
+
+		const int64_t beginNs = Internal::GetTimestampNs();
+		m_stats.m_queueWait.Add(beginNs - task->m_enqueueTimeNs);
+
 		m_bIsBusy = true;
+		m_pCurrentTask = task.GetRawPtr();
 		task->Execute();
+		m_pCurrentTask = pPreviousTask;
+
+		Internal::AddToCounter(m_stats.m_numExecutedTasks, 1);
+
+		auto& traceRecorder = scheduler->GetTraceRecorder();
+		if (traceRecorder.IsRecording())
+		{
+			traceRecorder.Record(task->GetName().c_str(), task->GetPriority(), m_threadId, beginNs, Internal::GetTimestampNs());
+		}
+
 		task.Clear();
 		m_bIsBusy = false;
+		m_bIsBusy.notify_all();
+
+		if (bIsBackground)
+		{
+			scheduler->ReleaseBackgroundSlot(m_threadType);
+		}
+
+		scheduler->OnTaskProcessed(m_threadType);
+	}
+}
+
+void WorkerThread::ProcessLightTask(LightTask*& pTask)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	if (pTask)
+	{
+		SAILOR_PROFILE_SCOPE("Task Execution");
+		SAILOR_PROFILE_TEXT(pTask->GetName());
+
+		Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
+
+		// The queue holds the task, the reference is taken over
+		LightTaskPtr task = std::move(pTask->m_pQueueReference);
+		pTask = nullptr;
+
+		const bool bIsBackground = task->GetPriority() == ETaskPriority::Background;
+		LightTask* pPreviousTask = m_pCurrentLightTask;
+
+		const int64_t beginNs = Internal::GetTimestampNs();
+		m_stats.m_queueWait.Add(beginNs - task->m_enqueueTimeNs);
+
+		m_bIsBusy = true;
+		m_pCurrentLightTask = task.GetRawPtr();
+		task->Execute();
+		m_pCurrentLightTask = pPreviousTask;
+
+		Internal::AddToCounter(m_stats.m_numExecutedTasks, 1);
+
+		auto& traceRecorder = scheduler->GetTraceRecorder();
+		if (traceRecorder.IsRecording())
+		{
+			traceRecorder.Record(task->GetName(), task->GetPriority(), m_threadId, beginNs, Internal::GetTimestampNs());
+		}
+
+		task.Clear();
+		m_bIsBusy = false;
+		m_bIsBusy.notify_all();
+
+		if (bIsBackground)
+		{
+			scheduler->ReleaseBackgroundSlot(m_threadType);
+		}
+
+		scheduler->OnTaskProcessed(m_threadType);
+	}
+}
+
+void WorkerThread::ProcessWork(ITaskPtr& task, LightTask*& pLightTask, Fiber*& pFiber)
+{
+	if (pFiber)
+	{
+		// The current fiber goes back to the pool and continues from here once it is acquired again
+		Fiber* pResumedFiber = pFiber;
+		pFiber = nullptr;
+
+		SwitchToFiber(pResumedFiber, true);
+		return;
 	}
+
+	if (pLightTask)
+	{
+		ProcessLightTask(pLightTask);
+		return;
+	}
+
+	ProcessTask(task);
 }
 
-void WorkerThread::SetExecFlag()
+bool WorkerThread::TryFetchAnyWork(ITaskPtr& pOutTask, LightTask*& pOutLightTask, Fiber*& pOutFiber)
 {
-	std::unique_lock<std::mutex> lk(m_execMutex);
-	m_bExecFlag++;
+	// The resumed tasks go first, that keeps the amount of the fibers low
+	return (m_bFibers && TryPopResumedFiber(pOutFiber)) || TryFetchAnyTask(pOutTask, pOutLightTask);
+}
+
+bool WorkerThread::TryFetchAnyTask(ITaskPtr& pOutTask, LightTask*& pOutLightTask)
+{
+	if (TryFetchTask(pOutTask, pOutLightTask))
+	{
+		return true;
+	}
+
+	Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
+
+	const bool bLowestFirst = m_numFetchedTasks % StarvationGuardPeriod == StarvationGuardPeriod - 1;
+	for (uint32_t i = 0; i < NumTaskPriorities; i++)
+	{
+		const ETaskPriority priority = (ETaskPriority)(bLowestFirst ? NumTaskPriorities - 1 - i : i);
+
+		const bool bIsBackground = priority == ETaskPriority::Background;
+		if (bIsBackground && !scheduler->CanStartBackgroundTask(m_threadType))
+		{
+			continue;
+		}
+
+		if (TryFetchTask(pOutTask, priority) || TryFetchLightTask(pOutLightTask, priority))
+		{
+			if (bIsBackground)
+			{
+				scheduler->AcquireBackgroundSlot(m_threadType);
+			}
+
+			m_numFetchedTasks++;
+			return true;
+		}
+	}
+
+	return false;
 }
 
 void WorkerThread::Process()
@@ -106,6 +623,8 @@ void WorkerThread::Process()
 	SAILOR_PROFILE_THREAD_NAME(m_threadName.c_str());
 
 	m_threadId = GetCurrentThreadId();
+	t_pCurrentWorkerThread = this;
+	m_stats.m_startTimeNs = Internal::GetTimestampNs();
 
 	if (m_threadType == EThreadType::Render || m_threadType == EThreadType::RHI)
 	{
@@ -114,34 +633,137 @@ void WorkerThread::Process()
 
 	Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
 
+	// The victims list is filled after the threads are started
+	scheduler->m_bIsInitialized.wait(false);
+
+	if (m_bFibers)
+	{
+		m_pThreadFiber = Fiber::ConvertCurrentThread(m_threadName);
+		m_pCurrentFiber = m_pThreadFiber;
+
+		// Returns on the termination
+		SwitchToFiber(AcquireFiber(), false);
+
+		// The fibers of the tasks that are still suspended are dropped without the unwinding
+		for (auto& pFiber : m_fibers)
+		{
+			Fiber::Destroy(pFiber);
+		}
+
+		m_fibers.Clear();
+		m_freeFibers.Clear();
+		m_resumedFibers.Clear();
+
+		Fiber::RevertCurrentThread(m_pThreadFiber);
+		m_pThreadFiber = m_pCurrentFiber = nullptr;
+
+		return;
+	}
+
+	RunLoop();
+}
+
+void WorkerThread::RunLoop()
+{
+	Scheduler* scheduler = App::GetSubmodule<Tasks::Scheduler>();
+
 	ITaskPtr pCurrentTask;
+	LightTask* pLightTask = nullptr;
+	Fiber* pResumedFiber = nullptr;
 	while (!scheduler->m_bIsTerminating)
 	{
+		if (TryFetchAnyWork(pCurrentTask, pLightTask, pResumedFiber))
 		{
-			std::unique_lock<std::mutex> lk(m_execMutex);
-			m_refresh.wait(lk, [=, this, &pCurrentTask]()
-				{
-					const bool res = ((m_bExecFlag > 0) && (TryFetchTask(pCurrentTask) ||
-						scheduler->TryFetchNextAvailiableTask(pCurrentTask, m_threadType))) ||
-						(bool)scheduler->m_bIsTerminating;
-					return res;
-				});
-			m_bExecFlag--;
+			EndIdle();
+			ProcessWork(pCurrentTask, pLightTask, pResumedFiber);
+			continue;
 		}
 
-		ProcessTask(pCurrentTask);
-	}
+		BeginIdle();
+
+		// Spin with the exponential backoff, the next task usually arrives soon
+		bool bFound = false;
+		for (uint32_t i = 0; i < NumSpins && !bFound; i++)
+		{
+			for (uint32_t j = 0; j < (1u << i); j++)
+			{
+				YieldProcessor();
+			}
+
+			bFound = TryFetchAnyWork(pCurrentTask, pLightTask, pResumedFiber);
+		}
+
+		if (bFound)
+		{
+			EndIdle();
+			ProcessWork(pCurrentTask, pLightTask, pResumedFiber);
+			continue;
+		}
+
+		m_parkingLot.PrepareToPark(this);
+
+		if (TryFetchAnyWork(pCurrentTask, pLightTask, pResumedFiber) || scheduler->m_bIsTerminating)
+		{
+			if (!m_parkingLot.CancelPark(this))
+			{
+				// The wakeup has been addressed to this worker, pass it to the next one
+				m_parkingLot.UnparkOne();
+			}
+
+			EndIdle();
+			ProcessWork(pCurrentTask, pLightTask, pResumedFiber);
+			continue;
+		}
+
+		Park();
+	}
+}
+
+void WorkerThread::BeginIdle()
+{
+	if (m_stats.m_idleSinceNs.load(std::memory_order_relaxed) == 0)
+	{
+		m_stats.m_idleSinceNs.store(Internal::GetTimestampNs(), std::memory_order_relaxed);
+	}
+}
+
+void WorkerThread::EndIdle()
+{
+	const int64_t idleSinceNs = m_stats.m_idleSinceNs.load(std::memory_order_relaxed);
+	if (idleSinceNs != 0)
+	{
+		Internal::AddToCounter(m_stats.m_idleTimeNs, (uint64_t)(Internal::GetTimestampNs() - idleSinceNs));
+		m_stats.m_idleSinceNs.store(0, std::memory_order_relaxed);
+	}
+}
+
+uint64_t WorkerThread::GetIdleTimeNs() const
+{
+	// The current idle period is not accounted yet
+	const int64_t idleSinceNs = m_stats.m_idleSinceNs.load(std::memory_order_relaxed);
+	const int64_t currentIdleNs = idleSinceNs != 0 ? Internal::GetTimestampNs() - idleSinceNs : 0;
+
+	return m_stats.m_idleTimeNs.load(std::memory_order_relaxed) + (uint64_t)(std::max)(currentIdleNs, (int64_t)0);
 }
 
-void Scheduler::Initialize()
+uint64_t WorkerThread::GetBusyTimeNs() const
 {
-	m_taskSyncPool.AddDefault(MaxTasksInPool);
-
-	for (uint32_t i = 0; i < MaxTasksInPool; i++)
+	if (m_stats.m_startTimeNs == 0)
 	{
-		m_freeList.push((uint16_t)(MaxTasksInPool - i - 1));
+		return 0;
 	}
 
+	const uint64_t totalNs = (uint64_t)(Internal::GetTimestampNs() - m_stats.m_startTimeNs);
+	const uint64_t idleNs = GetIdleTimeNs();
+
+	return totalNs > idleNs ? totalNs - idleNs : 0;
+}
+
+void Scheduler::Initialize(bool bWorkStealing, bool bFibers)
+{
+	m_bWorkStealing = bWorkStealing;
+	m_bFibers = bFibers;
+
 	m_mainThreadId = GetCurrentThreadId();
 	m_threadTypes[m_mainThreadId] = EThreadType::Main;
 
@@ -149,14 +771,13 @@ void Scheduler::Initialize()
 
 	const unsigned coresCount = std::thread::hardware_concurrency();
 	const unsigned numRHIThreads = RHIThreadsNum;
-	const unsigned numThreads = std::max(1u, coresCount - 2u - numRHIThreads);
+	// The unsigned subtraction would wrap on the machines with less than 4 cores
+	const unsigned numThreads = coresCount > 2u + numRHIThreads ? coresCount - 2u - numRHIThreads : 1u;
 
 	WorkerThread* newRenderingThread = new WorkerThread(
 		"Render Thread",
 		EThreadType::Render,
-		m_refreshCondVar[(uint32_t)EThreadType::Render],
-		m_queueMutex[(uint32_t)EThreadType::Render],
-		m_pSharedTaskQueue[(uint32_t)EThreadType::Render]);
+		m_parkingLots[(uint32_t)EThreadType::Render]);
 
 	m_renderingThreadId = newRenderingThread->GetThreadId();
 	m_threadTypes[m_renderingThreadId] = EThreadType::Render;
@@ -165,10 +786,9 @@ void Scheduler::Initialize()
 	for (uint32_t i = 0; i < numThreads; i++)
 	{
 		const std::string threadName = std::string("Worker Thread ") + std::to_string(i);
+		// The render and the RHI threads keep the order of their tasks, so only the workers are switching the fibers
 		WorkerThread* newThread = new WorkerThread(threadName, EThreadType::Worker,
-			m_refreshCondVar[(uint32_t)EThreadType::Worker],
-			m_queueMutex[(uint32_t)EThreadType::Worker],
-			m_pSharedTaskQueue[(uint32_t)EThreadType::Worker]);
+			m_parkingLots[(uint32_t)EThreadType::Worker], m_bFibers);
 
 		m_threadTypes[newThread->GetThreadId()] = EThreadType::Worker;
 
@@ -179,15 +799,27 @@ void Scheduler::Initialize()
 	{
 		const std::string threadName = std::string("RHI Thread ") + std::to_string(i);
 		WorkerThread* newThread = new WorkerThread(threadName, EThreadType::RHI,
-			m_refreshCondVar[(uint32_t)EThreadType::RHI],
-			m_queueMutex[(uint32_t)EThreadType::RHI],
-			m_pSharedTaskQueue[(uint32_t)EThreadType::RHI]);
+			m_parkingLots[(uint32_t)EThreadType::RHI]);
 
 		m_threadTypes[newThread->GetThreadId()] = EThreadType::RHI;
 		m_workerThreads.Emplace(newThread);
 	}
 
-	SAILOR_LOG("Initialize Tasks::Scheduler. Cores count: %d, Worker threads count: %zd", coresCount, m_workerThreads.Num());
+	for (auto& worker : m_workerThreads)
+	{
+		m_workerThreadsByType[(uint32_t)worker->GetThreadType()].Add(worker);
+	}
+
+	for (uint32_t i = 0; i < MaxThreadTypes; i++)
+	{
+		m_maxBackgroundTasks[i] = (std::max)((uint32_t)m_workerThreadsByType[i].Num() / 2, 1u);
+	}
+
+	m_bIsInitialized = true;
+	m_bIsInitialized.notify_all();
+
+	SAILOR_LOG("Initialize Tasks::Scheduler. Cores count: %d, Worker threads count: %zd, Work stealing: %s, Fibers: %s", coresCount, m_workerThreads.Num(),
+		m_bWorkStealing ? "on" : "off", m_bFibers ? "on" : "off");
 }
 
 Scheduler::Scheduler()
@@ -216,6 +848,32 @@ Scheduler::~Scheduler()
 	}
 
 	m_workerThreads.Clear();
+
+	for (auto& workers : m_workerThreadsByType)
+	{
+		workers.Clear();
+	}
+
+	for (auto& injectionQueues : m_injectionQueue)
+	{
+		for (auto& injectionQueue : injectionQueues)
+		{
+			ITaskPtr pTask;
+			while (injectionQueue.TryPop(pTask));
+		}
+	}
+
+	for (auto& lightTaskQueues : m_lightTaskQueue)
+	{
+		for (auto& lightTaskQueue : lightTaskQueues)
+		{
+			LightTask* pTask = nullptr;
+			while (lightTaskQueue.TryPop(pTask))
+			{
+				LightTaskPtr task = std::move(pTask->m_pQueueReference);
+			}
+		}
+	}
 }
 
 uint32_t Scheduler::GetNumWorkerThreads() const
@@ -227,19 +885,79 @@ void Scheduler::ProcessTasksOnMainThread()
 {
 	SAILOR_PROFILE_FUNCTION();
 	ITaskPtr pCurrentTask;
-	while (TryFetchNextAvailiableTask(pCurrentTask, EThreadType::Main))
+	LightTask* pLightTask = nullptr;
+	while (TryFetchNextAvailiableTask(pCurrentTask, EThreadType::Main) || TryFetchLightTask(pLightTask, EThreadType::Main))
 	{
-		if (pCurrentTask)
+		if (pLightTask)
+		{
+			ProcessLightTaskOnMainThread(pLightTask);
+		}
+		else if (pCurrentTask)
 		{
 			SAILOR_PROFILE_SCOPE("Task Execution");
 			SAILOR_PROFILE_TEXT(pCurrentTask->GetName().c_str());
 
+			const int64_t beginNs = Internal::GetTimestampNs();
 			pCurrentTask->Execute();
+
+			if (m_traceRecorder.IsRecording())
+			{
+				m_traceRecorder.Record(pCurrentTask->GetName().c_str(), pCurrentTask->GetPriority(), m_mainThreadId, beginNs, Internal::GetTimestampNs());
+			}
+
 			pCurrentTask.Clear();
+
+			OnTaskProcessed(EThreadType::Main);
 		}
 	}
 }
 
+void Scheduler::ProcessLightTaskOnMainThread(LightTask*& pTask)
+{
+	SAILOR_PROFILE_SCOPE("Task Execution");
+	SAILOR_PROFILE_TEXT(pTask->GetName());
+
+	LightTaskPtr task = std::move(pTask->m_pQueueReference);
+	pTask = nullptr;
+
+	const int64_t beginNs = Internal::GetTimestampNs();
+	task->Execute();
+
+	if (m_traceRecorder.IsRecording())
+	{
+		m_traceRecorder.Record(task->GetName(), task->GetPriority(), m_mainThreadId, beginNs, Internal::GetTimestampNs());
+	}
+
+	task.Clear();
+
+	OnTaskProcessed(EThreadType::Main);
+}
+
+void Scheduler::OnTaskPending(const ITaskPtr& pTask, EThreadType threadType)
+{
+	pTask.GetRawPtr()->m_enqueueTimeNs = Internal::GetTimestampNs();
+
+	OnTaskPending(threadType);
+}
+
+void Scheduler::OnTaskPending(EThreadType threadType)
+{
+	const uint32_t numPendingTasks = ++m_numPendingTasks[(uint32_t)threadType];
+
+	auto& peakNumPendingTasks = m_peakNumPendingTasks[(uint32_t)threadType];
+	uint32_t peak = peakNumPendingTasks.load(std::memory_order_relaxed);
+	while (numPendingTasks > peak && !peakNumPendingTasks.compare_exchange_weak(peak, numPendingTasks, std::memory_order_relaxed));
+}
+
+void Scheduler::OnTaskProcessed(EThreadType threadType)
+{
+	auto& numPendingTasks = m_numPendingTasks[(uint32_t)threadType];
+	if (numPendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		numPendingTasks.notify_all();
+	}
+}
+
 void Scheduler::RunChainedTasks_Internal(const ITaskPtr& pTask, const ITaskPtr& pTaskToIgnore)
 {
 	for (auto& chainedTasksNext : pTask->GetChainedTasksNext())
@@ -293,18 +1011,93 @@ void Scheduler::Run(const ITaskPtr& pTask, bool bAutoRunChainedTasks)
 
 	pTask.GetRawPtr()->OnEnqueue();
 
+	Enqueue(pTask);
+}
+
+void Scheduler::Resume(const ITaskPtr& pTask)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	check(pTask->IsStarted() && !pTask->IsFinished());
+
+	Enqueue(pTask);
+}
+
+void Scheduler::Enqueue(const ITaskPtr& pTask)
+{
+	const EThreadType threadType = pTask->GetThreadType();
+	OnTaskPending(pTask, threadType);
+
+	// The local deques are LIFO, so only the workers use them. The render and the RHI threads keep the order of their tasks
+	// and the main thread has no worker, so their tasks and the blocked ones stay in the shared queue
+	if (m_bWorkStealing && threadType == EThreadType::Worker && pTask->IsReadyToStart())
+	{
+		WorkerThread* pWorker = t_pCurrentWorkerThread;
+		if (pWorker && pWorker->GetThreadType() == threadType)
+		{
+			pWorker->PushLocalTask(pTask);
+		}
+		else
+		{
+			m_injectionQueue[(uint32_t)threadType][(uint32_t)pTask->GetPriority()].Push(pTask);
+		}
+	}
+	else
+	{
+		PushSharedTask(pTask, threadType);
+	}
+
+	NotifyWorkerThread(threadType);
+}
+
+void Scheduler::Enqueue(LightTask* pTask)
+{
+	const EThreadType threadType = pTask->GetThreadType();
+
+	pTask->m_enqueueTimeNs = Internal::GetTimestampNs();
+	pTask->m_pQueueReference = pTask;
+
+	if (pTask->m_threadId != 0)
 	{
-		std::mutex* pOutQueueMutex;
-		TVector<ITaskPtr>* pOutQueue;
-		std::condition_variable* pOutCondVar;
+		auto result = m_workerThreads.FindIf(
+			[&](const auto& worker)
+			{
+				return worker->GetThreadId() == pTask->m_threadId;
+			});
+
+		if (result != -1)
+		{
+			m_workerThreads[result]->ForcelyPushLightTask(pTask);
+			return;
+		}
 
-		GetThreadSyncVarsByThreadType(pTask->GetThreadType(), pOutQueueMutex, pOutQueue, pOutCondVar);
+		// The main thread has no worker, it takes the task from the shared queue
+		check(m_mainThreadId == pTask->m_threadId);
+	}
 
-		const std::lock_guard<std::mutex> lock(*pOutQueueMutex);
-		pOutQueue->Add(pTask);
+	// The same as for the tasks, only the workers push to the LIFO local deques
+	WorkerThread* pWorker = t_pCurrentWorkerThread;
+	if (m_bWorkStealing && threadType == EThreadType::Worker && pWorker && pWorker->GetThreadType() == threadType)
+	{
+		pWorker->PushLocalLightTask(pTask);
+	}
+	else
+	{
+		m_lightTaskQueue[(uint32_t)threadType][(uint32_t)pTask->GetPriority()].Push(pTask);
 	}
 
-	NotifyWorkerThread(pTask->GetThreadType());
+	NotifyWorkerThread(threadType);
+}
+
+void Scheduler::PushSharedTask(const ITaskPtr& pTask, EThreadType threadType)
+{
+	std::mutex* pOutQueueMutex;
+	TVector<ITaskPtr>* pOutQueue;
+
+	GetThreadSyncVarsByThreadType(threadType, pTask->GetPriority(), pOutQueueMutex, pOutQueue);
+
+	const std::lock_guard<std::mutex> lock(*pOutQueueMutex);
+	pOutQueue->Add(pTask);
 }
 
 void Scheduler::Run(const ITaskPtr& pTask, DWORD threadId, bool bAutoRunChainedTasks)
@@ -328,46 +1121,65 @@ void Scheduler::Run(const ITaskPtr& pTask, DWORD threadId, bool bAutoRunChainedT
 
 	if (result != -1)
 	{
-		m_workerThreads[result]->SetExecFlag();
+		OnTaskPending(pTask, m_workerThreads[result]->GetThreadType());
 		m_workerThreads[result]->ForcelyPushTask(pTask);
 		return;
 	}
 	check(m_mainThreadId == threadId);
 	// Add to Main thread if cannot find the thread in workers
-	{
-		std::mutex* pOutQueueMutex;
-		TVector<ITaskPtr>* pOutQueue;
-		std::condition_variable* pOutCondVar;
-
-		GetThreadSyncVarsByThreadType(EThreadType::Main, pOutQueueMutex, pOutQueue, pOutCondVar);
-
-		const std::lock_guard<std::mutex> lock(*pOutQueueMutex);
-		pOutQueue->Add(pTask);
-	}
+	OnTaskPending(pTask, EThreadType::Main);
+	PushSharedTask(pTask, EThreadType::Main);
 }
 
 void Scheduler::GetThreadSyncVarsByThreadType(
 	EThreadType threadType,
+	ETaskPriority priority,
 	std::mutex*& pOutQueueMutex,
-	TVector<ITaskPtr>*& pOutQueue,
-	std::condition_variable*& pOutCondVar)
+	TVector<ITaskPtr>*& pOutQueue)
 {
 	SAILOR_PROFILE_FUNCTION();
 
 	pOutQueueMutex = &m_queueMutex[(uint32_t)threadType];
-	pOutQueue = &m_pSharedTaskQueue[(uint32_t)threadType];
-	pOutCondVar = &m_refreshCondVar[(uint32_t)threadType];
+	pOutQueue = &m_pSharedTaskQueue[(uint32_t)threadType][(uint32_t)priority];
 }
 
 bool Scheduler::TryFetchNextAvailiableTask(ITaskPtr& pOutTask, EThreadType threadType)
+{
+	for (uint32_t i = 0; i < NumTaskPriorities; i++)
+	{
+		if (TryFetchNextAvailiableTask(pOutTask, threadType, (ETaskPriority)i))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Scheduler::TryFetchNextAvailiableTask(ITaskPtr& pOutTask, EThreadType threadType, ETaskPriority priority)
 {
 	SAILOR_PROFILE_FUNCTION();
 
 	std::mutex* pOutQueueMutex;
 	TVector<ITaskPtr>* pOutQueue;
-	std::condition_variable* pOutCondVar;
 
-	GetThreadSyncVarsByThreadType(threadType, pOutQueueMutex, pOutQueue, pOutCondVar);
+	GetThreadSyncVarsByThreadType(threadType, priority, pOutQueueMutex, pOutQueue);
+
+	if (m_bWorkStealing)
+	{
+		auto& injectionQueue = m_injectionQueue[(uint32_t)threadType][(uint32_t)priority];
+		while (injectionQueue.TryPop(pOutTask))
+		{
+			if (pOutTask->IsReadyToStart())
+			{
+				return true;
+			}
+
+			// The dependency was joined after the task has been run
+			PushSharedTask(pOutTask, threadType);
+			pOutTask.Clear();
+		}
+	}
 
 	const std::lock_guard<std::mutex> lock(*pOutQueueMutex);
 
@@ -391,41 +1203,128 @@ bool Scheduler::TryFetchNextAvailiableTask(ITaskPtr& pOutTask, EThreadType threa
 	return false;
 }
 
-void Scheduler::NotifyWorkerThread(EThreadType threadType, bool bNotifyAllThreads)
+bool Scheduler::TryFetchLightTask(LightTask*& pOutTask, EThreadType threadType)
 {
-	SAILOR_PROFILE_FUNCTION();
-	std::mutex* pOutQueueMutex;
-	TVector<ITaskPtr>* pOutQueue;
-	std::condition_variable* pOutCondVar;
+	for (uint32_t i = 0; i < NumTaskPriorities; i++)
+	{
+		if (TryFetchLightTask(pOutTask, threadType, (ETaskPriority)i))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Scheduler::TryFetchLightTask(LightTask*& pOutTask, EThreadType threadType, ETaskPriority priority)
+{
+	return m_lightTaskQueue[(uint32_t)threadType][(uint32_t)priority].TryPop(pOutTask);
+}
+
+template<typename TStealFunc>
+bool Scheduler::TryStealFromVictims(const WorkerThread* pThief, TStealFunc&& steal)
+{
+	if (!m_bWorkStealing)
+	{
+		return false;
+	}
+
+	// The victims are the threads of the same type, so the affinity is kept
+	const auto& victims = m_workerThreadsByType[(uint32_t)pThief->GetThreadType()];
+	const size_t numVictims = victims.Num();
+	if (numVictims < 2)
+	{
+		return false;
+	}
 
-	GetThreadSyncVarsByThreadType(threadType, pOutQueueMutex, pOutQueue, pOutCondVar);
+	// Start from the random victim to spread the thieves
+	thread_local uint32_t t_seed = (uint32_t)std::hash<const void*>()(pThief) | 1u;
+	t_seed ^= t_seed << 13;
+	t_seed ^= t_seed >> 17;
+	t_seed ^= t_seed << 5;
 
-	for (uint32_t i = 0; i < m_workerThreads.Num(); i++)
+	const size_t first = t_seed % numVictims;
+	for (size_t i = 0; i < numVictims; i++)
 	{
-		if (m_workerThreads[i]->GetThreadType() == threadType)
+		WorkerThread* pVictim = victims[(first + i) % numVictims];
+		if (pVictim != pThief && steal(pVictim))
 		{
-			m_workerThreads[i]->SetExecFlag();
+			return true;
 		}
 	}
 
+	return false;
+}
+
+bool Scheduler::TryStealTask(ITaskPtr& pOutTask, const WorkerThread* pThief, ETaskPriority priority)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	return TryStealFromVictims(pThief, [&](WorkerThread* pVictim) { return pVictim->TryStealTask(pOutTask, priority); });
+}
+
+bool Scheduler::TryStealLightTask(LightTask*& pOutTask, const WorkerThread* pThief, ETaskPriority priority)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	return TryStealFromVictims(pThief, [&](WorkerThread* pVictim) { return pVictim->TryStealLightTask(pOutTask, priority); });
+}
+
+WorkerThread* Scheduler::GetCurrentWorkerThread() const
+{
+	return t_pCurrentWorkerThread;
+}
+
+void Scheduler::NotifyWorkerThread(EThreadType threadType, bool bNotifyAllThreads)
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	// Only the parked workers are woken up, the running ones re-check the queues before parking
 	if (bNotifyAllThreads)
 	{
-		pOutCondVar->notify_all();
+		m_parkingLots[(uint32_t)threadType].UnparkAll();
 	}
 	else
 	{
-		pOutCondVar->notify_one();
+		m_parkingLots[(uint32_t)threadType].UnparkOne();
 	}
 }
 
 EThreadType Scheduler::GetCurrentThreadType() const
 {
-	return m_threadTypes[GetCurrentThreadId()];
+	return GetThreadType(GetCurrentThreadId());
+}
+
+EThreadType Scheduler::GetThreadType(DWORD threadId) const
+{
+	return m_threadTypes[threadId];
 }
 
 uint32_t Scheduler::GetNumTasks(EThreadType thread) const
 {
-	return (uint32_t)m_pSharedTaskQueue[(uint32_t)thread].Num();
+	size_t res = 0;
+	for (uint32_t i = 0; i < NumTaskPriorities; i++)
+	{
+		res += m_pSharedTaskQueue[(uint32_t)thread][i].Num();
+
+		if (m_bWorkStealing)
+		{
+			res += m_injectionQueue[(uint32_t)thread][i].Num();
+		}
+
+		res += m_lightTaskQueue[(uint32_t)thread][i].Num();
+	}
+
+	if (m_bWorkStealing)
+	{
+
+		for (const auto& worker : m_workerThreadsByType[(uint32_t)thread])
+		{
+			res += worker->GetNumLocalTasks();
+		}
+	}
+
+	return (uint32_t)res;
 }
 
 void Scheduler::WaitIdle(const TSet<EThreadType>& threads)
@@ -434,7 +1333,7 @@ void Scheduler::WaitIdle(const TSet<EThreadType>& threads)
 
 	for (const auto& thread : threads)
 	{
-		if (GetNumTasks(thread) > 0)
+		if (m_numPendingTasks[(uint32_t)thread] > 0)
 		{
 			if (thread == EThreadType::Main && IsMainThread())
 			{
@@ -452,38 +1351,76 @@ void Scheduler::WaitIdle(EThreadType type)
 {
 	SAILOR_PROFILE_FUNCTION();
 
-	std::mutex* pOutQueueMutex;
-	TVector<ITaskPtr>* pOutQueue;
-	std::condition_variable* pOutCondVar;
-	TVector<ITaskPtr> waitFor;
+	// The counter covers the queued, the blocked and the executing tasks,
+	// so there is no gap between fetching the task and marking the worker as busy
+	auto& numPendingTasks = m_numPendingTasks[(uint32_t)type];
+
+	uint32_t num = 0;
+	while ((num = numPendingTasks.load(std::memory_order_acquire)) != 0)
+	{
+		numPendingTasks.wait(num, std::memory_order_acquire);
+	}
+}
 
-	GetThreadSyncVarsByThreadType(type, pOutQueueMutex, pOutQueue, pOutCondVar);
+ETaskPriority Scheduler::GetCurrentTaskPriority() const
+{
+	WorkerThread* pWorker = t_pCurrentWorkerThread;
+	if (pWorker && pWorker->GetCurrentTask())
+	{
+		return pWorker->GetCurrentTask()->GetPriority();
+	}
 
+	if (pWorker && pWorker->GetCurrentLightTask())
 	{
-		const std::unique_lock<std::mutex> lock(m_queueMutex[(uint8_t)type]);
-		waitFor = *pOutQueue;
+		return pWorker->GetCurrentLightTask()->GetPriority();
 	}
 
-	do
+	return ETaskPriority::FrameCritical;
+}
+
+void Scheduler::WaitUntilCompleted(TaskSyncBlock& syncBlock)
+{
+	WorkerThread* pWorker = t_pCurrentWorkerThread;
+
+	// The waiting background task gives its slot away, otherwise its background dependencies could never start
+	const bool bIsBackground = pWorker && GetCurrentTaskPriority() == ETaskPriority::Background;
+	if (bIsBackground)
 	{
-		for (auto& wait : waitFor)
-		{
-			wait->Wait();
-		}
+		ReleaseBackgroundSlot(pWorker->GetThreadType());
+	}
 
-		{
-			const std::unique_lock<std::mutex> lock(m_queueMutex[(uint8_t)type]);
-			waitFor = *pOutQueue;
-		}
+	if (pWorker && pWorker->IsFiberMode())
+	{
+		// The worker continues with the other tasks while this one is suspended
+		pWorker->SuspendUntilFinished(syncBlock);
+	}
+	else
+	{
+		syncBlock.Wait();
+	}
+
+	if (bIsBackground)
+	{
+		AcquireBackgroundSlot(pWorker->GetThreadType());
+	}
+}
 
-	} while (waitFor.Num() != 0);
+bool Scheduler::CanStartBackgroundTask(EThreadType threadType) const
+{
+	return m_numBackgroundTasks[(uint32_t)threadType].load(std::memory_order_acquire) < m_maxBackgroundTasks[(uint32_t)threadType];
+}
 
-	for (auto& worker : m_workerThreads)
+void Scheduler::AcquireBackgroundSlot(EThreadType threadType)
+{
+	m_numBackgroundTasks[(uint32_t)threadType].fetch_add(1, std::memory_order_acq_rel);
+}
+
+void Scheduler::ReleaseBackgroundSlot(EThreadType threadType)
+{
+	// The freed slot could be the only thing the parked workers wait for
+	if (m_numBackgroundTasks[(uint32_t)threadType].fetch_sub(1, std::memory_order_acq_rel) == m_maxBackgroundTasks[(uint32_t)threadType])
 	{
-		if (worker->GetThreadType() == type)
-		{
-			worker->WaitIdle();
-		}
+		NotifyWorkerThread(threadType);
 	}
 }
 
@@ -497,26 +1434,95 @@ bool Scheduler::IsRendererThread() const
 	return m_renderingThreadId == GetCurrentThreadId();
 }
 
-uint16_t Scheduler::AcquireTaskSyncBlock()
+uint32_t Scheduler::AcquireTaskSyncBlock()
+{
+	return m_taskSyncBlocks.Acquire();
+}
+
+TaskSyncBlock& Scheduler::GetTaskSyncBlock(const ITask& task)
+{
+	return m_taskSyncBlocks.Get(task.m_taskSyncBlockHandle);
+}
+
+void Scheduler::ReleaseTaskSyncBlock(const ITask& task)
+{
+	m_taskSyncBlocks.Release(task.m_taskSyncBlockHandle);
+}
+
+void Scheduler::LogStats() const
 {
-	uint16_t last = 0;
-	if (m_freeList.try_pop(last))
+	SAILOR_LOG("Tasks::Scheduler stats:");
+
+	for (const auto& worker : m_workerThreads)
 	{
-		m_taskSyncPool[last].m_bCompletionFlag = false;
-		return last;
+		const auto& stats = worker->GetStats();
+
+		const uint64_t busyNs = worker->GetBusyTimeNs();
+		const uint64_t idleNs = worker->GetIdleTimeNs();
+		const double busyPercent = busyNs + idleNs > 0 ? 100.0 * busyNs / (busyNs + idleNs) : 0.0;
+
+		SAILOR_LOG("%s: busy %.1f%% (%.2fs), tasks %llu, stolen %llu, queue wait p50 < %lldus, p90 < %lldus, p99 < %lldus",
+			worker->GetName().c_str(),
+			busyPercent,
+			busyNs / 1e9,
+			stats.m_numExecutedTasks.load(std::memory_order_relaxed),
+			stats.m_numStolenTasks.load(std::memory_order_relaxed),
+			stats.m_queueWait.GetPercentileMicro(0.5f),
+			stats.m_queueWait.GetPercentileMicro(0.9f),
+			stats.m_queueWait.GetPercentileMicro(0.99f));
 	}
 
-	ensure(false, "Increase the pool size of task block primitives! Scheduler::MaxTasksInPool");
+	for (uint32_t i = 0; i < MaxThreadTypes; i++)
+	{
+		const EThreadType threadType = (EThreadType)i;
+		SAILOR_LOG("%s: threads %u, queued %u, pending %u, peak pending %u",
+			magic_enum::enum_name(threadType).data(),
+			GetNumWorkerThreads(threadType),
+			GetNumTasks(threadType),
+			GetNumPendingTasks(threadType),
+			GetPeakNumPendingTasks(threadType));
+	}
+}
 
-	return 0;
+void Scheduler::StartTrace()
+{
+	if (!m_traceRecorder.IsRecording())
+	{
+		m_traceRecorder.Start();
+	}
 }
 
-TaskSyncBlock& Scheduler::GetTaskSyncBlock(const ITask& task)
+bool Scheduler::StopTrace(const std::string& path)
 {
-	return m_taskSyncPool[task.m_taskSyncBlockHandle];
+	m_traceRecorder.Stop();
+
+	TVector<std::pair<DWORD, std::string>> threadNames;
+	threadNames.Add({ m_mainThreadId, "Main Thread" });
+
+	for (const auto& worker : m_workerThreads)
+	{
+		threadNames.Add({ worker->GetThreadId(), worker->GetName() });
+	}
+
+	return m_traceRecorder.ExportChromeTrace(path, threadNames);
 }
 
-void Scheduler::ReleaseTaskSyncBlock(const ITask& task)
+void Scheduler::ToggleTrace()
 {
-	m_freeList.push(task.m_taskSyncBlockHandle);
+	if (!m_traceRecorder.IsRecording())
+	{
+		StartTrace();
+		SAILOR_LOG("Recording the tasks trace, run the command again to save it");
+		return;
+	}
+
+	const std::string path = "TasksTrace.json";
+	if (StopTrace(path))
+	{
+		SAILOR_LOG("The tasks trace is saved to %s", path.c_str());
+	}
+	else
+	{
+		SAILOR_LOG("Cannot save the tasks trace to %s", path.c_str());
+	}
 }
\ No newline at end of file
@@ -3,17 +3,21 @@
 #include <functional>
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
 #include <thread>
 #include "Sailor.h"
 #include "Core/Submodule.h"
 #include "Memory/UniquePtr.hpp"
-
-// TODO: Implement ConcurrentList
-#include <concurrent_queue.h>
+#include "Containers/ConcurrentQueue.h"
+#include "Containers/WorkStealingDeque.h"
+#include "Tasks/Fiber.h"
+#include "Tasks/TaskSyncBlock.h"
+#include "Tasks/SchedulerStats.h"
 
 #define SAILOR_ENQUEUE_TASK(Name, Lambda) Sailor::App::GetSubmodule<Tasks::Scheduler>()->Run(Sailor::Tasks::CreateTask(Name, Lambda))
 #define SAILOR_ENQUEUE_TASK_RENDER_THREAD(Name, Lambda) Sailor::App::GetSubmodule<Tasks::Scheduler>()->Run(Sailor::Tasks::CreateTask(Name, Lambda, Sailor::EThreadType::Render))
 #define SAILOR_ENQUEUE_TASK_RHI_THREAD(Name, Lambda) Sailor::App::GetSubmodule<Tasks::Scheduler>()->Run(Sailor::Tasks::CreateTask(Name, Lambda, Sailor::EThreadType::RHI))
+#define SAILOR_ENQUEUE_TASK_WITH_PRIORITY(Name, Lambda, Priority) Sailor::App::GetSubmodule<Tasks::Scheduler>()->Run(Sailor::Tasks::CreateTask(Name, Lambda, Sailor::EThreadType::Worker, Priority))
 
 namespace Sailor
 {
@@ -29,6 +33,18 @@ namespace Sailor
 		RHI = 3
 	};
 
+	// The threads take the tasks of the higher priority first
+	enum class ETaskPriority : uint8_t
+	{
+		// The work that the current frame waits for
+		FrameCritical = 0,
+		Normal = 1,
+
+		// The bulk work like the shader compilation or the streaming,
+		// the amount of the concurrently executed background tasks is capped to keep the threads for the frame
+		Background = 2
+	};
+
 	namespace Tasks
 	{
 		class WorkerThread;
@@ -37,23 +53,54 @@ namespace Sailor
 		class ITask;
 		using ITaskPtr = TSharedPtr <ITask>;
 
-		struct TaskSyncBlock
+		class LightTask;
+
+		// Idle workers of the same thread type, the eventcount protocol prevents the lost wakeups:
+		// the worker registers, re-checks the queues and only then parks,
+		// while the producer publishes the task first and then wakes the one registered worker.
+		// The producer doesn't touch the lock while nobody is parked.
+		class WorkerParkingLot
 		{
-			std::condition_variable m_onComplete{};
-			std::mutex m_mutex{};
-			bool m_bCompletionFlag = false;
+		public:
+
+			SAILOR_API void PrepareToPark(WorkerThread* pWorker);
+
+			// Returns false if the worker has been already woken up
+			SAILOR_API bool CancelPark(WorkerThread* pWorker);
+
+			SAILOR_API bool UnparkOne();
+			SAILOR_API bool Unpark(WorkerThread* pWorker);
+			SAILOR_API void UnparkAll();
+
+			SAILOR_API uint32_t GetNumParked() const { return m_numParked.load(std::memory_order_relaxed); }
+
+		protected:
+
+			std::atomic<uint32_t> m_numParked = 0;
+			std::mutex m_mutex;
+			TVector<WorkerThread*> m_parked;
 		};
 
+		static constexpr uint32_t NumTaskPriorities = (uint32_t)magic_enum::enum_count<ETaskPriority>();
+
 		class WorkerThread
 		{
+			// The worker spins for 2^NumSpins pauses in total before parking
+			static constexpr uint32_t NumSpins = 8;
+
+			// Each N-th task is fetched starting from the lowest priority, so the stream of the higher priority tasks doesn't starve the others
+			static constexpr uint32_t StarvationGuardPeriod = 16;
+
+			// The stack is reserved, the pages are committed on demand
+			static constexpr size_t FiberStackSize = 1024 * 1024;
+
 		public:
 
 			SAILOR_API WorkerThread(
 				std::string threadName,
 				EThreadType threadType,
-				std::condition_variable& refresh,
-				std::mutex& mutex,
-				TVector<ITaskPtr>& pTasksQueue);
+				WorkerParkingLot& parkingLot,
+				bool bFibers = false);
 
 			SAILOR_API virtual ~WorkerThread();
 
@@ -61,22 +108,68 @@ namespace Sailor
 			WorkerThread(WorkerThread& copy) = delete;
 			WorkerThread& operator =(WorkerThread& rhs) = delete;
 
-			SAILOR_API void SetExecFlag();
-			SAILOR_API std::mutex& GetExecMutex() { return m_execMutex; }
 			SAILOR_API DWORD GetThreadId() const { return m_threadId; }
 			SAILOR_API bool IsBusy() const { return m_bIsBusy.load(); }
 			SAILOR_API EThreadType GetThreadType() const { return m_threadType; }
+			SAILOR_API const std::string& GetName() const { return m_threadName; }
+
+			SAILOR_API const WorkerThreadStats& GetStats() const { return m_stats; }
+
+			// The time since the start that the thread is not idle, the blocking waits are included
+			SAILOR_API uint64_t GetBusyTimeNs() const;
+			SAILOR_API uint64_t GetIdleTimeNs() const;
 
 			SAILOR_API void ForcelyPushTask(const ITaskPtr& pTask);
+			SAILOR_API void ForcelyPushLightTask(LightTask* pTask);
+
+			// Work stealing mode, the local deques are pushed/popped by this thread only (LIFO),
+			// the other threads of the same type steal from the opposite end (FIFO)
+			SAILOR_API void PushLocalTask(const ITaskPtr& pTask);
+			SAILOR_API bool TryStealTask(ITaskPtr& pOutTask, ETaskPriority priority);
+			SAILOR_API void PushLocalLightTask(LightTask* pTask);
+			SAILOR_API bool TryStealLightTask(LightTask*& pOutTask, ETaskPriority priority);
+			SAILOR_API size_t GetNumLocalTasks() const;
+
+			// The task that is executed by this thread, null between the tasks
+			SAILOR_API ITask* GetCurrentTask() const { return m_pCurrentTask; }
+			SAILOR_API LightTask* GetCurrentLightTask() const { return m_pCurrentLightTask; }
+
+			// Fiber mode, the waiting task suspends its fiber and the worker continues with the other tasks on the next fiber.
+			// There is no fallback to the blocking, the fiber is continued only by its worker and the blocked worker would never resume it.
+			SAILOR_API bool IsFiberMode() const { return m_bFibers; }
+			SAILOR_API void SuspendUntilFinished(TaskSyncBlock& syncBlock);
+
+			// Any thread, the suspended fiber is continued by its worker
+			SAILOR_API void ResumeFiber(Fiber* pFiber);
 
 			SAILOR_API void Process();
 			SAILOR_API void Join();
 			SAILOR_API void WaitIdle();
 
+			// Called by the parking lot, the worker is unregistered at this point
+			SAILOR_API void Wake();
+
 		protected:
 
+			SAILOR_API void Park();
+			SAILOR_API void RunLoop();
+			SAILOR_API void BeginIdle();
+			SAILOR_API void EndIdle();
 			SAILOR_API void ProcessTask(ITaskPtr& task);
-			SAILOR_API bool TryFetchTask(ITaskPtr& pOutTask);
+			SAILOR_API void ProcessLightTask(LightTask*& pTask);
+			SAILOR_API void ProcessWork(ITaskPtr& task, LightTask*& pLightTask, Fiber*& pFiber);
+			SAILOR_API bool TryFetchAnyWork(ITaskPtr& pOutTask, LightTask*& pOutLightTask, Fiber*& pOutFiber);
+			SAILOR_API bool TryFetchAnyTask(ITaskPtr& pOutTask, LightTask*& pOutLightTask);
+			SAILOR_API bool TryFetchTask(ITaskPtr& pOutTask, LightTask*& pOutLightTask);
+			SAILOR_API bool TryFetchTask(ITaskPtr& pOutTask, ETaskPriority priority);
+			SAILOR_API bool TryFetchLightTask(LightTask*& pOutTask, ETaskPriority priority);
+			SAILOR_API bool TryPopLocalTask(ITaskPtr& pOutTask, ETaskPriority priority);
+
+			SAILOR_API bool TryPopResumedFiber(Fiber*& pOutFiber);
+			SAILOR_API Fiber* AcquireFiber();
+			SAILOR_API void SwitchToFiber(Fiber* pFiber, bool bRecycleCurrent);
+			SAILOR_API void OnFiberEntered();
+			SAILOR_API static void FiberMain(void* pWorker);
 
 			std::string m_threadName;
 			TUniquePtr<std::thread> m_pThread;
@@ -84,29 +177,54 @@ namespace Sailor
 			EThreadType m_threadType;
 			DWORD m_threadId;
 
-			size_t m_bExecFlag = 0;
-			std::atomic<bool> m_bIsBusy;
-			std::mutex m_execMutex;
+			// Executing the task on the current fiber, the suspended tasks are not counted
+			std::atomic<bool> m_bIsBusy = false;
+			std::atomic<uint32_t> m_wakeSignal = 0;
 
 			// Specific tasks for this thread
 			std::mutex m_queueMutex;
 			TVector<ITaskPtr> m_pTaskQueue;
+			TVector<LightTask*> m_pLightTaskQueue;
+
+			// The raw pointers, the task holds itself while it is in the deque
+			TWorkStealingDeque<ITask*> m_localQueue[NumTaskPriorities];
+
+			// The light tasks are never blocked, so they don't go to the shared queues
+			TWorkStealingDeque<LightTask*> m_localLightQueue[NumTaskPriorities];
+
+			ITask* m_pCurrentTask = nullptr;
+			LightTask* m_pCurrentLightTask = nullptr;
+			uint32_t m_numFetchedTasks = 0;
+
+			WorkerThreadStats m_stats;
+
+			// The thread's own stack only waits for the termination, the loop and the tasks are running on the fibers
+			bool m_bFibers = false;
+			Fiber* m_pThreadFiber = nullptr;
+			Fiber* m_pCurrentFiber = nullptr;
+			Fiber* m_pFiberToRecycle = nullptr;
+			TVector<Fiber*> m_fibers;
+			TVector<Fiber*> m_freeFibers;
+
+			// Guarded by m_queueMutex
+			TVector<Fiber*> m_resumedFibers;
 
 			// Assigned from scheduler
-			std::condition_variable& m_refresh;
-			std::mutex& m_sharedQueueMutex;
-			TVector<ITaskPtr>& m_pSharedTaskQueue;
+			WorkerParkingLot& m_parkingLot;
 		};
 
 		class Scheduler final : public TSubmodule<Scheduler>
 		{
 			const uint8_t RHIThreadsNum = 2u;
-			const size_t MaxTasksInPool = 16384;
 			static const uint32_t MaxThreadTypes = (uint32_t)magic_enum::enum_count<EThreadType>();
 
 		public:
 
-			SAILOR_API void Initialize();
+			// The work stealing mode replaces the locked shared queues with the per thread deques
+			// and the lock-free injection queues for the tasks that are submitted from the other thread types
+			// In the fiber mode ITask::Wait doesn't block the worker threads of EThreadType::Worker,
+			// the other tasks run on the same thread meanwhile, so the locks shouldn't be held while waiting
+			SAILOR_API void Initialize(bool bWorkStealing = true, bool bFibers = false);
 
 			SAILOR_API virtual ~Scheduler() override;
 
@@ -118,14 +236,54 @@ namespace Sailor
 			SAILOR_API void WaitIdle(const TSet<EThreadType>& threads);
 
 			SAILOR_API uint32_t GetNumWorkerThreads() const;
+			SAILOR_API uint32_t GetNumWorkerThreads(EThreadType threadType) const { return (uint32_t)m_workerThreadsByType[(uint32_t)threadType].Num(); }
 			SAILOR_API uint32_t GetNumTasks(EThreadType thread) const;
+
+			// Queued, blocked and executing tasks
+			SAILOR_API uint32_t GetNumPendingTasks(EThreadType thread) const { return m_numPendingTasks[(uint32_t)thread].load(std::memory_order_relaxed); }
+			SAILOR_API uint32_t GetPeakNumPendingTasks(EThreadType thread) const { return m_peakNumPendingTasks[(uint32_t)thread].load(std::memory_order_relaxed); }
+
+			// Utilization of the workers, the latency and the depth of the queues
+			SAILOR_API void LogStats() const;
+
+			// The recorder of the task executions, the trace is exported on stop
+			SAILOR_API TaskTraceRecorder& GetTraceRecorder() { return m_traceRecorder; }
+			SAILOR_API void StartTrace();
+			SAILOR_API bool StopTrace(const std::string& path);
+			SAILOR_API void ToggleTrace();
+
+			// The priority of the task that is executed by the calling thread,
+			// the code out of the tasks is driving the frame so it is frame critical
+			SAILOR_API ETaskPriority GetCurrentTaskPriority() const;
+
+			// Blocks the calling thread or suspends the fiber of the calling task until the block is completed
+			SAILOR_API void WaitUntilCompleted(TaskSyncBlock& syncBlock);
+
+			// The cap is checked before the background task is taken and the slot is acquired after,
+			// so the concurrent fetches could exceed the cap for a moment, but the idle threads never spin on the reservations
+			SAILOR_API bool CanStartBackgroundTask(EThreadType threadType) const;
+			SAILOR_API void AcquireBackgroundSlot(EThreadType threadType);
+			SAILOR_API void ReleaseBackgroundSlot(EThreadType threadType);
 			SAILOR_API uint32_t GetNumRHIThreads() const { return RHIThreadsNum; }
 
 			SAILOR_API void Run(const ITaskPtr& pTask, bool bAutoRunChainedTasks = true);
 			SAILOR_API void Run(const ITaskPtr& pTask, DWORD threadId, bool bAutoRunChainedTasks = true);
+
+			// Enqueues the suspended coroutine task again, it continues on its current thread type
+			SAILOR_API void Resume(const ITaskPtr& pTask);
 			SAILOR_API void ProcessTasksOnMainThread();
 
 			SAILOR_API bool TryFetchNextAvailiableTask(ITaskPtr& pOutTask, EThreadType threadType);
+			SAILOR_API bool TryFetchNextAvailiableTask(ITaskPtr& pOutTask, EThreadType threadType, ETaskPriority priority);
+			SAILOR_API bool TryStealTask(ITaskPtr& pOutTask, const WorkerThread* pThief, ETaskPriority priority);
+
+			SAILOR_API bool TryFetchLightTask(LightTask*& pOutTask, EThreadType threadType);
+			SAILOR_API bool TryFetchLightTask(LightTask*& pOutTask, EThreadType threadType, ETaskPriority priority);
+			SAILOR_API bool TryStealLightTask(LightTask*& pOutTask, const WorkerThread* pThief, ETaskPriority priority);
+
+			SAILOR_API bool IsWorkStealingEnabled() const { return m_bWorkStealing; }
+			SAILOR_API bool IsFiberModeEnabled() const { return m_bFibers; }
+			SAILOR_API WorkerThread* GetCurrentWorkerThread() const;
 
 			SAILOR_API void NotifyWorkerThread(EThreadType threadType, bool bNotifyAllThreads = false);
 
@@ -135,42 +293,77 @@ namespace Sailor
 			SAILOR_API DWORD GetMainThreadId() const { return m_mainThreadId; }
 			SAILOR_API DWORD GetRendererThreadId() const { return m_renderingThreadId; }
 			SAILOR_API EThreadType GetCurrentThreadType() const;
+			SAILOR_API EThreadType GetThreadType(DWORD threadId) const;
 
 			SAILOR_API Scheduler();
 
 			SAILOR_API void RunChainedTasks(const ITaskPtr& pTask);
 
 			SAILOR_API TaskSyncBlock& GetTaskSyncBlock(const ITask& task);
-			SAILOR_API uint16_t AcquireTaskSyncBlock();
+			SAILOR_API uint32_t AcquireTaskSyncBlock();
 			SAILOR_API void ReleaseTaskSyncBlock(const ITask& task);
 
 		protected:
 
 			SAILOR_API void RunChainedTasks_Internal(const ITaskPtr& pTask, const ITaskPtr& pTaskToIgnore);
 
+			// The blocked tasks wait in the locked shared queue until the dependencies are resolved
+			SAILOR_API void Enqueue(const ITaskPtr& pTask);
+			SAILOR_API void PushSharedTask(const ITaskPtr& pTask, EThreadType threadType);
+
+			// The light task is enqueued once it is ready to start
+			SAILOR_API void Enqueue(LightTask* pTask);
+			SAILOR_API void ProcessLightTaskOnMainThread(LightTask*& pTask);
+
+			template<typename TStealFunc>
+			bool TryStealFromVictims(const WorkerThread* pThief, TStealFunc&& steal);
+
+			SAILOR_API void OnTaskPending(const ITaskPtr& pTask, EThreadType threadType);
+			SAILOR_API void OnTaskPending(EThreadType threadType);
+			SAILOR_API void OnTaskProcessed(EThreadType threadType);
+
 			SAILOR_API void GetThreadSyncVarsByThreadType(
 				EThreadType threadType,
+				ETaskPriority priority,
 				std::mutex*& pOutMutex,
-				TVector<ITaskPtr>*& pOutQueue,
-				std::condition_variable*& pOutCondVar);
+				TVector<ITaskPtr>*& pOutQueue);
 
 			std::mutex m_queueMutex[MaxThreadTypes];
-			std::condition_variable m_refreshCondVar[MaxThreadTypes];
-			TVector<ITaskPtr> m_pSharedTaskQueue[MaxThreadTypes];
+			WorkerParkingLot m_parkingLots[MaxThreadTypes];
+
+			// Enqueued and not finished yet, WaitIdle sleeps on it
+			std::atomic<uint32_t> m_numPendingTasks[MaxThreadTypes]{};
+			std::atomic<uint32_t> m_peakNumPendingTasks[MaxThreadTypes]{};
+			TVector<ITaskPtr> m_pSharedTaskQueue[MaxThreadTypes][NumTaskPriorities];
+
+			// Half of the threads of each type at most are executing the background tasks
+			std::atomic<uint32_t> m_numBackgroundTasks[MaxThreadTypes]{};
+			uint32_t m_maxBackgroundTasks[MaxThreadTypes]{};
+
+			bool m_bWorkStealing = false;
+			bool m_bFibers = false;
+			TConcurrentQueue<ITaskPtr> m_injectionQueue[MaxThreadTypes][NumTaskPriorities];
+
+			// The light tasks that are submitted from the other thread types or without the work stealing
+			TConcurrentQueue<LightTask*> m_lightTaskQueue[MaxThreadTypes][NumTaskPriorities];
+			TVector<WorkerThread*> m_workerThreadsByType[MaxThreadTypes];
 
 			std::atomic<uint32_t> m_numBusyThreads;
 			TVector<WorkerThread*> m_workerThreads;
 			std::atomic_bool m_bIsTerminating;
+			std::atomic_bool m_bIsInitialized = false;
 
 			DWORD m_mainThreadId = -1;
 			DWORD m_renderingThreadId = -1;
 
 			// Task Synchronization primitives pool
-			concurrency::concurrent_queue<uint16_t> m_freeList{};
-			TVector<TaskSyncBlock> m_taskSyncPool{};
+			TaskSyncBlockPool m_taskSyncBlocks{};
 			TMap<DWORD, EThreadType> m_threadTypes{};
 
+			TaskTraceRecorder m_traceRecorder;
+
 			friend class WorkerThread;
+			friend class LightTask;
 		};
 	}
 }
\ No newline at end of file
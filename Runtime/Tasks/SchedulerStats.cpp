@@ -0,0 +1,191 @@
+#include "SchedulerStats.h"
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include "Tasks/Scheduler.h"
+
+using namespace Sailor;
+using namespace Sailor::Tasks;
+
+namespace
+{
+	void WriteJsonString(std::ofstream& stream, const char* str)
+	{
+		stream << '"';
+		for (; *str; str++)
+		{
+			const char c = *str;
+			if (c == '"' || c == '\\')
+			{
+				stream << '\\' << c;
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				stream << ' ';
+			}
+			else
+			{
+				stream << c;
+			}
+		}
+		stream << '"';
+	}
+}
+
+void QueueWaitHistogram::Add(int64_t durationNs)
+{
+	const uint64_t micro = durationNs > 0 ? (uint64_t)durationNs / 1000 : 0;
+	const uint32_t bucket = (std::min)((uint32_t)std::bit_width(micro), NumBuckets - 1);
+
+	Internal::AddToCounter(m_buckets[bucket], 1);
+}
+
+uint64_t QueueWaitHistogram::GetNum() const
+{
+	uint64_t res = 0;
+	for (uint32_t i = 0; i < NumBuckets; i++)
+	{
+		res += GetBucket(i);
+	}
+
+	return res;
+}
+
+int64_t QueueWaitHistogram::GetPercentileMicro(float percentile) const
+{
+	const uint64_t num = GetNum();
+	if (num == 0)
+	{
+		return 0;
+	}
+
+	const uint64_t threshold = (std::max)((uint64_t)std::ceil(num * (double)percentile), (uint64_t)1);
+
+	uint64_t acc = 0;
+	for (uint32_t i = 0; i < NumBuckets; i++)
+	{
+		acc += GetBucket(i);
+		if (acc >= threshold)
+		{
+			return GetBucketUpperBoundMicro(i);
+		}
+	}
+
+	return GetBucketUpperBoundMicro(NumBuckets - 1);
+}
+
+TaskTraceRecorder::~TaskTraceRecorder()
+{
+	delete[] m_pEvents;
+}
+
+void TaskTraceRecorder::Start(uint32_t capacity)
+{
+	check(!IsRecording());
+
+	if (!m_pEvents)
+	{
+		m_capacity = std::bit_ceil((std::max)(capacity, 2u));
+		m_pEvents = new Event[m_capacity];
+	}
+
+	for (uint32_t i = 0; i < m_capacity; i++)
+	{
+		m_pEvents[i].m_sequence.store(0, std::memory_order_relaxed);
+	}
+
+	m_numEvents.store(0, std::memory_order_relaxed);
+	m_startTimeNs = Internal::GetTimestampNs();
+	m_bIsRecording.store(true, std::memory_order_release);
+}
+
+void TaskTraceRecorder::Stop()
+{
+	m_bIsRecording.store(false, std::memory_order_release);
+}
+
+void TaskTraceRecorder::Record(const char* name, ETaskPriority priority, DWORD threadId, int64_t beginNs, int64_t endNs)
+{
+	const uint64_t index = m_numEvents.fetch_add(1, std::memory_order_relaxed);
+	Event& event = m_pEvents[index & (m_capacity - 1)];
+
+	// The reader drops the event that is rewritten meanwhile
+	event.m_sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const size_t length = strnlen(name, MaxNameLength);
+	memcpy(event.m_name, name, length);
+	event.m_name[length] = '\0';
+	event.m_beginNs = beginNs;
+	event.m_endNs = endNs;
+	event.m_threadId = threadId;
+	event.m_priority = (uint8_t)priority;
+
+	event.m_sequence.store(index + 1, std::memory_order_release);
+}
+
+bool TaskTraceRecorder::ExportChromeTrace(const std::string& path, const TVector<std::pair<DWORD, std::string>>& threadNames) const
+{
+	SAILOR_PROFILE_FUNCTION();
+
+	std::ofstream stream(path, std::ios::out | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		return false;
+	}
+
+	stream << std::fixed << std::setprecision(3);
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool bFirst = true;
+	for (const auto& threadName : threadNames)
+	{
+		stream << (bFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadName.first << ",\"args\":{\"name\":";
+		WriteJsonString(stream, threadName.second.c_str());
+		stream << "}}";
+		bFirst = false;
+	}
+
+	const uint64_t numEvents = m_pEvents ? m_numEvents.load(std::memory_order_acquire) : 0;
+	const uint64_t first = numEvents > m_capacity ? numEvents - m_capacity : 0;
+
+	for (uint64_t i = first; i < numEvents; i++)
+	{
+		const Event& event = m_pEvents[i & (m_capacity - 1)];
+
+		if (event.m_sequence.load(std::memory_order_acquire) != i + 1)
+		{
+			continue;
+		}
+
+		Event copy;
+		memcpy(copy.m_name, event.m_name, sizeof(copy.m_name));
+		copy.m_name[MaxNameLength] = '\0';
+		copy.m_beginNs = event.m_beginNs;
+		copy.m_endNs = event.m_endNs;
+		copy.m_threadId = event.m_threadId;
+		copy.m_priority = event.m_priority;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (event.m_sequence.load(std::memory_order_relaxed) != i + 1)
+		{
+			continue;
+		}
+
+		// Microseconds
+		const double ts = (copy.m_beginNs - m_startTimeNs) / 1000.0;
+		const double dur = (copy.m_endNs - copy.m_beginNs) / 1000.0;
+
+		stream << (bFirst ? "" : ",") << "\n{\"name\":";
+		WriteJsonString(stream, copy.m_name);
+		stream << ",\"cat\":\"" << magic_enum::enum_name((ETaskPriority)copy.m_priority) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << copy.m_threadId
+			<< ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+		bFirst = false;
+	}
+
+	stream << "\n]}\n";
+
+	return stream.good();
+}
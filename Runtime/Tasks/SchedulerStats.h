@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "Core/Defines.h"
+#include "Containers/Vector.h"
+
+namespace Sailor
+{
+	enum class ETaskPriority : uint8_t;
+}
+
+namespace Sailor::Tasks
+{
+	namespace Internal
+	{
+		__forceinline int64_t GetTimestampNs()
+		{
+			return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// The counters are written by the owner thread only, so there is no need in the locked read-modify-write
+		__forceinline void AddToCounter(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+	}
+
+	// The bucket i counts the values in [2^(i-1), 2^i) microseconds, the first one is below 1us and the last one collects the rest
+	class QueueWaitHistogram
+	{
+	public:
+
+		static constexpr uint32_t NumBuckets = 24;
+
+		SAILOR_API void Add(int64_t durationNs);
+
+		SAILOR_API uint64_t GetBucket(uint32_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+		SAILOR_API uint64_t GetNum() const;
+
+		// The upper bound of the bucket that contains the percentile, 0 if there are no values
+		SAILOR_API int64_t GetPercentileMicro(float percentile) const;
+
+		SAILOR_API static int64_t GetBucketUpperBoundMicro(uint32_t index) { return 1ll << index; }
+
+	protected:
+
+		std::atomic<uint64_t> m_buckets[NumBuckets]{};
+	};
+
+	// Always on, updated by the worker thread and read by any thread
+	struct WorkerThreadStats
+	{
+		// The time the worker is spinning or parked without the tasks, the busy time is the rest
+		std::atomic<uint64_t> m_idleTimeNs{ 0 };
+
+		// The start of the current idle period, 0 while the worker is busy
+		std::atomic<int64_t> m_idleSinceNs{ 0 };
+		std::atomic<uint64_t> m_numExecutedTasks{ 0 };
+		std::atomic<uint64_t> m_numStolenTasks{ 0 };
+
+		// The time between the enqueue and the start of the execution
+		QueueWaitHistogram m_queueWait;
+
+		int64_t m_startTimeNs = 0;
+	};
+
+	// Ring buffer of the task executions, the oldest events are overwritten.
+	// Recording costs a single atomic increment and a copy of the task's name per task,
+	// the disabled recorder costs the single relaxed load.
+	// The trace is exported as Chrome trace JSON that could be opened in chrome://tracing or Perfetto.
+	class TaskTraceRecorder
+	{
+	public:
+
+		static constexpr uint32_t DefaultCapacity = 1 << 16;
+		static constexpr uint32_t MaxNameLength = 39;
+
+		TaskTraceRecorder() = default;
+		TaskTraceRecorder(const TaskTraceRecorder&) = delete;
+		TaskTraceRecorder& operator=(const TaskTraceRecorder&) = delete;
+
+		SAILOR_API ~TaskTraceRecorder();
+
+		// The buffer is allocated on the first start and reused later
+		SAILOR_API void Start(uint32_t capacity = DefaultCapacity);
+		SAILOR_API void Stop();
+
+		SAILOR_API bool IsRecording() const { return m_bIsRecording.load(std::memory_order_relaxed); }
+
+		// The caller checks IsRecording first, so the disabled recorder doesn't cost the timestamp
+		SAILOR_API void Record(const char* name, ETaskPriority priority, DWORD threadId, int64_t beginNs, int64_t endNs);
+
+		// The thread names are written as the metadata, the events of the suspended fibers could overlap on the same thread
+		SAILOR_API bool ExportChromeTrace(const std::string& path, const TVector<std::pair<DWORD, std::string>>& threadNames) const;
+
+	protected:
+
+		struct Event
+		{
+			// Index + 1 of the event once it is written, 0 while it is written
+			std::atomic<uint64_t> m_sequence{ 0 };
+			int64_t m_beginNs = 0;
+			int64_t m_endNs = 0;
+			DWORD m_threadId = 0;
+			uint8_t m_priority = 0;
+			char m_name[MaxNameLength + 1]{};
+		};
+
+		std::atomic<bool> m_bIsRecording{ false };
+		std::atomic<uint64_t> m_numEvents{ 0 };
+
+		Event* m_pEvents = nullptr;
+		uint32_t m_capacity = 0;
+		int64_t m_startTimeNs = 0;
+	};
+}
@@ -0,0 +1,164 @@
+#include "TaskSyncBlock.h"
+#include <windows.h>
+#include <cstdlib>
+#include "Core/LogMacros.h"
+
+using namespace Sailor;
+using namespace Sailor::Tasks;
+
+bool TaskSyncBlock::SleepUntilChanged(uint32_t state)
+{
+	// The waker clears the bit and notifies only if it has been set, so the bit is set before the sleep
+	if (!(state & WaitersBit) && !m_state.compare_exchange_weak(state, state | WaitersBit, std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	m_state.wait(state | WaitersBit, std::memory_order_relaxed);
+	return true;
+}
+
+void TaskSyncBlock::Lock()
+{
+	uint32_t state = m_state.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; ; i++)
+	{
+		if (!(state & LockedBit))
+		{
+			if (m_state.compare_exchange_weak(state, state | LockedBit, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			continue;
+		}
+
+		if (i < SpinCount)
+		{
+			YieldProcessor();
+		}
+		else
+		{
+			SleepUntilChanged(state);
+		}
+
+		state = m_state.load(std::memory_order_relaxed);
+	}
+}
+
+void TaskSyncBlock::Unlock()
+{
+	if (m_state.fetch_and(~(LockedBit | WaitersBit), std::memory_order_release) & WaitersBit)
+	{
+		m_state.notify_all();
+	}
+}
+
+void TaskSyncBlock::Wait()
+{
+	uint32_t state = m_state.load(std::memory_order_acquire);
+	while (!(state & CompletedBit))
+	{
+		SleepUntilChanged(state);
+		state = m_state.load(std::memory_order_acquire);
+	}
+}
+
+void TaskSyncBlock::AddSuspendedFiber(SuspendedFiber* pSuspended)
+{
+	check(m_state.load(std::memory_order_relaxed) & LockedBit);
+
+	pSuspended->m_pNext = m_pSuspendedFibers;
+	m_pSuspendedFibers = pSuspended;
+}
+
+SuspendedFiber* TaskSyncBlock::CompleteAndUnlock()
+{
+	check(m_state.load(std::memory_order_relaxed) & LockedBit);
+
+	SuspendedFiber* pSuspendedFibers = m_pSuspendedFibers;
+	m_pSuspendedFibers = nullptr;
+
+	uint32_t state = m_state.load(std::memory_order_relaxed);
+	while (!m_state.compare_exchange_weak(state, (state | CompletedBit) & ~(LockedBit | WaitersBit), std::memory_order_release, std::memory_order_relaxed));
+
+	if (state & WaitersBit)
+	{
+		m_state.notify_all();
+	}
+
+	return pSuspendedFibers;
+}
+
+TaskSyncBlockPool::~TaskSyncBlockPool()
+{
+	for (auto& segment : m_segments)
+	{
+		delete[] segment.load(std::memory_order_relaxed);
+	}
+}
+
+TaskSyncBlock* TaskSyncBlockPool::GetOrCreateSegment(uint32_t segment)
+{
+	TaskSyncBlock* pSegment = m_segments[segment].load(std::memory_order_acquire);
+	if (!pSegment)
+	{
+		// The threads that have got the handles from the same new segment wait for its allocation
+		const std::lock_guard<std::mutex> lock(m_segmentsMutex);
+
+		pSegment = m_segments[segment].load(std::memory_order_relaxed);
+		if (!pSegment)
+		{
+			pSegment = new TaskSyncBlock[SegmentSize];
+			m_segments[segment].store(pSegment, std::memory_order_release);
+		}
+	}
+
+	return pSegment;
+}
+
+uint32_t TaskSyncBlockPool::Acquire()
+{
+	uint64_t head = m_freeHead.load(std::memory_order_acquire);
+	while (GetHandle(head) != TaskSyncBlock::InvalidHandle)
+	{
+		TaskSyncBlock& block = Get(GetHandle(head));
+
+		// The block could be taken and released by the other thread meanwhile, then the tag is changed and CAS fails
+		const uint32_t next = block.m_nextFree.load(std::memory_order_relaxed);
+		if (m_freeHead.compare_exchange_weak(head, PackHead(next, GetTag(head) + 1), std::memory_order_acquire, std::memory_order_acquire))
+		{
+			block.Reset();
+			return GetHandle(head);
+		}
+	}
+
+	// The pool grows only up to the peak amount of the concurrent tasks
+	const uint32_t handle = m_numBlocks.fetch_add(1, std::memory_order_relaxed);
+	if (handle >= MaxSegments * SegmentSize)
+	{
+		// The task cannot exist without the sync block, the callers don't expect the invalid handle
+		SAILOR_LOG("Increase the amount of the segments in the pool of task sync blocks! TaskSyncBlockPool::MaxSegments");
+		std::abort();
+	}
+
+	GetOrCreateSegment(handle >> SegmentSizeLog2);
+
+	return handle;
+}
+
+void TaskSyncBlockPool::Release(uint32_t handle)
+{
+	if (handle == TaskSyncBlock::InvalidHandle)
+	{
+		return;
+	}
+
+	TaskSyncBlock& block = Get(handle);
+
+	uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+	do
+	{
+		block.m_nextFree.store(GetHandle(head), std::memory_order_relaxed);
+	} while (!m_freeHead.compare_exchange_weak(head, PackHead(handle, GetTag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include "Core/Defines.h"
+
+namespace Sailor::Tasks
+{
+	class WorkerThread;
+	class Fiber;
+
+	// The fiber of the task that waits for the completion, it is continued by the same worker.
+	// The node lives on the stack of the suspended fiber, so the registration doesn't allocate
+	struct SuspendedFiber
+	{
+		WorkerThread* m_pWorker = nullptr;
+		Fiber* m_pFiber = nullptr;
+		SuspendedFiber* m_pNext = nullptr;
+	};
+
+	// The completion flag of the task and the lock that guards its dependencies,
+	// both are packed into the single word and the blocked threads sleep on it with atomic::wait
+	class TaskSyncBlock final
+	{
+	public:
+
+		// Invalid handle
+		static constexpr uint32_t InvalidHandle = UINT32_MAX;
+
+		// The lock is taken for the short moments only, so spinning is cheaper than the sleep in most cases
+		static constexpr uint32_t SpinCount = 64;
+
+		SAILOR_API void Lock();
+		SAILOR_API void Unlock();
+
+		SAILOR_API bool IsCompleted() const { return m_state.load(std::memory_order_acquire) & CompletedBit; }
+
+		// Blocks the calling thread until the block is completed
+		SAILOR_API void Wait();
+
+		// Registers the fiber that is continued once the block is completed, should be called under the lock
+		SAILOR_API void AddSuspendedFiber(SuspendedFiber* pSuspended);
+
+		// Should be called under the lock, releases the lock and wakes the blocked threads.
+		// Returns the registered fibers, the caller resumes them
+		SAILOR_API SuspendedFiber* CompleteAndUnlock();
+
+	protected:
+
+		enum StateMask : uint32_t
+		{
+			LockedBit = 1u,
+			CompletedBit = 1u << 1,
+			// Somebody sleeps on m_state
+			WaitersBit = 1u << 2
+		};
+
+		void Reset()
+		{
+			m_state.store(0, std::memory_order_relaxed);
+			m_pSuspendedFibers = nullptr;
+		}
+
+		// Returns false if the state is changed meanwhile
+		bool SleepUntilChanged(uint32_t state);
+
+		std::atomic<uint32_t> m_state{ 0 };
+
+		// The next free block while the block is in the pool
+		std::atomic<uint32_t> m_nextFree{ InvalidHandle };
+
+		SuspendedFiber* m_pSuspendedFibers = nullptr;
+
+		friend class TaskSyncBlockPool;
+	};
+
+	// The blocks are allocated by the segments that are never moved or freed until the pool is destroyed,
+	// so the handle is resolved without the locks and the pool grows without the upper bound on the concurrent tasks.
+	// The free blocks are linked into the lock-free stack, the tag in the head prevents the ABA problem
+	class TaskSyncBlockPool final
+	{
+	public:
+
+		static constexpr uint32_t SegmentSizeLog2 = 12;
+		static constexpr uint32_t SegmentSize = 1u << SegmentSizeLog2;
+
+		// 4M concurrent tasks
+		static constexpr uint32_t MaxSegments = 1024;
+
+		TaskSyncBlockPool() = default;
+		TaskSyncBlockPool(const TaskSyncBlockPool&) = delete;
+		TaskSyncBlockPool& operator=(const TaskSyncBlockPool&) = delete;
+
+		SAILOR_API ~TaskSyncBlockPool();
+
+		SAILOR_API uint32_t Acquire();
+		SAILOR_API void Release(uint32_t handle);
+
+		SAILOR_API __forceinline TaskSyncBlock& Get(uint32_t handle)
+		{
+			check(handle < m_numBlocks.load(std::memory_order_relaxed));
+			return m_segments[handle >> SegmentSizeLog2].load(std::memory_order_acquire)[handle & (SegmentSize - 1)];
+		}
+
+		SAILOR_API uint32_t Num() const { return m_numBlocks.load(std::memory_order_relaxed); }
+
+	protected:
+
+		static __forceinline uint64_t PackHead(uint32_t handle, uint32_t tag) { return ((uint64_t)tag << 32) | handle; }
+		static __forceinline uint32_t GetHandle(uint64_t head) { return (uint32_t)head; }
+		static __forceinline uint32_t GetTag(uint64_t head) { return (uint32_t)(head >> 32); }
+
+		TaskSyncBlock* GetOrCreateSegment(uint32_t segment);
+
+		std::atomic<TaskSyncBlock*> m_segments[MaxSegments]{};
+		std::mutex m_segmentsMutex;
+
+		alignas(64) std::atomic<uint64_t> m_freeHead{ PackHead(TaskSyncBlock::InvalidHandle, 0) };
+		alignas(64) std::atomic<uint32_t> m_numBlocks{ 0 };
+	};
+}
@@ -29,14 +29,16 @@ void ITask::Join(const TWeakPtr<ITask>& job)
 bool ITask::AddDependency(ITaskPtr dependentJob)
 {
 	auto& syncBlock = App::GetSubmodule<Scheduler>()->GetTaskSyncBlock(*this);
-	std::unique_lock<std::mutex> lk(syncBlock.m_mutex);
+	syncBlock.Lock();
 	if (IsFinished())
 	{
+		syncBlock.Unlock();
 		return false;
 	}
 
 	dependentJob->m_numBlockers++;
 	m_dependencies.Emplace(dependentJob);
+	syncBlock.Unlock();
 	return true;
 }
 
@@ -73,38 +75,42 @@ void ITask::Complete()
 
 	auto scheduler = App::GetSubmodule<Tasks::Scheduler>();
 	auto& syncBlock = scheduler->GetTaskSyncBlock(*this);
-	{
-		std::unique_lock<std::mutex> lk(syncBlock.m_mutex);
+	syncBlock.Lock();
 
-		for (auto& job : m_dependencies)
+	for (auto& job : m_dependencies)
+	{
+		if (auto pJob = job.TryLock())
 		{
-			if (auto pJob = job.TryLock())
+			if (--pJob->m_numBlockers == 0)
 			{
-				if (--pJob->m_numBlockers == 0)
-				{
-					scheduler->NotifyWorkerThread(pJob->GetThreadType());
-				}
+				scheduler->NotifyWorkerThread(pJob->GetThreadType());
 			}
 		}
-
-		m_chainedTaskPrev.Clear();
-		m_dependencies.Clear();
-		m_state |= StateMask::IsFinishedBit;
-		syncBlock.m_bCompletionFlag = true;
 	}
 
-	syncBlock.m_onComplete.notify_all();
+	m_chainedTaskPrev.Clear();
+	m_dependencies.Clear();
+	m_state |= StateMask::IsFinishedBit;
+
+	SuspendedFiber* pSuspended = syncBlock.CompleteAndUnlock();
+	while (pSuspended)
+	{
+		// The node is on the stack of the fiber, so it could be gone once the fiber is resumed
+		SuspendedFiber* pNext = pSuspended->m_pNext;
+		pSuspended->m_pWorker->ResumeFiber(pSuspended->m_pFiber);
+		pSuspended = pNext;
+	}
 }
 
 void ITask::Wait()
 {
 	SAILOR_PROFILE_FUNCTION();
 
-	auto& syncBlock = App::GetSubmodule<Scheduler>()->GetTaskSyncBlock(*this);
-	std::unique_lock<std::mutex> lk(syncBlock.m_mutex);
-
-	if (!IsFinished())
+	if (IsFinished())
 	{
-		syncBlock.m_onComplete.wait(lk, [&]() { return syncBlock.m_bCompletionFlag; });
+		return;
 	}
+
+	auto scheduler = App::GetSubmodule<Scheduler>();
+	scheduler->WaitUntilCompleted(scheduler->GetTaskSyncBlock(*this));
 }
@@ -7,7 +7,9 @@
 #include "Sailor.h"
 #include "Memory/UniquePtr.hpp"
 #include "Memory/SharedPtr.hpp"
+#include "Containers/InlineVector.h"
 #include "Scheduler.h"
+#include "LightTask.h"
 
 namespace Sailor
 {
@@ -29,24 +31,25 @@ namespace Sailor
 		using TaskPtr = TSharedPtr<Task<TResult, TArgs>>;
 
 		template<typename TResult = void, typename TArgs = void>
-		TaskPtr<TResult, TArgs> CreateTask(const std::string& name, typename TFunction<TResult, TArgs>::type lambda, EThreadType thread = EThreadType::Worker)
+		TaskPtr<TResult, TArgs> CreateTask(const std::string& name, typename TFunction<TResult, TArgs>::type lambda, EThreadType thread = EThreadType::Worker, ETaskPriority priority = ETaskPriority::Normal)
 		{
 			auto task = TaskPtr<TResult, TArgs>::Make(name, std::move(lambda), thread);
 			task->m_self = task;
+			task->m_priority = priority;
 			task->m_taskSyncBlockHandle = App::GetSubmodule<Tasks::Scheduler>()->AcquireTaskSyncBlock();
 			return task;
 		}
 
 		template<typename TArgs>
-		TaskPtr<void, TArgs> CreateTaskWithArgs(const std::string& name, typename TFunction<void, TArgs>::type lambda, EThreadType thread = EThreadType::Worker)
+		TaskPtr<void, TArgs> CreateTaskWithArgs(const std::string& name, typename TFunction<void, TArgs>::type lambda, EThreadType thread = EThreadType::Worker, ETaskPriority priority = ETaskPriority::Normal)
 		{
-			return CreateTask<void, TArgs>(name, lambda, thread);
+			return CreateTask<void, TArgs>(name, lambda, thread, priority);
 		}
 
 		template<typename TResult>
-		TaskPtr<TResult, void> CreateTaskWithResult(const std::string& name, typename TFunction<TResult, void>::type lambda, EThreadType thread = EThreadType::Worker)
+		TaskPtr<TResult, void> CreateTaskWithResult(const std::string& name, typename TFunction<TResult, void>::type lambda, EThreadType thread = EThreadType::Worker, ETaskPriority priority = ETaskPriority::Normal)
 		{
-			return CreateTask<TResult, void>(name, lambda, thread);
+			return CreateTask<TResult, void>(name, lambda, thread, priority);
 		}
 
 		class ITask
@@ -91,8 +94,12 @@ namespace Sailor
 			SAILOR_API void Wait();
 
 			SAILOR_API EThreadType GetThreadType() const { return m_threadType; }
+			SAILOR_API ETaskPriority GetPriority() const { return m_priority; }
 
-			SAILOR_API const TVector<TWeakPtr<ITask>>& GetChainedTasksNext() const { return m_chainedTasksNext; }
+			// The priority could be changed only before the task is run
+			SAILOR_API void SetPriority(ETaskPriority priority) { check(!IsInQueue() && !IsStarted()); m_priority = priority; }
+
+			SAILOR_API const TInlineVector<TWeakPtr<ITask>, 2>& GetChainedTasksNext() const { return m_chainedTasksNext; }
 			SAILOR_API const ITaskPtr& GetChainedTaskPrev() const { return m_chainedTaskPrev; }
 
 			SAILOR_API void SetChainedTaskPrev(ITaskPtr task);
@@ -108,23 +115,32 @@ namespace Sailor
 			}
 
 			EThreadType m_threadType;
+			ETaskPriority m_priority = ETaskPriority::Normal;
 			std::atomic<uint8_t> m_state = 0;
 			std::atomic<uint16_t> m_numBlockers = 0;
-			uint16_t m_taskSyncBlockHandle = 0;
+			uint32_t m_taskSyncBlockHandle = TaskSyncBlock::InvalidHandle;
+
+			// The queue wait latency is measured from it
+			int64_t m_enqueueTimeNs = 0;
 
 			TWeakPtr<ITask> m_self;
 
-			TVector<TWeakPtr<ITask>> m_chainedTasksNext;
+			TInlineVector<TWeakPtr<ITask>, 2> m_chainedTasksNext;
 			ITaskPtr m_chainedTaskPrev;
 
-			TVector<TWeakPtr<ITask>> m_dependencies;
+			TInlineVector<TWeakPtr<ITask>, 2> m_dependencies;
+
+			// Keeps the task alive while it is in the lock-free queues that store the raw pointers
+			ITaskPtr m_pQueueReference;
 
-			std::string m_name; // TODO: remove name, to save 40 bytes
+			// The names are built at runtime (frame index, asset path), the high frequency work goes to LightTask that keeps the static name
+			std::string m_name;
 
 			friend class Scheduler;
+			friend class WorkerThread;
 
 			template<typename TResult, typename TArgs>
-			friend TaskPtr<TResult, TArgs> CreateTask(const std::string& name, typename TFunction<TResult, TArgs>::type lambda, EThreadType thread);
+			friend TaskPtr<TResult, TArgs> CreateTask(const std::string& name, typename TFunction<TResult, TArgs>::type lambda, EThreadType thread, ETaskPriority priority);
 		};
 
 		template<typename TResult>
@@ -206,21 +222,7 @@ namespace Sailor
 					}
 				}
 
-				if constexpr (NotVoid<TResult>)
-				{
-					const auto& result = ResultBase::m_result;
-
-					for (auto& m_chainedTaskNext : ITask::m_chainedTasksNext)
-					{
-						if (auto task = m_chainedTaskNext.Lock())
-						{
-							if (auto taskWithArgs = dynamic_cast<ITaskWithArgs<TResult>*>(task.GetRawPtr()))
-							{
-								taskWithArgs->SetArgs(result);
-							}
-						}
-					}
-				}
+				PassResultToChainedTasks();
 
 				ITask::Complete();
 			}
@@ -244,7 +246,8 @@ namespace Sailor
 				std::string name = "ChainedTask",
 				EThreadType thread = EThreadType::Worker)
 			{
-				auto resultTask = Tasks::CreateTask<TContinuationResult, TResult>(std::move(name), std::move(function), thread);
+				// The continuation is the part of the same work
+				auto resultTask = Tasks::CreateTask<TContinuationResult, TResult>(std::move(name), std::move(function), thread, ITask::m_priority);
 				if constexpr (NotVoid<TResult>)
 				{
 					resultTask->SetArgs(ResultBase::m_result);
@@ -262,7 +265,7 @@ namespace Sailor
 					std::move([=, this]()
 						{
 							return ITask::m_self.Lock(). template DynamicCast<ITaskWithResult<TResult>>()->GetResult();
-						}), ITask::m_threadType);
+						}), ITask::m_threadType, ITask::m_priority);
 
 				ChainTasks(resultTask);
 				RunTaskIfNeeded(resultTask);
@@ -272,6 +275,25 @@ namespace Sailor
 
 		protected:
 
+			SAILOR_API __forceinline void PassResultToChainedTasks()
+			{
+				if constexpr (NotVoid<TResult>)
+				{
+					const auto& result = ResultBase::m_result;
+
+					for (auto& m_chainedTaskNext : ITask::m_chainedTasksNext)
+					{
+						if (auto task = m_chainedTaskNext.Lock())
+						{
+							if (auto taskWithArgs = dynamic_cast<ITaskWithArgs<TResult>*>(task.GetRawPtr()))
+							{
+								taskWithArgs->SetArgs(result);
+							}
+						}
+					}
+				}
+			}
+
 			SAILOR_API __forceinline void ChainTasks(ITaskPtr nextTask)
 			{
 				if (auto ptr = m_self.TryLock())
@@ -280,11 +302,10 @@ namespace Sailor
 					nextTask->Join(ptr);
 				}
 
-				{
-					auto& taskSyncBlock = App::GetSubmodule<Scheduler>()->GetTaskSyncBlock(*this);
-					std::unique_lock<std::mutex> lk(taskSyncBlock.m_mutex);
-					ITask::m_chainedTasksNext.Add(nextTask);
-				}
+				auto& taskSyncBlock = App::GetSubmodule<Scheduler>()->GetTaskSyncBlock(*this);
+				taskSyncBlock.Lock();
+				ITask::m_chainedTasksNext.Add(nextTask);
+				taskSyncBlock.Unlock();
 			}
 
 			SAILOR_API __forceinline void RunTaskIfNeeded(const ITaskPtr& task)
@@ -297,7 +318,7 @@ namespace Sailor
 
 			Function m_function;
 
-			friend TaskPtr<TResult, TArgs> CreateTask(const std::string& name, typename TFunction<TResult, TArgs>::type lambda, EThreadType thread);
+			friend TaskPtr<TResult, TArgs> CreateTask(const std::string& name, typename TFunction<TResult, TArgs>::type lambda, EThreadType thread, ETaskPriority priority);
 		};
 	}
 }
\ No newline at end of file